@@ -1,6 +1,7 @@
 #include "avr_isp.h"
 #include "../lib/driver/avr_isp_prog_cmd.h"
-#include "../lib/driver/avr_isp_spi_sw.h"
+#include "../lib/driver/avr_isp_spi.h"
+#include "../lib/driver/avr_isp_page.h"
 
 #include <furi.h>
 
@@ -8,8 +9,9 @@
 #define TAG "AvrIsp"
 
 struct AvrIsp {
-    AvrIspSpiSw* spi;
+    AvrIspSpi* spi;
     bool pmode;
+    bool eeprom_byte_mode;
     AvrIspCallback callback;
     void* context;
 };
@@ -41,39 +43,32 @@ uint8_t avr_isp_spi_transaction(
     uint8_t addr_lo,
     uint8_t data) {
     furi_assert(instance);
-
-    avr_isp_spi_sw_txrx(instance->spi, cmd);
-    avr_isp_spi_sw_txrx(instance->spi, addr_hi);
-    avr_isp_spi_sw_txrx(instance->spi, addr_lo);
-    return avr_isp_spi_sw_txrx(instance->spi, data);
+    return avr_isp_spi_instruction(instance->spi, cmd, addr_hi, addr_lo, data);
 }
 
 static bool avr_isp_set_pmode(AvrIsp* instance, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
     furi_assert(instance);
 
-    uint8_t res = 0;
-    avr_isp_spi_sw_txrx(instance->spi, a);
-    avr_isp_spi_sw_txrx(instance->spi, b);
-    res = avr_isp_spi_sw_txrx(instance->spi, c);
-    avr_isp_spi_sw_txrx(instance->spi, d);
-    return res == 0x53;
+    uint8_t buf[] = {a, b, c, d};
+    avr_isp_spi_trx(instance->spi, buf, buf, sizeof(buf));
+    return buf[2] == 0x53;
 }
 
 void avr_isp_end_pmode(AvrIsp* instance) {
     furi_assert(instance);
 
     if(instance->pmode) {
-        avr_isp_spi_sw_res_set(instance->spi, true);
+        avr_isp_spi_res_set(instance->spi, true);
         // We're about to take the target out of reset
         // so configure SPI pins as input
-        if(instance->spi) avr_isp_spi_sw_free(instance->spi);
+        if(instance->spi) avr_isp_spi_free(instance->spi);
         instance->spi = NULL;
     }
 
     instance->pmode = false;
 }
 
-static bool avr_isp_start_pmode(AvrIsp* instance, AvrIspSpiSwSpeed spi_speed) {
+static bool avr_isp_start_pmode(AvrIsp* instance, AvrIspSpiSpeed spi_speed) {
     furi_assert(instance);
 
     // Reset target before driving PIN_SCK or PIN_MOSI
@@ -84,30 +79,31 @@ static bool avr_isp_start_pmode(AvrIsp* instance, AvrIspSpiSwSpeed spi_speed) {
     // which for many arduino's is not the SS pin.
     // So we have to configure RESET as output here,
     // (reset_target() first sets the correct level)
-    if(instance->spi) avr_isp_spi_sw_free(instance->spi);
-    instance->spi = avr_isp_spi_sw_init(spi_speed);
+    if(instance->spi) avr_isp_spi_free(instance->spi);
+    instance->spi = avr_isp_spi_init(spi_speed);
 
-    avr_isp_spi_sw_res_set(instance->spi, false);
+    avr_isp_spi_res_set(instance->spi, false);
     // See avr datasheets, chapter "SERIAL_PRG Programming Algorithm":
 
     // Pulse RESET after PIN_SCK is low:
-    avr_isp_spi_sw_sck_set(instance->spi, false);
+    avr_isp_spi_sck_set(instance->spi, false);
 
     // discharge PIN_SCK, value arbitrally chosen
     furi_delay_ms(20);
-    avr_isp_spi_sw_res_set(instance->spi, true);
+    avr_isp_spi_res_set(instance->spi, true);
 
     // Pulse must be minimum 2 target CPU speed cycles
     // so 100 usec is ok for CPU speeds above 20KHz
     furi_delay_ms(1);
 
-    avr_isp_spi_sw_res_set(instance->spi, false);
+    avr_isp_spi_res_set(instance->spi, false);
 
     // Send the enable programming command:
     // datasheet: must be > 20 msec
     furi_delay_ms(50);
     if(avr_isp_set_pmode(instance, AVR_ISP_SET_PMODE)) {
         instance->pmode = true;
+        instance->eeprom_byte_mode = false;
         return true;
     }
     return false;
@@ -116,20 +112,9 @@ static bool avr_isp_start_pmode(AvrIsp* instance, AvrIspSpiSwSpeed spi_speed) {
 bool avr_isp_auto_set_spi_speed_start_pmode(AvrIsp* instance) {
     furi_assert(instance);
 
-    AvrIspSpiSwSpeed spi_speed[] = {
-        AvrIspSpiSwSpeed1Mhz,
-        AvrIspSpiSwSpeed400Khz,
-        AvrIspSpiSwSpeed250Khz,
-        AvrIspSpiSwSpeed125Khz,
-        AvrIspSpiSwSpeed60Khz,
-        AvrIspSpiSwSpeed40Khz,
-        AvrIspSpiSwSpeed20Khz,
-        AvrIspSpiSwSpeed10Khz,
-        AvrIspSpiSwSpeed5Khz,
-        AvrIspSpiSwSpeed1Khz,
-    };
-    for(uint8_t i = 0; i < COUNT_OF(spi_speed); i++) {
-        if(avr_isp_start_pmode(instance, spi_speed[i])) {
+    // SPI1 speeds are probed first, the software SPI takes over below 250KHz
+    for(AvrIspSpiSpeed i = 0; i < AvrIspSpiSpeedCount; i++) {
+        if(avr_isp_start_pmode(instance, i)) {
             AvrIspSignature sig = avr_isp_read_signature(instance);
             AvrIspSignature sig_examination = avr_isp_read_signature(instance); //-V656
             uint8_t y = 0;
@@ -141,12 +126,12 @@ bool avr_isp_auto_set_spi_speed_start_pmode(AvrIsp* instance) {
                 y++;
             }
             if(y == 8) {
-                if(spi_speed[i] > AvrIspSpiSwSpeed1Mhz) {
-                    if(i < (COUNT_OF(spi_speed) - 1)) {
-                        avr_isp_end_pmode(instance);
-                        i++;
-                        return avr_isp_start_pmode(instance, spi_speed[i]);
-                    }
+                // One step slower for margin, even at 2MHz: that is fck/4 of an 8MHz target
+                if(i < (AvrIspSpiSpeedCount - 1)) {
+                    avr_isp_end_pmode(instance);
+                    i++;
+                    if(avr_isp_start_pmode(instance, i)) return true;
+                    break;
                 }
                 return true;
             }
@@ -154,7 +139,7 @@ bool avr_isp_auto_set_spi_speed_start_pmode(AvrIsp* instance) {
     }
 
     if(instance->spi) {
-        avr_isp_spi_sw_free(instance->spi);
+        avr_isp_spi_free(instance->spi);
         instance->spi = NULL;
     }
 
@@ -214,18 +199,19 @@ static bool avr_isp_flash_write_pages(
     furi_assert(instance);
 
     size_t x = 0;
-    uint16_t page = avr_isp_current_page(instance, addr, page_size);
-
     while(x < data_size) {
-        if(page != avr_isp_current_page(instance, addr, page_size)) {
-            avr_isp_commit(instance, page, data[x - 1]);
-            page = avr_isp_current_page(instance, addr, page_size);
+        // Load everything up to the page boundary at once, then commit the page
+        uint16_t page = avr_isp_current_page(instance, addr, page_size);
+        size_t size = 0;
+        while((x + size < data_size) &&
+              (avr_isp_current_page(instance, addr + size / 2, page_size) == page)) {
+            size += 2;
         }
-        avr_isp_spi_transaction(instance, AVR_ISP_WRITE_FLASH_LO(addr, data[x++]));
-        avr_isp_spi_transaction(instance, AVR_ISP_WRITE_FLASH_HI(addr, data[x++]));
-        addr++;
+        avr_isp_page_flash_load(instance->spi, addr, &data[x], size);
+        x += size;
+        addr += size / 2;
+        avr_isp_commit(instance, page, data[x - 1]);
     }
-    avr_isp_commit(instance, page, data[x - 1]);
     return true;
 }
 
@@ -243,16 +229,39 @@ bool avr_isp_erase_chip(AvrIsp* instance) {
     return ret;
 }
 
-static bool
-    avr_isp_eeprom_write(AvrIsp* instance, uint16_t addr, uint8_t* data, uint32_t data_size) {
+static bool avr_isp_eeprom_write(
+    AvrIsp* instance,
+    uint16_t addr,
+    uint16_t page_size,
+    uint8_t* data,
+    uint32_t data_size) {
     furi_assert(instance);
 
-    for(uint16_t i = 0; i < data_size; i++) {
-        avr_isp_spi_transaction(instance, AVR_ISP_WRITE_EEPROM(addr, data[i]));
-        furi_delay_ms(10);
-        addr++;
+    // EEPROM page size from the chip database, 0 and -1 mean no pages or unknown
+    bool page_mode = !instance->eeprom_byte_mode && (page_size > 1) && (page_size <= 64) &&
+                     ((page_size & (page_size - 1)) == 0);
+    if(!page_mode) {
+        return avr_isp_page_eeprom_write_bytes(instance->spi, addr, data, data_size);
     }
-    return true;
+
+    bool ret = true;
+    size_t x = 0;
+    while(x < data_size) {
+        size_t size = MIN(data_size - x, (size_t)(page_size - (addr & (page_size - 1))));
+        if(!instance->eeprom_byte_mode &&
+           !avr_isp_page_eeprom_write(instance->spi, addr, page_size, &data[x], size)) {
+            // Older parts list EEPROM pages but only have the C0h byte write
+            FURI_LOG_W(TAG, "EEPROM page write failed, switching to byte mode");
+            instance->eeprom_byte_mode = true;
+        }
+        if(instance->eeprom_byte_mode &&
+           !avr_isp_page_eeprom_write_bytes(instance->spi, addr, &data[x], size)) {
+            ret = false;
+        }
+        x += size;
+        addr += size;
+    }
+    return ret;
 }
 
 bool avr_isp_write_page(
@@ -275,7 +284,7 @@ bool avr_isp_write_page(
 
     case STK_SET_EEPROM_TYPE:
         if((addr + data_size) <= mem_size) {
-            ret = avr_isp_eeprom_write(instance, addr, data, data_size);
+            ret = avr_isp_eeprom_write(instance, addr, page_size, data, data_size);
         }
         break;
 
@@ -296,11 +305,7 @@ static bool avr_isp_flash_read_page(
     furi_assert(instance);
 
     if(page_size > data_size) return false;
-    for(uint16_t i = 0; i < page_size; i += 2) {
-        data[i] = avr_isp_spi_transaction(instance, AVR_ISP_READ_FLASH_LO(addr));
-        data[i + 1] = avr_isp_spi_transaction(instance, AVR_ISP_READ_FLASH_HI(addr));
-        addr++;
-    }
+    avr_isp_page_flash_read(instance->spi, addr, data, page_size);
     return true;
 }
 
@@ -313,10 +318,7 @@ static bool avr_isp_eeprom_read_page(
     furi_assert(instance);
 
     if(page_size > data_size) return false;
-    for(uint16_t i = 0; i < page_size; i++) {
-        data[i] = avr_isp_spi_transaction(instance, AVR_ISP_READ_EEPROM(addr));
-        addr++;
-    }
+    avr_isp_page_eeprom_read(instance->spi, addr, data, page_size);
     return true;
 }
 
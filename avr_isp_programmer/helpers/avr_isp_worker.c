@@ -129,6 +129,8 @@ static int32_t avr_isp_worker_prog_thread(void* context) {
         if(furi_thread_flags_get() & AvrIspWorkerEvtStop) break;
         avr_isp_prog_avrisp(prog);
     }
+    // The SPI bus is held by this thread while the target is in programming mode
+    avr_isp_prog_stop(prog);
     FURI_LOG_D(TAG, "AvrIspProgWorker Stop");
     return 0;
 }
@@ -0,0 +1,130 @@
+#include "avr_isp_page.h"
+#include "avr_isp_prog_cmd.h"
+
+#include <furi.h>
+
+#define TAG "AvrIspPage"
+
+#define AVR_ISP_PAGE_CHUNK 32
+#define AVR_ISP_PAGE_TIMEOUT 30
+// Written byte is 0xFF, polling can't tell when it is done
+#define AVR_ISP_PAGE_EEPROM_DELAY 10
+
+void avr_isp_page_flash_load(AvrIspSpi* spi, uint16_t addr, const uint8_t* data, size_t size) {
+    furi_assert(spi);
+
+    for(size_t i = 0; i < size; i += 2) {
+        if(avr_isp_spi_stream_is_full(spi)) avr_isp_spi_stream_flush(spi, NULL);
+        avr_isp_spi_stream_add(spi, AVR_ISP_WRITE_FLASH_LO(addr, data[i]));
+        avr_isp_spi_stream_add(spi, AVR_ISP_WRITE_FLASH_HI(addr, data[i + 1]));
+        addr++;
+    }
+    avr_isp_spi_stream_flush(spi, NULL);
+}
+
+void avr_isp_page_flash_read(AvrIspSpi* spi, uint16_t addr, uint8_t* data, size_t size) {
+    furi_assert(spi);
+
+    size_t x = 0;
+    for(size_t i = 0; i < size; i += 2) {
+        if(avr_isp_spi_stream_is_full(spi)) x += avr_isp_spi_stream_flush(spi, &data[x]);
+        avr_isp_spi_stream_add(spi, AVR_ISP_READ_FLASH_LO(addr));
+        avr_isp_spi_stream_add(spi, AVR_ISP_READ_FLASH_HI(addr));
+        addr++;
+    }
+    avr_isp_spi_stream_flush(spi, &data[x]);
+}
+
+void avr_isp_page_eeprom_read(AvrIspSpi* spi, uint16_t addr, uint8_t* data, size_t size) {
+    furi_assert(spi);
+
+    size_t x = 0;
+    for(size_t i = 0; i < size; i++) {
+        if(avr_isp_spi_stream_is_full(spi)) x += avr_isp_spi_stream_flush(spi, &data[x]);
+        avr_isp_spi_stream_add(spi, AVR_ISP_READ_EEPROM(addr));
+        addr++;
+    }
+    avr_isp_spi_stream_flush(spi, &data[x]);
+}
+
+static bool avr_isp_page_eeprom_verify(
+    AvrIspSpi* spi,
+    uint16_t addr,
+    const uint8_t* data,
+    size_t size) {
+    uint8_t current[AVR_ISP_PAGE_CHUNK];
+    for(size_t x = 0; x < size; x += AVR_ISP_PAGE_CHUNK) {
+        size_t chunk = MIN(size - x, (size_t)AVR_ISP_PAGE_CHUNK);
+        avr_isp_page_eeprom_read(spi, addr + x, current, chunk);
+        if(memcmp(current, &data[x], chunk) != 0) return false;
+    }
+    return true;
+}
+
+bool avr_isp_page_eeprom_write(
+    AvrIspSpi* spi,
+    uint16_t addr,
+    uint16_t page_size,
+    const uint8_t* data,
+    size_t size) {
+    furi_assert(spi);
+    // Loads and the page write go out as one transfer
+    furi_check(size < AVR_ISP_SPI_STREAM_SIZE / 4);
+
+    for(size_t i = 0; i < size; i++) {
+        uint16_t byte_addr = addr + i;
+        avr_isp_spi_stream_add(spi, AVR_ISP_LOAD_EEPROM_PAGE(byte_addr, page_size, data[i]));
+    }
+    avr_isp_spi_stream_add(spi, AVR_ISP_WRITE_EEPROM_PAGE(addr));
+    avr_isp_spi_stream_flush(spi, NULL);
+
+    /* polling ready */
+    uint32_t starttime = furi_get_tick();
+    while((furi_get_tick() - starttime) < AVR_ISP_PAGE_TIMEOUT) {
+        if(!(avr_isp_spi_instruction(spi, AVR_ISP_POLL_READY) & 0x01)) break;
+    }
+
+    // Parts without page mode ignore C1h/C2h, the old data reads back
+    return avr_isp_page_eeprom_verify(spi, addr, data, size);
+}
+
+bool avr_isp_page_eeprom_write_bytes(
+    AvrIspSpi* spi,
+    uint16_t addr,
+    const uint8_t* data,
+    size_t size) {
+    furi_assert(spi);
+
+    bool ret = true;
+    uint8_t current[AVR_ISP_PAGE_CHUNK];
+    for(size_t x = 0; x < size; x += AVR_ISP_PAGE_CHUNK) {
+        size_t chunk = MIN(size - x, (size_t)AVR_ISP_PAGE_CHUNK);
+        avr_isp_page_eeprom_read(spi, addr + x, current, chunk);
+
+        for(size_t i = 0; i < chunk; i++) {
+            if(current[i] == data[x + i]) continue;
+
+            uint16_t byte_addr = addr + x + i;
+            avr_isp_spi_instruction(spi, AVR_ISP_WRITE_EEPROM(byte_addr, data[x + i]));
+            if(data[x + i] == 0xFF) {
+                furi_delay_ms(AVR_ISP_PAGE_EEPROM_DELAY);
+            } else {
+                /* polling eeprom */
+                bool done = false;
+                uint32_t starttime = furi_get_tick();
+                while((furi_get_tick() - starttime) < AVR_ISP_PAGE_TIMEOUT) {
+                    if(avr_isp_spi_instruction(spi, AVR_ISP_READ_EEPROM(byte_addr)) ==
+                       data[x + i]) {
+                        done = true;
+                        break;
+                    }
+                }
+                if(!done) {
+                    FURI_LOG_E(TAG, "EEPROM write timeout, addr 0x%04X", byte_addr);
+                    ret = false;
+                }
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "avr_isp_spi.h"
+
+// Page-level instruction streams, a whole page of LOAD/READ instructions goes out at once.
+// Flash addresses are word addresses, EEPROM addresses are byte addresses, sizes are in bytes.
+
+void avr_isp_page_flash_load(AvrIspSpi* spi, uint16_t addr, const uint8_t* data, size_t size);
+
+void avr_isp_page_flash_read(AvrIspSpi* spi, uint16_t addr, uint8_t* data, size_t size);
+
+void avr_isp_page_eeprom_read(AvrIspSpi* spi, uint16_t addr, uint8_t* data, size_t size);
+
+// Page mode: C1h loads and one C2h write, false if the page does not read back
+bool avr_isp_page_eeprom_write(
+    AvrIspSpi* spi,
+    uint16_t addr,
+    uint16_t page_size,
+    const uint8_t* data,
+    size_t size);
+
+// Byte mode: only bytes that differ are written, each one is polled until it reads back
+bool avr_isp_page_eeprom_write_bytes(
+    AvrIspSpi* spi,
+    uint16_t addr,
+    const uint8_t* data,
+    size_t size);
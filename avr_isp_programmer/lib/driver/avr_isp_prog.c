@@ -1,5 +1,6 @@
 #include "avr_isp_prog.h"
 #include "avr_isp_prog_cmd.h"
+#include "avr_isp_page.h"
 
 #include <furi.h>
 
@@ -33,7 +34,7 @@ struct AvrIspProgCfgDevice {
 typedef struct AvrIspProgCfgDevice AvrIspProgCfgDevice;
 
 struct AvrIspProg {
-    AvrIspSpiSw* spi;
+    AvrIspSpi* spi;
     AvrIspProgCfgDevice* cfg;
     FuriStreamBuffer* stream_rx;
     FuriStreamBuffer* stream_tx;
@@ -65,7 +66,8 @@ AvrIspProg* avr_isp_prog_init(void) {
 
 void avr_isp_prog_free(AvrIspProg* instance) {
     furi_assert(instance);
-    if(instance->spi) avr_isp_prog_end_pmode(instance);
+    // The SPI bus belongs to the thread that ran the session, see avr_isp_prog_stop()
+    furi_check(!instance->spi);
     furi_stream_buffer_free(instance->stream_tx);
     furi_stream_buffer_free(instance->stream_rx);
     free(instance->cfg);
@@ -94,6 +96,11 @@ void avr_isp_prog_exit(AvrIspProg* instance) {
     instance->exit = true;
 }
 
+void avr_isp_prog_stop(AvrIspProg* instance) {
+    furi_assert(instance);
+    avr_isp_prog_end_pmode(instance);
+}
+
 void avr_isp_prog_set_tx_callback(AvrIspProg* instance, AvrIspProgCallback callback, void* context) {
     furi_assert(instance);
     furi_assert(context);
@@ -124,21 +131,7 @@ static void avr_isp_prog_fill(AvrIspProg* instance, size_t len) {
 
 static void avr_isp_prog_reset_target(AvrIspProg* instance, bool reset) {
     furi_assert(instance);
-    avr_isp_spi_sw_res_set(instance->spi, (reset == instance->rst_active_high) ? true : false);
-}
-
-static uint8_t avr_isp_prog_spi_transaction(
-    AvrIspProg* instance,
-    uint8_t cmd,
-    uint8_t addr_hi,
-    uint8_t addr_lo,
-    uint8_t data) {
-    furi_assert(instance);
-
-    avr_isp_spi_sw_txrx(instance->spi, cmd);
-    avr_isp_spi_sw_txrx(instance->spi, addr_hi);
-    avr_isp_spi_sw_txrx(instance->spi, addr_lo);
-    return avr_isp_spi_sw_txrx(instance->spi, data);
+    avr_isp_spi_res_set(instance->spi, (reset == instance->rst_active_high) ? true : false);
 }
 
 static void avr_isp_prog_empty_reply(AvrIspProg* instance) {
@@ -209,12 +202,9 @@ static void avr_isp_prog_set_cfg(AvrIspProg* instance) {
 static bool
     avr_isp_prog_set_pmode(AvrIspProg* instance, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
     furi_assert(instance);
-    uint8_t res = 0;
-    avr_isp_spi_sw_txrx(instance->spi, a);
-    avr_isp_spi_sw_txrx(instance->spi, b);
-    res = avr_isp_spi_sw_txrx(instance->spi, c);
-    avr_isp_spi_sw_txrx(instance->spi, d);
-    return res == 0x53;
+    uint8_t buf[] = {a, b, c, d};
+    avr_isp_spi_trx(instance->spi, buf, buf, sizeof(buf));
+    return buf[2] == 0x53;
 }
 
 static void avr_isp_prog_end_pmode(AvrIspProg* instance) {
@@ -224,14 +214,14 @@ static void avr_isp_prog_end_pmode(AvrIspProg* instance) {
         // We're about to take the target out of reset
         // so configure SPI pins as input
 
-        if(instance->spi) avr_isp_spi_sw_free(instance->spi);
+        if(instance->spi) avr_isp_spi_free(instance->spi);
         instance->spi = NULL;
     }
 
     instance->pmode = false;
 }
 
-static bool avr_isp_prog_start_pmode(AvrIspProg* instance, AvrIspSpiSwSpeed spi_speed) {
+static bool avr_isp_prog_start_pmode(AvrIspProg* instance, AvrIspSpiSpeed spi_speed) {
     furi_assert(instance);
     // Reset target before driving PIN_SCK or PIN_MOSI
 
@@ -241,14 +231,14 @@ static bool avr_isp_prog_start_pmode(AvrIspProg* instance, AvrIspSpiSwSpeed spi_
     // which for many arduino's is not the SS pin.
     // So we have to configure RESET as output here,
     // (reset_target() first sets the correct level)
-    if(instance->spi) avr_isp_spi_sw_free(instance->spi);
-    instance->spi = avr_isp_spi_sw_init(spi_speed);
+    if(instance->spi) avr_isp_spi_free(instance->spi);
+    instance->spi = avr_isp_spi_init(spi_speed);
 
     avr_isp_prog_reset_target(instance, true);
     // See avr datasheets, chapter "SERIAL_PRG Programming Algorithm":
 
     // Pulse RESET after PIN_SCK is low:
-    avr_isp_spi_sw_sck_set(instance->spi, false);
+    avr_isp_spi_sck_set(instance->spi, false);
 
     // discharge PIN_SCK, value arbitrally chosen
     furi_delay_ms(20);
@@ -273,27 +263,16 @@ static bool avr_isp_prog_start_pmode(AvrIspProg* instance, AvrIspSpiSwSpeed spi_
 static AvrIspProgSignature avr_isp_prog_check_signature(AvrIspProg* instance) {
     furi_assert(instance);
     AvrIspProgSignature signature;
-    signature.vendor = avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_VENDOR);
-    signature.part_family = avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_PART_FAMILY);
-    signature.part_number = avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_PART_NUMBER);
+    signature.vendor = avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_VENDOR);
+    signature.part_family = avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_PART_FAMILY);
+    signature.part_number = avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_PART_NUMBER);
     return signature;
 }
 
 static bool avr_isp_prog_auto_set_spi_speed_start_pmode(AvrIspProg* instance) {
-    AvrIspSpiSwSpeed spi_speed[] = {
-        AvrIspSpiSwSpeed1Mhz,
-        AvrIspSpiSwSpeed400Khz,
-        AvrIspSpiSwSpeed250Khz,
-        AvrIspSpiSwSpeed125Khz,
-        AvrIspSpiSwSpeed60Khz,
-        AvrIspSpiSwSpeed40Khz,
-        AvrIspSpiSwSpeed20Khz,
-        AvrIspSpiSwSpeed10Khz,
-        AvrIspSpiSwSpeed5Khz,
-        AvrIspSpiSwSpeed1Khz,
-    };
-    for(uint8_t i = 0; i < COUNT_OF(spi_speed); i++) {
-        if(avr_isp_prog_start_pmode(instance, spi_speed[i])) {
+    // SPI1 speeds are probed first, the software SPI takes over below 250KHz
+    for(AvrIspSpiSpeed i = 0; i < AvrIspSpiSpeedCount; i++) {
+        if(avr_isp_prog_start_pmode(instance, i)) {
             AvrIspProgSignature sig = avr_isp_prog_check_signature(instance);
             AvrIspProgSignature sig_examination = avr_isp_prog_check_signature(instance); //-V656
             uint8_t y = 0;
@@ -306,12 +285,12 @@ static bool avr_isp_prog_auto_set_spi_speed_start_pmode(AvrIspProg* instance) {
                 y++;
             }
             if(y == 8) {
-                if(spi_speed[i] > AvrIspSpiSwSpeed1Mhz) {
-                    if(i < (COUNT_OF(spi_speed) - 1)) {
-                        avr_isp_prog_end_pmode(instance);
-                        i++;
-                        return avr_isp_prog_start_pmode(instance, spi_speed[i]);
-                    }
+                // One step slower for margin, even at 2MHz: that is fck/4 of an 8MHz target
+                if(i < (AvrIspSpiSpeedCount - 1)) {
+                    avr_isp_prog_end_pmode(instance);
+                    i++;
+                    if(avr_isp_prog_start_pmode(instance, i)) return true;
+                    break;
                 }
                 return true;
             }
@@ -319,7 +298,7 @@ static bool avr_isp_prog_auto_set_spi_speed_start_pmode(AvrIspProg* instance) {
     }
 
     if(instance->spi) {
-        avr_isp_spi_sw_free(instance->spi);
+        avr_isp_spi_free(instance->spi);
         instance->spi = NULL;
     }
 
@@ -331,14 +310,14 @@ static void avr_isp_prog_universal(AvrIspProg* instance) {
     uint8_t data;
 
     avr_isp_prog_fill(instance, 4);
-    data = avr_isp_prog_spi_transaction(
-        instance, instance->buff[0], instance->buff[1], instance->buff[2], instance->buff[3]);
+    data = avr_isp_spi_instruction(
+        instance->spi, instance->buff[0], instance->buff[1], instance->buff[2], instance->buff[3]);
     avr_isp_prog_breply(instance, data);
 }
 
 static void avr_isp_prog_commit(AvrIspProg* instance, uint16_t addr, uint8_t data) {
     furi_assert(instance);
-    avr_isp_prog_spi_transaction(instance, AVR_ISP_COMMIT(addr));
+    avr_isp_spi_instruction(instance->spi, AVR_ISP_COMMIT(addr));
     /* polling flash */
     if(data == 0xFF) {
         furi_delay_ms(5);
@@ -346,7 +325,7 @@ static void avr_isp_prog_commit(AvrIspProg* instance, uint16_t addr, uint8_t dat
         /* polling flash */
         uint32_t starttime = furi_get_tick();
         while((furi_get_tick() - starttime) < 30) {
-            if(avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_FLASH_HI(addr)) != 0xFF) {
+            if(avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_FLASH_HI(addr)) != 0xFF) {
                 break;
             };
         }
@@ -381,22 +360,19 @@ static uint16_t avr_isp_prog_current_page(AvrIspProg* instance) {
 static uint8_t avr_isp_prog_write_flash_pages(AvrIspProg* instance, size_t length) {
     furi_assert(instance);
     size_t x = 0;
-    uint16_t page = avr_isp_prog_current_page(instance);
     while(x < length) {
-        if(page != avr_isp_prog_current_page(instance)) {
-            --x;
-            avr_isp_prog_commit(instance, page, instance->buff[x++]);
-            page = avr_isp_prog_current_page(instance);
+        // Load everything up to the page boundary at once, then commit the page
+        uint16_t page = avr_isp_prog_current_page(instance);
+        uint16_t addr = instance->addr;
+        size_t size = 0;
+        while((x + size < length) && (avr_isp_prog_current_page(instance) == page)) {
+            size += 2;
+            instance->addr++;
         }
-        avr_isp_prog_spi_transaction(
-            instance, AVR_ISP_WRITE_FLASH_LO(instance->addr, instance->buff[x++]));
-
-        avr_isp_prog_spi_transaction(
-            instance, AVR_ISP_WRITE_FLASH_HI(instance->addr, instance->buff[x++]));
-        instance->addr++;
+        avr_isp_page_flash_load(instance->spi, addr, &instance->buff[x], size);
+        x += size;
+        avr_isp_prog_commit(instance, page, instance->buff[x - 1]);
     }
-
-    avr_isp_prog_commit(instance, page, instance->buff[--x]);
     return STK_OK;
 }
 
@@ -416,13 +392,13 @@ static void avr_isp_prog_write_flash(AvrIspProg* instance, size_t length) {
 static uint8_t
     avr_isp_prog_write_eeprom_chunk(AvrIspProg* instance, uint16_t start, uint16_t length) {
     furi_assert(instance);
-    // this writes byte-by-byte,
-    // page writing may be faster (4 bytes at a time)
+    // this writes byte-by-byte, the STK500 device parameters don't tell
+    // whether the part has EEPROM page mode. Unchanged bytes are skipped
+    // and written ones are polled instead of waiting a fixed 10ms.
     avr_isp_prog_fill(instance, length);
-    for(uint16_t x = 0; x < length; x++) {
-        uint16_t addr = start + x;
-        avr_isp_prog_spi_transaction(instance, AVR_ISP_WRITE_EEPROM(addr, instance->buff[x]));
-        furi_delay_ms(10);
+    if(!avr_isp_page_eeprom_write_bytes(instance->spi, start, instance->buff, length)) {
+        instance->error++;
+        return STK_FAILED;
     }
     return STK_OK;
 }
@@ -436,13 +412,19 @@ static uint8_t avr_isp_prog_write_eeprom(AvrIspProg* instance, size_t length) {
         instance->error++;
         return STK_FAILED;
     }
+    // A failed chunk fails the command, the rest of the data is still read to stay in sync
+    uint8_t result = STK_OK;
     while(remaining > AVR_ISP_EECHUNK) {
-        avr_isp_prog_write_eeprom_chunk(instance, start, AVR_ISP_EECHUNK);
+        if(avr_isp_prog_write_eeprom_chunk(instance, start, AVR_ISP_EECHUNK) != STK_OK) {
+            result = STK_FAILED;
+        }
         start += AVR_ISP_EECHUNK;
         remaining -= AVR_ISP_EECHUNK;
     }
-    avr_isp_prog_write_eeprom_chunk(instance, start, remaining);
-    return STK_OK;
+    if(avr_isp_prog_write_eeprom_chunk(instance, start, remaining) != STK_OK) {
+        result = STK_FAILED;
+    }
+    return result;
 }
 
 static void avr_isp_prog_program_page(AvrIspProg* instance) {
@@ -473,14 +455,11 @@ static void avr_isp_prog_program_page(AvrIspProg* instance) {
 
 static uint8_t avr_isp_prog_flash_read_page(AvrIspProg* instance, uint16_t length) {
     furi_assert(instance);
-    for(uint16_t x = 0; x < length; x += 2) {
-        avr_isp_prog_tx_ch(
-            instance,
-            avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_FLASH_LO(instance->addr)));
-        avr_isp_prog_tx_ch(
-            instance,
-            avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_FLASH_HI(instance->addr)));
-        instance->addr++;
+    if(length > AVR_ISP_PROG_TX_RX_BUF_SIZE) return STK_FAILED;
+    avr_isp_page_flash_read(instance->spi, instance->addr, instance->buff, length);
+    instance->addr += length / 2;
+    for(uint16_t x = 0; x < length; x++) {
+        avr_isp_prog_tx_ch(instance, instance->buff[x]);
     }
     return STK_OK;
 }
@@ -489,10 +468,10 @@ static uint8_t avr_isp_prog_eeprom_read_page(AvrIspProg* instance, uint16_t leng
     furi_assert(instance);
     // here again we have a word address
     uint16_t start = instance->addr * 2;
+    if(length > AVR_ISP_PROG_TX_RX_BUF_SIZE) return STK_FAILED;
+    avr_isp_page_eeprom_read(instance->spi, start, instance->buff, length);
     for(uint16_t x = 0; x < length; x++) {
-        uint16_t addr = start + x;
-        avr_isp_prog_tx_ch(
-            instance, avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_EEPROM(addr)));
+        avr_isp_prog_tx_ch(instance, instance->buff[x]);
     }
     return STK_OK;
 }
@@ -522,9 +501,9 @@ static void avr_isp_prog_read_signature(AvrIspProg* instance) {
     }
     avr_isp_prog_tx_ch(instance, STK_INSYNC);
 
-    avr_isp_prog_tx_ch(instance, avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_VENDOR));
-    avr_isp_prog_tx_ch(instance, avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_PART_FAMILY));
-    avr_isp_prog_tx_ch(instance, avr_isp_prog_spi_transaction(instance, AVR_ISP_READ_PART_NUMBER));
+    avr_isp_prog_tx_ch(instance, avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_VENDOR));
+    avr_isp_prog_tx_ch(instance, avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_PART_FAMILY));
+    avr_isp_prog_tx_ch(instance, avr_isp_spi_instruction(instance->spi, AVR_ISP_READ_PART_NUMBER));
 
     avr_isp_prog_tx_ch(instance, STK_OK);
 }
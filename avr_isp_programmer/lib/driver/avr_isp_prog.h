@@ -1,6 +1,6 @@
 #pragma once
 
-#include "avr_isp_spi_sw.h"
+#include "avr_isp_spi.h"
 #include <furi_hal.h>
 
 typedef struct AvrIspProg AvrIspProg;
@@ -13,4 +13,6 @@ bool avr_isp_prog_rx(AvrIspProg* instance, uint8_t* data, size_t len);
 size_t avr_isp_prog_tx(AvrIspProg* instance, uint8_t* data, size_t max_len);
 void avr_isp_prog_avrisp(AvrIspProg* instance);
 void avr_isp_prog_exit(AvrIspProg* instance);
+// Leaves programming mode, must run on the thread that ran avr_isp_prog_avrisp()
+void avr_isp_prog_stop(AvrIspProg* instance);
 void avr_isp_prog_set_tx_callback(AvrIspProg* instance, AvrIspProgCallback callback, void* context);
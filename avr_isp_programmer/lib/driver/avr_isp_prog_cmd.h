@@ -26,6 +26,11 @@
 #define AVR_ISP_WRITE_EEPROM(add, data) \
     0xC0, (add >> 8) & 0xFF, add & 0xFF, data //Send cmd, Wait N ms
 #define AVR_ISP_READ_EEPROM(add) 0xA0, (add >> 8) & 0xFF, add & 0xFF, 0xFF
+#define AVR_ISP_LOAD_EEPROM_PAGE(add, page_size, data) \
+    0xC1, 0x00, add & (page_size - 1), data //Only the offset within the page
+#define AVR_ISP_WRITE_EEPROM_PAGE(add) \
+    0xC2, (add >> 8) & 0xFF, add & 0xFF, 0x00 //Send cmd, polling ready
+#define AVR_ISP_POLL_READY 0xF0, 0x00, 0x00, 0x00 //Bit 0 of the answer is busy
 
 #define AVR_ISP_COMMIT(add) \
     0x4C, (add >> 8) & 0xFF, add & 0xFF, 0x00 //Send cmd, polling read last addr page
@@ -0,0 +1,129 @@
+#include "avr_isp_spi.h"
+
+#include <furi.h>
+
+struct AvrIspSpi {
+    AvrIspSpiHw* hw;
+    AvrIspSpiSw* sw;
+    uint8_t stream[AVR_ISP_SPI_STREAM_SIZE];
+    size_t stream_len;
+};
+
+static const AvrIspSpiHwSpeed avr_isp_spi_hw_speed[] = {
+    [AvrIspSpiSpeedHw2Mhz] = AvrIspSpiHwSpeed2Mhz,
+    [AvrIspSpiSpeedHw1Mhz] = AvrIspSpiHwSpeed1Mhz,
+    [AvrIspSpiSpeedHw500Khz] = AvrIspSpiHwSpeed500Khz,
+    [AvrIspSpiSpeedHw250Khz] = AvrIspSpiHwSpeed250Khz,
+};
+
+static const AvrIspSpiSwSpeed avr_isp_spi_sw_speed[] = {
+    [AvrIspSpiSpeedSw125Khz] = AvrIspSpiSwSpeed125Khz,
+    [AvrIspSpiSpeedSw60Khz] = AvrIspSpiSwSpeed60Khz,
+    [AvrIspSpiSpeedSw40Khz] = AvrIspSpiSwSpeed40Khz,
+    [AvrIspSpiSpeedSw20Khz] = AvrIspSpiSwSpeed20Khz,
+    [AvrIspSpiSpeedSw10Khz] = AvrIspSpiSwSpeed10Khz,
+    [AvrIspSpiSpeedSw5Khz] = AvrIspSpiSwSpeed5Khz,
+    [AvrIspSpiSpeedSw1Khz] = AvrIspSpiSwSpeed1Khz,
+};
+
+AvrIspSpi* avr_isp_spi_init(AvrIspSpiSpeed speed) {
+    furi_assert(speed < AvrIspSpiSpeedCount);
+    AvrIspSpi* instance = malloc(sizeof(AvrIspSpi));
+    if(speed < COUNT_OF(avr_isp_spi_hw_speed)) {
+        instance->hw = avr_isp_spi_hw_init(avr_isp_spi_hw_speed[speed]);
+    } else {
+        instance->sw = avr_isp_spi_sw_init(avr_isp_spi_sw_speed[speed]);
+    }
+    return instance;
+}
+
+void avr_isp_spi_free(AvrIspSpi* instance) {
+    furi_assert(instance);
+    if(instance->hw) avr_isp_spi_hw_free(instance->hw);
+    if(instance->sw) avr_isp_spi_sw_free(instance->sw);
+    free(instance);
+}
+
+uint8_t avr_isp_spi_txrx(AvrIspSpi* instance, uint8_t data) {
+    furi_assert(instance);
+    if(instance->hw) return avr_isp_spi_hw_txrx(instance->hw, data);
+    return avr_isp_spi_sw_txrx(instance->sw, data);
+}
+
+void avr_isp_spi_trx(AvrIspSpi* instance, const uint8_t* tx, uint8_t* rx, size_t size) {
+    furi_assert(instance);
+    if(instance->hw) {
+        avr_isp_spi_hw_trx(instance->hw, tx, rx, size);
+    } else {
+        for(size_t i = 0; i < size; i++) {
+            rx[i] = avr_isp_spi_sw_txrx(instance->sw, tx[i]);
+        }
+    }
+}
+
+void avr_isp_spi_res_set(AvrIspSpi* instance, bool state) {
+    furi_assert(instance);
+    if(instance->hw) {
+        avr_isp_spi_hw_res_set(instance->hw, state);
+    } else {
+        avr_isp_spi_sw_res_set(instance->sw, state);
+    }
+}
+
+void avr_isp_spi_sck_set(AvrIspSpi* instance, bool state) {
+    furi_assert(instance);
+    if(instance->hw) {
+        avr_isp_spi_hw_sck_set(instance->hw, state);
+    } else {
+        avr_isp_spi_sw_sck_set(instance->sw, state);
+    }
+}
+
+uint8_t avr_isp_spi_instruction(
+    AvrIspSpi* instance,
+    uint8_t cmd,
+    uint8_t addr_hi,
+    uint8_t addr_lo,
+    uint8_t data) {
+    furi_assert(instance);
+
+    uint8_t buf[] = {cmd, addr_hi, addr_lo, data};
+    avr_isp_spi_trx(instance, buf, buf, sizeof(buf));
+    return buf[3];
+}
+
+void avr_isp_spi_stream_add(
+    AvrIspSpi* instance,
+    uint8_t cmd,
+    uint8_t addr_hi,
+    uint8_t addr_lo,
+    uint8_t data) {
+    furi_assert(instance);
+    furi_check(!avr_isp_spi_stream_is_full(instance));
+
+    instance->stream[instance->stream_len++] = cmd;
+    instance->stream[instance->stream_len++] = addr_hi;
+    instance->stream[instance->stream_len++] = addr_lo;
+    instance->stream[instance->stream_len++] = data;
+}
+
+bool avr_isp_spi_stream_is_full(AvrIspSpi* instance) {
+    furi_assert(instance);
+    return instance->stream_len == AVR_ISP_SPI_STREAM_SIZE;
+}
+
+size_t avr_isp_spi_stream_flush(AvrIspSpi* instance, uint8_t* data) {
+    furi_assert(instance);
+
+    size_t count = instance->stream_len / 4;
+    if(count == 0) return 0;
+
+    avr_isp_spi_trx(instance, instance->stream, instance->stream, instance->stream_len);
+    if(data) {
+        for(size_t i = 0; i < count; i++) {
+            data[i] = instance->stream[i * 4 + 3];
+        }
+    }
+    instance->stream_len = 0;
+    return count;
+}
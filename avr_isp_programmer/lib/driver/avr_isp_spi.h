@@ -0,0 +1,54 @@
+#pragma once
+
+#include "avr_isp_spi_sw.h"
+#include "avr_isp_spi_hw.h"
+
+// Fastest first, as auto speed detection probes them.
+// SPI1 covers 2MHz-250KHz, the software SPI the slower speeds.
+typedef enum {
+    AvrIspSpiSpeedHw2Mhz = 0,
+    AvrIspSpiSpeedHw1Mhz,
+    AvrIspSpiSpeedHw500Khz,
+    AvrIspSpiSpeedHw250Khz,
+    AvrIspSpiSpeedSw125Khz,
+    AvrIspSpiSpeedSw60Khz,
+    AvrIspSpiSpeedSw40Khz,
+    AvrIspSpiSpeedSw20Khz,
+    AvrIspSpiSpeedSw10Khz,
+    AvrIspSpiSpeedSw5Khz,
+    AvrIspSpiSpeedSw1Khz,
+
+    AvrIspSpiSpeedCount,
+} AvrIspSpiSpeed;
+
+// One 256 byte flash page, one 4-byte instruction per byte
+#define AVR_ISP_SPI_STREAM_SIZE (256 * 4)
+
+typedef struct AvrIspSpi AvrIspSpi;
+
+AvrIspSpi* avr_isp_spi_init(AvrIspSpiSpeed speed);
+void avr_isp_spi_free(AvrIspSpi* instance);
+uint8_t avr_isp_spi_txrx(AvrIspSpi* instance, uint8_t data);
+// Full duplex transfer of several ISP instructions at once, tx and rx may be the same buffer
+void avr_isp_spi_trx(AvrIspSpi* instance, const uint8_t* tx, uint8_t* rx, size_t size);
+void avr_isp_spi_res_set(AvrIspSpi* instance, bool state);
+void avr_isp_spi_sck_set(AvrIspSpi* instance, bool state);
+// Sends one 4-byte ISP instruction, returns the last answer byte
+uint8_t avr_isp_spi_instruction(
+    AvrIspSpi* instance,
+    uint8_t cmd,
+    uint8_t addr_hi,
+    uint8_t addr_lo,
+    uint8_t data);
+
+// Queues an ISP instruction, the queue goes out as one transfer on flush
+void avr_isp_spi_stream_add(
+    AvrIspSpi* instance,
+    uint8_t cmd,
+    uint8_t addr_hi,
+    uint8_t addr_lo,
+    uint8_t data);
+bool avr_isp_spi_stream_is_full(AvrIspSpi* instance);
+// Sends the queue, the last answer byte of every instruction goes to data if it is not NULL.
+// Returns the number of instructions sent.
+size_t avr_isp_spi_stream_flush(AvrIspSpi* instance, uint8_t* data);
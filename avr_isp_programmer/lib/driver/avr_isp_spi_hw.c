@@ -0,0 +1,151 @@
+#include "avr_isp_spi_hw.h"
+
+#include <furi.h>
+#include <furi_hal_spi.h>
+
+#define TAG "AvrIspSpiHw"
+
+#define AVR_ISP_SPI_HW_MISO &gpio_ext_pa6
+#define AVR_ISP_SPI_HW_MOSI &gpio_ext_pa7
+#define AVR_ISP_SPI_HW_SCK &gpio_ext_pb3
+#define AVR_ISP_SPI_HW_CS &gpio_ext_pa4
+#define AVR_ISP_RESET &gpio_ext_pb2
+
+#define AVR_ISP_SPI_HW_TIMEOUT 100
+// Shorter transfers are polled, DMA setup costs more than it saves
+#define AVR_ISP_SPI_HW_DMA_MIN 16
+
+/*
+ * SPI1 on the external header, mode 0, MSB first.
+ * The bus is acquired and configured once, from init to free, which is one
+ * programming mode session. Meanwhile SPI holds SCK low between transfers.
+ * Outside the session SCK and MOSI are driven low as GPIO,
+ * so the target never sees a floating clock. Init and free must run on the same thread.
+ */
+struct AvrIspSpiHw {
+    FuriHalSpiBusHandle handle; // Must be first, the handle callback casts it back
+    LL_SPI_InitTypeDef config;
+    const GpioPin* res;
+};
+
+static const uint32_t avr_isp_spi_hw_prescaler[] = {
+    [AvrIspSpiHwSpeed2Mhz] = LL_SPI_BAUDRATEPRESCALER_DIV32,
+    [AvrIspSpiHwSpeed1Mhz] = LL_SPI_BAUDRATEPRESCALER_DIV64,
+    [AvrIspSpiHwSpeed500Khz] = LL_SPI_BAUDRATEPRESCALER_DIV128,
+    [AvrIspSpiHwSpeed250Khz] = LL_SPI_BAUDRATEPRESCALER_DIV256,
+};
+
+static void avr_isp_spi_hw_set_pin_mode(AvrIspSpiHw* instance, uint32_t mode, uint32_t miso_mode) {
+    LL_GPIO_SetPinMode(instance->handle.sck->port, instance->handle.sck->pin, mode);
+    LL_GPIO_SetPinMode(instance->handle.mosi->port, instance->handle.mosi->pin, mode);
+    LL_GPIO_SetPinMode(instance->handle.miso->port, instance->handle.miso->pin, miso_mode);
+}
+
+static void avr_isp_spi_hw_handle_event_callback(
+    FuriHalSpiBusHandle* handle,
+    FuriHalSpiBusHandleEvent event) {
+    AvrIspSpiHw* instance = (AvrIspSpiHw*)handle;
+    SPI_TypeDef* spi = handle->bus->spi;
+
+    if(event == FuriHalSpiBusHandleEventActivate) {
+        LL_SPI_Init(spi, &instance->config);
+        LL_SPI_SetRxFIFOThreshold(spi, LL_SPI_RX_FIFO_TH_QUARTER);
+        LL_SPI_Enable(spi);
+    } else if(event == FuriHalSpiBusHandleEventDeactivate) {
+        LL_SPI_Disable(spi);
+    }
+}
+
+AvrIspSpiHw* avr_isp_spi_hw_init(AvrIspSpiHwSpeed speed) {
+    furi_assert(speed < COUNT_OF(avr_isp_spi_hw_prescaler));
+    AvrIspSpiHw* instance = malloc(sizeof(AvrIspSpiHw));
+    instance->handle.bus = &furi_hal_spi_bus_r;
+    instance->handle.callback = avr_isp_spi_hw_handle_event_callback;
+    instance->handle.miso = AVR_ISP_SPI_HW_MISO;
+    instance->handle.mosi = AVR_ISP_SPI_HW_MOSI;
+    instance->handle.sck = AVR_ISP_SPI_HW_SCK;
+    // Not connected to the target, the handle callback never touches it
+    instance->handle.cs = AVR_ISP_SPI_HW_CS;
+    instance->res = AVR_ISP_RESET;
+
+    instance->config.Mode = LL_SPI_MODE_MASTER;
+    instance->config.TransferDirection = LL_SPI_FULL_DUPLEX;
+    instance->config.DataWidth = LL_SPI_DATAWIDTH_8BIT;
+    instance->config.ClockPolarity = LL_SPI_POLARITY_LOW;
+    instance->config.ClockPhase = LL_SPI_PHASE_1EDGE;
+    instance->config.NSS = LL_SPI_NSS_SOFT;
+    instance->config.BaudRate = avr_isp_spi_hw_prescaler[speed];
+    instance->config.BitOrder = LL_SPI_MSB_FIRST;
+    instance->config.CRCCalculation = LL_SPI_CRCCALCULATION_DISABLE;
+    instance->config.CRCPoly = 7;
+
+    furi_hal_gpio_init(instance->handle.miso, GpioModeInput, GpioPullNo, GpioSpeedVeryHigh);
+    furi_hal_gpio_write(instance->handle.mosi, false);
+    furi_hal_gpio_init(
+        instance->handle.mosi, GpioModeOutputPushPull, GpioPullNo, GpioSpeedVeryHigh);
+    furi_hal_gpio_write(instance->handle.sck, false);
+    furi_hal_gpio_init(
+        instance->handle.sck, GpioModeOutputPushPull, GpioPullNo, GpioSpeedVeryHigh);
+    furi_hal_gpio_init(instance->res, GpioModeOutputPushPull, GpioPullNo, GpioSpeedVeryHigh);
+
+    LL_GPIO_SetAFPin_0_7(GPIOB, LL_GPIO_PIN_3, LL_GPIO_AF_5);
+    LL_GPIO_SetAFPin_0_7(GPIOA, LL_GPIO_PIN_7, LL_GPIO_AF_5);
+    LL_GPIO_SetAFPin_0_7(GPIOA, LL_GPIO_PIN_6, LL_GPIO_AF_5);
+
+    furi_hal_spi_bus_handle_init(&instance->handle);
+    furi_hal_spi_acquire(&instance->handle);
+    avr_isp_spi_hw_set_pin_mode(instance, LL_GPIO_MODE_ALTERNATE, LL_GPIO_MODE_ALTERNATE);
+    return instance;
+}
+
+void avr_isp_spi_hw_free(AvrIspSpiHw* instance) {
+    furi_assert(instance);
+    avr_isp_spi_hw_set_pin_mode(instance, LL_GPIO_MODE_OUTPUT, LL_GPIO_MODE_INPUT);
+    furi_hal_spi_release(&instance->handle);
+    furi_hal_spi_bus_handle_deinit(&instance->handle);
+    furi_hal_gpio_init(instance->res, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
+    furi_hal_gpio_init(instance->handle.miso, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
+    furi_hal_gpio_init(instance->handle.mosi, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
+    furi_hal_gpio_init(instance->handle.sck, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
+    free(instance);
+}
+
+void avr_isp_spi_hw_trx(AvrIspSpiHw* instance, const uint8_t* tx, uint8_t* rx, size_t size) {
+    furi_assert(instance);
+    furi_assert(size);
+
+    bool result = false;
+    if(size < AVR_ISP_SPI_HW_DMA_MIN) {
+        result = furi_hal_spi_bus_trx(&instance->handle, tx, rx, size, AVR_ISP_SPI_HW_TIMEOUT);
+    } else {
+        result = furi_hal_spi_bus_trx_dma(
+            &instance->handle, (uint8_t*)tx, rx, size, AVR_ISP_SPI_HW_TIMEOUT);
+    }
+
+    if(!result) {
+        // Same as a target that does not answer, callers verify what they read
+        FURI_LOG_E(TAG, "Transfer timeout");
+        memset(rx, 0xFF, size);
+    }
+}
+
+uint8_t avr_isp_spi_hw_txrx(AvrIspSpiHw* instance, uint8_t data) {
+    uint8_t rx = 0;
+    avr_isp_spi_hw_trx(instance, &data, &rx, 1);
+    return rx;
+}
+
+void avr_isp_spi_hw_res_set(AvrIspSpiHw* instance, bool state) {
+    furi_assert(instance);
+    furi_hal_gpio_write(instance->res, state);
+}
+
+void avr_isp_spi_hw_sck_set(AvrIspSpiHw* instance, bool state) {
+    furi_assert(instance);
+    // SPI keeps SCK low, the pin only has to be a GPIO while it is high
+    furi_hal_gpio_write(instance->handle.sck, state);
+    LL_GPIO_SetPinMode(
+        instance->handle.sck->port,
+        instance->handle.sck->pin,
+        state ? LL_GPIO_MODE_OUTPUT : LL_GPIO_MODE_ALTERNATE);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <furi_hal.h>
+
+// SPI1 kernel clock is 64MHz, the speed is the baud rate prescaler
+typedef enum {
+    AvrIspSpiHwSpeed2Mhz = 0,
+    AvrIspSpiHwSpeed1Mhz,
+    AvrIspSpiHwSpeed500Khz,
+    AvrIspSpiHwSpeed250Khz,
+} AvrIspSpiHwSpeed;
+
+typedef struct AvrIspSpiHw AvrIspSpiHw;
+
+AvrIspSpiHw* avr_isp_spi_hw_init(AvrIspSpiHwSpeed speed);
+void avr_isp_spi_hw_free(AvrIspSpiHw* instance);
+uint8_t avr_isp_spi_hw_txrx(AvrIspSpiHw* instance, uint8_t data);
+void avr_isp_spi_hw_trx(AvrIspSpiHw* instance, const uint8_t* tx, uint8_t* rx, size_t size);
+void avr_isp_spi_hw_res_set(AvrIspSpiHw* instance, bool state);
+void avr_isp_spi_hw_sck_set(AvrIspSpiHw* instance, bool state);
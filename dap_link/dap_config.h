@@ -6,6 +6,7 @@
 
 /*- Includes ----------------------------------------------------------------*/
 #include <furi_hal_gpio.h>
+#include "swo/swo_capture.h"
 
 /*- Definitions -------------------------------------------------------------*/
 #define DAP_CONFIG_ENABLE_JTAG
@@ -14,7 +15,7 @@
 #define DAP_CONFIG_DEFAULT_CLOCK 4200000 // Hz
 
 #define DAP_CONFIG_PACKET_SIZE 64
-#define DAP_CONFIG_PACKET_COUNT 1
+#define DAP_CONFIG_PACKET_COUNT 4
 
 #define DAP_CONFIG_JTAG_DEV_COUNT 8
 
@@ -27,6 +28,27 @@
 #define DAP_CONFIG_RESET_TARGET_FN dap_app_target_reset
 #define DAP_CONFIG_VENDOR_FN dap_app_vendor_cmd
 
+// SWO capture in UART mode, on the UART that is not used by the USB-UART bridge
+#define DAP_CONFIG_ENABLE_SWO
+#define DAP_CONFIG_SWO_BUFFER_SIZE SWO_CAPTURE_BUFFER_SIZE
+#define DAP_CONFIG_SWO_MAX_BAUDRATE 4000000 // Hz
+
+#define DAP_CONFIG_SWO_START_FN dap_app_swo_start
+#define DAP_CONFIG_SWO_STOP_FN dap_app_swo_stop
+#define DAP_CONFIG_SWO_ACTIVE_FN swo_capture_is_active
+#define DAP_CONFIG_SWO_COUNT_FN swo_capture_get_count
+#define DAP_CONFIG_SWO_INDEX_FN swo_capture_get_index
+#define DAP_CONFIG_SWO_READ_FN swo_capture_read
+#define DAP_CONFIG_SWO_ERROR_FN swo_capture_get_overrun
+
+// SWD engine statistics, CPU time is measured with the DWT cycle counter
+#define DAP_CONFIG_ENABLE_SWD_STATS
+#define DAP_CONFIG_CYCLE_COUNTER() (DWT->CYCCNT)
+
+// SWD fast path for the no-delay clock: BSRR words precomputed for the selected pins,
+// one store per clock edge and fully unrolled data phases
+#define DAP_CONFIG_ENABLE_SWD_FAST_PATH
+
 // Attribute to use for performance-critical functions
 #define DAP_CONFIG_PERFORMANCE_ATTR
 
@@ -48,12 +70,26 @@ extern GpioPin flipper_dap_reset_pin;
 extern GpioPin flipper_dap_tdo_pin;
 extern GpioPin flipper_dap_tdi_pin;
 
+// SWCLK and SWDIO share GPIOA in both pin configurations
+typedef struct {
+    GPIO_TypeDef* port;
+    uint32_t clock_low_data[2]; // SWCLK low, SWDIO driven to 0 or 1
+    uint32_t clock_low; // SWCLK low, SWDIO untouched
+    uint32_t clock_high; // SWCLK high
+    uint32_t swdio_shift;
+} FlipperDapSwdFast;
+
+extern FlipperDapSwdFast flipper_dap_swd_fast;
+
 extern void dap_app_vendor_cmd(uint8_t cmd);
 extern void dap_app_target_reset();
 extern void dap_app_disconnect();
 extern void dap_app_connect_swd();
 extern void dap_app_connect_jtag();
 
+extern bool dap_app_swo_start(int transport, uint32_t baudrate);
+extern void dap_app_swo_stop(void);
+
 //-----------------------------------------------------------------------------
 static inline void DAP_CONFIG_SWCLK_TCK_write(int value) {
     furi_hal_gpio_write(&flipper_dap_swclk_pin, value);
@@ -218,6 +254,51 @@ static inline void DAP_CONFIG_CONNECT_JTAG(void) {
     dap_app_connect_jtag();
 }
 
+//-----------------------------------------------------------------------------
+__attribute__((always_inline)) static inline void
+    DAP_CONFIG_SWD_FAST_write(uint32_t value, int size) {
+    GPIO_TypeDef* port = flipper_dap_swd_fast.port;
+    const uint32_t* clock_low_data = flipper_dap_swd_fast.clock_low_data;
+    const uint32_t clock_high = flipper_dap_swd_fast.clock_high;
+
+#pragma GCC unroll 32
+    for(int i = 0; i < size; i++) {
+        port->BSRR = clock_low_data[value & 1];
+        port->BSRR = clock_high;
+        value >>= 1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+__attribute__((always_inline)) static inline uint32_t DAP_CONFIG_SWD_FAST_read(int size) {
+    GPIO_TypeDef* port = flipper_dap_swd_fast.port;
+    const uint32_t clock_low = flipper_dap_swd_fast.clock_low;
+    const uint32_t clock_high = flipper_dap_swd_fast.clock_high;
+    const uint32_t swdio_shift = flipper_dap_swd_fast.swdio_shift;
+    uint32_t value = 0;
+
+#pragma GCC unroll 32
+    for(int i = 0; i < size; i++) {
+        port->BSRR = clock_low;
+        uint32_t bit = (port->IDR >> swdio_shift) & 1;
+        port->BSRR = clock_high;
+        value |= bit << i;
+    }
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+__attribute__((always_inline)) static inline void DAP_CONFIG_SWD_FAST_clock(int cycles) {
+    GPIO_TypeDef* port = flipper_dap_swd_fast.port;
+    const uint32_t clock_low = flipper_dap_swd_fast.clock_low;
+    const uint32_t clock_high = flipper_dap_swd_fast.clock_high;
+
+    while(cycles--) {
+        port->BSRR = clock_low;
+        port->BSRR = clock_high;
+    }
+}
+
 //-----------------------------------------------------------------------------
 static inline void DAP_CONFIG_LED(int index, int state) {
     (void)index;
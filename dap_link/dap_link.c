@@ -15,6 +15,9 @@
 #include "dap_config.h"
 #include "gui/dap_gui.h"
 #include "usb/dap_v2_usb.h"
+#include "swo/swo_capture.h"
+#include "mem/dap_mem_block.h"
+#include "stats/dap_stats.h"
 #include <dialogs/dialogs.h>
 #include "dap_link_icons.h"
 
@@ -45,11 +48,28 @@ void dap_thread_send_stop(FuriThread* thread) {
     furi_thread_flags_set(furi_thread_get_id(thread), DapEventStop);
 }
 
+typedef enum {
+    CdcThreadEventStop = DapEventStop,
+    CdcThreadEventUartRx = (1 << 1),
+    CdcThreadEventCdcRx = (1 << 2),
+    CdcThreadEventCdcConfig = (1 << 3),
+    CdcThreadEventApplyConfig = (1 << 4),
+    CdcThreadEventCdcDtrHigh = (1 << 5),
+    CdcThreadEventCdcDtrLow = (1 << 6),
+    CdcThreadEventCdcTxComplete = (1 << 7),
+
+    CdcThreadEventAll = CdcThreadEventStop | CdcThreadEventUartRx | CdcThreadEventCdcRx |
+                        CdcThreadEventCdcConfig | CdcThreadEventApplyConfig |
+                        CdcThreadEventCdcDtrHigh | CdcThreadEventCdcDtrLow |
+                        CdcThreadEventCdcTxComplete,
+} CdcThreadEvent;
+
 GpioPin flipper_dap_swclk_pin;
 GpioPin flipper_dap_swdio_pin;
 GpioPin flipper_dap_reset_pin;
 GpioPin flipper_dap_tdo_pin;
 GpioPin flipper_dap_tdi_pin;
+FlipperDapSwdFast flipper_dap_swd_fast;
 
 /***************************************************************************/
 /****************************** DAP PROCESS ********************************/
@@ -60,6 +80,17 @@ typedef struct {
     uint8_t size;
 } DapPacket;
 
+// Requests received over the bulk endpoint, filled from the USB interrupt
+typedef struct {
+    DapPacket packets[DAP_CONFIG_PACKET_COUNT];
+    uint8_t head;
+    uint8_t tail;
+    uint8_t count;
+    bool rx_pending;
+} DapPacketQueue;
+
+static DapPacketQueue dap_v2_queue;
+
 typedef enum {
     DapThreadEventStop = DapEventStop,
     DapThreadEventRxV1 = (1 << 1),
@@ -67,11 +98,24 @@ typedef enum {
     DapThreadEventUsbConnect = (1 << 3),
     DapThreadEventUsbDisconnect = (1 << 4),
     DapThreadEventApplyConfig = (1 << 5),
+    DapThreadEventSwo = (1 << 6),
+    DapThreadEventResetStats = (1 << 7),
     DapThreadEventAll = DapThreadEventStop | DapThreadEventRxV1 | DapThreadEventRxV2 |
                         DapThreadEventUsbConnect | DapThreadEventUsbDisconnect |
-                        DapThreadEventApplyConfig,
+                        DapThreadEventApplyConfig | DapThreadEventSwo |
+                        DapThreadEventResetStats,
 } DapThreadEvent;
 
+// SWO transport value for streaming over the dedicated bulk endpoint
+#define DAP_SWO_TRANSPORT_ENDPOINT 2
+
+// Streamed block read packets are dropped if the host does not read them in time
+#define DAP_MEM_BLOCK_TX_TIMEOUT 1000
+
+// Trace data waiting for the SWO endpoint to become free
+static DapPacket dap_swo_packet;
+static bool dap_swo_streaming = false;
+
 #define USB_SERIAL_NUMBER_LEN 16
 char usb_serial_number[USB_SERIAL_NUMBER_LEN] = {0};
 
@@ -86,12 +130,85 @@ static void dap_app_rx1_callback(void* context) {
     furi_thread_flags_set(thread_id, DapThreadEventRxV1);
 }
 
+// Must be called from the USB interrupt or inside a critical section
+static void dap_v2_queue_receive(void) {
+    if(dap_v2_queue.count == DAP_CONFIG_PACKET_COUNT) {
+        // Endpoint keeps NAKing until a slot is released
+        dap_v2_queue.rx_pending = true;
+        return;
+    }
+
+    dap_v2_queue.rx_pending = false;
+
+    DapPacket* packet = &dap_v2_queue.packets[dap_v2_queue.head];
+    packet->size = dap_v2_usb_rx(packet->data, DAP_CONFIG_PACKET_SIZE);
+
+    // Transfer abort has no response and must reach the transfer in progress
+    if(packet->size == 0 || !dap_filter_request(packet->data)) return;
+
+    dap_v2_queue.head = (dap_v2_queue.head + 1) % DAP_CONFIG_PACKET_COUNT;
+    dap_v2_queue.count++;
+}
+
+static void dap_v2_queue_reset(void) {
+    FURI_CRITICAL_ENTER();
+    dap_v2_queue.head = 0;
+    dap_v2_queue.tail = 0;
+    dap_v2_queue.count = 0;
+    dap_v2_queue.rx_pending = false;
+    FURI_CRITICAL_EXIT();
+}
+
+// Get the next request to be processed, or NULL if there is none yet.
+// Queued commands are held back until a regular request arrives.
+static DapPacket* dap_v2_queue_peek(void) {
+    DapPacket* packet = NULL;
+
+    FURI_CRITICAL_ENTER();
+    const uint8_t count = dap_v2_queue.count;
+    FURI_CRITICAL_EXIT();
+
+    for(uint8_t i = 0; i < count; i++) {
+        const uint8_t index = (dap_v2_queue.tail + i) % DAP_CONFIG_PACKET_COUNT;
+        if(!dap_is_queued_request(dap_v2_queue.packets[index].data)) {
+            packet = &dap_v2_queue.packets[dap_v2_queue.tail];
+            break;
+        }
+    }
+
+    // Do not stall if the host has filled the whole queue with queued commands
+    if(count == DAP_CONFIG_PACKET_COUNT) {
+        packet = &dap_v2_queue.packets[dap_v2_queue.tail];
+    }
+
+    return packet;
+}
+
+static void dap_v2_queue_release(void) {
+    FURI_CRITICAL_ENTER();
+    dap_v2_queue.tail = (dap_v2_queue.tail + 1) % DAP_CONFIG_PACKET_COUNT;
+    dap_v2_queue.count--;
+    if(dap_v2_queue.rx_pending) {
+        dap_v2_queue_receive();
+    }
+    FURI_CRITICAL_EXIT();
+}
+
 static void dap_app_rx2_callback(void* context) {
     furi_assert(context);
     FuriThreadId thread_id = (FuriThreadId)context;
+    // Take the packet right away, so that the host can send the next one
+    // while this one is being processed
+    dap_v2_queue_receive();
     furi_thread_flags_set(thread_id, DapThreadEventRxV2);
 }
 
+static void dap_app_swo_callback(void* context) {
+    furi_assert(context);
+    FuriThreadId thread_id = (FuriThreadId)context;
+    furi_thread_flags_set(thread_id, DapThreadEventSwo);
+}
+
 static void dap_app_usb_state_callback(bool state, void* context) {
     furi_assert(context);
     FuriThreadId thread_id = (FuriThreadId)context;
@@ -107,24 +224,78 @@ static void dap_app_process_v1() {
     DapPacket rx_packet;
     memset(&tx_packet, 0, sizeof(DapPacket));
     rx_packet.size = dap_v1_usb_rx(rx_packet.data, DAP_CONFIG_PACKET_SIZE);
+    uint32_t start = dap_stats_timestamp();
     dap_process_request(rx_packet.data, rx_packet.size, tx_packet.data, DAP_CONFIG_PACKET_SIZE);
-    dap_v1_usb_tx(tx_packet.data, DAP_CONFIG_PACKET_SIZE);
+    dap_stats_add_command(rx_packet.data[0], start);
+    if(!dap_mem_block_skip_response()) {
+        start = dap_stats_timestamp();
+        dap_v1_usb_tx(tx_packet.data, DAP_CONFIG_PACKET_SIZE);
+        dap_stats_add_usb(start);
+    }
+    // Block reads are only streamed over the bulk interface, HID gets the first packet
+    dap_mem_block_cancel_read();
 }
 
-static void dap_app_process_v2() {
+static uint32_t dap_app_process_v2() {
     DapPacket tx_packet;
-    DapPacket rx_packet;
-    memset(&tx_packet, 0, sizeof(DapPacket));
-    rx_packet.size = dap_v2_usb_rx(rx_packet.data, DAP_CONFIG_PACKET_SIZE);
-    size_t len = dap_process_request(
-        rx_packet.data, rx_packet.size, tx_packet.data, DAP_CONFIG_PACKET_SIZE);
-    dap_v2_usb_tx(tx_packet.data, len);
+    DapPacket* rx_packet;
+    uint32_t processed = 0;
+
+    while((rx_packet = dap_v2_queue_peek()) != NULL) {
+        memset(&tx_packet, 0, sizeof(DapPacket));
+        uint8_t command = rx_packet->data[0];
+        uint32_t start = dap_stats_timestamp();
+        size_t len = dap_process_request(
+            rx_packet->data, rx_packet->size, tx_packet.data, DAP_CONFIG_PACKET_SIZE);
+        dap_v2_queue_release();
+        dap_stats_add_command(command, start);
+        start = dap_stats_timestamp();
+        if(!dap_mem_block_skip_response()) {
+            dap_v2_usb_tx(tx_packet.data, len);
+        }
+        processed++;
+
+        // The rest of a block read follows its first packet without further requests
+        while((len = dap_mem_block_read_next(tx_packet.data)) > 0) {
+            if(dap_v2_usb_tx_timeout(tx_packet.data, len, DAP_MEM_BLOCK_TX_TIMEOUT) <= 0) {
+                dap_mem_block_cancel();
+            }
+        }
+        dap_stats_add_usb(start);
+    }
+
+    return processed;
+}
+
+static void dap_app_process_swo() {
+    if(!dap_swo_streaming) return;
+
+    if(dap_swo_packet.size == 0) {
+        dap_swo_packet.size = swo_capture_read(dap_swo_packet.data, DAP_CONFIG_PACKET_SIZE);
+    }
+
+    // Endpoint busy: retried on the next data or transfer complete event
+    if(dap_swo_packet.size > 0 &&
+       dap_v2_usb_swo_tx(dap_swo_packet.data, dap_swo_packet.size) > 0) {
+        dap_swo_packet.size = 0;
+    }
 }
 
 void dap_app_vendor_cmd(uint8_t cmd) {
-    // openocd -c "cmsis-dap cmd 81"
-    if(cmd == 0x01) {
+    switch(cmd) {
+    case 0x01:
+        // openocd -c "cmsis-dap cmd 81"
         furi_hal_power_reset();
+        break;
+    case DAP_MEM_BLOCK_CMD_READ:
+        dap_mem_block_read();
+        break;
+    case DAP_MEM_BLOCK_CMD_WRITE:
+        dap_mem_block_write();
+        break;
+    case DAP_MEM_BLOCK_CMD_WRITE_DATA:
+        dap_mem_block_write_data();
+        break;
     }
 }
 
@@ -147,6 +318,17 @@ static void dap_init_gpio(DapSwdPins swd_pins) {
     flipper_dap_reset_pin = gpio_ext_pa4;
     flipper_dap_tdo_pin = gpio_ext_pb3;
     flipper_dap_tdi_pin = gpio_ext_pb2;
+
+    // BSRR: low half sets pins, high half resets them
+    furi_check(flipper_dap_swclk_pin.port == flipper_dap_swdio_pin.port);
+    const uint32_t swclk = flipper_dap_swclk_pin.pin;
+    const uint32_t swdio = flipper_dap_swdio_pin.pin;
+    flipper_dap_swd_fast.port = flipper_dap_swclk_pin.port;
+    flipper_dap_swd_fast.clock_low_data[0] = (swclk << 16) | (swdio << 16);
+    flipper_dap_swd_fast.clock_low_data[1] = (swclk << 16) | swdio;
+    flipper_dap_swd_fast.clock_low = swclk << 16;
+    flipper_dap_swd_fast.clock_high = swclk;
+    flipper_dap_swd_fast.swdio_shift = __builtin_ctz(swdio);
 }
 
 static void dap_deinit_gpio(DapSwdPins swd_pins) {
@@ -189,6 +371,7 @@ static int32_t dap_process(void* p) {
 
     // init dap
     dap_init();
+    dap_stats_reset();
 
     // get name
     const char* name = furi_hal_version_get_name_ptr();
@@ -197,12 +380,17 @@ static int32_t dap_process(void* p) {
     }
     snprintf(usb_serial_number, USB_SERIAL_NUMBER_LEN, "DAP_%s", name);
 
+    // init swo
+    swo_capture_alloc(dap_app_swo_callback, furi_thread_get_id(furi_thread_get_current()));
+
     // init usb
+    dap_v2_queue_reset();
     usb_config_prev = furi_hal_usb_get_config();
     dap_common_usb_alloc_name(usb_serial_number);
     dap_common_usb_set_context(furi_thread_get_id(furi_thread_get_current()));
     dap_v1_usb_set_rx_callback(dap_app_rx1_callback);
     dap_v2_usb_set_rx_callback(dap_app_rx2_callback);
+    dap_v2_usb_set_swo_tx_complete_callback(dap_app_swo_callback);
     dap_common_usb_set_state_callback(dap_app_usb_state_callback);
     furi_hal_usb_set_config(&dap_v2_usb_hid, NULL);
 
@@ -219,26 +407,43 @@ static int32_t dap_process(void* p) {
             }
 
             if(events & DapThreadEventRxV2) {
-                dap_app_process_v2();
-                dap_state->dap_counter++;
+                dap_state->dap_counter += dap_app_process_v2();
                 dap_state->dap_version = DapVersionV2;
             }
 
             if(events & DapThreadEventUsbConnect) {
+                dap_stats_reset();
                 dap_state->usb_connected = true;
             }
 
             if(events & DapThreadEventUsbDisconnect) {
+                dap_v2_queue_reset();
+                dap_mem_block_cancel();
                 dap_state->usb_connected = false;
                 dap_state->dap_version = DapVersionUnknown;
             }
 
+            if(events & DapThreadEventSwo) {
+                dap_app_process_swo();
+            }
+
+            if(events & DapThreadEventResetStats) {
+                dap_stats_reset();
+            }
+
             if(events & DapThreadEventApplyConfig) {
                 if(swd_pins_prev != app->config.swd_pins) {
                     dap_deinit_gpio(swd_pins_prev);
                     swd_pins_prev = app->config.swd_pins;
                     dap_init_gpio(swd_pins_prev);
                 }
+
+                // USB-UART bridge may only take the UART once SWO has released it
+                if(swo_capture_is_active() && swo_capture_get_uart() == app->config.uart_pins) {
+                    swo_capture_stop();
+                }
+                furi_thread_flags_set(
+                    furi_thread_get_id(app->cdc_thread), CdcThreadEventApplyConfig);
             }
 
             if(events & DapThreadEventStop) {
@@ -250,6 +455,7 @@ static int32_t dap_process(void* p) {
     // deinit usb
     furi_hal_usb_set_config(usb_config_prev, NULL);
     dap_common_usb_free_name();
+    swo_capture_free();
     dap_deinit_gpio(swd_pins_prev);
     return 0;
 }
@@ -258,37 +464,46 @@ static int32_t dap_process(void* p) {
 /****************************** CDC PROCESS ********************************/
 /***************************************************************************/
 
-typedef enum {
-    CdcThreadEventStop = DapEventStop,
-    CdcThreadEventUartRx = (1 << 1),
-    CdcThreadEventCdcRx = (1 << 2),
-    CdcThreadEventCdcConfig = (1 << 3),
-    CdcThreadEventApplyConfig = (1 << 4),
-    CdcThreadEventCdcDtrHigh = (1 << 5),
-    CdcThreadEventCdcDtrLow = (1 << 6),
-    CdcThreadEventCdcTxComplete = (1 << 7),
-
-    CdcThreadEventAll = CdcThreadEventStop | CdcThreadEventUartRx | CdcThreadEventCdcRx |
-                        CdcThreadEventCdcConfig | CdcThreadEventApplyConfig |
-                        CdcThreadEventCdcDtrHigh | CdcThreadEventCdcDtrLow |
-                        CdcThreadEventCdcTxComplete,
-} CdcThreadEvent;
+#define CDC_RX_STREAM_SIZE 4096
+#define CDC_USB_PACKET_SIZE 64
 
 typedef struct {
     FuriStreamBuffer* rx_stream;
     FuriThreadId thread_id;
     FuriHalSerialHandle* serial_handle;
     struct usb_cdc_line_coding line_coding;
+    // UART data waiting for a USB buffer, filled up to a full packet while USB is busy
+    uint8_t usb_packet[CDC_USB_PACKET_SIZE];
+    size_t usb_packet_size;
+    // Written by the UART interrupt
+    volatile uint32_t rx_overrun;
+    volatile uint32_t uart_overrun;
 } CDCProcess;
 
-static void cdc_uart_irq_cb(FuriHalSerialHandle* handle, FuriHalSerialRxEvent event, void* ctx) {
+static void cdc_uart_dma_rx_cb(
+    FuriHalSerialHandle* handle,
+    FuriHalSerialRxEvent event,
+    size_t size,
+    void* ctx) {
     CDCProcess* app = ctx;
 
-    if(event == FuriHalSerialRxEventData) {
-        uint8_t data = furi_hal_serial_async_rx(handle);
-        furi_stream_buffer_send(app->rx_stream, &data, 1, 0);
-        furi_thread_flags_set(app->thread_id, CdcThreadEventUartRx);
+    // Called on DMA half/full transfer and on line idle, so the thread wakes once per burst
+    if(event & (FuriHalSerialRxEventData | FuriHalSerialRxEventIdle)) {
+        uint8_t data[CDC_USB_PACKET_SIZE];
+        while(size) {
+            size_t len = furi_hal_serial_dma_rx(handle, data, MIN(size, sizeof(data)));
+            size_t sent = furi_stream_buffer_send(app->rx_stream, data, len, 0);
+            // USB side is not keeping up, the newest data is lost
+            app->rx_overrun += len - sent;
+            size -= len;
+        }
+    }
+
+    if(event & FuriHalSerialRxEventOverrunError) {
+        app->uart_overrun++;
     }
+
+    furi_thread_flags_set(app->thread_id, CdcThreadEventUartRx);
 }
 
 static void cdc_usb_rx_callback(void* context) {
@@ -324,7 +539,7 @@ static void cdc_init_uart(
     DapUartType type,
     DapUartTXRX swap,
     uint32_t baudrate,
-    void (*cb)(FuriHalSerialHandle* handle, FuriHalSerialRxEvent event, void* ctx),
+    FuriHalSerialDmaRxCallback cb,
     void* ctx) {
     if(baudrate == 0) baudrate = 115200;
 
@@ -338,7 +553,7 @@ static void cdc_init_uart(
             LL_USART_SetTXRXSwap(USART1, LL_USART_TXRX_STANDARD);
         }
         furi_hal_serial_init(app->serial_handle, baudrate);
-        furi_hal_serial_async_rx_start(app->serial_handle, cb, ctx, false);
+        furi_hal_serial_dma_rx_start(app->serial_handle, cb, ctx, true);
         break;
     case DapUartTypeLPUART1:
         app->serial_handle = furi_hal_serial_control_acquire(FuriHalSerialIdLpuart);
@@ -349,7 +564,7 @@ static void cdc_init_uart(
             LL_LPUART_SetTXRXSwap(LPUART1, LL_LPUART_TXRX_STANDARD);
         }
         furi_hal_serial_init(app->serial_handle, baudrate);
-        furi_hal_serial_async_rx_start(app->serial_handle, cb, ctx, false);
+        furi_hal_serial_dma_rx_start(app->serial_handle, cb, ctx, true);
         break;
     }
 }
@@ -369,6 +584,26 @@ static void cdc_deinit_uart(CDCProcess* app, DapUartType type) {
     }
 }
 
+static void cdc_forward_to_usb(CDCProcess* app, DapState* dap_state, bool cdc_connect) {
+    while(true) {
+        app->usb_packet_size += furi_stream_buffer_receive(
+            app->rx_stream,
+            &app->usb_packet[app->usb_packet_size],
+            CDC_USB_PACKET_SIZE - app->usb_packet_size,
+            0);
+        if(app->usb_packet_size == 0) break;
+
+        if(cdc_connect) {
+            // Short packets only go out when USB is idle, a busy link gets full packets
+            if(app->usb_packet_size < CDC_USB_PACKET_SIZE && !dap_cdc_usb_tx_idle()) break;
+            // Both USB buffers are busy, retry on tx complete
+            if(dap_cdc_usb_tx(app->usb_packet, app->usb_packet_size) <= 0) break;
+            dap_state->cdc_rx_counter += app->usb_packet_size;
+        }
+        app->usb_packet_size = 0;
+    }
+}
+
 static int32_t dap_cdc_process(void* p) {
     DapApp* dap_app = p;
     DapState* dap_state = &(dap_app->state);
@@ -381,13 +616,16 @@ static int32_t dap_cdc_process(void* p) {
 
     CDCProcess* app = malloc(sizeof(CDCProcess));
     app->thread_id = furi_thread_get_id(furi_thread_get_current());
-    app->rx_stream = furi_stream_buffer_alloc(512, 1);
+    app->rx_stream = furi_stream_buffer_alloc(CDC_RX_STREAM_SIZE, 1);
+    app->usb_packet_size = 0;
+    app->rx_overrun = 0;
+    app->uart_overrun = 0;
 
     const uint8_t rx_buffer_size = 64;
     uint8_t* rx_buffer = malloc(rx_buffer_size);
 
     cdc_init_uart(
-        app, uart_pins_prev, uart_swap_prev, dap_state->cdc_baudrate, cdc_uart_irq_cb, app);
+        app, uart_pins_prev, uart_swap_prev, dap_state->cdc_baudrate, cdc_uart_dma_rx_cb, app);
 
     dap_cdc_usb_set_context(app);
     dap_cdc_usb_set_rx_callback(cdc_usb_rx_callback);
@@ -412,14 +650,9 @@ static int32_t dap_cdc_process(void* p) {
             }
 
             if(events & (CdcThreadEventUartRx | CdcThreadEventCdcTxComplete)) {
-                size_t len =
-                    furi_stream_buffer_receive(app->rx_stream, rx_buffer, rx_buffer_size, 0);
-                if(cdc_connect) {
-                    if(len > 0) {
-                        dap_cdc_usb_tx(rx_buffer, len);
-                    }
-                    dap_state->cdc_rx_counter += len;
-                }
+                cdc_forward_to_usb(app, dap_state, cdc_connect);
+                dap_state->cdc_rx_overrun = app->rx_overrun;
+                dap_state->cdc_uart_overrun = app->uart_overrun;
             }
 
             if(events & CdcThreadEventCdcRx) {
@@ -441,7 +674,7 @@ static int32_t dap_cdc_process(void* p) {
                         uart_pins_prev,
                         uart_swap_prev,
                         dap_state->cdc_baudrate,
-                        cdc_uart_irq_cb,
+                        cdc_uart_dma_rx_cb,
                         app);
                 }
             }
@@ -474,7 +707,7 @@ static DapApp* dap_app_alloc() {
     DapApp* dap_app = malloc(sizeof(DapApp));
     dap_app->dap_thread = furi_thread_alloc_ex("DapProcess", 1024, dap_process, dap_app);
     dap_app->cdc_thread = furi_thread_alloc_ex("DapCdcProcess", 1024, dap_cdc_process, dap_app);
-    dap_app->gui_thread = furi_thread_alloc_ex("DapGui", 1024, dap_gui_thread, dap_app);
+    dap_app->gui_thread = furi_thread_alloc_ex("DapGui", 2048, dap_gui_thread, dap_app);
     return dap_app;
 }
 
@@ -488,11 +721,41 @@ static void dap_app_free(DapApp* dap_app) {
 
 static DapApp* app_handle = NULL;
 
+static uint32_t dap_swd_session_start = 0;
+
+static void dap_app_log_swd_stats(void) {
+    dap_swd_stats_t stats;
+    dap_swd_get_stats(&stats);
+    if(stats.transfers == 0) return;
+
+    uint32_t elapsed = furi_get_tick() - dap_swd_session_start;
+    FURI_LOG_I(
+        "DAP",
+        "SWD: %lu transfers in %lu ms, %lu wait, %lu fault, %lu error",
+        stats.transfers,
+        elapsed,
+        stats.waits,
+        stats.faults,
+        stats.errors);
+    FURI_LOG_I(
+        "DAP",
+        "SWD: %lu clocks and %lu CPU cycles per transfer",
+        (uint32_t)(stats.clock_cycles / stats.transfers),
+        (uint32_t)(stats.cpu_cycles / stats.transfers));
+}
+
 void dap_app_disconnect() {
+    if(app_handle->state.dap_mode == DapModeSWD) {
+        dap_app_log_swd_stats();
+    }
     app_handle->state.dap_mode = DapModeDisconnected;
 }
 
 void dap_app_connect_swd() {
+    if(app_handle->state.dap_mode != DapModeSWD) {
+        dap_swd_reset_stats();
+        dap_swd_session_start = furi_get_tick();
+    }
     app_handle->state.dap_mode = DapModeSWD;
 }
 
@@ -500,16 +763,40 @@ void dap_app_connect_jtag() {
     app_handle->state.dap_mode = DapModeJTAG;
 }
 
+bool dap_app_swo_start(int transport, uint32_t baudrate) {
+    // SWO is captured on the UART that is not used by the USB-UART bridge
+    DapUartType uart = (app_handle->config.uart_pins == DapUartTypeUSART1) ? DapUartTypeLPUART1 :
+                                                                               DapUartTypeUSART1;
+
+    dap_swo_streaming = (transport == DAP_SWO_TRANSPORT_ENDPOINT);
+    dap_swo_packet.size = 0;
+
+    return swo_capture_start(uart, baudrate);
+}
+
+void dap_app_swo_stop(void) {
+    swo_capture_stop();
+}
+
 void dap_app_set_config(DapApp* app, DapConfig* config) {
     app->config = *config;
+    // DAP thread passes the event on to the CDC thread, see DapThreadEventApplyConfig
     furi_thread_flags_set(furi_thread_get_id(app->dap_thread), DapThreadEventApplyConfig);
-    furi_thread_flags_set(furi_thread_get_id(app->cdc_thread), CdcThreadEventApplyConfig);
 }
 
 DapConfig* dap_app_get_config(DapApp* app) {
     return &app->config;
 }
 
+void dap_app_get_stats(DapApp* app, DapStats* stats) {
+    UNUSED(app);
+    dap_stats_get(stats);
+}
+
+void dap_app_reset_stats(DapApp* app) {
+    furi_thread_flags_set(furi_thread_get_id(app->dap_thread), DapThreadEventResetStats);
+}
+
 int32_t dap_link_app(void* p) {
     UNUSED(p);
     // Disable expansion protocol to avoid interference with UART Handle
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include "stats/dap_stats.h"
 
 typedef enum {
     DapModeDisconnected,
@@ -21,6 +22,8 @@ typedef struct {
     uint32_t cdc_baudrate;
     uint32_t cdc_tx_counter;
     uint32_t cdc_rx_counter;
+    uint32_t cdc_rx_overrun; // bytes dropped, USB did not keep up with the UART
+    uint32_t cdc_uart_overrun; // UART hardware overrun errors
 } DapState;
 
 typedef enum {
@@ -52,4 +55,8 @@ const char* dap_app_get_serial(DapApp* app);
 
 void dap_app_set_config(DapApp* app, DapConfig* config);
 
-DapConfig* dap_app_get_config(DapApp* app);
\ No newline at end of file
+DapConfig* dap_app_get_config(DapApp* app);
+
+void dap_app_get_stats(DapApp* app, DapStats* stats);
+
+void dap_app_reset_stats(DapApp* app);
\ No newline at end of file
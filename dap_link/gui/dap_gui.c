@@ -48,6 +48,10 @@ DapGuiApp* dap_gui_alloc() {
     view_dispatcher_add_view(
         app->view_dispatcher, DapGuiAppViewMainView, dap_main_view_get_view(app->main_view));
 
+    app->stats_view = dap_stats_view_alloc();
+    view_dispatcher_add_view(
+        app->view_dispatcher, DapGuiAppViewStatsView, dap_stats_view_get_view(app->stats_view));
+
     app->widget = widget_alloc();
     view_dispatcher_add_view(
         app->view_dispatcher, DapGuiAppViewWidget, widget_get_view(app->widget));
@@ -64,6 +68,9 @@ void dap_gui_free(DapGuiApp* app) {
     view_dispatcher_remove_view(app->view_dispatcher, DapGuiAppViewMainView);
     dap_main_view_free(app->main_view);
 
+    view_dispatcher_remove_view(app->view_dispatcher, DapGuiAppViewStatsView);
+    dap_stats_view_free(app->stats_view);
+
     view_dispatcher_remove_view(app->view_dispatcher, DapGuiAppViewWidget);
     widget_free(app->widget);
 
@@ -4,4 +4,7 @@ typedef enum {
     DapAppCustomEventConfig,
     DapAppCustomEventHelp,
     DapAppCustomEventAbout,
+    DapAppCustomEventStats,
+    DapAppCustomEventStatsReset,
+    DapAppCustomEventStatsSave,
 } DapAppCustomEvent;
@@ -13,6 +13,7 @@
 #include "scenes/config/dap_scene.h"
 #include "dap_gui_custom_event.h"
 #include "views/dap_main_view.h"
+#include "views/dap_stats_view.h"
 
 typedef struct {
     DapApp* dap_app;
@@ -24,11 +25,13 @@ typedef struct {
 
     VariableItemList* var_item_list;
     DapMainView* main_view;
+    DapStatsView* stats_view;
     Widget* widget;
 } DapGuiApp;
 
 typedef enum {
     DapGuiAppViewVarItemList,
     DapGuiAppViewMainView,
+    DapGuiAppViewStatsView,
     DapGuiAppViewWidget,
 } DapGuiAppView;
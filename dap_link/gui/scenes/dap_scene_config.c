@@ -41,9 +41,12 @@ static void ok_cb(void* context, uint32_t index) {
     DapGuiApp* app = context;
     switch(index) {
     case 3:
-        view_dispatcher_send_custom_event(app->view_dispatcher, DapAppCustomEventHelp);
+        view_dispatcher_send_custom_event(app->view_dispatcher, DapAppCustomEventStats);
         break;
     case 4:
+        view_dispatcher_send_custom_event(app->view_dispatcher, DapAppCustomEventHelp);
+        break;
+    case 5:
         view_dispatcher_send_custom_event(app->view_dispatcher, DapAppCustomEventAbout);
         break;
     default:
@@ -72,6 +75,7 @@ void dap_scene_config_on_enter(void* context) {
     variable_item_set_current_value_index(item, config->uart_swap);
     variable_item_set_current_value_text(item, uart_swap[config->uart_swap]);
 
+    variable_item_list_add(var_item_list, "Statistics", 0, NULL, NULL);
     variable_item_list_add(var_item_list, "Help and Pinout", 0, NULL, NULL);
     variable_item_list_add(var_item_list, "About", 0, NULL, NULL);
 
@@ -86,7 +90,10 @@ void dap_scene_config_on_enter(void* context) {
 bool dap_scene_config_on_event(void* context, SceneManagerEvent event) {
     DapGuiApp* app = context;
     if(event.type == SceneManagerEventTypeCustom) {
-        if(event.event == DapAppCustomEventHelp) {
+        if(event.event == DapAppCustomEventStats) {
+            scene_manager_next_scene(app->scene_manager, DapSceneStats);
+            return true;
+        } else if(event.event == DapAppCustomEventHelp) {
             scene_manager_next_scene(app->scene_manager, DapSceneHelp);
             return true;
         } else if(event.event == DapAppCustomEventAbout) {
@@ -85,6 +85,19 @@ void dap_scene_help_on_enter(void* context) {
         break;
     }
 
+    // SWO takes the UART that is not used by the USB-UART bridge
+    furi_string_cat(string, "\e#SWO:\r\n");
+    switch(config->uart_pins) {
+    case DapUartTypeUSART1:
+        furi_string_cat(string, "    SWO: 16 [C0]\r\n");
+        break;
+    case DapUartTypeLPUART1:
+        furi_string_cat(string, "    SWO: 14 [RX]\r\n");
+        break;
+    default:
+        break;
+    }
+
     widget_add_text_scroll_element(app->widget, 0, 0, 128, 64, furi_string_get_cstr(string));
     furi_string_free(string);
     view_dispatcher_switch_to_view(app->view_dispatcher, DapGuiAppViewWidget);
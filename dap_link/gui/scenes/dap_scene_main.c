@@ -75,6 +75,13 @@ static bool process_dap_state(DapGuiApp* app) {
         need_to_update = true;
     }
 
+    if(prev_state->cdc_rx_overrun != next_state.cdc_rx_overrun ||
+       prev_state->cdc_uart_overrun != next_state.cdc_uart_overrun) {
+        dap_main_view_set_lost(
+            app->main_view, next_state.cdc_rx_overrun + next_state.cdc_uart_overrun);
+        need_to_update = true;
+    }
+
     if(prev_state->cdc_tx_counter != next_state.cdc_tx_counter) {
         if(!state->tx_active) {
             state->tx_active = true;
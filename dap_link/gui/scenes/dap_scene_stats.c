@@ -0,0 +1,65 @@
+#include "../dap_gui_i.h"
+
+#define DAP_STATS_CSV_PATH APP_DATA_PATH("stats.csv")
+
+static void dap_scene_stats_callback(DapStatsViewEvent event, void* context) {
+    DapGuiApp* app = context;
+    if(event == DapStatsViewEventReset) {
+        view_dispatcher_send_custom_event(app->view_dispatcher, DapAppCustomEventStatsReset);
+    } else if(event == DapStatsViewEventSave) {
+        view_dispatcher_send_custom_event(app->view_dispatcher, DapAppCustomEventStatsSave);
+    }
+}
+
+static void dap_scene_stats_update(DapGuiApp* app) {
+    DapStats* stats = (DapStats*)scene_manager_get_scene_state(app->scene_manager, DapSceneStats);
+    if(stats == NULL) return;
+
+    dap_app_get_stats(app->dap_app, stats);
+    dap_stats_view_set_stats(app->stats_view, stats);
+}
+
+void dap_scene_stats_on_enter(void* context) {
+    DapGuiApp* app = context;
+    // Too large for the GUI thread stack
+    DapStats* stats = malloc(sizeof(DapStats));
+    scene_manager_set_scene_state(app->scene_manager, DapSceneStats, (uint32_t)stats);
+
+    dap_stats_view_set_callback(app->stats_view, dap_scene_stats_callback, app);
+    dap_scene_stats_update(app);
+    view_dispatcher_switch_to_view(app->view_dispatcher, DapGuiAppViewStatsView);
+}
+
+bool dap_scene_stats_on_event(void* context, SceneManagerEvent event) {
+    DapGuiApp* app = context;
+
+    if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == DapAppCustomEventStatsReset) {
+            dap_app_reset_stats(app->dap_app);
+            return true;
+        } else if(event.event == DapAppCustomEventStatsSave) {
+            DapStats* stats =
+                (DapStats*)scene_manager_get_scene_state(app->scene_manager, DapSceneStats);
+            dap_app_get_stats(app->dap_app, stats);
+            if(dap_stats_save_csv(stats, DAP_STATS_CSV_PATH)) {
+                notification_message(app->notifications, &sequence_success);
+            } else {
+                notification_message(app->notifications, &sequence_error);
+            }
+            return true;
+        }
+    } else if(event.type == SceneManagerEventTypeTick) {
+        dap_scene_stats_update(app);
+        return true;
+    }
+
+    return false;
+}
+
+void dap_scene_stats_on_exit(void* context) {
+    DapGuiApp* app = context;
+    DapStats* stats = (DapStats*)scene_manager_get_scene_state(app->scene_manager, DapSceneStats);
+    scene_manager_set_scene_state(app->scene_manager, DapSceneStats, (uint32_t)NULL);
+    FURI_SW_MEMBARRIER();
+    free(stats);
+}
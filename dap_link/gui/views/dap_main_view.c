@@ -18,6 +18,7 @@ typedef struct {
     DapMainViewVersion version;
     bool usb_connected;
     uint32_t baudrate;
+    uint32_t lost;
     bool dap_active;
     bool tx_active;
     bool rx_active;
@@ -81,7 +82,17 @@ static void dap_main_view_draw_callback(Canvas* canvas, void* _model) {
         canvas_draw_icon_ex(canvas, 101, 16, &I_ArrowUpEmpty_12x18, IconRotation180);
     }
 
-    canvas_draw_str_aligned(canvas, 100, 38, AlignCenter, AlignTop, "UART");
+    if(model->lost == 0) {
+        canvas_draw_str_aligned(canvas, 100, 38, AlignCenter, AlignTop, "UART");
+    } else {
+        char lost_str[12];
+        if(model->lost > 99999) {
+            snprintf(lost_str, 12, "Lost 99999+");
+        } else {
+            snprintf(lost_str, 12, "Lost %lu", model->lost);
+        }
+        canvas_draw_str_aligned(canvas, 100, 38, AlignCenter, AlignTop, lost_str);
+    }
 
     canvas_draw_line(canvas, 44, 52, 123, 52);
     if(model->baudrate == 0) {
@@ -170,6 +181,11 @@ void dap_main_view_set_baudrate(DapMainView* dap_main_view, uint32_t baudrate) {
         dap_main_view->view, DapMainViewModel * model, { model->baudrate = baudrate; }, false);
 }
 
+void dap_main_view_set_lost(DapMainView* dap_main_view, uint32_t lost) {
+    with_view_model(
+        dap_main_view->view, DapMainViewModel * model, { model->lost = lost; }, false);
+}
+
 void dap_main_view_update(DapMainView* dap_main_view) {
     with_view_model(
         dap_main_view->view, DapMainViewModel * model, { UNUSED(model); }, true);
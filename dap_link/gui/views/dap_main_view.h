@@ -42,4 +42,6 @@ void dap_main_view_set_usb_connected(DapMainView* dap_main_view, bool connected)
 
 void dap_main_view_set_baudrate(DapMainView* dap_main_view, uint32_t baudrate);
 
+void dap_main_view_set_lost(DapMainView* dap_main_view, uint32_t lost);
+
 void dap_main_view_update(DapMainView* dap_main_view);
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "dap_stats_view.h"
+#include <gui/elements.h>
+
+#define DAP_STATS_VIEW_ROWS 4
+#define DAP_STATS_VIEW_ROW_HEIGHT 9
+// Session and SWD summary rows come before the commands
+#define DAP_STATS_VIEW_SUMMARY_ROWS 2
+
+struct DapStatsView {
+    View* view;
+    DapStatsViewCallback callback;
+    void* context;
+};
+
+typedef struct {
+    DapStats stats;
+    uint8_t offset;
+} DapStatsViewModel;
+
+static size_t dap_stats_view_get_row_count(DapStatsViewModel* model) {
+    size_t count = DAP_STATS_VIEW_SUMMARY_ROWS;
+    for(size_t i = 0; i < DAP_STATS_COMMAND_COUNT; i++) {
+        if(model->stats.commands[i].count) count++;
+    }
+    return count;
+}
+
+static void dap_stats_view_draw_row(Canvas* canvas, DapStatsViewModel* model, size_t row, int y) {
+    char str[32];
+    DapStats* stats = &model->stats;
+
+    if(row == 0) {
+        // Share of the session spent processing requests and waiting for the host to read
+        uint64_t elapsed_us = (uint64_t)MAX(stats->elapsed_ms, 1UL) * 1000;
+        snprintf(
+            str,
+            sizeof(str),
+            "%lus Busy %lu%% USB %lu%%",
+            stats->elapsed_ms / 1000,
+            (uint32_t)(stats->busy_us * 100 / elapsed_us),
+            (uint32_t)(stats->usb_us * 100 / elapsed_us));
+        canvas_draw_str(canvas, 2, y, str);
+        return;
+    }
+
+    if(row == 1) {
+        snprintf(
+            str,
+            sizeof(str),
+            "SWD %lukHz W%lu F%lu E%lu",
+            dap_stats_get_swd_bitrate(stats) / 1000,
+            stats->swd.waits,
+            stats->swd.faults,
+            stats->swd.errors);
+        canvas_draw_str(canvas, 2, y, str);
+        return;
+    }
+
+    // Commands that were seen at least once, in ID order
+    row -= DAP_STATS_VIEW_SUMMARY_ROWS;
+    for(size_t i = 0; i < DAP_STATS_COMMAND_COUNT; i++) {
+        DapStatsCommand* command = &stats->commands[i];
+        if(command->count == 0) continue;
+        if(row-- > 0) continue;
+
+        canvas_draw_str(canvas, 2, y, dap_stats_get_command_name(i));
+        snprintf(
+            str,
+            sizeof(str),
+            "%lu %luus",
+            command->count,
+            (uint32_t)(command->total_us / command->count));
+        canvas_draw_str_aligned(canvas, 122, y, AlignRight, AlignBottom, str);
+        return;
+    }
+}
+
+static void dap_stats_view_draw_callback(Canvas* canvas, void* _model) {
+    DapStatsViewModel* model = _model;
+    canvas_clear(canvas);
+
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_box(canvas, 0, 0, 127, 11);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_set_font(canvas, FontSecondary);
+    canvas_draw_str_aligned(canvas, 64, 9, AlignCenter, AlignBottom, "DAP Statistics");
+    canvas_set_color(canvas, ColorBlack);
+
+    size_t row_count = dap_stats_view_get_row_count(model);
+    for(size_t i = 0; i < DAP_STATS_VIEW_ROWS && model->offset + i < row_count; i++) {
+        dap_stats_view_draw_row(
+            canvas, model, model->offset + i, 21 + i * DAP_STATS_VIEW_ROW_HEIGHT);
+    }
+
+    if(row_count > DAP_STATS_VIEW_ROWS) {
+        elements_scrollbar_pos(
+            canvas, 128, 13, 38, model->offset, row_count - DAP_STATS_VIEW_ROWS + 1);
+    }
+
+    elements_button_left(canvas, "Reset");
+    elements_button_center(canvas, "Save");
+}
+
+static bool dap_stats_view_input_callback(InputEvent* event, void* context) {
+    furi_assert(context);
+    DapStatsView* dap_stats_view = context;
+    bool consumed = false;
+
+    if(event->type != InputTypeShort && event->type != InputTypeRepeat) return false;
+
+    if(event->key == InputKeyUp || event->key == InputKeyDown) {
+        with_view_model(
+            dap_stats_view->view,
+            DapStatsViewModel * model,
+            {
+                size_t row_count = dap_stats_view_get_row_count(model);
+                if(event->key == InputKeyUp && model->offset > 0) {
+                    model->offset--;
+                } else if(
+                    event->key == InputKeyDown &&
+                    model->offset + DAP_STATS_VIEW_ROWS < row_count) {
+                    model->offset++;
+                }
+            },
+            true);
+        consumed = true;
+    } else if(event->type == InputTypeShort && dap_stats_view->callback) {
+        if(event->key == InputKeyLeft) {
+            dap_stats_view->callback(DapStatsViewEventReset, dap_stats_view->context);
+            consumed = true;
+        } else if(event->key == InputKeyOk) {
+            dap_stats_view->callback(DapStatsViewEventSave, dap_stats_view->context);
+            consumed = true;
+        }
+    }
+
+    return consumed;
+}
+
+DapStatsView* dap_stats_view_alloc() {
+    DapStatsView* dap_stats_view = malloc(sizeof(DapStatsView));
+
+    dap_stats_view->view = view_alloc();
+    view_allocate_model(dap_stats_view->view, ViewModelTypeLocking, sizeof(DapStatsViewModel));
+    view_set_context(dap_stats_view->view, dap_stats_view);
+    view_set_draw_callback(dap_stats_view->view, dap_stats_view_draw_callback);
+    view_set_input_callback(dap_stats_view->view, dap_stats_view_input_callback);
+    return dap_stats_view;
+}
+
+void dap_stats_view_free(DapStatsView* dap_stats_view) {
+    view_free(dap_stats_view->view);
+    free(dap_stats_view);
+}
+
+View* dap_stats_view_get_view(DapStatsView* dap_stats_view) {
+    return dap_stats_view->view;
+}
+
+void dap_stats_view_set_callback(
+    DapStatsView* dap_stats_view,
+    DapStatsViewCallback callback,
+    void* context) {
+    with_view_model(
+        dap_stats_view->view,
+        DapStatsViewModel * model,
+        {
+            UNUSED(model);
+            dap_stats_view->callback = callback;
+            dap_stats_view->context = context;
+        },
+        false);
+}
+
+void dap_stats_view_set_stats(DapStatsView* dap_stats_view, const DapStats* stats) {
+    with_view_model(
+        dap_stats_view->view,
+        DapStatsViewModel * model,
+        {
+            model->stats = *stats;
+            // Commands disappear after a reset
+            size_t row_count = dap_stats_view_get_row_count(model);
+            if(model->offset + DAP_STATS_VIEW_ROWS > row_count) {
+                model->offset = row_count > DAP_STATS_VIEW_ROWS ? row_count - DAP_STATS_VIEW_ROWS :
+                                                                  0;
+            }
+        },
+        true);
+}
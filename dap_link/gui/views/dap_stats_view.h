@@ -0,0 +1,25 @@
+#pragma once
+#include <gui/view.h>
+#include "../../stats/dap_stats.h"
+
+typedef struct DapStatsView DapStatsView;
+
+typedef enum {
+    DapStatsViewEventReset,
+    DapStatsViewEventSave,
+} DapStatsViewEvent;
+
+typedef void (*DapStatsViewCallback)(DapStatsViewEvent event, void* context);
+
+DapStatsView* dap_stats_view_alloc();
+
+void dap_stats_view_free(DapStatsView* dap_stats_view);
+
+View* dap_stats_view_get_view(DapStatsView* dap_stats_view);
+
+void dap_stats_view_set_callback(
+    DapStatsView* dap_stats_view,
+    DapStatsViewCallback callback,
+    void* context);
+
+void dap_stats_view_set_stats(DapStatsView* dap_stats_view, const DapStats* stats);
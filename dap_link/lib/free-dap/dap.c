@@ -36,6 +36,12 @@
 /*- Definitions -------------------------------------------------------------*/
 #define ARRAY_SIZE(x)  ((int)(sizeof(x) / sizeof(0[x])))
 
+#ifdef DAP_CONFIG_ENABLE_SWD_STATS
+  #define DAP_SWD_STATS_ADD(field, value)  dap_swd_stats.field += (value)
+#else
+  #define DAP_SWD_STATS_ADD(field, value)
+#endif
+
 enum
 {
   ID_DAP_INFO               = 0x00,
@@ -187,6 +193,40 @@ enum
   SWD_SEQUENCE_DIN          = 0x80,
 };
 
+enum
+{
+  SWO_TRANSPORT_NONE        = 0,
+  SWO_TRANSPORT_DATA        = 1,
+  SWO_TRANSPORT_ENDPOINT    = 2,
+};
+
+enum
+{
+  SWO_MODE_OFF              = 0,
+  SWO_MODE_UART             = 1,
+  SWO_MODE_MANCHESTER       = 2,
+};
+
+enum
+{
+  SWO_CONTROL_STOP          = 0,
+  SWO_CONTROL_START         = 1,
+};
+
+enum
+{
+  SWO_STATUS_CAPTURE        = 1 << 0,
+  SWO_STATUS_STREAM_ERROR   = 1 << 6,
+  SWO_STATUS_OVERRUN        = 1 << 7,
+};
+
+enum
+{
+  SWO_EXT_STATUS_TRACE      = 1 << 0,
+  SWO_EXT_STATUS_COUNT      = 1 << 1,
+  SWO_EXT_STATUS_INDEX      = 1 << 2,
+};
+
 #define ARM_JTAG_IR_LENGTH  4
 
 /*- Constants ---------------------------------------------------------------*/
@@ -251,12 +291,17 @@ static int dap_req_ptr;
 static uint8_t *dap_resp_buf;
 static int dap_resp_size;
 static int dap_resp_ptr;
+static int dap_resp_base;
 
 static bool dap_buf_error;
 
 static int dap_swd_turnaround;
 static bool dap_swd_data_phase;
 
+#ifdef DAP_CONFIG_ENABLE_SWD_FAST_PATH
+static bool dap_swd_fast;
+#endif
+
 #ifdef DAP_CONFIG_ENABLE_JTAG
 static int dap_jtag_dev_count;
 static int dap_jtag_dev_index;
@@ -266,6 +311,16 @@ static int dap_jtag_ir_after[DAP_CONFIG_JTAG_DEV_COUNT];
 static int dap_jtag_ir;
 #endif
 
+#ifdef DAP_CONFIG_ENABLE_SWD_STATS
+static dap_swd_stats_t dap_swd_stats;
+#endif
+
+#ifdef DAP_CONFIG_ENABLE_SWO
+static int dap_swo_config_transport;
+static int dap_swo_config_mode;
+static uint32_t dap_swo_config_baudrate;
+#endif
+
 /*- Implementations ---------------------------------------------------------*/
 
 //-----------------------------------------------------------------------------
@@ -343,13 +398,11 @@ static inline uint32_t dap_parity(uint32_t value)
 }
 
 //-----------------------------------------------------------------------------
-static int dap_swd_operation(int req, uint32_t *data)
+static int dap_swd_operation_generic(int req, uint32_t *data)
 {
   uint32_t value;
   int ack = 0;
 
-  req &= (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | DAP_TRANSFER_A2 | DAP_TRANSFER_A3);
-
   dap_swd_write(0x81 | (dap_parity(req) << 5) | (req << 1), 8);
 
   DAP_CONFIG_SWDIO_TMS_in();
@@ -358,6 +411,8 @@ static int dap_swd_operation(int req, uint32_t *data)
 
   ack = dap_swd_read(3);
 
+  DAP_SWD_STATS_ADD(clock_cycles, 8 + dap_swd_turnaround + 3);
+
   if (DAP_TRANSFER_OK == ack)
   {
     if (req & DAP_TRANSFER_RnW)
@@ -365,7 +420,10 @@ static int dap_swd_operation(int req, uint32_t *data)
       value = dap_swd_read(32);
 
       if (dap_parity(value) != dap_swd_read(1))
+      {
         ack = DAP_TRANSFER_ERROR;
+        DAP_SWD_STATS_ADD(errors, 1);
+      }
 
       if (data)
         *data = value;
@@ -386,6 +444,8 @@ static int dap_swd_operation(int req, uint32_t *data)
 
     DAP_CONFIG_SWDIO_TMS_write(0);
     dap_swj_run(dap_idle_cycles);
+
+    DAP_SWD_STATS_ADD(clock_cycles, 32 + 1 + dap_swd_turnaround + dap_idle_cycles);
   }
 
   else if (DAP_TRANSFER_WAIT == ack || DAP_TRANSFER_FAULT == ack)
@@ -402,11 +462,18 @@ static int dap_swd_operation(int req, uint32_t *data)
       DAP_CONFIG_SWDIO_TMS_write(0);
       dap_swj_run(32 + 1);
     }
+
+    DAP_SWD_STATS_ADD(clock_cycles, dap_swd_turnaround + (dap_swd_data_phase ? 32 + 1 : 0));
+    DAP_SWD_STATS_ADD(waits, (DAP_TRANSFER_WAIT == ack) ? 1 : 0);
+    DAP_SWD_STATS_ADD(faults, (DAP_TRANSFER_FAULT == ack) ? 1 : 0);
   }
 
   else
   {
     dap_swj_run(dap_swd_turnaround + 32 + 1);
+
+    DAP_SWD_STATS_ADD(clock_cycles, dap_swd_turnaround + 32 + 1);
+    DAP_SWD_STATS_ADD(errors, 1);
   }
 
   DAP_CONFIG_SWDIO_TMS_write(1);
@@ -414,6 +481,118 @@ static int dap_swd_operation(int req, uint32_t *data)
   return ack;
 }
 
+#ifdef DAP_CONFIG_ENABLE_SWD_FAST_PATH
+//-----------------------------------------------------------------------------
+DAP_CONFIG_PERFORMANCE_ATTR
+static int dap_swd_operation_fast(int req, uint32_t *data)
+{
+  uint32_t value;
+  uint32_t parity_error;
+  int ack = 0;
+
+  DAP_CONFIG_SWD_FAST_write(0x81 | (dap_parity(req) << 5) | (req << 1), 8);
+
+  DAP_CONFIG_SWDIO_TMS_in();
+
+  DAP_CONFIG_SWD_FAST_clock(dap_swd_turnaround);
+
+  ack = DAP_CONFIG_SWD_FAST_read(3);
+
+  DAP_SWD_STATS_ADD(clock_cycles, 8 + dap_swd_turnaround + 3);
+
+  if (DAP_TRANSFER_OK == ack)
+  {
+    if (req & DAP_TRANSFER_RnW)
+    {
+      value = DAP_CONFIG_SWD_FAST_read(32);
+      parity_error = dap_parity(value) ^ DAP_CONFIG_SWD_FAST_read(1);
+
+      // DAP_TRANSFER_OK becomes DAP_TRANSFER_ERROR on parity mismatch
+      ack <<= parity_error * 3;
+      DAP_SWD_STATS_ADD(errors, parity_error);
+
+      if (data)
+        *data = value;
+
+      DAP_CONFIG_SWD_FAST_clock(dap_swd_turnaround);
+
+      DAP_CONFIG_SWDIO_TMS_out();
+    }
+    else
+    {
+      DAP_CONFIG_SWD_FAST_clock(dap_swd_turnaround);
+
+      DAP_CONFIG_SWDIO_TMS_out();
+
+      value = *data;
+      DAP_CONFIG_SWD_FAST_write(value, 32);
+      DAP_CONFIG_SWD_FAST_write(dap_parity(value), 1);
+    }
+
+    DAP_CONFIG_SWDIO_TMS_write(0);
+    DAP_CONFIG_SWD_FAST_clock(dap_idle_cycles);
+
+    DAP_SWD_STATS_ADD(clock_cycles, 32 + 1 + dap_swd_turnaround + dap_idle_cycles);
+  }
+
+  else if (DAP_TRANSFER_WAIT == ack || DAP_TRANSFER_FAULT == ack)
+  {
+    if (dap_swd_data_phase && (req & DAP_TRANSFER_RnW))
+      DAP_CONFIG_SWD_FAST_clock(32 + 1);
+
+    DAP_CONFIG_SWD_FAST_clock(dap_swd_turnaround);
+
+    DAP_CONFIG_SWDIO_TMS_out();
+
+    if (dap_swd_data_phase && (0 == (req & DAP_TRANSFER_RnW)))
+    {
+      DAP_CONFIG_SWDIO_TMS_write(0);
+      DAP_CONFIG_SWD_FAST_clock(32 + 1);
+    }
+
+    DAP_SWD_STATS_ADD(clock_cycles, dap_swd_turnaround + (dap_swd_data_phase ? 32 + 1 : 0));
+    DAP_SWD_STATS_ADD(waits, (DAP_TRANSFER_WAIT == ack) ? 1 : 0);
+    DAP_SWD_STATS_ADD(faults, (DAP_TRANSFER_FAULT == ack) ? 1 : 0);
+  }
+
+  else
+  {
+    DAP_CONFIG_SWD_FAST_clock(dap_swd_turnaround + 32 + 1);
+
+    DAP_SWD_STATS_ADD(clock_cycles, dap_swd_turnaround + 32 + 1);
+    DAP_SWD_STATS_ADD(errors, 1);
+  }
+
+  DAP_CONFIG_SWDIO_TMS_write(1);
+
+  return ack;
+}
+#endif // DAP_CONFIG_ENABLE_SWD_FAST_PATH
+
+//-----------------------------------------------------------------------------
+static int dap_swd_operation(int req, uint32_t *data)
+{
+  int ack;
+
+#ifdef DAP_CONFIG_ENABLE_SWD_STATS
+  uint32_t start = DAP_CONFIG_CYCLE_COUNTER();
+#endif
+
+  req &= (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | DAP_TRANSFER_A2 | DAP_TRANSFER_A3);
+
+#ifdef DAP_CONFIG_ENABLE_SWD_FAST_PATH
+  if (dap_swd_fast)
+    ack = dap_swd_operation_fast(req, data);
+  else
+#endif
+    ack = dap_swd_operation_generic(req, data);
+
+  DAP_SWD_STATS_ADD(transfers, 1);
+  DAP_SWD_STATS_ADD(cpu_cycles, DAP_CONFIG_CYCLE_COUNTER() - start);
+
+  return ack;
+}
+
 #ifdef DAP_CONFIG_ENABLE_JTAG
 //-----------------------------------------------------------------------------
 #define DAP_JTAG_FN(ver, delay) \
@@ -607,6 +786,9 @@ static void dap_setup_clock(int freq)
     dap_swj_run     = dap_swj_run_fast;
     dap_swd_write   = dap_swd_write_fast;
     dap_swd_read    = dap_swd_read_fast;
+#ifdef DAP_CONFIG_ENABLE_SWD_FAST_PATH
+    dap_swd_fast    = true;
+#endif
 #ifdef DAP_CONFIG_ENABLE_JTAG
     dap_jtag_write  = dap_jtag_write_fast;
     dap_jtag_read   = dap_jtag_read_fast;
@@ -619,6 +801,9 @@ static void dap_setup_clock(int freq)
     dap_swj_run     = dap_swj_run_slow;
     dap_swd_write   = dap_swd_write_slow;
     dap_swd_read    = dap_swd_read_slow;
+#ifdef DAP_CONFIG_ENABLE_SWD_FAST_PATH
+    dap_swd_fast    = false;
+#endif
 #ifdef DAP_CONFIG_ENABLE_JTAG
     dap_jtag_write  = dap_jtag_write_slow;
     dap_jtag_read   = dap_jtag_read_slow;
@@ -698,6 +883,7 @@ static void dap_buf_init(uint8_t *req, int req_size, uint8_t *resp, int resp_siz
   dap_resp_buf  = resp;
   dap_resp_size = resp_size;
   dap_resp_ptr  = 0;
+  dap_resp_base = 0;
 
   dap_buf_error = false;
 }
@@ -750,6 +936,12 @@ uint32_t dap_req_get_word(void)
   return value;
 }
 
+//-----------------------------------------------------------------------------
+int dap_req_get_remaining(void)
+{
+  return dap_buf_error ? 0 : (dap_req_size - dap_req_ptr);
+}
+
 //-----------------------------------------------------------------------------
 void dap_resp_add_byte(uint8_t value)
 {
@@ -779,8 +971,11 @@ void dap_resp_add_word(uint32_t value)
 }
 
 //-----------------------------------------------------------------------------
+// The index is relative to the response of the command being processed
 void dap_resp_set_byte(int index, uint8_t value)
 {
+  index += dap_resp_base;
+
   if (index < dap_resp_ptr)
     dap_resp_buf[index] = value;
 }
@@ -791,6 +986,30 @@ bool dap_is_buf_error(void)
   return dap_buf_error;
 }
 
+//-----------------------------------------------------------------------------
+int dap_vendor_transfer(int index, int request, uint32_t *data)
+{
+  // Single DP/AP transfer with WAIT retries, for use by the vendor commands.
+  // Posted AP reads and RDBUFF are left to the caller.
+  if (!dap_select_device(index))
+    return DAP_TRANSFER_INVALID;
+
+  return dap_transfer_word(request, data);
+}
+
+//-----------------------------------------------------------------------------
+bool dap_vendor_is_aborted(void)
+{
+  return dap_abort;
+}
+
+//-----------------------------------------------------------------------------
+bool dap_vendor_is_swd(void)
+{
+  // Posted AP reads and RDBUFF follow the SWD rules, JTAG would need its own handling.
+  return DAP_PORT_SWD == dap_port;
+}
+
 //-----------------------------------------------------------------------------
 static void dap_info(void)
 {
@@ -798,9 +1017,12 @@ static void dap_info(void)
 
   if (DAP_INFO_CAPABILITIES == index)
   {
-    int cap = DAP_CAP_SWD;
+    int cap = DAP_CAP_SWD | DAP_CAP_ATOMIC_CMD;
 #ifdef DAP_CONFIG_ENABLE_JTAG
     cap |= DAP_CAP_JTAG;
+#endif
+#ifdef DAP_CONFIG_ENABLE_SWO
+    cap |= DAP_CAP_SWO_UART | DAP_CAP_SWO_STREAMING;
 #endif
     dap_resp_add_byte(1);
     dap_resp_add_byte(cap);
@@ -816,6 +1038,13 @@ static void dap_info(void)
     dap_resp_add_byte(DAP_CONFIG_PACKET_SIZE & 0xff);
     dap_resp_add_byte((DAP_CONFIG_PACKET_SIZE >> 8) & 0xff);
   }
+#ifdef DAP_CONFIG_ENABLE_SWO
+  else if (DAP_INFO_SWO_BUF_SIZE == index)
+  {
+    dap_resp_add_byte(4);
+    dap_resp_add_word(DAP_CONFIG_SWO_BUFFER_SIZE);
+  }
+#endif
   else
   {
     dap_resp_add_byte(0); // Size placeholder
@@ -830,7 +1059,7 @@ static void dap_info(void)
           dap_resp_add_byte(*str++);
         dap_resp_add_byte(0);
 
-        dap_resp_set_byte(1, dap_resp_ptr-2);
+        dap_resp_set_byte(1, dap_resp_ptr-dap_resp_base-2);
 
         break;
       }
@@ -1389,6 +1618,143 @@ static void dap_jtag_idcode(void)
 #endif
 }
 
+#ifdef DAP_CONFIG_ENABLE_SWO
+//-----------------------------------------------------------------------------
+static int dap_swo_get_status(void)
+{
+  int status = DAP_CONFIG_SWO_ACTIVE_FN() ? SWO_STATUS_CAPTURE : 0;
+
+  if (DAP_CONFIG_SWO_ERROR_FN())
+    status |= SWO_STATUS_OVERRUN;
+
+  return status;
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_transport(void)
+{
+  int transport = dap_req_get_byte();
+
+  if (DAP_CONFIG_SWO_ACTIVE_FN() || transport > SWO_TRANSPORT_ENDPOINT)
+  {
+    dap_resp_add_byte(DAP_ERROR);
+    return;
+  }
+
+  dap_swo_config_transport = transport;
+  dap_resp_add_byte(DAP_OK);
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_mode(void)
+{
+  int mode = dap_req_get_byte();
+
+  if (DAP_CONFIG_SWO_ACTIVE_FN() || (SWO_MODE_OFF != mode && SWO_MODE_UART != mode))
+  {
+    dap_resp_add_byte(DAP_ERROR);
+    return;
+  }
+
+  dap_swo_config_mode = mode;
+  dap_resp_add_byte(DAP_OK);
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_baudrate(void)
+{
+  uint32_t baudrate = dap_req_get_word();
+
+  if (baudrate > DAP_CONFIG_SWO_MAX_BAUDRATE)
+    baudrate = DAP_CONFIG_SWO_MAX_BAUDRATE;
+
+  dap_swo_config_baudrate = baudrate;
+
+  if (DAP_CONFIG_SWO_ACTIVE_FN())
+  {
+    DAP_CONFIG_SWO_STOP_FN();
+
+    if (baudrate)
+      DAP_CONFIG_SWO_START_FN(dap_swo_config_transport, baudrate);
+  }
+
+  dap_resp_add_word(baudrate);
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_control(void)
+{
+  int control = dap_req_get_byte();
+
+  if (SWO_CONTROL_START == control && !DAP_CONFIG_SWO_ACTIVE_FN())
+  {
+    if (SWO_MODE_UART != dap_swo_config_mode || 0 == dap_swo_config_baudrate ||
+        !DAP_CONFIG_SWO_START_FN(dap_swo_config_transport, dap_swo_config_baudrate))
+    {
+      dap_resp_add_byte(DAP_ERROR);
+      return;
+    }
+  }
+  else if (SWO_CONTROL_STOP == control)
+  {
+    DAP_CONFIG_SWO_STOP_FN();
+  }
+
+  dap_resp_add_byte(DAP_OK);
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_status(void)
+{
+  dap_resp_add_byte(dap_swo_get_status());
+  dap_resp_add_word(DAP_CONFIG_SWO_COUNT_FN());
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_ext_status(void)
+{
+  int control = dap_req_get_byte();
+
+  if (control & SWO_EXT_STATUS_TRACE)
+    dap_resp_add_byte(dap_swo_get_status());
+
+  if (control & SWO_EXT_STATUS_COUNT)
+    dap_resp_add_word(DAP_CONFIG_SWO_COUNT_FN());
+
+  if (control & SWO_EXT_STATUS_INDEX)
+  {
+    dap_resp_add_word(DAP_CONFIG_SWO_INDEX_FN());
+    dap_resp_add_word(0); // No test domain timer
+  }
+}
+
+//-----------------------------------------------------------------------------
+static void dap_swo_data(void)
+{
+  int size = dap_req_get_half();
+  int count = 0;
+
+  dap_resp_add_byte(dap_swo_get_status());
+  dap_resp_add_byte(0); // Count placeholder
+  dap_resp_add_byte(0);
+
+  // Data is only served here when it is not streamed over the SWO endpoint
+  if (SWO_TRANSPORT_DATA == dap_swo_config_transport && !dap_buf_error)
+  {
+    int space = dap_resp_size - dap_resp_ptr;
+
+    if (size > space)
+      size = space;
+
+    count = DAP_CONFIG_SWO_READ_FN(&dap_resp_buf[dap_resp_ptr], size);
+    dap_resp_ptr += count;
+  }
+
+  dap_resp_set_byte(2, count);
+  dap_resp_set_byte(3, count >> 8);
+}
+#endif
+
 //-----------------------------------------------------------------------------
 void dap_init(void)
 {
@@ -1403,6 +1769,11 @@ void dap_init(void)
 #ifdef DAP_CONFIG_ENABLE_JTAG
   dap_jtag_dev_count = 0;
 #endif
+#ifdef DAP_CONFIG_ENABLE_SWO
+  dap_swo_config_transport = SWO_TRANSPORT_NONE;
+  dap_swo_config_mode      = SWO_MODE_OFF;
+  dap_swo_config_baudrate  = 0;
+#endif
 
   dap_setup_clock(DAP_CONFIG_DEFAULT_CLOCK);
 
@@ -1424,7 +1795,13 @@ bool dap_filter_request(uint8_t *req)
 }
 
 //-----------------------------------------------------------------------------
-int dap_process_request(uint8_t *req, int req_size, uint8_t *resp, int resp_size)
+bool dap_is_queued_request(uint8_t *req)
+{
+  return ID_DAP_QUEUE_COMMANDS == req[0];
+}
+
+//-----------------------------------------------------------------------------
+static bool dap_process_command(void)
 {
   static const struct
   {
@@ -1451,16 +1828,19 @@ int dap_process_request(uint8_t *req, int req_size, uint8_t *resp, int resp_size
     { ID_DAP_JTAG_SEQUENCE,		dap_jtag_sequence },
     { ID_DAP_JTAG_CONFIGURE,		dap_jtag_configure },
     { ID_DAP_JTAG_IDCODE,		dap_jtag_idcode },
+#ifdef DAP_CONFIG_ENABLE_SWO
+    { ID_DAP_SWO_TRANSPORT,		dap_swo_transport },
+    { ID_DAP_SWO_MODE,			dap_swo_mode },
+    { ID_DAP_SWO_BAUDRATE,		dap_swo_baudrate },
+    { ID_DAP_SWO_CONTROL,		dap_swo_control },
+    { ID_DAP_SWO_STATUS,		dap_swo_status },
+    { ID_DAP_SWO_EXT_STATUS,		dap_swo_ext_status },
+    { ID_DAP_SWO_DATA,			dap_swo_data },
+#endif
   };
   int cmd;
 
-  dap_buf_init(req, req_size, resp, resp_size);
-
-  dap_abort = false;
-
-#ifdef DAP_CONFIG_ENABLE_JTAG
-  dap_jtag_ir = JTAG_INVALID;
-#endif
+  dap_resp_base = dap_resp_ptr;
 
   cmd = dap_req_get_byte();
   dap_resp_add_byte(cmd);
@@ -1470,7 +1850,7 @@ int dap_process_request(uint8_t *req, int req_size, uint8_t *resp, int resp_size
     if (cmd == handlers[i].cmd)
     {
       handlers[i].handler();
-      return dap_resp_ptr;
+      return true;
     }
   }
 
@@ -1481,11 +1861,62 @@ int dap_process_request(uint8_t *req, int req_size, uint8_t *resp, int resp_size
 #else
     dap_resp_add_byte(DAP_ERROR);
 #endif
-    return dap_resp_ptr;
+    return true;
   }
 
   dap_resp_set_byte(0, ID_DAP_INVALID);
 
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+static void dap_execute_commands(void)
+{
+  int count = dap_req_get_byte();
+  int executed = 0;
+
+  dap_resp_add_byte(0); // Count placeholder
+
+  // Nested DAP_ExecuteCommands are not allowed and end up as invalid commands.
+  // Parsing can't continue past an invalid command, so it stops the sequence.
+  while (executed < count && !dap_buf_error)
+  {
+    bool valid = dap_process_command();
+
+    executed++;
+
+    if (!valid)
+      break;
+  }
+
+  dap_resp_base = 0;
+  dap_resp_set_byte(1, executed);
+}
+
+//-----------------------------------------------------------------------------
+int dap_process_request(uint8_t *req, int req_size, uint8_t *resp, int resp_size)
+{
+  dap_buf_init(req, req_size, resp, resp_size);
+
+  dap_abort = false;
+
+#ifdef DAP_CONFIG_ENABLE_JTAG
+  dap_jtag_ir = JTAG_INVALID;
+#endif
+
+  // Queued commands are held back by the caller until a regular request
+  // arrives, after that they are executed the same way as DAP_ExecuteCommands
+  if (req_size > 0 && (ID_DAP_EXECUTE_COMMANDS == req[0] || ID_DAP_QUEUE_COMMANDS == req[0]))
+  {
+    dap_req_get_byte();
+    dap_resp_add_byte(ID_DAP_EXECUTE_COMMANDS);
+    dap_execute_commands();
+  }
+  else
+  {
+    dap_process_command();
+  }
+
   return dap_resp_ptr;
 }
 
@@ -1507,3 +1938,21 @@ void dap_clock_test(int delay)
       dap_swj_run_fast(1<<30);
   }
 }
+
+//-----------------------------------------------------------------------------
+void dap_swd_get_stats(dap_swd_stats_t *stats)
+{
+#ifdef DAP_CONFIG_ENABLE_SWD_STATS
+  *stats = dap_swd_stats;
+#else
+  memset(stats, 0, sizeof(dap_swd_stats_t));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void dap_swd_reset_stats(void)
+{
+#ifdef DAP_CONFIG_ENABLE_SWD_STATS
+  memset(&dap_swd_stats, 0, sizeof(dap_swd_stats_t));
+#endif
+}
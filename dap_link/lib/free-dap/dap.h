@@ -33,18 +33,36 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/*- Types -------------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t transfers;
+  uint32_t waits;
+  uint32_t faults;
+  uint32_t errors;
+  uint64_t clock_cycles;
+  uint64_t cpu_cycles;
+} dap_swd_stats_t;
+
 /*- Prototypes --------------------------------------------------------------*/
 void dap_init(void);
 uint8_t dap_req_get_byte(void);
 uint16_t dap_req_get_half(void);
 uint32_t dap_req_get_word(void);
+int dap_req_get_remaining(void);
 void dap_resp_add_byte(uint8_t value);
 void dap_resp_add_word(uint32_t value);
 void dap_resp_set_byte(int index, uint8_t value);
 bool dap_is_buf_error(void);
+int dap_vendor_transfer(int index, int request, uint32_t *data);
+bool dap_vendor_is_aborted(void);
+bool dap_vendor_is_swd(void);
 bool dap_filter_request(uint8_t *req);
+bool dap_is_queued_request(uint8_t *req);
 int dap_process_request(uint8_t *req, int req_size, uint8_t *resp, int resp_size);
 void dap_clock_test(int delay);
+void dap_swd_get_stats(dap_swd_stats_t *stats);
+void dap_swd_reset_stats(void);
 
 #endif // _DAP_H_
 
@@ -0,0 +1,286 @@
+#include "dap_mem_block.h"
+#include <furi.h>
+#include <dap.h>
+#include "../dap_config.h"
+
+// CMSIS-DAP transfer request bits, register address goes in bits 2 and 3
+#define DAP_REQUEST_APnDP (1 << 0)
+#define DAP_REQUEST_RnW (1 << 1)
+
+#define DAP_TRANSFER_INVALID 0
+#define DAP_TRANSFER_OK (1 << 0)
+#define DAP_TRANSFER_FAULT (1 << 2)
+
+#define DP_CTRL_STAT 0x04
+#define DP_SELECT 0x08
+#define DP_RDBUFF 0x0C
+
+#define AP_CSW 0x00
+#define AP_TAR 0x04
+#define AP_DRW 0x0C
+
+// STICKYORUN, STICKYCMP, STICKYERR and WDATAERR
+#define DP_CTRL_STAT_STICKY_MASK ((1 << 1) | (1 << 4) | (1 << 5) | (1 << 7))
+
+// TAR auto-increment is only guaranteed within a 1 KiB block
+#define TAR_INCREMENT_MASK 0x3FF
+
+#define ID_DAP_VENDOR_0 0x80
+
+// Command, status and word count, followed by the data
+#define DAP_MEM_BLOCK_HEADER_SIZE 3
+#define DAP_MEM_BLOCK_PACKET_WORDS \
+    ((DAP_CONFIG_PACKET_SIZE - DAP_MEM_BLOCK_HEADER_SIZE) / sizeof(uint32_t))
+
+typedef enum {
+    DapMemBlockIdle,
+    DapMemBlockRead,
+    DapMemBlockWrite,
+} DapMemBlockState;
+
+typedef struct {
+    DapMemBlockState state;
+    int index;
+    uint32_t address; // Next address to be accessed through DRW
+    uint32_t remaining; // Words left in the block
+    uint32_t written;
+    int ack;
+    bool tar_valid;
+    bool read_posted; // An AP read is in flight, its data comes with the next read
+    bool skip_response;
+} DapMemBlock;
+
+static DapMemBlock dap_mem_block = {0};
+
+static int dap_mem_block_dp_read(int reg, uint32_t* value) {
+    return dap_vendor_transfer(dap_mem_block.index, DAP_REQUEST_RnW | reg, value);
+}
+
+static int dap_mem_block_ap_read(int reg, uint32_t* value) {
+    return dap_vendor_transfer(
+        dap_mem_block.index, DAP_REQUEST_APnDP | DAP_REQUEST_RnW | reg, value);
+}
+
+static int dap_mem_block_ap_write(int reg, uint32_t value) {
+    return dap_vendor_transfer(dap_mem_block.index, DAP_REQUEST_APnDP | reg, &value);
+}
+
+static void dap_mem_block_advance(void) {
+    dap_mem_block.address += sizeof(uint32_t);
+    if((dap_mem_block.address & TAR_INCREMENT_MASK) == 0) {
+        dap_mem_block.tar_valid = false;
+    }
+}
+
+static int dap_mem_block_check_sticky(void) {
+    uint32_t ctrl_stat = 0;
+    int ack = dap_mem_block_dp_read(DP_CTRL_STAT, &ctrl_stat);
+    if(ack == DAP_TRANSFER_OK && (ctrl_stat & DP_CTRL_STAT_STICKY_MASK)) {
+        ack = DAP_TRANSFER_FAULT;
+    }
+    return ack;
+}
+
+// Request: index, AP, CSW, address, length in bytes
+static int dap_mem_block_setup(DapMemBlockState state) {
+    dap_mem_block.state = DapMemBlockIdle;
+    dap_mem_block.index = dap_req_get_byte();
+    uint32_t select = (uint32_t)dap_req_get_byte() << 24;
+    uint32_t csw = dap_req_get_word();
+    dap_mem_block.address = dap_req_get_word();
+    uint32_t length = dap_req_get_word();
+
+    // The transfer sequence relies on SWD posted reads, JTAG is not supported
+    if(dap_is_buf_error() || !dap_vendor_is_swd() ||
+       (dap_mem_block.address % sizeof(uint32_t)) || (length % sizeof(uint32_t))) {
+        dap_mem_block.ack = DAP_TRANSFER_INVALID;
+        return dap_mem_block.ack;
+    }
+
+    dap_mem_block.remaining = length / sizeof(uint32_t);
+    dap_mem_block.written = 0;
+    dap_mem_block.tar_valid = false;
+    dap_mem_block.read_posted = false;
+
+    // Leaves DP SELECT pointing at the AP, bank 0
+    int ack = dap_vendor_transfer(dap_mem_block.index, DP_SELECT, &select);
+    if(ack == DAP_TRANSFER_OK) {
+        ack = dap_mem_block_ap_write(AP_CSW, csw);
+    }
+
+    if(ack == DAP_TRANSFER_OK && dap_mem_block.remaining > 0) {
+        dap_mem_block.state = state;
+    }
+    dap_mem_block.ack = ack;
+
+    return ack;
+}
+
+static int dap_mem_block_read_word(uint32_t* value) {
+    int ack = DAP_TRANSFER_OK;
+
+    if(!dap_mem_block.read_posted) {
+        if(!dap_mem_block.tar_valid) {
+            ack = dap_mem_block_ap_write(AP_TAR, dap_mem_block.address);
+            if(ack != DAP_TRANSFER_OK) return ack;
+            dap_mem_block.tar_valid = true;
+        }
+
+        ack = dap_mem_block_ap_read(AP_DRW, NULL);
+        if(ack != DAP_TRANSFER_OK) return ack;
+        dap_mem_block.read_posted = true;
+        dap_mem_block_advance();
+    }
+
+    // Keep the AP pipeline full until the block or the TAR increment range ends
+    if(dap_mem_block.remaining > 1 && dap_mem_block.tar_valid) {
+        ack = dap_mem_block_ap_read(AP_DRW, value);
+        dap_mem_block_advance();
+    } else {
+        ack = dap_mem_block_dp_read(DP_RDBUFF, value);
+        dap_mem_block.read_posted = false;
+    }
+
+    dap_mem_block.remaining--;
+    return ack;
+}
+
+static int dap_mem_block_write_word(uint32_t value) {
+    int ack;
+
+    if(!dap_mem_block.tar_valid) {
+        ack = dap_mem_block_ap_write(AP_TAR, dap_mem_block.address);
+        if(ack != DAP_TRANSFER_OK) return ack;
+        dap_mem_block.tar_valid = true;
+    }
+
+    ack = dap_mem_block_ap_write(AP_DRW, value);
+    dap_mem_block_advance();
+    return ack;
+}
+
+static size_t dap_mem_block_read_packet(uint8_t* packet) {
+    uint8_t count = 0;
+    int ack = dap_mem_block.ack;
+
+    while(ack == DAP_TRANSFER_OK && dap_mem_block.state == DapMemBlockRead &&
+          count < DAP_MEM_BLOCK_PACKET_WORDS) {
+        uint32_t value = 0;
+        ack = dap_mem_block_read_word(&value);
+        if(ack != DAP_TRANSFER_OK) break;
+
+        uint8_t* data = &packet[DAP_MEM_BLOCK_HEADER_SIZE + count * sizeof(uint32_t)];
+        memcpy(data, &value, sizeof(uint32_t));
+        count++;
+
+        if(dap_mem_block.remaining == 0) {
+            ack = dap_mem_block_check_sticky();
+            dap_mem_block.state = DapMemBlockIdle;
+        }
+    }
+
+    if(ack != DAP_TRANSFER_OK) {
+        dap_mem_block.state = DapMemBlockIdle;
+    }
+    dap_mem_block.ack = ack;
+
+    packet[0] = ID_DAP_VENDOR_0 + DAP_MEM_BLOCK_CMD_READ;
+    packet[1] = ack;
+    packet[2] = count;
+    return DAP_MEM_BLOCK_HEADER_SIZE + count * sizeof(uint32_t);
+}
+
+// Response: status, word count, data. The rest of the block follows in packets of the same
+// format, sent without further requests.
+void dap_mem_block_read(void) {
+    uint8_t packet[DAP_CONFIG_PACKET_SIZE];
+
+    dap_mem_block_setup(DapMemBlockRead);
+    size_t size = dap_mem_block_read_packet(packet);
+
+    // Command byte is already in the response
+    for(size_t i = 1; i < size; i++) {
+        dap_resp_add_byte(packet[i]);
+    }
+}
+
+// Response: status. Data follows in DAP_MEM_BLOCK_CMD_WRITE_DATA requests.
+void dap_mem_block_write(void) {
+    int ack = dap_mem_block_setup(DapMemBlockWrite);
+    dap_resp_add_byte(ack);
+}
+
+// Request: word count, data. Only the last request of the block is answered,
+// with the status and the number of words written.
+void dap_mem_block_write_data(void) {
+    int count = dap_req_get_byte();
+
+    if(dap_mem_block.state == DapMemBlockWrite) {
+        // Missing words would read as 0, so a packet shorter than its word count ends the block
+        if(dap_is_buf_error() || count * (int)sizeof(uint32_t) > dap_req_get_remaining()) {
+            dap_mem_block.ack = DAP_TRANSFER_INVALID;
+            dap_mem_block.remaining = 0;
+        }
+
+        for(; count > 0 && dap_mem_block.remaining > 0; count--) {
+            uint32_t value = dap_req_get_word();
+            dap_mem_block.remaining--;
+
+            if(dap_is_buf_error()) {
+                dap_mem_block.ack = DAP_TRANSFER_INVALID;
+            }
+
+            // After an error the rest of the block is consumed, but not written
+            if(dap_mem_block.ack == DAP_TRANSFER_OK) {
+                dap_mem_block.ack = dap_mem_block_write_word(value);
+                if(dap_mem_block.ack == DAP_TRANSFER_OK) dap_mem_block.written++;
+            }
+        }
+
+        if(dap_mem_block.remaining > 0) {
+            dap_mem_block.skip_response = true;
+            return;
+        }
+
+        if(dap_mem_block.ack == DAP_TRANSFER_OK) {
+            dap_mem_block.ack = dap_mem_block_dp_read(DP_RDBUFF, NULL);
+        }
+        if(dap_mem_block.ack == DAP_TRANSFER_OK) {
+            dap_mem_block.ack = dap_mem_block_check_sticky();
+        }
+        dap_mem_block.state = DapMemBlockIdle;
+        dap_resp_add_byte(dap_mem_block.ack);
+    } else {
+        dap_resp_add_byte(DAP_TRANSFER_INVALID);
+    }
+
+    dap_resp_add_word(dap_mem_block.written);
+}
+
+bool dap_mem_block_skip_response(void) {
+    bool skip = dap_mem_block.skip_response;
+    dap_mem_block.skip_response = false;
+    return skip;
+}
+
+size_t dap_mem_block_read_next(uint8_t* packet) {
+    if(dap_mem_block.state != DapMemBlockRead) return 0;
+
+    if(dap_vendor_is_aborted()) {
+        dap_mem_block_cancel();
+        return 0;
+    }
+
+    return dap_mem_block_read_packet(packet);
+}
+
+void dap_mem_block_cancel_read(void) {
+    if(dap_mem_block.state == DapMemBlockRead) {
+        dap_mem_block.state = DapMemBlockIdle;
+    }
+}
+
+void dap_mem_block_cancel(void) {
+    dap_mem_block.state = DapMemBlockIdle;
+    dap_mem_block.skip_response = false;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Vendor command numbers, sent as ID_DAP_Vendor0 (0x80) + number
+#define DAP_MEM_BLOCK_CMD_READ 0x02
+#define DAP_MEM_BLOCK_CMD_WRITE 0x03
+#define DAP_MEM_BLOCK_CMD_WRITE_DATA 0x04
+
+// Vendor command handlers, called from dap_process_request()
+void dap_mem_block_read(void);
+
+void dap_mem_block_write(void);
+
+void dap_mem_block_write_data(void);
+
+// True once after a request that must not be answered (write data in the middle of a block)
+bool dap_mem_block_skip_response(void);
+
+// Next packet of a block read, 0 if there is nothing more to send
+size_t dap_mem_block_read_next(uint8_t* packet);
+
+void dap_mem_block_cancel_read(void);
+
+void dap_mem_block_cancel(void);
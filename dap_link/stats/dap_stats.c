@@ -0,0 +1,204 @@
+#include "dap_stats.h"
+#include <furi.h>
+#include <furi_hal_cortex.h>
+#include <storage/storage.h>
+#include "../dap_config.h"
+
+#define DAP_STATS_SLOT_QUEUE_COMMANDS 0x20
+#define DAP_STATS_SLOT_EXECUTE_COMMANDS 0x21
+#define DAP_STATS_SLOT_VENDOR 0x22
+#define DAP_STATS_SLOT_UNKNOWN 0x23
+
+#define ID_DAP_QUEUE_COMMANDS 0x7E
+#define ID_DAP_EXECUTE_COMMANDS 0x7F
+#define ID_DAP_VENDOR_0 0x80
+
+#define DAP_STATS_CSV_LINE_SIZE 160
+
+static const char* const dap_stats_command_names[DAP_STATS_COMMAND_COUNT] = {
+    [0x00] = "Info",
+    [0x01] = "HostStatus",
+    [0x02] = "Connect",
+    [0x03] = "Disconnect",
+    [0x04] = "TransferConf",
+    [0x05] = "Transfer",
+    [0x06] = "TransferBlock",
+    [0x07] = "TransferAbort",
+    [0x08] = "WriteABORT",
+    [0x09] = "Delay",
+    [0x0A] = "ResetTarget",
+    [0x10] = "SWJ_Pins",
+    [0x11] = "SWJ_Clock",
+    [0x12] = "SWJ_Sequence",
+    [0x13] = "SWD_Configure",
+    [0x14] = "JTAG_Sequence",
+    [0x15] = "JTAG_Configure",
+    [0x16] = "JTAG_IDCODE",
+    [0x17] = "SWO_Transport",
+    [0x18] = "SWO_Mode",
+    [0x19] = "SWO_Baudrate",
+    [0x1A] = "SWO_Control",
+    [0x1B] = "SWO_Status",
+    [0x1C] = "SWO_Data",
+    [0x1D] = "SWD_Sequence",
+    [0x1E] = "SWO_ExtStatus",
+    [0x1F] = "UART_Transport",
+    [DAP_STATS_SLOT_QUEUE_COMMANDS] = "QueueCmds",
+    [DAP_STATS_SLOT_EXECUTE_COMMANDS] = "ExecuteCmds",
+    [DAP_STATS_SLOT_VENDOR] = "Vendor",
+    [DAP_STATS_SLOT_UNKNOWN] = "Unknown",
+};
+
+typedef struct {
+    DapStatsCommand commands[DAP_STATS_COMMAND_COUNT];
+    uint32_t start_tick;
+    uint64_t busy_us;
+    uint64_t usb_us;
+} DapStatsState;
+
+static DapStatsState dap_stats = {0};
+
+static size_t dap_stats_slot(uint8_t command) {
+    if(command < DAP_STATS_SLOT_QUEUE_COMMANDS) return command;
+    if(command == ID_DAP_QUEUE_COMMANDS) return DAP_STATS_SLOT_QUEUE_COMMANDS;
+    if(command == ID_DAP_EXECUTE_COMMANDS) return DAP_STATS_SLOT_EXECUTE_COMMANDS;
+    if(command >= ID_DAP_VENDOR_0) return DAP_STATS_SLOT_VENDOR;
+    return DAP_STATS_SLOT_UNKNOWN;
+}
+
+static uint32_t dap_stats_elapsed_us(uint32_t start) {
+    return (DAP_CONFIG_CYCLE_COUNTER() - start) / furi_hal_cortex_instructions_per_microsecond();
+}
+
+void dap_stats_reset(void) {
+    memset(&dap_stats, 0, sizeof(DapStatsState));
+    dap_stats.start_tick = furi_get_tick();
+    dap_swd_reset_stats();
+}
+
+uint32_t dap_stats_timestamp(void) {
+    return DAP_CONFIG_CYCLE_COUNTER();
+}
+
+void dap_stats_add_command(uint8_t command, uint32_t start) {
+    uint32_t us = dap_stats_elapsed_us(start);
+    DapStatsCommand* stats = &dap_stats.commands[dap_stats_slot(command)];
+
+    // Buckets grow by a factor of 4, starting at 16us
+    size_t bucket = 0;
+    if(us >= 16) {
+        bucket = MIN((31 - __builtin_clz(us)) / 2 - 1, DAP_STATS_HISTOGRAM_SIZE - 1);
+    }
+
+    stats->count++;
+    stats->total_us += us;
+    stats->max_us = MAX(stats->max_us, us);
+    stats->histogram[bucket]++;
+    dap_stats.busy_us += us;
+}
+
+void dap_stats_add_usb(uint32_t start) {
+    dap_stats.usb_us += dap_stats_elapsed_us(start);
+}
+
+void dap_stats_get(DapStats* stats) {
+    memcpy(stats->commands, dap_stats.commands, sizeof(stats->commands));
+    stats->elapsed_ms = furi_get_tick() - dap_stats.start_tick;
+    stats->busy_us = dap_stats.busy_us;
+    stats->usb_us = dap_stats.usb_us;
+    dap_swd_get_stats(&stats->swd);
+}
+
+const char* dap_stats_get_command_name(size_t index) {
+    furi_assert(index < DAP_STATS_COMMAND_COUNT);
+    return dap_stats_command_names[index] ? dap_stats_command_names[index] : "Reserved";
+}
+
+uint32_t dap_stats_get_histogram_limit(size_t bucket) {
+    furi_assert(bucket < DAP_STATS_HISTOGRAM_SIZE);
+    if(bucket == DAP_STATS_HISTOGRAM_SIZE - 1) return 0;
+    return 16UL << (bucket * 2);
+}
+
+uint32_t dap_stats_get_swd_bitrate(const DapStats* stats) {
+    if(stats->swd.cpu_cycles == 0) return 0;
+    return (uint64_t)stats->swd.clock_cycles * SystemCoreClock / stats->swd.cpu_cycles;
+}
+
+static bool dap_stats_write_line(File* file, FuriString* line) {
+    furi_string_push_back(line, '\n');
+    size_t size = furi_string_size(line);
+    bool success = storage_file_write(file, furi_string_get_cstr(line), size) == size;
+    furi_string_reset(line);
+    return success;
+}
+
+bool dap_stats_save_csv(const DapStats* stats, const char* path) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    FuriString* line = furi_string_alloc();
+    furi_string_reserve(line, DAP_STATS_CSV_LINE_SIZE);
+    bool success = false;
+
+    do {
+        if(!storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+
+        furi_string_printf(line, "command,count,total_us,avg_us,max_us");
+        for(size_t bucket = 0; bucket < DAP_STATS_HISTOGRAM_SIZE; bucket++) {
+            uint32_t limit = dap_stats_get_histogram_limit(bucket);
+            if(limit) {
+                furi_string_cat_printf(line, ",lt_%luus", limit);
+            } else {
+                furi_string_cat_printf(line, ",longer");
+            }
+        }
+        if(!dap_stats_write_line(file, line)) break;
+
+        size_t index;
+        for(index = 0; index < DAP_STATS_COMMAND_COUNT; index++) {
+            const DapStatsCommand* command = &stats->commands[index];
+            if(command->count == 0) continue;
+
+            furi_string_printf(
+                line,
+                "%s,%lu,%llu,%lu,%lu",
+                dap_stats_get_command_name(index),
+                command->count,
+                command->total_us,
+                (uint32_t)(command->total_us / command->count),
+                command->max_us);
+            for(size_t bucket = 0; bucket < DAP_STATS_HISTOGRAM_SIZE; bucket++) {
+                furi_string_cat_printf(line, ",%lu", command->histogram[bucket]);
+            }
+            if(!dap_stats_write_line(file, line)) break;
+        }
+        if(index < DAP_STATS_COMMAND_COUNT) break;
+
+        // Session totals as comment lines, so the table above stays importable
+        furi_string_printf(
+            line,
+            "# elapsed_ms %lu, busy_us %llu, usb_us %llu",
+            stats->elapsed_ms,
+            stats->busy_us,
+            stats->usb_us);
+        if(!dap_stats_write_line(file, line)) break;
+
+        furi_string_printf(
+            line,
+            "# swd transfers %lu, wait %lu, fault %lu, error %lu, bitrate_hz %lu",
+            stats->swd.transfers,
+            stats->swd.waits,
+            stats->swd.faults,
+            stats->swd.errors,
+            dap_stats_get_swd_bitrate(stats));
+        if(!dap_stats_write_line(file, line)) break;
+
+        success = true;
+    } while(0);
+
+    furi_string_free(line);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return success;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <dap.h>
+
+// Commands 0x00-0x1F, DAP_QueueCommands, DAP_ExecuteCommands, vendor and unknown commands
+#define DAP_STATS_COMMAND_COUNT 36
+
+// Latency buckets: <16us, <64us, <256us, <1ms, <4ms, <16ms, <64ms, longer
+#define DAP_STATS_HISTOGRAM_SIZE 8
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t histogram[DAP_STATS_HISTOGRAM_SIZE];
+} DapStatsCommand;
+
+typedef struct {
+    DapStatsCommand commands[DAP_STATS_COMMAND_COUNT];
+    uint32_t elapsed_ms; // Since the last reset
+    uint64_t busy_us; // Processing requests
+    uint64_t usb_us; // Waiting for the host to take responses
+    dap_swd_stats_t swd; // Current or last SWD session
+} DapStats;
+
+// Called from the DAP thread
+void dap_stats_reset(void);
+
+uint32_t dap_stats_timestamp(void);
+
+void dap_stats_add_command(uint8_t command, uint32_t start);
+
+void dap_stats_add_usb(uint32_t start);
+
+// Snapshot for the GUI thread, counters may be off by one request while it is taken
+void dap_stats_get(DapStats* stats);
+
+const char* dap_stats_get_command_name(size_t index);
+
+// Upper bound of a latency bucket in microseconds, 0 for the last one
+uint32_t dap_stats_get_histogram_limit(size_t bucket);
+
+// Achieved SWD clock while transfers were running, in Hz
+uint32_t dap_stats_get_swd_bitrate(const DapStats* stats);
+
+bool dap_stats_save_csv(const DapStats* stats, const char* path);
@@ -0,0 +1,143 @@
+#include "swo_capture.h"
+#include <furi.h>
+#include <furi_hal_serial_control.h>
+#include <furi_hal_serial.h>
+
+#define SWO_CAPTURE_BUFFER_MASK (SWO_CAPTURE_BUFFER_SIZE - 1)
+#define SWO_CAPTURE_DISCARD_SIZE 32
+
+typedef struct {
+    uint8_t* buffer;
+    // Free running byte counters, written only by the UART interrupt and the DAP thread
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile bool overrun;
+    FuriHalSerialHandle* serial_handle;
+    DapUartType uart;
+    SwoCaptureCallback callback;
+    void* context;
+} SwoCapture;
+
+static SwoCapture swo_capture = {0};
+
+static void swo_capture_rx_callback(
+    FuriHalSerialHandle* handle,
+    FuriHalSerialRxEvent event,
+    size_t size,
+    void* context) {
+    UNUSED(context);
+
+    if(event & (FuriHalSerialRxEventData | FuriHalSerialRxEventIdle)) {
+        while(size) {
+            const uint32_t head = swo_capture.head;
+            const uint32_t offset = head & SWO_CAPTURE_BUFFER_MASK;
+            const uint32_t space = SWO_CAPTURE_BUFFER_SIZE - (head - swo_capture.tail);
+            // DMA data is copied straight into the ring, up to its end
+            const uint32_t chunk = MIN(MIN(space, SWO_CAPTURE_BUFFER_SIZE - offset), size);
+
+            if(chunk == 0) {
+                // Host is not keeping up, the newest data is lost
+                uint8_t discard[SWO_CAPTURE_DISCARD_SIZE];
+                size -= furi_hal_serial_dma_rx(handle, discard, MIN(size, sizeof(discard)));
+                swo_capture.overrun = true;
+                continue;
+            }
+
+            const size_t len = furi_hal_serial_dma_rx(handle, &swo_capture.buffer[offset], chunk);
+            swo_capture.head = head + len;
+            size -= len;
+        }
+
+        if(swo_capture.callback != NULL) {
+            swo_capture.callback(swo_capture.context);
+        }
+    }
+
+    if(event & FuriHalSerialRxEventOverrunError) {
+        swo_capture.overrun = true;
+    }
+}
+
+void swo_capture_alloc(SwoCaptureCallback callback, void* context) {
+    furi_assert(swo_capture.buffer == NULL);
+    swo_capture.buffer = malloc(SWO_CAPTURE_BUFFER_SIZE);
+    swo_capture.callback = callback;
+    swo_capture.context = context;
+}
+
+void swo_capture_free(void) {
+    swo_capture_stop();
+    free(swo_capture.buffer);
+    swo_capture.buffer = NULL;
+    swo_capture.callback = NULL;
+    swo_capture.context = NULL;
+}
+
+bool swo_capture_start(DapUartType uart, uint32_t baudrate) {
+    furi_assert(swo_capture.buffer);
+    furi_assert(swo_capture.serial_handle == NULL);
+
+    const FuriHalSerialId serial_id =
+        (uart == DapUartTypeUSART1) ? FuriHalSerialIdUsart : FuriHalSerialIdLpuart;
+
+    swo_capture.serial_handle = furi_hal_serial_control_acquire(serial_id);
+    if(swo_capture.serial_handle == NULL) return false;
+
+    swo_capture.uart = uart;
+    swo_capture.head = 0;
+    swo_capture.tail = 0;
+    swo_capture.overrun = false;
+
+    furi_hal_serial_init(swo_capture.serial_handle, baudrate);
+    // SWO is receive only, leave the TX pin alone
+    furi_hal_serial_disable_direction(swo_capture.serial_handle, FuriHalSerialDirectionTx);
+    furi_hal_serial_dma_rx_start(swo_capture.serial_handle, swo_capture_rx_callback, NULL, true);
+
+    return true;
+}
+
+void swo_capture_stop(void) {
+    if(swo_capture.serial_handle == NULL) return;
+
+    furi_hal_serial_deinit(swo_capture.serial_handle);
+    furi_hal_serial_control_release(swo_capture.serial_handle);
+    swo_capture.serial_handle = NULL;
+}
+
+bool swo_capture_is_active(void) {
+    return swo_capture.serial_handle != NULL;
+}
+
+DapUartType swo_capture_get_uart(void) {
+    return swo_capture.uart;
+}
+
+uint32_t swo_capture_get_count(void) {
+    return swo_capture.head - swo_capture.tail;
+}
+
+uint32_t swo_capture_get_index(void) {
+    return swo_capture.tail;
+}
+
+uint32_t swo_capture_read(uint8_t* data, uint32_t size) {
+    const uint32_t tail = swo_capture.tail;
+    const uint32_t offset = tail & SWO_CAPTURE_BUFFER_MASK;
+
+    size = MIN(size, swo_capture.head - tail);
+
+    const uint32_t first = MIN(size, SWO_CAPTURE_BUFFER_SIZE - offset);
+    memcpy(data, &swo_capture.buffer[offset], first);
+    memcpy(data + first, swo_capture.buffer, size - first);
+
+    swo_capture.tail = tail + size;
+    return size;
+}
+
+bool swo_capture_get_overrun(void) {
+    FURI_CRITICAL_ENTER();
+    const bool overrun = swo_capture.overrun;
+    swo_capture.overrun = false;
+    FURI_CRITICAL_EXIT();
+    return overrun;
+}
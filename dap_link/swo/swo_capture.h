@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "../dap_link.h"
+
+// Must be a power of two
+#define SWO_CAPTURE_BUFFER_SIZE (8192UL)
+
+// Called from the UART interrupt when new trace data is available
+typedef void (*SwoCaptureCallback)(void* context);
+
+void swo_capture_alloc(SwoCaptureCallback callback, void* context);
+
+void swo_capture_free(void);
+
+bool swo_capture_start(DapUartType uart, uint32_t baudrate);
+
+void swo_capture_stop(void);
+
+bool swo_capture_is_active(void);
+
+DapUartType swo_capture_get_uart(void);
+
+uint32_t swo_capture_get_count(void);
+
+uint32_t swo_capture_get_index(void);
+
+uint32_t swo_capture_read(uint8_t* data, uint32_t size);
+
+bool swo_capture_get_overrun(void);
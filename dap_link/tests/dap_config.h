@@ -0,0 +1,196 @@
+// Host build of free-dap for dap_replay: the SWJ pins go to the simulated target in
+// dap_target.c instead of the GPIOs. Options follow the Flipper dap_config.h, SWO and the
+// vendor commands are left out.
+
+#ifndef _DAP_CONFIG_H_
+#define _DAP_CONFIG_H_
+
+/*- Includes ----------------------------------------------------------------*/
+#include <stdint.h>
+#include <time.h>
+#include "dap_target.h"
+
+/*- Definitions -------------------------------------------------------------*/
+#define DAP_CONFIG_ENABLE_JTAG
+
+#define DAP_CONFIG_DEFAULT_PORT DAP_PORT_SWD
+#define DAP_CONFIG_DEFAULT_CLOCK 4200000 // Hz
+
+#define DAP_CONFIG_PACKET_SIZE 64
+#define DAP_CONFIG_PACKET_COUNT 4
+
+#define DAP_CONFIG_JTAG_DEV_COUNT 8
+
+// DAP_CONFIG_PRODUCT_STR must contain "CMSIS-DAP" to be compatible with the standard
+#define DAP_CONFIG_VENDOR_STR "Flipper Zero"
+#define DAP_CONFIG_PRODUCT_STR "Generic CMSIS-DAP Adapter"
+#define DAP_CONFIG_SER_NUM_STR "00000000"
+#define DAP_CONFIG_CMSIS_DAP_VER_STR "2.0.0"
+
+// SWD engine statistics, CPU time is measured in nanoseconds of the host clock
+#define DAP_CONFIG_ENABLE_SWD_STATS
+#define DAP_CONFIG_CYCLE_COUNTER() dap_host_cycle_counter()
+
+// The fast path is built from the same pin functions, the target sees identical edges
+#define DAP_CONFIG_ENABLE_SWD_FAST_PATH
+
+#define DAP_CONFIG_PERFORMANCE_ATTR
+
+// Same clock selection as on Flipper, the delays themselves take no time here
+#define DAP_CONFIG_DELAY_CONSTANT 6290
+#define DAP_CONFIG_FAST_CLOCK 2400000 // Hz
+
+/*- Implementations ---------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+static inline uint32_t dap_host_cycle_counter(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000000UL + (uint32_t)now.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWCLK_TCK_write(int value) {
+    dap_target_swclk_write(value);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWDIO_TMS_write(int value) {
+    dap_target_swdio_write(value);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_TDI_write(int value) {
+    dap_target_tdi_write(value);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_nTRST_write(int value) {
+    (void)value;
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_nRESET_write(int value) {
+    dap_target_nreset_write(value);
+}
+
+//-----------------------------------------------------------------------------
+static inline int DAP_CONFIG_SWCLK_TCK_read(void) {
+    return dap_target_swclk_read();
+}
+
+//-----------------------------------------------------------------------------
+static inline int DAP_CONFIG_SWDIO_TMS_read(void) {
+    return dap_target_swdio_read();
+}
+
+//-----------------------------------------------------------------------------
+static inline int DAP_CONFIG_TDO_read(void) {
+    return dap_target_tdo_read();
+}
+
+//-----------------------------------------------------------------------------
+static inline int DAP_CONFIG_TDI_read(void) {
+    return dap_target_tdi_read();
+}
+
+//-----------------------------------------------------------------------------
+static inline int DAP_CONFIG_nTRST_read(void) {
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+static inline int DAP_CONFIG_nRESET_read(void) {
+    return dap_target_nreset_read();
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWCLK_TCK_set(void) {
+    dap_target_swclk_write(true);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWCLK_TCK_clr(void) {
+    dap_target_swclk_write(false);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWDIO_TMS_in(void) {
+    dap_target_swdio_drive(false);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWDIO_TMS_out(void) {
+    dap_target_swdio_drive(true);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SETUP(void) {
+    dap_target_swdio_drive(false);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_DISCONNECT(void) {
+    dap_target_swdio_drive(false);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_CONNECT_SWD(void) {
+    dap_target_swdio_drive(true);
+    dap_target_swdio_write(true);
+    dap_target_swclk_write(true);
+    dap_target_nreset_write(true);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_CONNECT_JTAG(void) {
+    dap_target_swdio_drive(true);
+    dap_target_swdio_write(true);
+    dap_target_swclk_write(true);
+    dap_target_nreset_write(true);
+    dap_target_tdi_write(true);
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWD_FAST_write(uint32_t value, int size) {
+    for(int i = 0; i < size; i++) {
+        dap_target_swdio_write(value & 1);
+        dap_target_swclk_write(false);
+        dap_target_swclk_write(true);
+        value >>= 1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static inline uint32_t DAP_CONFIG_SWD_FAST_read(int size) {
+    uint32_t value = 0;
+
+    for(int i = 0; i < size; i++) {
+        dap_target_swclk_write(false);
+        uint32_t bit = dap_target_swdio_read();
+        dap_target_swclk_write(true);
+        value |= bit << i;
+    }
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_SWD_FAST_clock(int cycles) {
+    while(cycles--) {
+        dap_target_swclk_write(false);
+        dap_target_swclk_write(true);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_LED(int index, int state) {
+    (void)index;
+    (void)state;
+}
+
+//-----------------------------------------------------------------------------
+static inline void DAP_CONFIG_DELAY(uint32_t cycles) {
+    (void)cycles;
+}
+
+#endif // _DAP_CONFIG_H_
@@ -0,0 +1,266 @@
+/*
+ * Replays CMSIS-DAP command streams through the free-dap core against the simulated target
+ * in dap_target.c and checks the responses byte for byte.
+ *
+ * Stream format, one packet per line, bytes in hex:
+ *   > 05 00 01 02       request, goes through dap_filter_request() and dap_process_request()
+ *   < 05 01 01 77 14 c1 0b   expected response of the request above
+ *   # comment
+ * A request without a '<' line is only executed, e.g. DAP_TransferAbort that gets no reply.
+ *
+ * dap_replay [-r passes] [-u] stream...
+ *   -r  replays every stream this many times and reports the throughput
+ *   -u  prints the stream with the responses that were actually received, for new streams
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dap_config.h"
+#include "../lib/free-dap/dap.h"
+
+#define REPLAY_LINE_SIZE (512U)
+
+typedef struct {
+    char* text; // Line as it is in the stream, for -u
+    int line;
+    uint8_t request[DAP_CONFIG_PACKET_SIZE];
+    int request_size; // 0 for comments and '<' lines
+    uint8_t expected[DAP_CONFIG_PACKET_SIZE];
+    int expected_size; // -1 when the response is not checked
+} ReplayPacket;
+
+typedef struct {
+    const char* name;
+    ReplayPacket* packets;
+    size_t count;
+} ReplayStream;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t mismatches;
+    uint64_t transfer_clocks; // Target edges during requests that ran SWD transfers
+} ReplayResult;
+
+static int replay_parse_bytes(const char* text, int line, uint8_t* data) {
+    int size = 0;
+    char* end;
+
+    while(true) {
+        while(*text == ' ' || *text == '\t') text++;
+        if(*text == '\0' || *text == '\n' || *text == '#') break;
+
+        unsigned long value = strtoul(text, &end, 16);
+        if(end == text || value > 0xFF || size == DAP_CONFIG_PACKET_SIZE) {
+            fprintf(stderr, "line %d: bad packet\n", line);
+            return -1;
+        }
+        data[size++] = value;
+        text = end;
+    }
+    return size;
+}
+
+static bool replay_load(ReplayStream* stream, const char* name) {
+    FILE* file = fopen(name, "r");
+    if(!file) {
+        perror(name);
+        return false;
+    }
+
+    char text[REPLAY_LINE_SIZE];
+    size_t capacity = 0;
+    size_t last_request = SIZE_MAX; // Index of the request a '<' line belongs to
+    bool is_ok = true;
+
+    stream->name = name;
+    stream->packets = NULL;
+    stream->count = 0;
+
+    for(int line = 1; is_ok && fgets(text, sizeof(text), file); line++) {
+        if(stream->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            stream->packets = realloc(stream->packets, capacity * sizeof(ReplayPacket));
+        }
+
+        ReplayPacket* packet = &stream->packets[stream->count++];
+        memset(packet, 0, sizeof(ReplayPacket));
+        packet->text = strdup(text);
+        packet->line = line;
+        packet->expected_size = -1;
+
+        if(text[0] == '>') {
+            packet->request_size = replay_parse_bytes(&text[1], line, packet->request);
+            is_ok = packet->request_size > 0;
+            last_request = stream->count - 1;
+        } else if(text[0] == '<') {
+            if(last_request != stream->count - 2) {
+                fprintf(stderr, "%s:%d: response without a request\n", name, line);
+                is_ok = false;
+                break;
+            }
+            ReplayPacket* request = &stream->packets[last_request];
+            request->expected_size = replay_parse_bytes(&text[1], line, request->expected);
+            is_ok = request->expected_size >= 0;
+        }
+    }
+
+    fclose(file);
+    return is_ok;
+}
+
+static void replay_print_bytes(FILE* file, char prefix, const uint8_t* data, int size) {
+    fputc(prefix, file);
+    for(int i = 0; i < size; i++) {
+        fprintf(file, " %02x", data[i]);
+    }
+    fputc('\n', file);
+}
+
+static void replay_run(const ReplayStream* stream, bool is_update, ReplayResult* result) {
+    uint8_t response[DAP_CONFIG_PACKET_SIZE];
+
+    dap_target_reset();
+    dap_init();
+    dap_swd_reset_stats();
+
+    for(size_t i = 0; i < stream->count; i++) {
+        ReplayPacket* packet = &stream->packets[i];
+
+        if(!packet->request_size) {
+            if(is_update && packet->text[0] != '<') fputs(packet->text, stdout);
+            continue;
+        }
+        if(is_update) fputs(packet->text, stdout);
+
+        result->requests++;
+        if(!dap_filter_request(packet->request)) continue;
+
+        dap_swd_stats_t stats_before, stats_after;
+        DapTargetStats target_before, target_after;
+        dap_swd_get_stats(&stats_before);
+        dap_target_get_stats(&target_before);
+
+        int size = dap_process_request(
+            packet->request, packet->request_size, response, sizeof(response));
+
+        dap_swd_get_stats(&stats_after);
+        dap_target_get_stats(&target_after);
+        if(stats_after.transfers != stats_before.transfers) {
+            result->transfer_clocks += target_after.clocks - target_before.clocks;
+        }
+
+        if(is_update) replay_print_bytes(stdout, '<', response, size);
+
+        if(packet->expected_size < 0) continue;
+        if(size != packet->expected_size || memcmp(response, packet->expected, size)) {
+            result->mismatches++;
+            fprintf(stderr, "%s:%d: response mismatch\n", stream->name, packet->line);
+            replay_print_bytes(stderr, '<', packet->expected, packet->expected_size);
+            replay_print_bytes(stderr, '=', response, size);
+        }
+    }
+}
+
+static double replay_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static bool replay_stream(const ReplayStream* stream, uint32_t passes, bool is_update) {
+    ReplayResult result = {0};
+    ReplayResult pass_result;
+
+    double start = replay_time();
+    for(uint32_t pass = 0; pass < passes; pass++) {
+        //Statistics and the target are reset by every pass, the last one is reported
+        pass_result = (ReplayResult){0};
+        replay_run(stream, is_update && pass == 0, &pass_result);
+        result.requests += pass_result.requests;
+        result.mismatches += pass_result.mismatches;
+    }
+    double elapsed = replay_time() - start;
+    if(is_update) return true;
+
+    dap_swd_stats_t stats;
+    DapTargetStats target;
+    dap_swd_get_stats(&stats);
+    dap_target_get_stats(&target);
+
+    bool is_ok = result.mismatches == 0;
+    printf(
+        "%s: %u requests in %u passes, %u mismatches, %.0f requests/s\n",
+        stream->name,
+        result.requests,
+        passes,
+        result.mismatches,
+        result.requests / elapsed);
+
+    if(stats.transfers) {
+        printf(
+            "  SWD, last pass: %u transfers, %u WAIT, %u FAULT, %u errors, "
+            "%.1f clocks and %.0f ns per transfer\n",
+            stats.transfers,
+            stats.waits,
+            stats.faults,
+            stats.errors,
+            (double)stats.clock_cycles / stats.transfers,
+            (double)stats.cpu_cycles / stats.transfers);
+    }
+    printf(
+        "  target, last pass: %llu clocks, %u contentions, %u protocol errors\n",
+        (unsigned long long)target.clocks,
+        target.contentions,
+        target.protocol_errors);
+
+    //The engine counts the clocks it meant to give, the target counts the edges it got
+    if(stats.clock_cycles != pass_result.transfer_clocks) {
+        printf(
+            "  SWD clock count %llu, the target saw %llu\n",
+            (unsigned long long)stats.clock_cycles,
+            (unsigned long long)pass_result.transfer_clocks);
+        is_ok = false;
+    }
+    if(target.contentions || target.protocol_errors) is_ok = false;
+
+    return is_ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t passes = 1;
+    bool is_update = false;
+    int option;
+
+    while((option = getopt(argc, argv, "r:u")) != -1) {
+        if(option == 'r') {
+            passes = strtoul(optarg, NULL, 0);
+        } else if(option == 'u') {
+            is_update = true;
+        } else {
+            fprintf(stderr, "usage: %s [-r passes] [-u] stream...\n", argv[0]);
+            return 2;
+        }
+    }
+    if(optind == argc || passes == 0) {
+        fprintf(stderr, "usage: %s [-r passes] [-u] stream...\n", argv[0]);
+        return 2;
+    }
+
+    bool is_ok = true;
+    for(int i = optind; i < argc; i++) {
+        ReplayStream stream;
+        if(!replay_load(&stream, argv[i])) return 2;
+        is_ok &= replay_stream(&stream, is_update ? 1 : passes, is_update);
+
+        for(size_t j = 0; j < stream.count; j++) {
+            free(stream.packets[j].text);
+        }
+        free(stream.packets);
+    }
+
+    return is_ok ? 0 : 1;
+}
@@ -0,0 +1,689 @@
+#include "dap_target.h"
+#include <string.h>
+
+#define DAP_TARGET_LINE_RESET_ONES (50U)
+#define DAP_TARGET_SELECT_BITS     (16U)
+#define DAP_TARGET_SELECT_SWD      (0xE79EU) // JTAG-to-SWD, LSB first
+#define DAP_TARGET_SELECT_JTAG     (0xE73CU) // SWD-to-JTAG, LSB first
+
+//SWD acks as they go out on the wire, LSB first
+#define SWD_ACK_OK    (0x1U)
+#define SWD_ACK_WAIT  (0x2U)
+#define SWD_ACK_FAULT (0x4U)
+
+//SWD request header, bit 0 is the start bit
+#define SWD_REQ_APNDP  (1U << 1)
+#define SWD_REQ_RNW    (1U << 2)
+#define SWD_REQ_PARITY (1U << 5)
+#define SWD_REQ_STOP   (1U << 6)
+#define SWD_REQ_PARK   (1U << 7)
+
+//JTAG-DP instructions and the acks in the low bits of the DPACC/APACC scan
+#define JTAG_IR_LENGTH (4U)
+#define JTAG_IR_ABORT  (0x8U)
+#define JTAG_IR_DPACC  (0xAU)
+#define JTAG_IR_APACC  (0xBU)
+#define JTAG_IR_IDCODE (0xEU)
+#define JTAG_ACK_OK    (0x2U) // OK/FAULT
+#define JTAG_ACK_WAIT  (0x1U)
+#define JTAG_ACC_BITS  (35U)
+
+#define DP_DPIDR_ABORT  (0x0U)
+#define DP_CTRL_STAT    (0x4U)
+#define DP_SELECT       (0x8U)
+#define DP_RDBUFF       (0xCU)
+#define DP_BANK_DLCR    (0x1U)
+#define DP_DLCR_TRN_POS (8U)
+
+#define DP_CTRL_ORUNDETECT   (1UL << 0)
+#define DP_CTRL_STICKYORUN   (1UL << 1)
+#define DP_CTRL_STICKYERR    (1UL << 5)
+#define DP_CTRL_WDATAERR     (1UL << 7)
+#define DP_CTRL_CDBGRSTREQ   (1UL << 26)
+#define DP_CTRL_CDBGRSTACK   (1UL << 27)
+#define DP_CTRL_CDBGPWRUPREQ (1UL << 28)
+#define DP_CTRL_CDBGPWRUPACK (1UL << 29)
+#define DP_CTRL_CSYSPWRUPREQ (1UL << 30)
+#define DP_CTRL_CSYSPWRUPACK (1UL << 31)
+#define DP_CTRL_STICKY       (DP_CTRL_STICKYORUN | DP_CTRL_STICKYERR | DP_CTRL_WDATAERR)
+#define DP_CTRL_WRITABLE \
+    (DP_CTRL_ORUNDETECT | DP_CTRL_CDBGRSTREQ | DP_CTRL_CDBGPWRUPREQ | DP_CTRL_CSYSPWRUPREQ)
+
+#define DP_ABORT_DAPABORT   (1UL << 0)
+#define DP_ABORT_STKCMPCLR  (1UL << 1)
+#define DP_ABORT_STKERRCLR  (1UL << 2)
+#define DP_ABORT_WDERRCLR   (1UL << 3)
+#define DP_ABORT_ORUNERRCLR (1UL << 4)
+
+#define AP_CSW  (0x00U)
+#define AP_TAR  (0x04U)
+#define AP_DRW  (0x0CU)
+#define AP_BD0  (0x10U)
+#define AP_BD3  (0x1CU)
+#define AP_CFG  (0xF4U)
+#define AP_BASE (0xF8U)
+#define AP_IDR  (0xFCU)
+
+#define AP_CSW_SIZE     (0x7UL)
+#define AP_CSW_ADDRINC  (0x3UL << 4)
+#define AP_CSW_DEVICEEN (1UL << 6)
+#define AP_CSW_RESET    (0x2UL) // Word accesses, no increment
+#define AP_TAR_WRAP     (0x3FFUL) // TAR auto-increment stays within 1KB
+
+typedef enum {
+    DapTargetModeJtag,
+    DapTargetModeSwd,
+} DapTargetMode;
+
+typedef enum {
+    SwdStateLockout, // After a protocol error or a mode change, until a line reset
+    SwdStateReset, // Line reset seen, waiting for the idle cycles after it
+    SwdStateIdle, // Waiting for a start bit
+    SwdStateRequest,
+    SwdStateTurnaround, // The probe releases SWDIO before the ACK
+    SwdStateAck,
+    SwdStateReadData, // 32 data bits and parity from the target
+    SwdStateWriteData, // 32 data bits and parity from the probe, after its turnaround
+} SwdState;
+
+typedef enum {
+    TapTestLogicReset,
+    TapRunTestIdle,
+    TapSelectDr,
+    TapCaptureDr,
+    TapShiftDr,
+    TapExit1Dr,
+    TapPauseDr,
+    TapExit2Dr,
+    TapUpdateDr,
+    TapSelectIr,
+    TapCaptureIr,
+    TapShiftIr,
+    TapExit1Ir,
+    TapPauseIr,
+    TapExit2Ir,
+    TapUpdateIr,
+    TapStateCount,
+} TapState;
+
+//Next TAP state for TMS low and high
+static const uint8_t dap_target_tap_next[TapStateCount][2] = {
+    [TapTestLogicReset] = {TapRunTestIdle, TapTestLogicReset},
+    [TapRunTestIdle] = {TapRunTestIdle, TapSelectDr},
+    [TapSelectDr] = {TapCaptureDr, TapSelectIr},
+    [TapCaptureDr] = {TapShiftDr, TapExit1Dr},
+    [TapShiftDr] = {TapShiftDr, TapExit1Dr},
+    [TapExit1Dr] = {TapPauseDr, TapUpdateDr},
+    [TapPauseDr] = {TapPauseDr, TapExit2Dr},
+    [TapExit2Dr] = {TapShiftDr, TapUpdateDr},
+    [TapUpdateDr] = {TapRunTestIdle, TapSelectDr},
+    [TapSelectIr] = {TapCaptureIr, TapTestLogicReset},
+    [TapCaptureIr] = {TapShiftIr, TapExit1Ir},
+    [TapShiftIr] = {TapShiftIr, TapExit1Ir},
+    [TapExit1Ir] = {TapPauseIr, TapUpdateIr},
+    [TapPauseIr] = {TapPauseIr, TapExit2Ir},
+    [TapExit2Ir] = {TapShiftIr, TapUpdateIr},
+    [TapUpdateIr] = {TapRunTestIdle, TapSelectDr},
+};
+
+static struct {
+    //Pins
+    bool swclk;
+    bool swdio;
+    bool swdio_drive;
+    bool tdi;
+    bool nreset;
+    bool target_drive;
+    bool target_swdio;
+
+    //SWJ-DP line reset and select sequences
+    DapTargetMode mode;
+    uint32_t ones;
+    bool select_active;
+    uint32_t select_bits;
+    uint32_t select_count;
+
+    //SWD
+    SwdState swd_state;
+    uint32_t swd_count;
+    uint8_t swd_request;
+    uint8_t swd_ack;
+    uint32_t swd_data;
+    uint32_t swd_turnaround;
+    bool swd_dpidr_needed; // After a line reset only a DPIDR read is answered
+
+    //JTAG
+    TapState tap;
+    uint8_t ir;
+    uint8_t ir_shift;
+    uint64_t dr_shift;
+    uint8_t dr_length;
+    uint8_t jtag_ack;
+    uint32_t jtag_result;
+
+    //DP and MEM-AP
+    uint32_t ctrl_stat;
+    uint32_t select;
+    uint32_t dlcr;
+    uint32_t rdbuff;
+    uint32_t resend;
+    uint32_t ap_busy;
+    uint32_t csw;
+    uint32_t tar;
+    uint8_t ram[DAP_TARGET_RAM_SIZE];
+    uint8_t slow[DAP_TARGET_SLOW_SIZE];
+
+    DapTargetStats stats;
+} target;
+
+static uint32_t dap_target_parity(uint32_t value) {
+    return __builtin_parity(value);
+}
+
+//Memory and MEM-AP
+
+static uint8_t* dap_target_mem(uint32_t address, bool* is_slow) {
+    *is_slow = false;
+    if(address - DAP_TARGET_RAM_ADDR < DAP_TARGET_RAM_SIZE) {
+        return &target.ram[address - DAP_TARGET_RAM_ADDR];
+    }
+    if(address - DAP_TARGET_SLOW_ADDR < DAP_TARGET_SLOW_SIZE) {
+        *is_slow = true;
+        return &target.slow[address - DAP_TARGET_SLOW_ADDR];
+    }
+    return NULL;
+}
+
+static uint32_t dap_target_csw_size(void) {
+    switch(target.csw & AP_CSW_SIZE) {
+    case 0:
+        return 1;
+    case 1:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+/** Reads the word holding the access, the other byte lanes are returned as they are */
+static uint32_t dap_target_mem_read(uint32_t address) {
+    bool is_slow;
+    uint8_t* word = dap_target_mem(address & ~3UL, &is_slow);
+    if(!word) {
+        target.ctrl_stat |= DP_CTRL_STICKYERR;
+        return 0;
+    }
+    if(is_slow) target.ap_busy = DAP_TARGET_SLOW_WAITS;
+    return word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t)word[3] << 24);
+}
+
+/** Writes the byte lanes of the access, the data comes on the lanes of its address */
+static void dap_target_mem_write(uint32_t address, uint32_t size, uint32_t value) {
+    bool is_slow;
+    address &= ~(size - 1);
+    uint8_t* word = dap_target_mem(address & ~3UL, &is_slow);
+    if(!word) {
+        target.ctrl_stat |= DP_CTRL_STICKYERR;
+        return;
+    }
+    if(is_slow) target.ap_busy = DAP_TARGET_SLOW_WAITS;
+    for(uint32_t i = address & 3; i < (address & 3) + size; i++) {
+        word[i] = value >> (8 * i);
+    }
+}
+
+static void dap_target_tar_increment(uint32_t size) {
+    if(target.csw & AP_CSW_ADDRINC) {
+        target.tar = (target.tar & ~AP_TAR_WRAP) | ((target.tar + size) & AP_TAR_WRAP);
+    }
+}
+
+static uint32_t dap_target_ap_read(uint32_t address) {
+    //Only AP 0 is there, the probe finds an IDR of 0 on the others
+    if(target.select >> 24) return 0;
+
+    uint32_t value = 0;
+    if(address == AP_CSW) {
+        value = target.csw | AP_CSW_DEVICEEN;
+    } else if(address == AP_TAR) {
+        value = target.tar;
+    } else if(address == AP_DRW) {
+        value = dap_target_mem_read(target.tar);
+        dap_target_tar_increment(dap_target_csw_size());
+    } else if(address >= AP_BD0 && address <= AP_BD3) {
+        value = dap_target_mem_read((target.tar & ~0xFUL) | (address & 0xC));
+    } else if(address == AP_BASE) {
+        value = DAP_TARGET_AP_BASE;
+    } else if(address == AP_IDR) {
+        value = DAP_TARGET_AP_IDR;
+    }
+    return value;
+}
+
+static void dap_target_ap_write(uint32_t address, uint32_t value) {
+    if(target.select >> 24) return;
+
+    if(address == AP_CSW) {
+        target.csw = value & ~AP_CSW_DEVICEEN;
+    } else if(address == AP_TAR) {
+        target.tar = value;
+    } else if(address == AP_DRW) {
+        uint32_t size = dap_target_csw_size();
+        dap_target_mem_write(target.tar, size, value);
+        dap_target_tar_increment(size);
+    } else if(address >= AP_BD0 && address <= AP_BD3) {
+        dap_target_mem_write((target.tar & ~0xFUL) | (address & 0xC), 4, value);
+    }
+}
+
+/** AP register address from SELECT and A[3:2] of the request */
+static uint32_t dap_target_ap_address(uint32_t a32) {
+    return (target.select & 0xF0) | a32;
+}
+
+//DP
+
+static void dap_target_abort(uint32_t value) {
+    if(value & DP_ABORT_DAPABORT) target.ap_busy = 0;
+    if(value & DP_ABORT_STKERRCLR) target.ctrl_stat &= ~DP_CTRL_STICKYERR;
+    if(value & DP_ABORT_WDERRCLR) target.ctrl_stat &= ~DP_CTRL_WDATAERR;
+    if(value & DP_ABORT_ORUNERRCLR) target.ctrl_stat &= ~DP_CTRL_STICKYORUN;
+}
+
+static uint32_t dap_target_dp_read(uint32_t address) {
+    switch(address) {
+    case DP_DPIDR_ABORT:
+        return DAP_TARGET_SWD_IDCODE;
+    case DP_CTRL_STAT:
+        return (target.select & 0xF) == DP_BANK_DLCR ? target.dlcr : target.ctrl_stat;
+    case DP_SELECT:
+        return target.resend;
+    default:
+        //JTAG-DP returns the AP read result in the next scan, RDBUFF itself reads as zero
+        return target.mode == DapTargetModeSwd ? target.rdbuff : 0;
+    }
+}
+
+static void dap_target_dp_write(uint32_t address, uint32_t value) {
+    switch(address) {
+    case DP_DPIDR_ABORT:
+        dap_target_abort(value);
+        break;
+    case DP_CTRL_STAT:
+        if((target.select & 0xF) == DP_BANK_DLCR) {
+            target.dlcr = value & (0x3UL << DP_DLCR_TRN_POS);
+            target.swd_turnaround = (target.dlcr >> DP_DLCR_TRN_POS) + 1;
+            break;
+        }
+        //Power and reset requests are granted at once, the sticky flags clear through ABORT
+        target.ctrl_stat = (target.ctrl_stat & DP_CTRL_STICKY) | (value & DP_CTRL_WRITABLE);
+        if(value & DP_CTRL_CDBGRSTREQ) target.ctrl_stat |= DP_CTRL_CDBGRSTACK;
+        if(value & DP_CTRL_CDBGPWRUPREQ) target.ctrl_stat |= DP_CTRL_CDBGPWRUPACK;
+        if(value & DP_CTRL_CSYSPWRUPREQ) target.ctrl_stat |= DP_CTRL_CSYSPWRUPACK;
+        break;
+    case DP_SELECT:
+        target.select = value;
+        break;
+    default:
+        break;
+    }
+}
+
+//SWD
+
+static void dap_target_swd_lockout(void) {
+    target.stats.protocol_errors++;
+    target.target_drive = false;
+    target.swd_state = SwdStateLockout;
+}
+
+/** Answers the request once the turnaround is over, reads are done here and writes later */
+static void dap_target_swd_start_ack(void) {
+    bool is_ap = target.swd_request & SWD_REQ_APNDP;
+    bool is_read = target.swd_request & SWD_REQ_RNW;
+    uint32_t address = (target.swd_request >> 1) & 0xC;
+
+    if(target.swd_dpidr_needed && (is_ap || !is_read || address != DP_DPIDR_ABORT)) {
+        dap_target_swd_lockout();
+        return;
+    }
+
+    //AP accesses and RDBUFF wait for the AP, AP accesses fault on a sticky error
+    bool is_waiting = is_ap || (is_read && address == DP_RDBUFF);
+    if(is_waiting && target.ap_busy) {
+        target.ap_busy--;
+        target.swd_ack = SWD_ACK_WAIT;
+    } else if(is_ap && (target.ctrl_stat & DP_CTRL_STICKY)) {
+        target.swd_ack = SWD_ACK_FAULT;
+    } else {
+        target.swd_ack = SWD_ACK_OK;
+    }
+
+    if(target.swd_ack == SWD_ACK_OK && is_read) {
+        if(is_ap) {
+            //Posted: the previous result goes out, this one waits in RDBUFF
+            target.swd_data = target.rdbuff;
+            target.rdbuff = dap_target_ap_read(dap_target_ap_address(address));
+        } else {
+            target.swd_data = dap_target_dp_read(address);
+            if(address == DP_DPIDR_ABORT) target.swd_dpidr_needed = false;
+        }
+        target.resend = target.swd_data;
+    }
+
+    target.target_drive = true;
+    target.target_swdio = target.swd_ack & 1;
+    target.swd_state = SwdStateAck;
+    target.swd_count = 1;
+}
+
+static void dap_target_swd_write_done(void) {
+    bool is_ap = target.swd_request & SWD_REQ_APNDP;
+    uint32_t address = (target.swd_request >> 1) & 0xC;
+
+    if(is_ap) {
+        dap_target_ap_write(dap_target_ap_address(address), target.swd_data);
+    } else {
+        dap_target_dp_write(address, target.swd_data);
+    }
+}
+
+static bool dap_target_swd_request_is_valid(uint8_t request) {
+    uint32_t parity = dap_target_parity((request >> 1) & 0xF);
+    return (!!(request & SWD_REQ_PARITY) == parity) && !(request & SWD_REQ_STOP) &&
+           (request & SWD_REQ_PARK);
+}
+
+static void dap_target_swd_clock(bool is_driven, bool level) {
+    if(is_driven && level && target.ones >= DAP_TARGET_LINE_RESET_ONES) {
+        target.target_drive = false;
+        target.swd_state = SwdStateReset;
+        target.swd_dpidr_needed = true;
+        return;
+    }
+
+    switch(target.swd_state) {
+    case SwdStateLockout:
+        break;
+    case SwdStateReset:
+        if(is_driven && !level) target.swd_state = SwdStateIdle;
+        break;
+    case SwdStateIdle:
+        if(is_driven && level) {
+            target.swd_request = 1;
+            target.swd_count = 1;
+            target.swd_state = SwdStateRequest;
+        }
+        break;
+    case SwdStateRequest:
+        target.swd_request |= level << target.swd_count;
+        if(++target.swd_count < 8) break;
+        if(target.swd_request == 0xFF) {
+            //Eight ones are the start of a line reset, not a request
+            target.swd_state = SwdStateLockout;
+            break;
+        }
+        if(!dap_target_swd_request_is_valid(target.swd_request)) {
+            dap_target_swd_lockout();
+            break;
+        }
+        target.swd_count = 0;
+        target.swd_state = SwdStateTurnaround;
+        break;
+    case SwdStateTurnaround:
+        if(++target.swd_count == target.swd_turnaround) dap_target_swd_start_ack();
+        break;
+    case SwdStateAck:
+        if(target.swd_count < 3) {
+            target.target_swdio = (target.swd_ack >> target.swd_count) & 1;
+            target.swd_count++;
+        } else if(target.swd_ack != SWD_ACK_OK) {
+            target.target_drive = false;
+            target.swd_state = SwdStateIdle;
+        } else if(target.swd_request & SWD_REQ_RNW) {
+            target.target_swdio = target.swd_data & 1;
+            target.swd_count = 1;
+            target.swd_state = SwdStateReadData;
+        } else {
+            target.target_drive = false;
+            target.swd_data = 0;
+            target.swd_count = 0;
+            target.swd_state = SwdStateWriteData;
+        }
+        break;
+    case SwdStateReadData:
+        if(target.swd_count < 32) {
+            target.target_swdio = (target.swd_data >> target.swd_count) & 1;
+        } else if(target.swd_count == 32) {
+            target.target_swdio = dap_target_parity(target.swd_data);
+        } else {
+            target.target_drive = false;
+            target.swd_state = SwdStateIdle;
+        }
+        target.swd_count++;
+        break;
+    case SwdStateWriteData:
+        //Turnaround cycles of the probe are not driven
+        if(!is_driven) break;
+        if(target.swd_count < 32) {
+            target.swd_data |= (uint32_t)level << target.swd_count;
+            target.swd_count++;
+            break;
+        }
+        if(level == dap_target_parity(target.swd_data)) {
+            dap_target_swd_write_done();
+        } else {
+            target.stats.protocol_errors++;
+            target.ctrl_stat |= DP_CTRL_WDATAERR;
+        }
+        target.swd_state = SwdStateIdle;
+        break;
+    }
+}
+
+//JTAG
+
+static void dap_target_jtag_capture(void) {
+    switch(target.ir) {
+    case JTAG_IR_ABORT:
+    case JTAG_IR_DPACC:
+    case JTAG_IR_APACC:
+        target.dr_length = JTAG_ACC_BITS;
+        if(target.ir != JTAG_IR_ABORT && target.ap_busy) {
+            target.ap_busy--;
+            target.jtag_ack = JTAG_ACK_WAIT;
+        } else {
+            target.jtag_ack = JTAG_ACK_OK;
+        }
+        target.dr_shift = ((uint64_t)target.jtag_result << 3) | target.jtag_ack;
+        break;
+    case JTAG_IR_IDCODE:
+        target.dr_length = 32;
+        target.dr_shift = DAP_TARGET_JTAG_IDCODE;
+        break;
+    default:
+        //BYPASS
+        target.dr_length = 1;
+        target.dr_shift = 0;
+        break;
+    }
+}
+
+static void dap_target_jtag_update(void) {
+    if(target.dr_length != JTAG_ACC_BITS || target.jtag_ack == JTAG_ACK_WAIT) return;
+
+    bool is_read = target.dr_shift & 1;
+    uint32_t address = (target.dr_shift << 1) & 0xC;
+    uint32_t data = target.dr_shift >> 3;
+
+    if(target.ir == JTAG_IR_ABORT) {
+        dap_target_abort(data);
+    } else if(target.ir == JTAG_IR_DPACC) {
+        if(is_read) {
+            target.jtag_result = dap_target_dp_read(address);
+        } else {
+            dap_target_dp_write(address, data);
+        }
+    } else if(!(target.ctrl_stat & DP_CTRL_STICKY)) {
+        //JTAG-DP has no FAULT, AP accesses are dropped while a sticky flag is set
+        if(is_read) {
+            target.jtag_result = dap_target_ap_read(dap_target_ap_address(address));
+        } else {
+            dap_target_ap_write(dap_target_ap_address(address), data);
+        }
+    }
+}
+
+static void dap_target_tap_clock(bool tms) {
+    if(target.tap == TapShiftDr) {
+        target.dr_shift = (target.dr_shift >> 1) |
+                          ((uint64_t)target.tdi << (target.dr_length - 1));
+    } else if(target.tap == TapShiftIr) {
+        target.ir_shift = (target.ir_shift >> 1) | (target.tdi << (JTAG_IR_LENGTH - 1));
+    }
+
+    target.tap = dap_target_tap_next[target.tap][tms];
+
+    switch(target.tap) {
+    case TapTestLogicReset:
+        target.ir = JTAG_IR_IDCODE;
+        break;
+    case TapCaptureDr:
+        dap_target_jtag_capture();
+        break;
+    case TapUpdateDr:
+        dap_target_jtag_update();
+        break;
+    case TapCaptureIr:
+        target.ir_shift = 0x1;
+        break;
+    case TapUpdateIr:
+        target.ir = target.ir_shift;
+        break;
+    default:
+        break;
+    }
+}
+
+//SWJ-DP
+
+/** Line resets and the select sequences that follow them, on the bits the probe drives */
+static void dap_target_swj_select(bool is_driven, bool level) {
+    if(!is_driven) {
+        target.ones = 0;
+        target.select_active = false;
+        return;
+    }
+
+    if(level) {
+        if(++target.ones >= DAP_TARGET_LINE_RESET_ONES) target.select_active = false;
+    } else {
+        if(target.ones >= DAP_TARGET_LINE_RESET_ONES) {
+            target.select_active = true;
+            target.select_bits = 0;
+            target.select_count = 0;
+        }
+        target.ones = 0;
+    }
+
+    if(!target.select_active) return;
+
+    target.select_bits |= (uint32_t)level << target.select_count;
+    if(++target.select_count < DAP_TARGET_SELECT_BITS) return;
+
+    target.select_active = false;
+    if(target.select_bits == DAP_TARGET_SELECT_SWD && target.mode != DapTargetModeSwd) {
+        //A line reset has to follow before the first request
+        target.mode = DapTargetModeSwd;
+        target.swd_state = SwdStateLockout;
+    } else if(target.select_bits == DAP_TARGET_SELECT_JTAG && target.mode != DapTargetModeJtag) {
+        target.mode = DapTargetModeJtag;
+        target.target_drive = false;
+        target.tap = TapTestLogicReset;
+        target.ir = JTAG_IR_IDCODE;
+    }
+}
+
+static void dap_target_clock(void) {
+    bool is_driven = target.swdio_drive;
+    bool level = target.swdio;
+
+    target.stats.clocks++;
+    if(is_driven && target.target_drive) target.stats.contentions++;
+
+    //The select sequence is decoded first, its last bit already goes to the new front end
+    DapTargetMode mode = target.mode;
+    dap_target_swj_select(is_driven, level);
+    if(target.mode != mode) return;
+
+    if(target.mode == DapTargetModeSwd) {
+        dap_target_swd_clock(is_driven, level);
+    } else if(is_driven) {
+        dap_target_tap_clock(level);
+    }
+}
+
+void dap_target_reset(void) {
+    memset(&target, 0, sizeof(target));
+    target.swclk = true;
+    target.swdio = true;
+    target.tdi = true;
+    target.nreset = true;
+    target.mode = DapTargetModeJtag;
+    target.swd_state = SwdStateLockout;
+    target.swd_turnaround = 1;
+    target.tap = TapTestLogicReset;
+    target.ir = JTAG_IR_IDCODE;
+    target.csw = AP_CSW_RESET;
+}
+
+void dap_target_get_stats(DapTargetStats* stats) {
+    *stats = target.stats;
+}
+
+void dap_target_swclk_write(bool level) {
+    bool is_rising = level && !target.swclk;
+    target.swclk = level;
+    if(is_rising) dap_target_clock();
+}
+
+bool dap_target_swclk_read(void) {
+    return target.swclk;
+}
+
+void dap_target_swdio_write(bool level) {
+    target.swdio = level;
+}
+
+void dap_target_swdio_drive(bool drive) {
+    target.swdio_drive = drive;
+}
+
+bool dap_target_swdio_read(void) {
+    if(target.swdio_drive) return target.swdio;
+    if(target.target_drive) return target.target_swdio;
+    return true;
+}
+
+void dap_target_tdi_write(bool level) {
+    target.tdi = level;
+}
+
+bool dap_target_tdi_read(void) {
+    return target.tdi;
+}
+
+bool dap_target_tdo_read(void) {
+    if(target.mode != DapTargetModeJtag) return true;
+    if(target.tap == TapShiftDr) return target.dr_shift & 1;
+    if(target.tap == TapShiftIr) return target.ir_shift & 1;
+    return true;
+}
+
+void dap_target_nreset_write(bool level) {
+    target.nreset = level;
+}
+
+bool dap_target_nreset_read(void) {
+    return target.nreset;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Simulated ADIv5 target on the SWJ pins of the host build: an SWJ-DP with SWD and JTAG
+ * front ends, one AHB MEM-AP and a small memory map. Like a real SWJ-DP it starts in JTAG
+ * and changes over on the JTAG-to-SWD and SWD-to-JTAG select sequences.
+ *
+ * 0x20000000 RAM
+ * 0x40000000 slow peripheral window, every access keeps the AP busy for
+ *            DAP_TARGET_SLOW_WAITS requests that are answered with WAIT
+ * anything else is a bus error, it sets STICKYERR
+ */
+
+#define DAP_TARGET_SWD_IDCODE  (0x0BC11477UL)
+#define DAP_TARGET_JTAG_IDCODE (0x4BA00477UL)
+#define DAP_TARGET_AP_IDR      (0x04770031UL)
+#define DAP_TARGET_AP_BASE     (0xE00FF003UL)
+
+#define DAP_TARGET_RAM_ADDR   (0x20000000UL)
+#define DAP_TARGET_RAM_SIZE   (0x4000UL)
+#define DAP_TARGET_SLOW_ADDR  (0x40000000UL)
+#define DAP_TARGET_SLOW_SIZE  (0x100UL)
+#define DAP_TARGET_SLOW_WAITS (2)
+
+typedef struct {
+    uint64_t clocks; // Rising SWCLK/TCK edges
+    uint32_t contentions; // Edges where the probe and the target both drove SWDIO
+    uint32_t protocol_errors; // Malformed SWD requests and parity errors in write data
+} DapTargetStats;
+
+/** Power-on reset: JTAG mode, RAM cleared, DP and AP registers at their reset values */
+void dap_target_reset(void);
+void dap_target_get_stats(DapTargetStats* stats);
+
+//Pins as the probe drives and reads them
+void dap_target_swclk_write(bool level);
+bool dap_target_swclk_read(void);
+void dap_target_swdio_write(bool level);
+/** The probe drives SWDIO/TMS, the target may drive SWDIO only while this is off */
+void dap_target_swdio_drive(bool drive);
+bool dap_target_swdio_read(void);
+void dap_target_tdi_write(bool level);
+bool dap_target_tdi_read(void);
+bool dap_target_tdo_read(void);
+void dap_target_nreset_write(bool level);
+bool dap_target_nreset_read(void);
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+
+# Loads and dumps target memory through the DAP Link block transfer vendor commands,
+# and compares them with plain DAP_TransferBlock. Requires pyusb and CMSIS-DAP v2.
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+import usb.core
+import usb.util
+
+VID = 0x0483
+PID = 0x5740
+PACKET_SIZE = 64
+
+ID_DAP_CONNECT = 0x02
+ID_DAP_DISCONNECT = 0x03
+ID_DAP_TRANSFER_CONFIGURE = 0x04
+ID_DAP_TRANSFER = 0x05
+ID_DAP_TRANSFER_BLOCK = 0x06
+ID_DAP_SWJ_CLOCK = 0x11
+ID_DAP_SWJ_SEQUENCE = 0x12
+ID_DAP_VENDOR_0 = 0x80
+
+MEM_BLOCK_READ = ID_DAP_VENDOR_0 + 0x02
+MEM_BLOCK_WRITE = ID_DAP_VENDOR_0 + 0x03
+MEM_BLOCK_WRITE_DATA = ID_DAP_VENDOR_0 + 0x04
+MEM_BLOCK_PACKET_WORDS = (PACKET_SIZE - 3) // 4
+
+DAP_PORT_SWD = 1
+DAP_TRANSFER_OK = 1
+
+DP_ABORT_WRITE = 0x00
+DP_DPIDR_READ = 0x02
+DP_CTRL_STAT_WRITE = 0x04
+DP_CTRL_STAT_READ = 0x06
+DP_SELECT_WRITE = 0x08
+AP_CSW_WRITE = 0x01
+AP_TAR_WRITE = 0x05
+AP_DRW_WRITE = 0x0D
+AP_DRW_READ = 0x0F
+
+# 32-bit access, single auto-increment, privileged data access
+DEFAULT_CSW = 0x23000012
+
+TAR_BLOCK_SIZE = 1024
+
+
+class DapError(Exception):
+    pass
+
+
+class Dap:
+    def __init__(self, serial=None):
+        self.device = usb.core.find(
+            idVendor=VID,
+            idProduct=PID,
+            custom_match=lambda d: serial is None
+            or usb.util.get_string(d, d.iSerialNumber) == serial,
+        )
+        if self.device is None:
+            raise DapError("DAP Link not found")
+        self.device.set_configuration()
+        interface = next(
+            i
+            for i in self.device.get_active_configuration()
+            if i.bInterfaceClass == 0xFF
+        )
+        self.ep_out = usb.util.find_descriptor(
+            interface,
+            custom_match=lambda e: usb.util.endpoint_direction(e.bEndpointAddress)
+            == usb.util.ENDPOINT_OUT,
+        )
+        # The first IN endpoint is the response one, the second streams SWO
+        self.ep_in = usb.util.find_descriptor(
+            interface,
+            custom_match=lambda e: usb.util.endpoint_direction(e.bEndpointAddress)
+            == usb.util.ENDPOINT_IN,
+        )
+
+    def send(self, request):
+        self.ep_out.write(bytes(request))
+
+    def receive(self, command):
+        response = bytes(self.ep_in.read(PACKET_SIZE, timeout=2000))
+        if response[0] != command:
+            raise DapError(f"unexpected response {response[0]:#04x} to {command:#04x}")
+        return response
+
+    def command(self, request):
+        self.send(request)
+        return self.receive(request[0])
+
+    def connect(self, clock):
+        self.command(struct.pack("<BI", ID_DAP_SWJ_CLOCK, clock))
+        if self.command([ID_DAP_CONNECT, DAP_PORT_SWD])[1] != DAP_PORT_SWD:
+            raise DapError("SWD connect failed")
+        self.command(struct.pack("<BBHH", ID_DAP_TRANSFER_CONFIGURE, 0, 64, 0))
+        # Line reset, JTAG-to-SWD switch, line reset, idle
+        for sequence in (b"\xff" * 7, b"\x9e\xe7", b"\xff" * 7, b"\x00"):
+            self.command(bytes([ID_DAP_SWJ_SEQUENCE, len(sequence) * 8]) + sequence)
+        dpidr = self.transfer([(DP_DPIDR_READ, None)])[0]
+        self.transfer([(DP_ABORT_WRITE, 0x1E), (DP_CTRL_STAT_WRITE, 0x50000000)])
+        for _ in range(100):
+            if self.transfer([(DP_CTRL_STAT_READ, None)])[0] & 0xA0000000 == 0xA0000000:
+                return dpidr
+        raise DapError("debug power-up failed")
+
+    def disconnect(self):
+        self.command([ID_DAP_DISCONNECT])
+
+    def transfer(self, requests):
+        request = bytearray([ID_DAP_TRANSFER, 0, len(requests)])
+        for transfer, value in requests:
+            request.append(transfer)
+            if value is not None:
+                request += struct.pack("<I", value)
+        response = self.command(request)
+        if response[1] != len(requests) or response[2] != DAP_TRANSFER_OK:
+            raise DapError(f"transfer failed, ack {response[2]}")
+        return struct.unpack_from(f"<{(len(response) - 3) // 4}I", response, 3)
+
+    def select(self, ap, csw):
+        self.transfer([(DP_SELECT_WRITE, ap << 24), (AP_CSW_WRITE, csw)])
+
+    # Plain CMSIS-DAP: TAR write and one DAP_TransferBlock per packet
+    def block_write(self, address, data):
+        words = struct.unpack(f"<{len(data) // 4}I", data)
+        offset = 0
+        while offset < len(words):
+            self.transfer([(AP_TAR_WRITE, address + offset * 4)])
+            limit = min(
+                len(words),
+                offset
+                + (TAR_BLOCK_SIZE - (address + offset * 4) % TAR_BLOCK_SIZE) // 4,
+            )
+            while offset < limit:
+                count = min(limit - offset, (PACKET_SIZE - 5) // 4)
+                request = struct.pack(
+                    "<BBHB", ID_DAP_TRANSFER_BLOCK, 0, count, AP_DRW_WRITE
+                )
+                response = self.command(
+                    request + struct.pack(f"<{count}I", *words[offset : offset + count])
+                )
+                if response[3] != DAP_TRANSFER_OK:
+                    raise DapError(f"block write failed, ack {response[3]}")
+                offset += count
+
+    def block_read(self, address, size):
+        data = bytearray()
+        while len(data) < size:
+            self.transfer([(AP_TAR_WRITE, address + len(data))])
+            limit = min(
+                size,
+                len(data) + TAR_BLOCK_SIZE - (address + len(data)) % TAR_BLOCK_SIZE,
+            )
+            while len(data) < limit:
+                count = min(limit - len(data), PACKET_SIZE - 4) // 4
+                request = struct.pack(
+                    "<BBHB", ID_DAP_TRANSFER_BLOCK, 0, count, AP_DRW_READ
+                )
+                response = self.command(request)
+                if response[3] != DAP_TRANSFER_OK:
+                    raise DapError(f"block read failed, ack {response[3]}")
+                data += response[4 : 4 + count * 4]
+        return bytes(data)
+
+    # Vendor commands: one setup, then the data streams in full packets
+    def mem_write(self, ap, csw, address, data):
+        response = self.command(
+            struct.pack("<BBBIII", MEM_BLOCK_WRITE, 0, ap, csw, address, len(data))
+        )
+        if response[1] != DAP_TRANSFER_OK:
+            raise DapError(f"memory write setup failed, ack {response[1]}")
+        step = MEM_BLOCK_PACKET_WORDS * 4
+        for offset in range(0, len(data), step):
+            chunk = data[offset : offset + step]
+            self.send(bytes([MEM_BLOCK_WRITE_DATA, len(chunk) // 4]) + chunk)
+        response = self.receive(MEM_BLOCK_WRITE_DATA)
+        ack, written = struct.unpack_from("<BI", response, 1)
+        if ack != DAP_TRANSFER_OK:
+            raise DapError(f"memory write failed after {written * 4} bytes, ack {ack}")
+
+    def mem_read(self, ap, csw, address, size):
+        self.send(struct.pack("<BBBIII", MEM_BLOCK_READ, 0, ap, csw, address, size))
+        data = bytearray()
+        while len(data) < size:
+            response = self.receive(MEM_BLOCK_READ)
+            data += response[3 : 3 + response[2] * 4]
+            if response[1] != DAP_TRANSFER_OK:
+                raise DapError(
+                    f"memory read failed after {len(data)} bytes, ack {response[1]}"
+                )
+        return bytes(data)
+
+
+def measure(name, size, function):
+    start = time.perf_counter()
+    result = function()
+    elapsed = time.perf_counter() - start
+    print(f"{name:<24} {size / elapsed / 1024:8.1f} KiB/s")
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="DAP Link memory block transfers")
+    parser.add_argument("command", choices=["read", "write", "bench"])
+    parser.add_argument("address", type=lambda x: int(x, 0))
+    parser.add_argument("size_or_file", help="size for read and bench, file for write")
+    parser.add_argument("output", nargs="?", help="output file for read")
+    parser.add_argument("--serial", help="DAP Link serial number, e.g. DAP_Oyevoxo")
+    parser.add_argument("--clock", type=int, default=10000000, help="SWD clock in Hz")
+    parser.add_argument("--ap", type=int, default=0)
+    parser.add_argument("--csw", type=lambda x: int(x, 0), default=DEFAULT_CSW)
+    args = parser.parse_args()
+
+    if args.address % 4:
+        parser.error("address must be word aligned")
+
+    dap = Dap(args.serial)
+    print(f"DPIDR {dap.connect(args.clock):#010x}")
+    try:
+        if args.command == "write":
+            with open(args.size_or_file, "rb") as file:
+                data = file.read()
+            data += b"\x00" * (-len(data) % 4)
+            measure(
+                "write",
+                len(data),
+                lambda: dap.mem_write(args.ap, args.csw, args.address, data),
+            )
+            return 0
+
+        size = int(args.size_or_file, 0)
+        if size % 4:
+            parser.error("size must be a multiple of 4")
+
+        if args.command == "read":
+            data = measure(
+                "read",
+                size,
+                lambda: dap.mem_read(args.ap, args.csw, args.address, size),
+            )
+            if args.output:
+                with open(args.output, "wb") as file:
+                    file.write(data)
+            return 0
+
+        # Target RAM is overwritten
+        pattern = os.urandom(size)
+        dap.select(args.ap, args.csw)
+        measure(
+            "DAP_TransferBlock write",
+            size,
+            lambda: dap.block_write(args.address, pattern),
+        )
+        readback = measure(
+            "DAP_TransferBlock read", size, lambda: dap.block_read(args.address, size)
+        )
+        if readback != pattern:
+            raise DapError("DAP_TransferBlock verify failed")
+
+        pattern = os.urandom(size)
+        measure(
+            "block write",
+            size,
+            lambda: dap.mem_write(args.ap, args.csw, args.address, pattern),
+        )
+        readback = measure(
+            "block read",
+            size,
+            lambda: dap.mem_read(args.ap, args.csw, args.address, size),
+        )
+        if readback != pattern:
+            raise DapError("block verify failed")
+        print("verify OK")
+    finally:
+        dap.disconnect()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -24,10 +24,13 @@
 #define DAP_HID_EP_OUT (HID_EP_OUT | DAP_HID_EP_RECV)
 #define DAP_HID_EP_BULK_IN (HID_EP_IN | DAP_HID_EP_BULK_SEND)
 #define DAP_HID_EP_BULK_OUT (HID_EP_OUT | DAP_HID_EP_BULK_RECV)
+// All endpoint numbers are taken, SWO shares the number with the bulk OUT endpoint
+#define DAP_HID_EP_BULK_SWO (HID_EP_IN | DAP_HID_EP_BULK_RECV)
 
 #define DAP_HID_EP_SIZE 64
 #define DAP_CDC_COMM_EP_SIZE 8
 #define DAP_CDC_EP_SIZE 64
+#define DAP_CDC_TX_BUFFERS 2
 
 #define DAP_BULK_INTERVAL 0
 #define DAP_HID_INTERVAL 1
@@ -99,6 +102,7 @@ struct HidConfigDescriptor {
     struct usb_interface_descriptor bulk_interface;
     struct usb_endpoint_descriptor bulk_ep_out;
     struct usb_endpoint_descriptor bulk_ep_in;
+    struct usb_endpoint_descriptor bulk_ep_swo;
 
     // CDC
     struct usb_iad_descriptor iad;
@@ -213,7 +217,7 @@ static const struct HidConfigDescriptor hid_cfg_desc = {
             .bDescriptorType = USB_DTYPE_INTERFACE,
             .bInterfaceNumber = USB_INTF_BULK,
             .bAlternateSetting = 0,
-            .bNumEndpoints = 2,
+            .bNumEndpoints = 3,
             .bInterfaceClass = USB_CLASS_VENDOR,
             .bInterfaceSubClass = 0,
             .bInterfaceProtocol = 0,
@@ -240,6 +244,16 @@ static const struct HidConfigDescriptor hid_cfg_desc = {
             .bInterval = DAP_BULK_INTERVAL,
         },
 
+    .bulk_ep_swo =
+        {
+            .bLength = sizeof(struct usb_endpoint_descriptor),
+            .bDescriptorType = USB_DTYPE_ENDPOINT,
+            .bEndpointAddress = DAP_HID_EP_BULK_SWO,
+            .bmAttributes = USB_EPTYPE_BULK,
+            .wMaxPacketSize = DAP_HID_EP_SIZE,
+            .bInterval = DAP_BULK_INTERVAL,
+        },
+
     // CDC
     .iad =
         {
@@ -442,12 +456,14 @@ const usb_msos_descriptor_set_t usb_msos_descriptor_set = {
 typedef struct {
     FuriSemaphore* semaphore_v1;
     FuriSemaphore* semaphore_v2;
+    FuriSemaphore* semaphore_swo;
     FuriSemaphore* semaphore_cdc;
     bool connected;
     usbd_device* usb_dev;
     DapStateCallback state_callback;
     DapRxCallback rx_callback_v1;
     DapRxCallback rx_callback_v2;
+    DapRxCallback tx_complete_swo;
     DapRxCallback rx_callback_cdc;
     DapRxCallback tx_complete_cdc;
     DapCDCControlLineCallback control_line_callback_cdc;
@@ -459,12 +475,14 @@ typedef struct {
 static DAPState dap_state = {
     .semaphore_v1 = NULL,
     .semaphore_v2 = NULL,
+    .semaphore_swo = NULL,
     .semaphore_cdc = NULL,
     .connected = false,
     .usb_dev = NULL,
     .state_callback = NULL,
     .rx_callback_v1 = NULL,
     .rx_callback_v2 = NULL,
+    .tx_complete_swo = NULL,
     .rx_callback_cdc = NULL,
     .control_line_callback_cdc = NULL,
     .config_callback_cdc = NULL,
@@ -520,10 +538,35 @@ int32_t dap_v2_usb_tx(uint8_t* buffer, uint8_t size) {
     }
 }
 
+int32_t dap_v2_usb_tx_timeout(uint8_t* buffer, uint8_t size, uint32_t timeout) {
+    if((dap_state.semaphore_v2 == NULL) || (dap_state.connected == false)) return 0;
+
+    // Unsolicited packets: give up if the host stops reading
+    if(furi_semaphore_acquire(dap_state.semaphore_v2, timeout) == FuriStatusOk) {
+        if(dap_state.connected) {
+            return usbd_ep_write(dap_state.usb_dev, DAP_HID_EP_BULK_IN, buffer, size);
+        }
+    }
+    return 0;
+}
+
+int32_t dap_v2_usb_swo_tx(uint8_t* buffer, uint8_t size) {
+    if((dap_state.semaphore_swo == NULL) || (dap_state.connected == false)) return 0;
+
+    // Trace data stays in the capture buffer until the endpoint is free
+    if(furi_semaphore_acquire(dap_state.semaphore_swo, 0) == FuriStatusOk) {
+        if(dap_state.connected) {
+            return usbd_ep_write(dap_state.usb_dev, DAP_HID_EP_BULK_SWO, buffer, size);
+        }
+    }
+    return 0;
+}
+
 int32_t dap_cdc_usb_tx(uint8_t* buffer, uint8_t size) {
     if((dap_state.semaphore_cdc == NULL) || (dap_state.connected == false)) return 0;
 
-    if(furi_semaphore_acquire(dap_state.semaphore_cdc, 100) == FuriStatusOk) {
+    // Endpoint is double buffered, one packet can be queued while the other one is sent
+    if(furi_semaphore_acquire(dap_state.semaphore_cdc, 0) == FuriStatusOk) {
         if(dap_state.connected) {
             int32_t len =
                 usbd_ep_write(dap_state.usb_dev, HID_EP_IN | DAP_CDC_EP_SEND, buffer, size);
@@ -534,6 +577,11 @@ int32_t dap_cdc_usb_tx(uint8_t* buffer, uint8_t size) {
     return 0;
 }
 
+bool dap_cdc_usb_tx_idle(void) {
+    if(dap_state.semaphore_cdc == NULL) return true;
+    return furi_semaphore_get_count(dap_state.semaphore_cdc) == DAP_CDC_TX_BUFFERS;
+}
+
 void dap_v1_usb_set_rx_callback(DapRxCallback callback) {
     dap_state.rx_callback_v1 = callback;
 }
@@ -542,6 +590,10 @@ void dap_v2_usb_set_rx_callback(DapRxCallback callback) {
     dap_state.rx_callback_v2 = callback;
 }
 
+void dap_v2_usb_set_swo_tx_complete_callback(DapRxCallback callback) {
+    dap_state.tx_complete_swo = callback;
+}
+
 void dap_cdc_usb_set_rx_callback(DapRxCallback callback) {
     dap_state.rx_callback_cdc = callback;
 }
@@ -621,7 +673,9 @@ static void hid_init(usbd_device* dev, FuriHalUsbInterface* intf, void* ctx) {
     dap_state.usb_dev = dev;
     if(dap_state.semaphore_v1 == NULL) dap_state.semaphore_v1 = furi_semaphore_alloc(1, 1);
     if(dap_state.semaphore_v2 == NULL) dap_state.semaphore_v2 = furi_semaphore_alloc(1, 1);
-    if(dap_state.semaphore_cdc == NULL) dap_state.semaphore_cdc = furi_semaphore_alloc(1, 1);
+    if(dap_state.semaphore_swo == NULL) dap_state.semaphore_swo = furi_semaphore_alloc(1, 1);
+    if(dap_state.semaphore_cdc == NULL)
+        dap_state.semaphore_cdc = furi_semaphore_alloc(DAP_CDC_TX_BUFFERS, DAP_CDC_TX_BUFFERS);
 
     usbd_reg_config(dev, hid_ep_config);
     usbd_reg_control(dev, hid_control);
@@ -634,9 +688,11 @@ static void hid_deinit(usbd_device* dev) {
 
     furi_semaphore_free(dap_state.semaphore_v1);
     furi_semaphore_free(dap_state.semaphore_v2);
+    furi_semaphore_free(dap_state.semaphore_swo);
     furi_semaphore_free(dap_state.semaphore_cdc);
     dap_state.semaphore_v1 = NULL;
     dap_state.semaphore_v2 = NULL;
+    dap_state.semaphore_swo = NULL;
     dap_state.semaphore_cdc = NULL;
 
     usbd_reg_config(dev, NULL);
@@ -715,12 +771,18 @@ static void hid_txrx_ep_callback(usbd_device* dev, uint8_t event, uint8_t ep) {
 
 static void hid_txrx_ep_bulk_callback(usbd_device* dev, uint8_t event, uint8_t ep) {
     UNUSED(dev);
-    UNUSED(ep);
 
     switch(event) {
     case usbd_evt_eptx:
-        furi_semaphore_release(dap_state.semaphore_v2);
-        furi_console_log_printf("bulk tx complete");
+        if(ep == DAP_HID_EP_BULK_SWO) {
+            furi_semaphore_release(dap_state.semaphore_swo);
+            if(dap_state.tx_complete_swo != NULL) {
+                dap_state.tx_complete_swo(dap_state.context);
+            }
+        } else {
+            furi_semaphore_release(dap_state.semaphore_v2);
+            furi_console_log_printf("bulk tx complete");
+        }
         break;
     case usbd_evt_eprx:
         if(dap_state.rx_callback_v2 != NULL) {
@@ -763,6 +825,7 @@ static usbd_respond hid_ep_config(usbd_device* dev, uint8_t cfg) {
         usbd_ep_deconfig(dev, DAP_HID_EP_IN);
         usbd_ep_deconfig(dev, DAP_HID_EP_BULK_IN);
         usbd_ep_deconfig(dev, DAP_HID_EP_BULK_OUT);
+        usbd_ep_deconfig(dev, DAP_HID_EP_BULK_SWO);
         usbd_ep_deconfig(dev, HID_EP_IN | DAP_CDC_EP_COMM);
         usbd_ep_deconfig(dev, HID_EP_IN | DAP_CDC_EP_SEND);
         usbd_ep_deconfig(dev, HID_EP_OUT | DAP_CDC_EP_RECV);
@@ -778,8 +841,13 @@ static usbd_respond hid_ep_config(usbd_device* dev, uint8_t cfg) {
         usbd_ep_config(dev, DAP_HID_EP_OUT, USB_EPTYPE_INTERRUPT, DAP_HID_EP_SIZE);
         usbd_ep_config(dev, DAP_HID_EP_BULK_OUT, USB_EPTYPE_BULK, DAP_HID_EP_SIZE);
         usbd_ep_config(dev, DAP_HID_EP_BULK_IN, USB_EPTYPE_BULK, DAP_HID_EP_SIZE);
+        usbd_ep_config(dev, DAP_HID_EP_BULK_SWO, USB_EPTYPE_BULK, DAP_HID_EP_SIZE);
         usbd_ep_config(dev, HID_EP_OUT | DAP_CDC_EP_RECV, USB_EPTYPE_BULK, DAP_CDC_EP_SIZE);
-        usbd_ep_config(dev, HID_EP_IN | DAP_CDC_EP_SEND, USB_EPTYPE_BULK, DAP_CDC_EP_SIZE);
+        usbd_ep_config(
+            dev,
+            HID_EP_IN | DAP_CDC_EP_SEND,
+            USB_EPTYPE_BULK | USB_EPTYPE_DBLBUF,
+            DAP_CDC_EP_SIZE);
         usbd_ep_config(dev, HID_EP_IN | DAP_CDC_EP_COMM, USB_EPTYPE_INTERRUPT, DAP_CDC_EP_SIZE);
         usbd_reg_endpoint(dev, DAP_HID_EP_IN, hid_txrx_ep_callback);
         usbd_reg_endpoint(dev, DAP_HID_EP_OUT, hid_txrx_ep_callback);
@@ -787,6 +855,10 @@ static usbd_respond hid_ep_config(usbd_device* dev, uint8_t cfg) {
         usbd_reg_endpoint(dev, DAP_HID_EP_BULK_IN, hid_txrx_ep_bulk_callback);
         usbd_reg_endpoint(dev, HID_EP_OUT | DAP_CDC_EP_RECV, cdc_txrx_ep_callback);
         usbd_reg_endpoint(dev, HID_EP_IN | DAP_CDC_EP_SEND, cdc_txrx_ep_callback);
+        // Packets queued before reconfiguration will never complete
+        while(furi_semaphore_get_count(dap_state.semaphore_cdc) < DAP_CDC_TX_BUFFERS) {
+            furi_semaphore_release(dap_state.semaphore_cdc);
+        }
         // usbd_ep_write(dev, DAP_HID_EP_IN, NULL, 0);
         // usbd_ep_write(dev, DAP_HID_EP_BULK_IN, NULL, 0);
         // usbd_ep_write(dev, HID_EP_IN | DAP_CDC_EP_SEND, NULL, 0);
@@ -21,10 +21,16 @@ void dap_v1_usb_set_rx_callback(DapRxCallback callback);
 
 int32_t dap_v2_usb_tx(uint8_t* buffer, uint8_t size);
 
+int32_t dap_v2_usb_tx_timeout(uint8_t* buffer, uint8_t size, uint32_t timeout);
+
 size_t dap_v2_usb_rx(uint8_t* buffer, size_t size);
 
 void dap_v2_usb_set_rx_callback(DapRxCallback callback);
 
+int32_t dap_v2_usb_swo_tx(uint8_t* buffer, uint8_t size);
+
+void dap_v2_usb_set_swo_tx_complete_callback(DapRxCallback callback);
+
 /************************************ CDC **************************************/
 
 typedef void (*DapCDCControlLineCallback)(uint8_t state, void* context);
@@ -32,6 +38,8 @@ typedef void (*DapCDCConfigCallback)(struct usb_cdc_line_coding* config, void* c
 
 int32_t dap_cdc_usb_tx(uint8_t* buffer, uint8_t size);
 
+bool dap_cdc_usb_tx_idle(void);
+
 size_t dap_cdc_usb_rx(uint8_t* buffer, size_t size);
 
 void dap_cdc_usb_set_rx_callback(DapRxCallback callback);
@@ -52,6 +52,13 @@ FlipTDIApp* flip_tdi_app_alloc() {
     view_dispatcher_add_view(
         app->view_dispatcher, FlipTDIViewWidget, widget_get_view(app->widget));
 
+    // Variable Item List
+    app->variable_item_list = variable_item_list_alloc();
+    view_dispatcher_add_view(
+        app->view_dispatcher,
+        FlipTDIViewVariableItemList,
+        variable_item_list_get_view(app->variable_item_list));
+
     // Field Presence
     app->flip_tdi_view_main_instance = flip_tdi_view_main_alloc();
     view_dispatcher_add_view(
@@ -81,6 +88,10 @@ void flip_tdi_app_free(FlipTDIApp* app) {
     view_dispatcher_remove_view(app->view_dispatcher, FlipTDIViewWidget);
     widget_free(app->widget);
 
+    // Variable Item List
+    view_dispatcher_remove_view(app->view_dispatcher, FlipTDIViewVariableItemList);
+    variable_item_list_free(app->variable_item_list);
+
     // FlipTDIViewMain
     view_dispatcher_remove_view(app->view_dispatcher, FlipTDIViewMain);
     flip_tdi_view_main_free(app->flip_tdi_view_main_instance);
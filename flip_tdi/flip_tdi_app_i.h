@@ -9,11 +9,13 @@
 #include <gui/scene_manager.h>
 #include <gui/modules/submenu.h>
 #include <gui/modules/widget.h>
+#include <gui/modules/variable_item_list.h>
 #include <notification/notification_messages.h>
 #include "views/flip_tdi_view_main.h"
 #include <flip_tdi_icons.h>
 
 #include "helpers/ftdi_usb.h"
+#include "helpers/ftdi_gpio.h"
 
 
 typedef struct FlipTDIApp FlipTDIApp;
@@ -25,6 +27,7 @@ struct FlipTDIApp {
     NotificationApp* notifications;
     Submenu* submenu;
     Widget* widget;
+    VariableItemList* variable_item_list;
     FlipTDIViewMainType* flip_tdi_view_main_instance;
 
     FtdiUsb* ftdi_usb;
@@ -5,6 +5,7 @@ typedef enum {
     SubmenuIndexWiringUart = 10,
     SubmenuIndexWiringSpi,
     SubmenuIndexWiringGpio,
+    SubmenuIndexPinout,
     SubmenuIndexAbout,
 
     //FlipTDICustomEvent
@@ -3,18 +3,43 @@
 #include "ftdi_uart.h"
 #include "ftdi_bitbang.h"
 #include "ftdi_latency_timer.h"
+#include "ftdi_gpio.h"
 
 #define TAG "FTDI"
 
-#define FTDI_TX_RX_BUF_SIZE     (4096UL)
+#define FTDI_RX_PACKET_COUNT    (32UL)
+#define FTDI_TX_PACKET_COUNT    (32UL)
 #define FTDI_INTERFACE_A        (0x01UL)
 #define FTDI_DRIVER_INTERFACE_A (0x00UL)
 #define FTDI_UART_MAX_TX_SIZE   (64UL)
 
+typedef struct {
+    uint32_t size;
+    uint32_t pos; // OUT packets: bytes consumed by the engines
+    uint8_t data[FTDI_PACKET_SIZE];
+} FtdiPacket;
+
+/** Single producer, single consumer ring of packets, head and tail run freely */
+typedef struct {
+    FtdiPacket* packet;
+    uint32_t count;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+} FtdiPacketRing;
+
 struct Ftdi {
     FtdiModemStatus status;
-    FuriStreamBuffer* stream_rx;
-    FuriStreamBuffer* stream_tx;
+    //OUT packets are read from the endpoint straight into rx and consumed in place
+    FtdiPacketRing rx;
+    volatile bool rx_stalled;
+    volatile bool rx_purge;
+    volatile uint32_t rx_purge_head;
+    //IN packets are filled in place behind the status header, tx.head is the one being filled
+    FtdiPacketRing tx;
+    volatile bool tx_claimed;
+    volatile bool tx_flush;
+    volatile bool tx_purge;
+    volatile bool tx_purge_claimed;
     uint32_t baudrate;
     uint32_t bitband_speed;
     FtdiDataConfig data_config;
@@ -27,8 +52,31 @@ struct Ftdi {
 
     FtdiCallbackTxImmediate callback_tx_immediate;
     void* context_tx_immediate;
+    FtdiCallbackPacket callback_rx_free;
+    void* context_rx_free;
+    FtdiCallbackPacket callback_tx_ready;
+    void* context_tx_ready;
 };
 
+static void ftdi_packet_ring_alloc(FtdiPacketRing* ring, uint32_t count, uint32_t size) {
+    ring->packet = malloc(sizeof(FtdiPacket) * count);
+    ring->count = count;
+    ring->head = 0;
+    ring->tail = 0;
+    for(uint32_t i = 0; i < count; i++) {
+        ring->packet[i].size = size;
+        ring->packet[i].pos = 0;
+    }
+}
+
+static inline FtdiPacket* ftdi_packet_ring_get(FtdiPacketRing* ring, uint32_t index) {
+    return &ring->packet[index % ring->count];
+}
+
+static inline bool ftdi_packet_ring_is_full(FtdiPacketRing* ring) {
+    return (ring->head - ring->tail) >= ring->count;
+}
+
 static bool ftdi_check_interface(Ftdi* ftdi, uint16_t index) {
     UNUSED(ftdi);
     uint8_t interface = index & 0xff;
@@ -44,10 +92,17 @@ static void ftdi_callback_tx_immediate(void* context) {
 
 Ftdi* ftdi_alloc(void) {
     Ftdi* ftdi = malloc(sizeof(Ftdi));
-    ftdi->stream_rx =
-        furi_stream_buffer_alloc(sizeof(uint8_t) * FTDI_TX_RX_BUF_SIZE, sizeof(uint8_t));
-    ftdi->stream_tx =
-        furi_stream_buffer_alloc(sizeof(uint8_t) * FTDI_TX_RX_BUF_SIZE, sizeof(uint8_t));
+    ftdi_packet_ring_alloc(&ftdi->rx, FTDI_RX_PACKET_COUNT, 0);
+    ftdi->rx_stalled = false;
+    ftdi->rx_purge = false;
+    ftdi_packet_ring_alloc(&ftdi->tx, FTDI_TX_PACKET_COUNT, FTDI_PACKET_STATUS_SIZE);
+    ftdi->tx_claimed = false;
+    ftdi->tx_flush = false;
+    ftdi->tx_purge = false;
+    ftdi->tx_purge_claimed = false;
+    ftdi->callback_tx_immediate = NULL;
+    ftdi->callback_rx_free = NULL;
+    ftdi->callback_tx_ready = NULL;
     ftdi->baudrate = 115200;
 
     FtdiModemStatus status = {0};
@@ -68,23 +123,21 @@ void ftdi_free(Ftdi* ftdi) {
     ftdi_uart_free(ftdi->ftdi_uart);
     ftdi_bitbang_free(ftdi->ftdi_bitbang);
     ftdi_latency_timer_free(ftdi->ftdi_latency_timer);
-    furi_stream_buffer_free(ftdi->stream_tx);
-    furi_stream_buffer_free(ftdi->stream_rx);
+    free(ftdi->tx.packet);
+    free(ftdi->rx.packet);
     free(ftdi);
 }
 
 void ftdi_switch_callback_tx_immediate(Ftdi* ftdi) {
     FtdiMpsse* mpsse_handle = ftdi_bitbang_get_mpsse_handle(ftdi->ftdi_bitbang);
+    //MPSSE responses are coalesced until SEND_IMMEDIATE or the latency timer, as on FT232H
     if(ftdi->bit_mode.MPSSE) {
         ftdi_mpsse_gpio_set_callback(mpsse_handle, ftdi_callback_tx_immediate, ftdi);
-        ftdi_latency_timer_set_callback(ftdi->ftdi_latency_timer, NULL, NULL);
-        ftdi_latency_timer_enable(ftdi->ftdi_latency_timer, false);
     } else {
         ftdi_mpsse_gpio_set_callback(mpsse_handle, NULL, NULL);
-        ftdi_latency_timer_enable(ftdi->ftdi_latency_timer, true);
-        ftdi_latency_timer_set_callback(
-            ftdi->ftdi_latency_timer, ftdi_callback_tx_immediate, ftdi);
     }
+    ftdi_latency_timer_enable(ftdi->ftdi_latency_timer, true);
+    ftdi_latency_timer_set_callback(ftdi->ftdi_latency_timer, ftdi_callback_tx_immediate, ftdi);
 }
 
 void ftdi_set_callback_tx_immediate(Ftdi* ftdi, FtdiCallbackTxImmediate callback, void* context) {
@@ -92,63 +145,216 @@ void ftdi_set_callback_tx_immediate(Ftdi* ftdi, FtdiCallbackTxImmediate callback
     ftdi->context_tx_immediate = context;
 }
 
+void ftdi_set_callback_rx_free(Ftdi* ftdi, FtdiCallbackPacket callback, void* context) {
+    ftdi->callback_rx_free = callback;
+    ftdi->context_rx_free = context;
+}
+
+void ftdi_set_callback_tx_ready(Ftdi* ftdi, FtdiCallbackPacket callback, void* context) {
+    ftdi->callback_tx_ready = callback;
+    ftdi->context_tx_ready = context;
+}
+
+//Purges can come from the USB control interrupt, the ring owners apply them
+
 void ftdi_reset_purge_rx(Ftdi* ftdi) {
-    furi_stream_buffer_reset(ftdi->stream_rx);
+    ftdi->rx_purge_head = ftdi->rx.head;
+    ftdi->rx_purge = true;
+    ftdi_bitbang_purge_rx(ftdi->ftdi_bitbang);
 }
 
 void ftdi_reset_purge_tx(Ftdi* ftdi) {
-    furi_stream_buffer_reset(ftdi->stream_tx);
+    ftdi->tx_purge = true;
 }
 
 void ftdi_reset_sio(Ftdi* ftdi) {
     UNUSED(ftdi);
 }
 
-uint32_t ftdi_set_tx_buf(Ftdi* ftdi, const uint8_t* data, uint32_t size) {
-    uint32_t len = furi_stream_buffer_spaces_available(ftdi->stream_tx);
+uint8_t* ftdi_rx_packet_alloc(Ftdi* ftdi) {
+    if(ftdi_packet_ring_is_full(&ftdi->rx)) {
+        ftdi->rx_stalled = true;
+        return NULL;
+    }
+    return ftdi_packet_ring_get(&ftdi->rx, ftdi->rx.head)->data;
+}
 
-    if(len < size) {
-        size = len;
-        //ToDo: set error
-        //ftdi->status.DR = 1;
-        FURI_LOG_E(TAG, "FTDI TX buffer overflow");
+void ftdi_rx_packet_push(Ftdi* ftdi, uint32_t size) {
+    FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->rx, ftdi->rx.head);
+    packet->size = size;
+    packet->pos = 0;
+    __DMB();
+    ftdi->rx.head++;
+}
+
+//Packets were freed, let the endpoint continue if it stopped on a full ring
+static void ftdi_rx_resume(Ftdi* ftdi) {
+    if(ftdi->rx_stalled) {
+        ftdi->rx_stalled = false;
+        if(ftdi->callback_rx_free) ftdi->callback_rx_free(ftdi->context_rx_free);
     }
+}
 
-    return furi_stream_buffer_send(ftdi->stream_tx, data, size, 0);
+const uint8_t* ftdi_rx_packet_peek(Ftdi* ftdi, uint32_t* size) {
+    if(ftdi->rx_purge) {
+        ftdi->rx_purge = false;
+        ftdi->rx.tail = ftdi->rx_purge_head;
+        ftdi_rx_resume(ftdi);
+    }
+    if(ftdi->rx.tail == ftdi->rx.head) {
+        *size = 0;
+        return NULL;
+    }
+    FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->rx, ftdi->rx.tail);
+    *size = packet->size - packet->pos;
+    return &packet->data[packet->pos];
+}
+
+void ftdi_rx_packet_consume(Ftdi* ftdi, uint32_t size) {
+    FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->rx, ftdi->rx.tail);
+    packet->pos += size;
+    if(packet->pos < packet->size) return;
+
+    __DMB();
+    ftdi->rx.tail++;
+    ftdi_rx_resume(ftdi);
 }
 
-uint32_t ftdi_get_tx_buf(Ftdi* ftdi, uint8_t* data, uint32_t size) {
-    return furi_stream_buffer_receive(ftdi->stream_tx, data, size, 0);
+uint32_t ftdi_get_rx_buf(Ftdi* ftdi, uint8_t* data, uint32_t size) {
+    uint32_t len = 0;
+    while(len < size) {
+        uint32_t available = 0;
+        const uint8_t* packet = ftdi_rx_packet_peek(ftdi, &available);
+        if(!packet) break;
+        available = MIN(available, size - len);
+        memcpy(&data[len], packet, available);
+        ftdi_rx_packet_consume(ftdi, available);
+        len += available;
+    }
+    return len;
 }
 
-uint32_t ftdi_available_tx_buf(Ftdi* ftdi) {
-    return furi_stream_buffer_bytes_available(ftdi->stream_tx);
+/** Queues the packet being filled, call with interrupts disabled */
+static bool ftdi_tx_packet_queue(Ftdi* ftdi) {
+    FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.head);
+    if(packet->size <= FTDI_PACKET_STATUS_SIZE) return false;
+    ftdi->tx.head++;
+    return true;
 }
 
-uint32_t ftdi_set_rx_buf(Ftdi* ftdi, const uint8_t* data, uint32_t size) {
-    uint32_t len = furi_stream_buffer_spaces_available(ftdi->stream_rx);
+uint8_t* ftdi_tx_packet_claim(Ftdi* ftdi, uint32_t* size) {
+    uint8_t* data = NULL;
+    *size = 0;
 
-    if(len < size) {
-        size = len;
-        //Todo: set error
-        FURI_LOG_E(TAG, "FTDI RX buffer overflow");
+    FURI_CRITICAL_ENTER();
+    if(!ftdi_packet_ring_is_full(&ftdi->tx)) {
+        FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.head);
+        *size = FTDI_PACKET_SIZE - packet->size;
+        data = &packet->data[packet->size];
+        ftdi->tx_claimed = true;
     }
-    return furi_stream_buffer_send(ftdi->stream_rx, data, size, 0);
+    FURI_CRITICAL_EXIT();
+
+    return data;
+}
+
+void ftdi_tx_packet_commit(Ftdi* ftdi, uint32_t size) {
+    bool is_queued = false;
+
+    FURI_CRITICAL_ENTER();
+    FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.head);
+    if(ftdi->tx_purge_claimed) {
+        //Purged while being filled, the data belongs to before the purge
+        ftdi->tx_purge_claimed = false;
+        packet->size = FTDI_PACKET_STATUS_SIZE;
+    } else {
+        packet->size += size;
+    }
+    ftdi->tx_claimed = false;
+    //Full packets go out at once, a flush requested meanwhile is applied here
+    if((packet->size == FTDI_PACKET_SIZE) || ftdi->tx_flush) {
+        ftdi->tx_flush = false;
+        is_queued = ftdi_tx_packet_queue(ftdi);
+    }
+    FURI_CRITICAL_EXIT();
+
+    if(is_queued && ftdi->callback_tx_ready) ftdi->callback_tx_ready(ftdi->context_tx_ready);
+}
+
+void ftdi_tx_flush(Ftdi* ftdi) {
+    FURI_CRITICAL_ENTER();
+    if(ftdi->tx_claimed) {
+        ftdi->tx_flush = true;
+    } else if(!ftdi_packet_ring_is_full(&ftdi->tx)) {
+        ftdi_tx_packet_queue(ftdi);
+    }
+    FURI_CRITICAL_EXIT();
+}
+
+uint8_t* ftdi_tx_packet_get(Ftdi* ftdi, uint32_t* size) {
+    FURI_CRITICAL_ENTER();
+    if(ftdi->tx_purge) {
+        ftdi->tx_purge = false;
+        ftdi->tx_purge_claimed = false;
+        while(ftdi->tx.tail != ftdi->tx.head) {
+            ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.tail++)->size = FTDI_PACKET_STATUS_SIZE;
+        }
+        //A claimed packet is still being written, it is reset on commit
+        if(ftdi->tx_claimed) {
+            ftdi->tx_purge_claimed = true;
+        } else {
+            ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.head)->size = FTDI_PACKET_STATUS_SIZE;
+        }
+    }
+    FURI_CRITICAL_EXIT();
+
+    if(ftdi->tx.tail == ftdi->tx.head) return NULL;
+
+    FtdiPacket* packet = ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.tail);
+    memcpy(packet->data, &ftdi->status, FTDI_PACKET_STATUS_SIZE);
+    *size = packet->size;
+    return packet->data;
 }
 
-uint32_t ftdi_get_rx_buf(Ftdi* ftdi, uint8_t* data, uint32_t size, uint32_t timeout) {
-    return furi_stream_buffer_receive(ftdi->stream_rx, data, size, timeout);
+void ftdi_tx_packet_release(Ftdi* ftdi) {
+    ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.tail)->size = FTDI_PACKET_STATUS_SIZE;
+    __DMB();
+    ftdi->tx.tail++;
 }
 
-uint32_t ftdi_available_rx_buf(Ftdi* ftdi) {
-    return furi_stream_buffer_bytes_available(ftdi->stream_rx);
+uint32_t ftdi_set_tx_buf(Ftdi* ftdi, const uint8_t* data, uint32_t size) {
+    uint32_t len = 0;
+    while(len < size) {
+        uint32_t space = 0;
+        uint8_t* packet = ftdi_tx_packet_claim(ftdi, &space);
+        if(!packet) {
+            //ToDo: set error
+            //ftdi->status.DR = 1;
+            FURI_LOG_E(TAG, "FTDI TX buffer overflow");
+            break;
+        }
+        space = MIN(space, size - len);
+        memcpy(packet, &data[len], space);
+        ftdi_tx_packet_commit(ftdi, space);
+        len += space;
+    }
+    return len;
+}
+
+uint32_t ftdi_available_tx_space(Ftdi* ftdi) {
+    uint32_t packets = ftdi->tx.count - (ftdi->tx.head - ftdi->tx.tail);
+    if(!packets) return 0;
+    uint32_t fill = ftdi_packet_ring_get(&ftdi->tx, ftdi->tx.head)->size;
+    return (packets - 1) * FTDI_PACKET_PAYLOAD_SIZE + (FTDI_PACKET_SIZE - fill);
 }
 
 void ftdi_loopback(Ftdi* ftdi) {
-    //todo fix size
-    uint8_t data[128];
-    uint32_t len = ftdi_get_rx_buf(ftdi, data, 128, 0);
-    ftdi_set_tx_buf(ftdi, data, len);
+    uint32_t size = 0;
+    const uint8_t* data = ftdi_rx_packet_peek(ftdi, &size);
+    if(data) {
+        size = ftdi_set_tx_buf(ftdi, data, size);
+        ftdi_rx_packet_consume(ftdi, size);
+    }
 }
 
 /*
@@ -275,6 +481,8 @@ void ftdi_set_bitmode(Ftdi* ftdi, uint16_t value, uint16_t index) {
     }
 
     if(ftdi->bit_mode.BITBANG || ftdi->bit_mode.SYNCBB || ftdi->bit_mode.MPSSE) {
+        //A pinout selected in the app takes effect when the host enters a bit mode
+        ftdi_gpio_update_pinout();
         ftdi_bitbang_set_gpio(ftdi->ftdi_bitbang, ftdi->bit_mode_mask);
         ftdi_bitbang_enable(ftdi->ftdi_bitbang, ftdi->bit_mode);
     } else {
@@ -315,6 +523,10 @@ void ftdi_start_uart_tx(Ftdi* ftdi) {
     ftdi_uart_tx(ftdi->ftdi_uart);
 }
 
+void ftdi_start_bitbang_rx(Ftdi* ftdi) {
+    ftdi_bitbang_rx(ftdi->ftdi_bitbang);
+}
+
 uint8_t ftdi_get_bitbang_gpio(Ftdi* ftdi) {
     ftdi_reset_purge_tx(ftdi);
     return ftdi_bitbang_get_gpio(ftdi->ftdi_bitbang);
@@ -3,22 +3,47 @@
 
 //#define FTDI_DEBUG
 
+//USB packets with the 2 bytes of modem status in front of the IN data
+#define FTDI_PACKET_SIZE         (64UL)
+#define FTDI_PACKET_STATUS_SIZE  (2UL)
+#define FTDI_PACKET_PAYLOAD_SIZE (FTDI_PACKET_SIZE - FTDI_PACKET_STATUS_SIZE)
+
 typedef struct Ftdi Ftdi;
 
 typedef void (*FtdiCallbackTxImmediate)(void* context);
+typedef void (*FtdiCallbackPacket)(void* context);
 
 Ftdi* ftdi_alloc(void);
 void ftdi_free(Ftdi* ftdi);
 void ftdi_set_callback_tx_immediate(Ftdi* ftdi, FtdiCallbackTxImmediate callback, void* context);
+/** Called when an OUT packet is free again after ftdi_rx_packet_alloc() failed */
+void ftdi_set_callback_rx_free(Ftdi* ftdi, FtdiCallbackPacket callback, void* context);
+/** Called when an IN packet is queued, may be called from an interrupt */
+void ftdi_set_callback_tx_ready(Ftdi* ftdi, FtdiCallbackPacket callback, void* context);
 void ftdi_reset_purge_rx(Ftdi* ftdi);
 void ftdi_reset_purge_tx(Ftdi* ftdi);
 void ftdi_reset_sio(Ftdi* ftdi);
+
+//USB side of the packet pool
+/** Free OUT packet to read the endpoint into, NULL while all of them are in use */
+uint8_t* ftdi_rx_packet_alloc(Ftdi* ftdi);
+void ftdi_rx_packet_push(Ftdi* ftdi, uint32_t size);
+/** Next queued IN packet with the modem status filled in, NULL if none */
+uint8_t* ftdi_tx_packet_get(Ftdi* ftdi, uint32_t* size);
+void ftdi_tx_packet_release(Ftdi* ftdi);
+/** Queues the partially filled IN packet, for SEND_IMMEDIATE and the latency timer */
+void ftdi_tx_flush(Ftdi* ftdi);
+
+//Engine side of the packet pool
+/** Unconsumed data of the oldest OUT packet, valid until consumed */
+const uint8_t* ftdi_rx_packet_peek(Ftdi* ftdi, uint32_t* size);
+void ftdi_rx_packet_consume(Ftdi* ftdi, uint32_t size);
+/** Free space of the IN packet being filled, must be followed by ftdi_tx_packet_commit() */
+uint8_t* ftdi_tx_packet_claim(Ftdi* ftdi, uint32_t* size);
+void ftdi_tx_packet_commit(Ftdi* ftdi, uint32_t size);
 uint32_t ftdi_set_tx_buf(Ftdi* ftdi, const uint8_t* data, uint32_t size);
-uint32_t ftdi_get_tx_buf(Ftdi* ftdi, uint8_t* data, uint32_t size);
-uint32_t ftdi_available_tx_buf(Ftdi* ftdi);
-uint32_t ftdi_set_rx_buf(Ftdi* ftdi, const uint8_t* data, uint32_t size);
-uint32_t ftdi_get_rx_buf(Ftdi* ftdi, uint8_t* data, uint32_t size, uint32_t timeout);
-uint32_t ftdi_available_rx_buf(Ftdi* ftdi);
+uint32_t ftdi_available_tx_space(Ftdi* ftdi);
+uint32_t ftdi_get_rx_buf(Ftdi* ftdi, uint8_t* data, uint32_t size);
 void ftdi_loopback(Ftdi* ftdi);
 void ftdi_set_baudrate(Ftdi* ftdi, uint16_t value, uint16_t index);
 void ftdi_set_data_config(Ftdi* ftdi, uint16_t value, uint16_t index);
@@ -32,4 +57,5 @@ FtdiModemStatus ftdi_get_modem_status(Ftdi* ftdi);
 void ftdi_set_modem_status(Ftdi* ftdi, FtdiModemStatus status);
 
 void ftdi_start_uart_tx(Ftdi* ftdi);
+void ftdi_start_bitbang_rx(Ftdi* ftdi);
 uint8_t ftdi_get_bitbang_gpio(Ftdi* ftdi);
@@ -4,12 +4,14 @@
 #include "ftdi_bitbang.h"
 #include "furi.h"
 #include <furi_hal.h>
-#include <furi_hal_bus.h>
 #include <furi_hal_resources.h>
 #include "ftdi_gpio.h"
+#include "ftdi_bitbang_dma.h"
 
 #define TAG "FTDI_BITBANG"
 
+#define FTDI_BITBANG_TX_RETRY_TIMEOUT (1UL)
+
 typedef enum {
     FtdiBitbangModeOff = (0UL),
     FtdiBitbangModeBitbang = (1UL),
@@ -18,79 +20,34 @@ typedef enum {
     FtdiBitbangModeReserved = (4UL),
 } FtdiBitbangMode;
 
-typedef void (*FtdiBitbangGpioIO)(uint8_t state);
 struct FtdiBitbang {
     FuriThread* worker_thread;
     Ftdi* ftdi;
     FtdiMpsse* ftdi_mpsse;
+    FtdiBitbangDma* ftdi_bitbang_dma;
     uint32_t speed;
     FtdiBitbangMode mode;
 
     uint8_t gpio_mask;
-    FtdiBitbangGpioIO gpio_o[8];
     uint8_t gpio_data;
 };
 
 typedef enum {
     WorkerEventReserved = (1 << 0),
     WorkerEventStop = (1 << 1),
-    WorkerEventTimerUpdate = (1 << 2),
+    WorkerEventConfig = (1 << 2),
+    WorkerEventRx = (1 << 3),
+    WorkerEventPurgeRx = (1 << 4),
+    WorkerEventDmaHalf = (1 << 5),
+    WorkerEventDmaFull = (1 << 6),
 } WorkerEvent;
 
-#define WORKER_EVENTS_MASK (WorkerEventStop | WorkerEventTimerUpdate)
-
-static void ftdi_bitbang_tim_init(FtdiBitbang* ftdi_bitbang);
-static void ftdi_bitbang_tim_deinit(FtdiBitbang* ftdi_bitbang);
+#define WORKER_EVENTS_MASK                                                        \
+    (WorkerEventStop | WorkerEventConfig | WorkerEventRx | WorkerEventPurgeRx | \
+     WorkerEventDmaHalf | WorkerEventDmaFull)
 
 void ftdi_bitbang_gpio_set_direction(FtdiBitbang* ftdi_bitbang) {
     ftdi_gpio_set_direction(ftdi_bitbang->gpio_mask);
-    if(ftdi_bitbang->gpio_mask & 0b00000001) {
-        ftdi_bitbang->gpio_o[0] = ftdi_gpio_set_b0;
-    } else {
-        ftdi_bitbang->gpio_o[0] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b00000010) {
-        ftdi_bitbang->gpio_o[1] = ftdi_gpio_set_b1;
-    } else {
-        ftdi_bitbang->gpio_o[1] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b00000100) {
-        ftdi_bitbang->gpio_o[2] = ftdi_gpio_set_b2;
-    } else {
-        ftdi_bitbang->gpio_o[2] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b00001000) {
-        ftdi_bitbang->gpio_o[3] = ftdi_gpio_set_b3;
-    } else {
-        ftdi_bitbang->gpio_o[3] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b00010000) {
-        ftdi_bitbang->gpio_o[4] = ftdi_gpio_set_b4;
-    } else {
-        ftdi_bitbang->gpio_o[4] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b00100000) {
-        ftdi_bitbang->gpio_o[5] = ftdi_gpio_set_b5;
-    } else {
-        ftdi_bitbang->gpio_o[5] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b01000000) {
-        ftdi_bitbang->gpio_o[6] = ftdi_gpio_set_b6;
-    } else {
-        ftdi_bitbang->gpio_o[6] = ftdi_gpio_set_noop;
-    }
-
-    if(ftdi_bitbang->gpio_mask & 0b10000000) {
-        ftdi_bitbang->gpio_o[7] = ftdi_gpio_set_b7;
-    } else {
-        ftdi_bitbang->gpio_o[7] = ftdi_gpio_set_noop;
-    }
 }
 
 void ftdi_bitbang_gpio_init(FtdiBitbang* ftdi_bitbang) {
@@ -98,17 +55,6 @@ void ftdi_bitbang_gpio_init(FtdiBitbang* ftdi_bitbang) {
     ftdi_bitbang_gpio_set_direction(ftdi_bitbang);
 }
 
-static inline void ftdi_bitbang_gpio_set(FtdiBitbang* ftdi_bitbang, uint8_t gpio_data_out) {
-    ftdi_bitbang->gpio_o[0](gpio_data_out & 0b00000001);
-    ftdi_bitbang->gpio_o[1](gpio_data_out & 0b00000010);
-    ftdi_bitbang->gpio_o[2](gpio_data_out & 0b00000100);
-    ftdi_bitbang->gpio_o[3](gpio_data_out & 0b00001000);
-    ftdi_bitbang->gpio_o[4](gpio_data_out & 0b00010000);
-    ftdi_bitbang->gpio_o[5](gpio_data_out & 0b00100000);
-    ftdi_bitbang->gpio_o[6](gpio_data_out & 0b01000000);
-    ftdi_bitbang->gpio_o[7](gpio_data_out & 0b10000000);
-}
-
 static inline uint8_t ftdi_bitbang_gpio_get(void) {
     uint8_t gpio_data = 0;
     gpio_data |= ftdi_gpio_get_b0();
@@ -122,41 +68,86 @@ static inline uint8_t ftdi_bitbang_gpio_get(void) {
     return gpio_data;
 }
 
+static inline bool ftdi_bitbang_is_dma_mode(FtdiBitbang* ftdi_bitbang) {
+    return (ftdi_bitbang->mode == FtdiBitbangModeBitbang) ||
+           (ftdi_bitbang->mode == FtdiBitbangModeSyncbb);
+}
+
+static void ftdi_bitbang_dma_callback(void* context, size_t half) {
+    FtdiBitbang* ftdi_bitbang = context;
+    furi_thread_flags_set(
+        furi_thread_get_id(ftdi_bitbang->worker_thread),
+        half ? WorkerEventDmaFull : WorkerEventDmaHalf);
+}
+
+/**
+ * Sends the pin states sampled in a finished half of the DMA ring and refills it.
+ * Async bitbang reports every sample, sync bitbang one per byte written by the host.
+ */
+static void ftdi_bitbang_dma_process(FtdiBitbang* ftdi_bitbang, size_t half, uint8_t* buffer) {
+    //A stale event from before a restart, the rings are gone
+    if(!ftdi_bitbang_dma_is_running(ftdi_bitbang->ftdi_bitbang_dma)) return;
+
+    size_t size = ftdi_bitbang_dma_get_half_size(ftdi_bitbang->ftdi_bitbang_dma);
+    size_t count = ftdi_bitbang_dma_read(ftdi_bitbang->ftdi_bitbang_dma, half, buffer);
+    if(ftdi_bitbang->mode == FtdiBitbangModeBitbang) count = size;
+    if(count) {
+        ftdi_set_tx_buf(ftdi_bitbang->ftdi, buffer, count);
+        ftdi_bitbang->gpio_data = buffer[count - 1];
+    }
+
+    size_t length = ftdi_get_rx_buf(ftdi_bitbang->ftdi, buffer, size);
+    ftdi_bitbang_dma_write(ftdi_bitbang->ftdi_bitbang_dma, half, buffer, length);
+}
+
 static int32_t ftdi_bitbang_worker(void* context) {
     furi_assert(context);
     FtdiBitbang* ftdi_bitbang = context;
 
-    uint8_t buffer[64];
+    uint8_t buffer[FTDI_BITBANG_DMA_HALF_SIZE_MAX];
 
     FURI_LOG_I(TAG, "Worker started");
-    ftdi_bitbang_tim_init(ftdi_bitbang);
+    uint32_t timeout = FuriWaitForever;
     while(1) {
-        uint32_t events =
-            furi_thread_flags_wait(WORKER_EVENTS_MASK, FuriFlagWaitAny, FuriWaitForever);
+        uint32_t events = furi_thread_flags_wait(WORKER_EVENTS_MASK, FuriFlagWaitAny, timeout);
+        if(events == (uint32_t)FuriFlagErrorTimeout) {
+            //MPSSE output was stalled, retry the pending commands
+            events = WorkerEventRx;
+        }
         furi_check((events & FuriFlagError) == 0);
-        if(events & WorkerEventTimerUpdate) {
+
+        if(events & WorkerEventStop) break;
+
+        if(events & WorkerEventConfig) {
+            //Mode, speed and direction changes restart the DMA engine here, between halves
+            ftdi_bitbang_dma_stop(ftdi_bitbang->ftdi_bitbang_dma);
+            if(ftdi_bitbang_is_dma_mode(ftdi_bitbang)) {
+                ftdi_bitbang_dma_set_gpio(ftdi_bitbang->ftdi_bitbang_dma, ftdi_bitbang->gpio_mask);
+                ftdi_bitbang_dma_start(ftdi_bitbang->ftdi_bitbang_dma, ftdi_bitbang->speed);
+            }
+        }
+
+        if(events & WorkerEventPurgeRx) {
+            ftdi_mpsse_reset(ftdi_bitbang->ftdi_mpsse);
+            timeout = FuriWaitForever;
+        }
+
+        if(events & WorkerEventRx) {
             if(ftdi_bitbang->mode == FtdiBitbangModeMpsse) {
-                ftdi_mpsse_state_machine(ftdi_bitbang->ftdi_mpsse);
+                //Drain everything received, wake up again only on new USB data
+                bool done = ftdi_mpsse_process(ftdi_bitbang->ftdi_mpsse);
+                timeout = done ? FuriWaitForever : FTDI_BITBANG_TX_RETRY_TIMEOUT;
             } else {
-                size_t length = ftdi_get_rx_buf(ftdi_bitbang->ftdi, buffer, 1, 0);
-                if(length > 0) {
-                    ftdi_bitbang_gpio_set(ftdi_bitbang, buffer[0]);
-                    if(ftdi_bitbang->mode == FtdiBitbangModeSyncbb) {
-                        ftdi_bitbang->gpio_data = ftdi_bitbang_gpio_get();
-                        ftdi_set_tx_buf(ftdi_bitbang->ftdi, &ftdi_bitbang->gpio_data, 1);
-                    }
-                }
-                if(ftdi_bitbang->mode == FtdiBitbangModeBitbang) {
-                    ftdi_bitbang->gpio_data = ftdi_bitbang_gpio_get();
-                    ftdi_set_tx_buf(ftdi_bitbang->ftdi, &ftdi_bitbang->gpio_data, 1);
-                }
+                timeout = FuriWaitForever;
             }
-            continue;
         }
 
-        if(events & WorkerEventStop) break;
+        if(ftdi_bitbang_is_dma_mode(ftdi_bitbang)) {
+            if(events & WorkerEventDmaHalf) ftdi_bitbang_dma_process(ftdi_bitbang, 0, buffer);
+            if(events & WorkerEventDmaFull) ftdi_bitbang_dma_process(ftdi_bitbang, 1, buffer);
+        }
     }
-    ftdi_bitbang_tim_deinit(ftdi_bitbang);
+    ftdi_bitbang_dma_stop(ftdi_bitbang->ftdi_bitbang_dma);
 
     FURI_LOG_I(TAG, "Worker stopped");
     return 0;
@@ -170,6 +161,8 @@ FtdiBitbang* ftdi_bitbang_alloc(Ftdi* ftdi) {
     FtdiBitbang* ftdi_bitbang = malloc(sizeof(FtdiBitbang));
     ftdi_bitbang->ftdi = ftdi;
     ftdi_bitbang->ftdi_mpsse = ftdi_mpsse_alloc(ftdi);
+    ftdi_bitbang->ftdi_bitbang_dma =
+        ftdi_bitbang_dma_alloc(ftdi_bitbang_dma_callback, ftdi_bitbang);
     ftdi_bitbang->mode = FtdiBitbangModeOff;
     ftdi_bitbang->speed = 10000;
     ftdi_bitbang->gpio_mask = 0;
@@ -185,10 +178,11 @@ void ftdi_bitbang_free(FtdiBitbang* ftdi_bitbang) {
     if(!ftdi_bitbang) return;
 
     ftdi_bitbang->mode = FtdiBitbangModeOff;
-    ftdi_mpsse_free(ftdi_bitbang->ftdi_mpsse);
-    furi_thread_flags_set(ftdi_bitbang->worker_thread, WorkerEventStop);
+    furi_thread_flags_set(furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventStop);
     furi_thread_join(ftdi_bitbang->worker_thread);
     furi_thread_free(ftdi_bitbang->worker_thread);
+    ftdi_bitbang_dma_free(ftdi_bitbang->ftdi_bitbang_dma);
+    ftdi_mpsse_free(ftdi_bitbang->ftdi_mpsse);
 
     ftdi_gpio_deinit();
 
@@ -203,6 +197,7 @@ FtdiMpsse* ftdi_bitbang_get_mpsse_handle(FtdiBitbang* ftdi_bitbang) {
 void ftdi_bitbang_set_gpio(FtdiBitbang* ftdi_bitbang, uint8_t gpio_mask) {
     ftdi_bitbang->gpio_mask = gpio_mask;
     ftdi_bitbang_gpio_set_direction(ftdi_bitbang);
+    furi_thread_flags_set(furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventConfig);
 }
 
 void ftdi_bitbang_enable(FtdiBitbang* ftdi_bitbang, FtdiBitMode mode) {
@@ -216,74 +211,26 @@ void ftdi_bitbang_enable(FtdiBitbang* ftdi_bitbang, FtdiBitMode mode) {
         ftdi_bitbang->mode = FtdiBitbangModeOff;
     }
 
-    if(ftdi_bitbang->mode != FtdiBitbangModeOff) {
-        LL_TIM_SetCounter(TIM17, 0);
-        LL_TIM_EnableCounter(TIM17);
-    } else {
-        LL_TIM_DisableCounter(TIM17);
-    }
-}
-
-void ftdi_bitbang_set_speed(FtdiBitbang* ftdi_bitbang, uint32_t speed) {
-    UNUSED(ftdi_bitbang);
-    UNUSED(speed);
+    //MPSSE is woken up by USB data, the DMA engine paces bitbang modes only
+    furi_thread_flags_set(furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventConfig);
 
-    //Todo limit speed
-    if(speed > 40000) {
-        speed = 40000;
+    if(ftdi_bitbang->mode == FtdiBitbangModeMpsse) {
+        furi_thread_flags_set(
+            furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventPurgeRx | WorkerEventRx);
     }
-
-    uint32_t freq_div = 64000000LU / speed;
-    uint32_t prescaler = freq_div / 0x10000LU;
-    uint32_t period = freq_div / (prescaler + 1);
-    LL_TIM_SetPrescaler(TIM17, prescaler);
-    LL_TIM_SetAutoReload(TIM17, period - 1);
 }
 
-static void ftdi_bitbang_tim_isr(void* context) {
-    FtdiBitbang* ftdi_bitbang = context;
-    UNUSED(ftdi_bitbang);
-    if(LL_TIM_IsActiveFlag_UPDATE(TIM17)) {
-        LL_TIM_ClearFlag_UPDATE(TIM17);
-        //Speed max 40kHz
-        furi_thread_flags_set(
-            furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventTimerUpdate);
-        //Todo Speed Max 70kHz
-        // uint8_t buffer[1];
-        // size_t length = ftdi_get_rx_buf(ftdi_bitbang->ftdi, buffer, 1);
-        // if(length > 0) {
-        //     ftdi_bitbang_gpio_set(ftdi_bitbang, buffer[0]);
-        //     if(!ftdi_bitbang->async) {
-        //         ftdi_bitbang->gpio_data = ftdi_bitbang_gpio_get();
-        //         ftdi_set_tx_buf(ftdi_bitbang->ftdi, &ftdi_bitbang->gpio_data, 1);
-        //     }
-        // }
-        // if(ftdi_bitbang->enable && ftdi_bitbang->async) {
-        //     ftdi_bitbang->gpio_data = ftdi_bitbang_gpio_get();
-        //     ftdi_set_tx_buf(ftdi_bitbang->ftdi, &ftdi_bitbang->gpio_data, 1);
-        // }
+void ftdi_bitbang_rx(FtdiBitbang* ftdi_bitbang) {
+    if(ftdi_bitbang->mode == FtdiBitbangModeMpsse) {
+        furi_thread_flags_set(furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventRx);
     }
 }
 
-static void ftdi_bitbang_tim_init(FtdiBitbang* ftdi_bitbang) {
-    furi_hal_bus_enable(FuriHalBusTIM17);
-
-    LL_TIM_SetCounterMode(TIM17, LL_TIM_COUNTERMODE_UP);
-    LL_TIM_SetClockDivision(TIM17, LL_TIM_CLOCKDIVISION_DIV1);
-    LL_TIM_SetAutoReload(TIM17, 6400 - 1);
-    LL_TIM_SetPrescaler(TIM17, 0); // 10kHz
-    LL_TIM_SetClockSource(TIM17, LL_TIM_CLOCKSOURCE_INTERNAL);
-    LL_TIM_DisableARRPreload(TIM17);
-
-    furi_hal_interrupt_set_isr(
-        FuriHalInterruptIdTim1TrgComTim17, ftdi_bitbang_tim_isr, ftdi_bitbang);
-
-    LL_TIM_EnableIT_UPDATE(TIM17);
+void ftdi_bitbang_purge_rx(FtdiBitbang* ftdi_bitbang) {
+    furi_thread_flags_set(furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventPurgeRx);
 }
 
-static void ftdi_bitbang_tim_deinit(FtdiBitbang* ftdi_bitbang) {
-    UNUSED(ftdi_bitbang);
-    LL_TIM_DisableCounter(TIM17);
-    furi_hal_bus_disable(FuriHalBusTIM17);
-    furi_hal_interrupt_set_isr(FuriHalInterruptIdTim1TrgComTim17, NULL, NULL);
-}
\ No newline at end of file
+void ftdi_bitbang_set_speed(FtdiBitbang* ftdi_bitbang, uint32_t speed) {
+    ftdi_bitbang->speed = MIN(speed, FTDI_BITBANG_DMA_SPEED_MAX);
+    furi_thread_flags_set(furi_thread_get_id(ftdi_bitbang->worker_thread), WorkerEventConfig);
+}
@@ -10,4 +10,6 @@ FtdiMpsse* ftdi_bitbang_get_mpsse_handle(FtdiBitbang* ftdi_bitbang);
 void ftdi_bitbang_set_gpio(FtdiBitbang* ftdi_bitbang, uint8_t gpio_mask);
 void ftdi_bitbang_enable(FtdiBitbang* ftdi_bitbang, FtdiBitMode mode);
 void ftdi_bitbang_set_speed(FtdiBitbang* ftdi_bitbang, uint32_t speed);
+void ftdi_bitbang_rx(FtdiBitbang* ftdi_bitbang);
+void ftdi_bitbang_purge_rx(FtdiBitbang* ftdi_bitbang);
 uint8_t ftdi_bitbang_get_gpio(FtdiBitbang* ftdi_bitbang);
\ No newline at end of file
@@ -0,0 +1,331 @@
+#pragma GCC optimize("O3")
+#pragma GCC optimize("-funroll-all-loops")
+
+#include "ftdi_bitbang_dma.h"
+#include "furi.h"
+#include <furi_hal.h>
+#include <furi_hal_bus.h>
+#include "ftdi_gpio.h"
+
+#include <stm32wbxx_ll_dma.h>
+#include <stm32wbxx_ll_tim.h>
+
+#define TAG "FTDI_BITBANG_DMA"
+
+//Half ring interrupts per second up to 512 kHz. Above it the half size is capped,
+//so the rate grows to speed / FTDI_BITBANG_DMA_HALF_SIZE_MAX, about 3900 at 1 MHz
+#define FTDI_BITBANG_DMA_IRQ_RATE   (2000UL)
+#define FTDI_BITBANG_DMA_RING_SIZE  (FTDI_BITBANG_DMA_HALF_SIZE_MAX * 2)
+#define FTDI_BITBANG_DMA_TIM_CLOCK  (64000000UL)
+#define FTDI_BITBANG_DMA_PORT_COUNT (3UL)
+
+//Outputs: BSRR words at the start of a sample, TIM2 update, CC1 and CC2 requests
+#define FTDI_BITBANG_DMA_OUT_INSTANCE (DMA2)
+//Inputs: IDR captures in the middle of a sample, TIM2 CC3, CC4 and TIM17 CC1 requests
+#define FTDI_BITBANG_DMA_IN_INSTANCE  (DMA1)
+//Capture of port A reports the finished halves
+#define FTDI_BITBANG_DMA_IN_IRQ_CHANNEL (LL_DMA_CHANNEL_3)
+
+typedef struct {
+    GPIO_TypeDef* port;
+    uint32_t out_channel;
+    uint32_t out_request;
+    uint32_t in_channel;
+    uint32_t in_request;
+} FtdiBitbangDmaPort;
+
+//DMA2 channel 1 is used by the UART, channels 6 and 7 by the hardware SPI,
+//DMA1 channels 1 and 2 by the firmware signal drivers, 6 and 7 by the serial RX
+static const FtdiBitbangDmaPort ftdi_bitbang_dma_port[FTDI_BITBANG_DMA_PORT_COUNT] = {
+    {GPIOA,
+     LL_DMA_CHANNEL_2,
+     LL_DMAMUX_REQ_TIM2_UP,
+     FTDI_BITBANG_DMA_IN_IRQ_CHANNEL,
+     LL_DMAMUX_REQ_TIM2_CH3},
+    {GPIOB, LL_DMA_CHANNEL_3, LL_DMAMUX_REQ_TIM2_CH1, LL_DMA_CHANNEL_4, LL_DMAMUX_REQ_TIM2_CH4},
+    {GPIOC, LL_DMA_CHANNEL_4, LL_DMAMUX_REQ_TIM2_CH2, LL_DMA_CHANNEL_5, LL_DMAMUX_REQ_TIM17_CH1},
+};
+
+struct FtdiBitbangDma {
+    FtdiBitbangDmaCallback callback;
+    void* context;
+    bool is_running;
+
+    uint32_t* out[FTDI_BITBANG_DMA_PORT_COUNT]; // BSRR ring per port
+    uint16_t* in[FTDI_BITBANG_DMA_PORT_COUNT]; // IDR ring per port
+    size_t half_size;
+    size_t count[2]; // Host samples in each half
+    volatile uint32_t pending; // Finished halves not refilled yet, bit per half
+    volatile uint32_t overrun_count; // Halves that finished again before being refilled
+
+    //BSRR words of a byte are bsrr[0][low nibble] | bsrr[1][high nibble]
+    uint32_t bsrr[2][16][FTDI_BITBANG_DMA_PORT_COUNT];
+    uint8_t gpio_port[FTDI_GPIO_COUNT];
+    uint16_t gpio_pin[FTDI_GPIO_COUNT];
+};
+
+static void ftdi_bitbang_dma_half_done(FtdiBitbangDma* ftdi_bitbang_dma, size_t half) {
+    //The worker missed the previous round, the samples of that half were sent again
+    if(ftdi_bitbang_dma->pending & (1UL << half)) ftdi_bitbang_dma->overrun_count++;
+    ftdi_bitbang_dma->pending |= 1UL << half;
+    ftdi_bitbang_dma->callback(ftdi_bitbang_dma->context, half);
+}
+
+static void ftdi_bitbang_dma_isr(void* context) {
+    FtdiBitbangDma* ftdi_bitbang_dma = context;
+#if FTDI_BITBANG_DMA_IN_IRQ_CHANNEL == LL_DMA_CHANNEL_3
+    if(LL_DMA_IsActiveFlag_HT3(FTDI_BITBANG_DMA_IN_INSTANCE)) {
+        LL_DMA_ClearFlag_HT3(FTDI_BITBANG_DMA_IN_INSTANCE);
+        ftdi_bitbang_dma_half_done(ftdi_bitbang_dma, 0);
+    }
+    if(LL_DMA_IsActiveFlag_TC3(FTDI_BITBANG_DMA_IN_INSTANCE)) {
+        LL_DMA_ClearFlag_TC3(FTDI_BITBANG_DMA_IN_INSTANCE);
+        ftdi_bitbang_dma_half_done(ftdi_bitbang_dma, 1);
+    }
+#else
+#error Update this code. Would you kindly?
+#endif
+}
+
+FtdiBitbangDma* ftdi_bitbang_dma_alloc(FtdiBitbangDmaCallback callback, void* context) {
+    FtdiBitbangDma* ftdi_bitbang_dma = malloc(sizeof(FtdiBitbangDma));
+    ftdi_bitbang_dma->callback = callback;
+    ftdi_bitbang_dma->context = context;
+    ftdi_bitbang_dma->is_running = false;
+    ftdi_bitbang_dma->half_size = 1;
+    ftdi_bitbang_dma_set_gpio(ftdi_bitbang_dma, 0);
+
+    return ftdi_bitbang_dma;
+}
+
+void ftdi_bitbang_dma_free(FtdiBitbangDma* ftdi_bitbang_dma) {
+    if(!ftdi_bitbang_dma) return;
+    ftdi_bitbang_dma_stop(ftdi_bitbang_dma);
+    free(ftdi_bitbang_dma);
+    ftdi_bitbang_dma = NULL;
+}
+
+static uint8_t ftdi_bitbang_dma_get_port_index(const GPIO_TypeDef* port) {
+    for(uint8_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+        if(ftdi_bitbang_dma_port[p].port == port) return p;
+    }
+    furi_crash("Unknown port");
+}
+
+/** Precomputes the BSRR words of the output pins, inputs get no writes */
+void ftdi_bitbang_dma_set_gpio(FtdiBitbangDma* ftdi_bitbang_dma, uint8_t gpio_mask) {
+    memset(ftdi_bitbang_dma->bsrr, 0, sizeof(ftdi_bitbang_dma->bsrr));
+
+    for(size_t i = 0; i < FTDI_GPIO_COUNT; i++) {
+        uint8_t port = ftdi_bitbang_dma_get_port_index(ftdi_gpio_pins[i].port);
+        uint16_t pin = ftdi_gpio_pins[i].pin;
+        ftdi_bitbang_dma->gpio_port[i] = port;
+        ftdi_bitbang_dma->gpio_pin[i] = pin;
+        if(!(gpio_mask & (1 << i))) continue;
+
+        uint8_t nibble_bit = 1 << (i % 4);
+        for(size_t value = 0; value < 16; value++) {
+            if(value & nibble_bit) {
+                ftdi_bitbang_dma->bsrr[i / 4][value][port] |= pin;
+            } else {
+                ftdi_bitbang_dma->bsrr[i / 4][value][port] |= (uint32_t)pin << 16;
+            }
+        }
+    }
+}
+
+void ftdi_bitbang_dma_write(
+    FtdiBitbangDma* ftdi_bitbang_dma,
+    size_t half,
+    const uint8_t* data,
+    size_t size) {
+    size_t offset = half * ftdi_bitbang_dma->half_size;
+    size = MIN(size, ftdi_bitbang_dma->half_size);
+
+    for(size_t i = 0; i < size; i++) {
+        const uint32_t* low = ftdi_bitbang_dma->bsrr[0][data[i] & 0x0F];
+        const uint32_t* high = ftdi_bitbang_dma->bsrr[1][data[i] >> 4];
+        for(size_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+            ftdi_bitbang_dma->out[p][offset + i] = low[p] | high[p];
+        }
+    }
+    //An empty BSRR write leaves the pins as they are
+    for(size_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+        memset(
+            &ftdi_bitbang_dma->out[p][offset + size],
+            0,
+            (ftdi_bitbang_dma->half_size - size) * sizeof(uint32_t));
+    }
+    ftdi_bitbang_dma->count[half] = size;
+
+    FURI_CRITICAL_ENTER();
+    ftdi_bitbang_dma->pending &= ~(1UL << half);
+    FURI_CRITICAL_EXIT();
+}
+
+size_t ftdi_bitbang_dma_read(FtdiBitbangDma* ftdi_bitbang_dma, size_t half, uint8_t* data) {
+    size_t offset = half * ftdi_bitbang_dma->half_size;
+
+    for(size_t i = 0; i < ftdi_bitbang_dma->half_size; i++) {
+        uint8_t value = 0;
+        for(size_t j = 0; j < FTDI_GPIO_COUNT; j++) {
+            uint16_t idr = ftdi_bitbang_dma->in[ftdi_bitbang_dma->gpio_port[j]][offset + i];
+            if(idr & ftdi_bitbang_dma->gpio_pin[j]) value |= 1 << j;
+        }
+        data[i] = value;
+    }
+    return ftdi_bitbang_dma->count[half];
+}
+
+size_t ftdi_bitbang_dma_get_half_size(FtdiBitbangDma* ftdi_bitbang_dma) {
+    return ftdi_bitbang_dma->half_size;
+}
+
+bool ftdi_bitbang_dma_is_running(FtdiBitbangDma* ftdi_bitbang_dma) {
+    return ftdi_bitbang_dma->is_running;
+}
+
+/** The rings take about 9 KB, so they only exist while the engine runs */
+static void ftdi_bitbang_dma_ring_alloc(FtdiBitbangDma* ftdi_bitbang_dma) {
+    size_t samples = FTDI_BITBANG_DMA_PORT_COUNT * FTDI_BITBANG_DMA_RING_SIZE;
+    uint32_t* out = malloc(samples * sizeof(uint32_t));
+    uint16_t* in = malloc(samples * sizeof(uint16_t));
+    for(size_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+        ftdi_bitbang_dma->out[p] = &out[p * FTDI_BITBANG_DMA_RING_SIZE];
+        ftdi_bitbang_dma->in[p] = &in[p * FTDI_BITBANG_DMA_RING_SIZE];
+    }
+}
+
+static void ftdi_bitbang_dma_ring_free(FtdiBitbangDma* ftdi_bitbang_dma) {
+    free(ftdi_bitbang_dma->out[0]);
+    free(ftdi_bitbang_dma->in[0]);
+    for(size_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+        ftdi_bitbang_dma->out[p] = NULL;
+        ftdi_bitbang_dma->in[p] = NULL;
+    }
+}
+
+static void ftdi_bitbang_dma_channel_init(FtdiBitbangDma* ftdi_bitbang_dma, size_t p) {
+    const FtdiBitbangDmaPort* port = &ftdi_bitbang_dma_port[p];
+    uint32_t length = ftdi_bitbang_dma->half_size * 2;
+
+    LL_DMA_ConfigTransfer(
+        FTDI_BITBANG_DMA_OUT_INSTANCE,
+        port->out_channel,
+        LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MODE_CIRCULAR | LL_DMA_PERIPH_NOINCREMENT |
+            LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_WORD | LL_DMA_MDATAALIGN_WORD |
+            LL_DMA_PRIORITY_VERYHIGH);
+    LL_DMA_SetPeriphAddress(
+        FTDI_BITBANG_DMA_OUT_INSTANCE, port->out_channel, (uint32_t) & (port->port->BSRR));
+    LL_DMA_SetMemoryAddress(
+        FTDI_BITBANG_DMA_OUT_INSTANCE, port->out_channel, (uint32_t)ftdi_bitbang_dma->out[p]);
+    LL_DMA_SetDataLength(FTDI_BITBANG_DMA_OUT_INSTANCE, port->out_channel, length);
+    LL_DMA_SetPeriphRequest(FTDI_BITBANG_DMA_OUT_INSTANCE, port->out_channel, port->out_request);
+
+    LL_DMA_ConfigTransfer(
+        FTDI_BITBANG_DMA_IN_INSTANCE,
+        port->in_channel,
+        LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR | LL_DMA_PERIPH_NOINCREMENT |
+            LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD |
+            LL_DMA_PRIORITY_HIGH);
+    LL_DMA_SetPeriphAddress(
+        FTDI_BITBANG_DMA_IN_INSTANCE, port->in_channel, (uint32_t) & (port->port->IDR));
+    LL_DMA_SetMemoryAddress(
+        FTDI_BITBANG_DMA_IN_INSTANCE, port->in_channel, (uint32_t)ftdi_bitbang_dma->in[p]);
+    LL_DMA_SetDataLength(FTDI_BITBANG_DMA_IN_INSTANCE, port->in_channel, length);
+    LL_DMA_SetPeriphRequest(FTDI_BITBANG_DMA_IN_INSTANCE, port->in_channel, port->in_request);
+
+    LL_DMA_EnableChannel(FTDI_BITBANG_DMA_OUT_INSTANCE, port->out_channel);
+    LL_DMA_EnableChannel(FTDI_BITBANG_DMA_IN_INSTANCE, port->in_channel);
+}
+
+static void ftdi_bitbang_dma_tim_init(TIM_TypeDef* tim, uint32_t prescaler, uint32_t reload) {
+    LL_TIM_SetCounterMode(tim, LL_TIM_COUNTERMODE_UP);
+    LL_TIM_SetClockDivision(tim, LL_TIM_CLOCKDIVISION_DIV1);
+    LL_TIM_SetClockSource(tim, LL_TIM_CLOCKSOURCE_INTERNAL);
+    LL_TIM_SetPrescaler(tim, prescaler);
+    LL_TIM_SetAutoReload(tim, reload);
+    //Load the prescaler now, before any DMA request is enabled
+    LL_TIM_GenerateEvent_UPDATE(tim);
+    LL_TIM_ClearFlag_UPDATE(tim);
+}
+
+/**
+ * TIM2 and TIM17 run the same time base, started together. Every sample period
+ * TIM2 writes the three ports, then both capture them half a period later.
+ */
+void ftdi_bitbang_dma_start(FtdiBitbangDma* ftdi_bitbang_dma, uint32_t speed) {
+    ftdi_bitbang_dma_stop(ftdi_bitbang_dma);
+
+    speed = CLAMP(speed, FTDI_BITBANG_DMA_SPEED_MAX, 1UL);
+    uint32_t freq_div = FTDI_BITBANG_DMA_TIM_CLOCK / speed;
+    uint32_t prescaler = freq_div / 0x10000LU;
+    uint32_t period = freq_div / (prescaler + 1);
+
+    //Small halves at low speeds, so the host does not wait for a whole ring
+    ftdi_bitbang_dma->half_size =
+        CLAMP(speed / FTDI_BITBANG_DMA_IRQ_RATE, FTDI_BITBANG_DMA_HALF_SIZE_MAX, 1UL);
+    ftdi_bitbang_dma->pending = 0;
+    ftdi_bitbang_dma->overrun_count = 0;
+    ftdi_bitbang_dma_ring_alloc(ftdi_bitbang_dma);
+    ftdi_bitbang_dma_write(ftdi_bitbang_dma, 0, NULL, 0);
+    ftdi_bitbang_dma_write(ftdi_bitbang_dma, 1, NULL, 0);
+
+    for(size_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+        ftdi_bitbang_dma_channel_init(ftdi_bitbang_dma, p);
+    }
+    LL_DMA_ClearFlag_GI3(FTDI_BITBANG_DMA_IN_INSTANCE);
+    furi_hal_interrupt_set_isr(FuriHalInterruptIdDma1Ch3, ftdi_bitbang_dma_isr, ftdi_bitbang_dma);
+    LL_DMA_EnableIT_HT(FTDI_BITBANG_DMA_IN_INSTANCE, FTDI_BITBANG_DMA_IN_IRQ_CHANNEL);
+    LL_DMA_EnableIT_TC(FTDI_BITBANG_DMA_IN_INSTANCE, FTDI_BITBANG_DMA_IN_IRQ_CHANNEL);
+
+    furi_hal_bus_enable(FuriHalBusTIM2);
+    furi_hal_bus_enable(FuriHalBusTIM17);
+    ftdi_bitbang_dma_tim_init(TIM2, prescaler, period - 1);
+    ftdi_bitbang_dma_tim_init(TIM17, prescaler, period - 1);
+
+    LL_TIM_OC_SetCompareCH1(TIM2, 0);
+    LL_TIM_OC_SetCompareCH2(TIM2, 0);
+    LL_TIM_OC_SetCompareCH3(TIM2, period / 2);
+    LL_TIM_OC_SetCompareCH4(TIM2, period / 2);
+    LL_TIM_OC_SetCompareCH1(TIM17, period / 2);
+
+    LL_TIM_EnableDMAReq_UPDATE(TIM2);
+    LL_TIM_EnableDMAReq_CC1(TIM2);
+    LL_TIM_EnableDMAReq_CC2(TIM2);
+    LL_TIM_EnableDMAReq_CC3(TIM2);
+    LL_TIM_EnableDMAReq_CC4(TIM2);
+    LL_TIM_EnableDMAReq_CC1(TIM17);
+
+    FURI_CRITICAL_ENTER();
+    LL_TIM_EnableCounter(TIM17);
+    LL_TIM_EnableCounter(TIM2);
+    FURI_CRITICAL_EXIT();
+
+    ftdi_bitbang_dma->is_running = true;
+}
+
+void ftdi_bitbang_dma_stop(FtdiBitbangDma* ftdi_bitbang_dma) {
+    if(!ftdi_bitbang_dma->is_running) return;
+    ftdi_bitbang_dma->is_running = false;
+
+    LL_TIM_DisableCounter(TIM2);
+    LL_TIM_DisableCounter(TIM17);
+    //Resets the timers with their DMA requests
+    furi_hal_bus_disable(FuriHalBusTIM2);
+    furi_hal_bus_disable(FuriHalBusTIM17);
+
+    LL_DMA_DisableIT_HT(FTDI_BITBANG_DMA_IN_INSTANCE, FTDI_BITBANG_DMA_IN_IRQ_CHANNEL);
+    LL_DMA_DisableIT_TC(FTDI_BITBANG_DMA_IN_INSTANCE, FTDI_BITBANG_DMA_IN_IRQ_CHANNEL);
+    for(size_t p = 0; p < FTDI_BITBANG_DMA_PORT_COUNT; p++) {
+        LL_DMA_DisableChannel(FTDI_BITBANG_DMA_OUT_INSTANCE, ftdi_bitbang_dma_port[p].out_channel);
+        LL_DMA_DisableChannel(FTDI_BITBANG_DMA_IN_INSTANCE, ftdi_bitbang_dma_port[p].in_channel);
+    }
+    LL_DMA_ClearFlag_GI3(FTDI_BITBANG_DMA_IN_INSTANCE);
+    furi_hal_interrupt_set_isr(FuriHalInterruptIdDma1Ch3, NULL, NULL);
+
+    ftdi_bitbang_dma_ring_free(ftdi_bitbang_dma);
+    if(ftdi_bitbang_dma->overrun_count) {
+        FURI_LOG_W(TAG, "Half buffers overrun: %lu", ftdi_bitbang_dma->overrun_count);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <furi.h>
+
+#define FTDI_BITBANG_DMA_HALF_SIZE_MAX (256UL)
+#define FTDI_BITBANG_DMA_SPEED_MAX     (1000000UL)
+
+typedef struct FtdiBitbangDma FtdiBitbangDma;
+
+/**
+ * Called from the DMA interrupt when a half of the sample ring is done, half is 0 or 1.
+ * A half that finishes again before ftdi_bitbang_dma_write() refilled it counts as an overrun,
+ * the count is logged when the engine stops.
+ */
+typedef void (*FtdiBitbangDmaCallback)(void* context, size_t half);
+
+FtdiBitbangDma* ftdi_bitbang_dma_alloc(FtdiBitbangDmaCallback callback, void* context);
+void ftdi_bitbang_dma_free(FtdiBitbangDma* ftdi_bitbang_dma);
+void ftdi_bitbang_dma_set_gpio(FtdiBitbangDma* ftdi_bitbang_dma, uint8_t gpio_mask);
+void ftdi_bitbang_dma_start(FtdiBitbangDma* ftdi_bitbang_dma, uint32_t speed);
+void ftdi_bitbang_dma_stop(FtdiBitbangDma* ftdi_bitbang_dma);
+size_t ftdi_bitbang_dma_get_half_size(FtdiBitbangDma* ftdi_bitbang_dma);
+bool ftdi_bitbang_dma_is_running(FtdiBitbangDma* ftdi_bitbang_dma);
+
+/**
+ * Converts the pin states captured in a finished half, data must hold half size bytes.
+ * Returns how many of these samples were written by the host, the rest held the outputs.
+ */
+size_t ftdi_bitbang_dma_read(FtdiBitbangDma* ftdi_bitbang_dma, size_t half, uint8_t* data);
+
+/** Fills a finished half with the next samples, outputs are held after the last one */
+void ftdi_bitbang_dma_write(
+    FtdiBitbangDma* ftdi_bitbang_dma,
+    size_t half,
+    const uint8_t* data,
+    size_t size);
@@ -1,4 +1,4 @@
-#include "ftdi_latency_timer.h"
+#include "ftdi_gpio.h"
 #include "furi.h"
 #include <furi_hal.h>
 
@@ -6,86 +6,99 @@
 
 #define TAG "FTDI_GPIO"
 
-#define gpio_b0 (gpio_ext_pa7)
-#define gpio_b1 (gpio_ext_pa6)
-#define gpio_b2 (gpio_ext_pa4)
-#define gpio_b3 (gpio_ext_pb3)
-#define gpio_b4 (gpio_ext_pb2)
-#define gpio_b5 (gpio_ext_pc3)
-#define gpio_b6 (gpio_ext_pc1)
-#define gpio_b7 (gpio_ext_pc0)
+#define gpio_ext_pa7_pin {.port = GPIOA, .pin = LL_GPIO_PIN_7}
+#define gpio_ext_pa6_pin {.port = GPIOA, .pin = LL_GPIO_PIN_6}
+#define gpio_ext_pa4_pin {.port = GPIOA, .pin = LL_GPIO_PIN_4}
+#define gpio_ext_pb3_pin {.port = GPIOB, .pin = LL_GPIO_PIN_3}
+#define gpio_ext_pb2_pin {.port = GPIOB, .pin = LL_GPIO_PIN_2}
+#define gpio_ext_pc3_pin {.port = GPIOC, .pin = LL_GPIO_PIN_3}
+#define gpio_ext_pc1_pin {.port = GPIOC, .pin = LL_GPIO_PIN_1}
+#define gpio_ext_pc0_pin {.port = GPIOC, .pin = LL_GPIO_PIN_0}
+
+static const GpioPin ftdi_gpio_pinout[FtdiGpioPinoutCount][FTDI_GPIO_COUNT] = {
+    [FtdiGpioPinoutFtdi] =
+        {
+            gpio_ext_pa7_pin, // TCK/SCK
+            gpio_ext_pa6_pin, // TDI/MOSI
+            gpio_ext_pa4_pin, // TDO/MISO
+            gpio_ext_pb3_pin, // TMS/CS
+            gpio_ext_pb2_pin,
+            gpio_ext_pc3_pin,
+            gpio_ext_pc1_pin,
+            gpio_ext_pc0_pin,
+        },
+    [FtdiGpioPinoutSpi] =
+        {
+            gpio_ext_pb3_pin, // SPI1 SCK
+            gpio_ext_pa7_pin, // SPI1 MOSI
+            gpio_ext_pa6_pin, // SPI1 MISO
+            gpio_ext_pa4_pin, // CS
+            gpio_ext_pb2_pin,
+            gpio_ext_pc3_pin,
+            gpio_ext_pc1_pin,
+            gpio_ext_pc0_pin,
+        },
+};
+
+GpioPin ftdi_gpio_pins[FTDI_GPIO_COUNT] = {
+    gpio_ext_pa7_pin,
+    gpio_ext_pa6_pin,
+    gpio_ext_pa4_pin,
+    gpio_ext_pb3_pin,
+    gpio_ext_pb2_pin,
+    gpio_ext_pc3_pin,
+    gpio_ext_pc1_pin,
+    gpio_ext_pc0_pin,
+};
+
+static FtdiGpioPinout ftdi_gpio_pinout_request = FtdiGpioPinoutFtdi;
+static FtdiGpioPinout ftdi_gpio_pinout_active = FtdiGpioPinoutFtdi;
 
 void ftdi_gpio_set_direction(uint8_t gpio_mask) {
-    // gpio_ext_pa7
-    if(gpio_mask & 0b00000001) {
-        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_7, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_7, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pa6
-    if(gpio_mask & 0b00000010) {
-        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_6, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_6, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pa4
-    if(gpio_mask & 0b00000100) {
-        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_4, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_4, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pb3
-    if(gpio_mask & 0b00001000) {
-        LL_GPIO_SetPinMode(GPIOB, LL_GPIO_PIN_3, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOB, LL_GPIO_PIN_3, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pb2
-    if(gpio_mask & 0b00010000) {
-        LL_GPIO_SetPinMode(GPIOB, LL_GPIO_PIN_2, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOB, LL_GPIO_PIN_2, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pc3
-    if(gpio_mask & 0b00100000) {
-        LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_3, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_3, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pc1
-    if(gpio_mask & 0b01000000) {
-        LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_1, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_1, LL_GPIO_MODE_INPUT);
-    }
-    // gpio_ext_pc0
-    if(gpio_mask & 0b10000000) {
-        LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_0, LL_GPIO_MODE_OUTPUT);
-    } else {
-        LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_0, LL_GPIO_MODE_INPUT);
+    for(size_t i = 0; i < FTDI_GPIO_COUNT; i++) {
+        if(gpio_mask & (1 << i)) {
+            LL_GPIO_SetPinMode(
+                ftdi_gpio_pins[i].port, ftdi_gpio_pins[i].pin, LL_GPIO_MODE_OUTPUT);
+        } else {
+            LL_GPIO_SetPinMode(ftdi_gpio_pins[i].port, ftdi_gpio_pins[i].pin, LL_GPIO_MODE_INPUT);
+        }
     }
 }
 
 void ftdi_gpio_init(uint8_t gpio_mask) {
-    furi_hal_gpio_init(&gpio_b0, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b1, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b2, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b3, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b4, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b5, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b6, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
-    furi_hal_gpio_init(&gpio_b7, GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
+    for(size_t i = 0; i < FTDI_GPIO_COUNT; i++) {
+        furi_hal_gpio_init(&ftdi_gpio_pins[i], GpioModeInput, GpioPullDown, GpioSpeedVeryHigh);
+    }
 
     ftdi_gpio_set_direction(gpio_mask);
 }
 
 void ftdi_gpio_deinit() {
-    furi_hal_gpio_init(&gpio_b0, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b1, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b2, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b3, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b4, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b5, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b6, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
-    furi_hal_gpio_init(&gpio_b7, GpioModeAnalog, GpioPullNo, GpioSpeedLow);
+    for(size_t i = 0; i < FTDI_GPIO_COUNT; i++) {
+        furi_hal_gpio_init(&ftdi_gpio_pins[i], GpioModeAnalog, GpioPullNo, GpioSpeedLow);
+    }
+}
+
+void ftdi_gpio_set_pinout(FtdiGpioPinout pinout) {
+    furi_check(pinout < FtdiGpioPinoutCount);
+    ftdi_gpio_pinout_request = pinout;
+}
+
+FtdiGpioPinout ftdi_gpio_get_pinout(void) {
+    return ftdi_gpio_pinout_request;
+}
+
+/**
+ * Switches to the requested pinout. Both pinouts use the same pins,
+ * so the following ftdi_gpio_set_direction() reconfigures all of them.
+ */
+void ftdi_gpio_update_pinout(void) {
+    if(ftdi_gpio_pinout_active == ftdi_gpio_pinout_request) return;
+    ftdi_gpio_pinout_active = ftdi_gpio_pinout_request;
+    memcpy(
+        ftdi_gpio_pins, ftdi_gpio_pinout[ftdi_gpio_pinout_active], sizeof(ftdi_gpio_pins));
+}
+
+FtdiGpioPinout ftdi_gpio_get_active_pinout(void) {
+    return ftdi_gpio_pinout_active;
 }
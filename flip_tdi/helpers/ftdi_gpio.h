@@ -1,106 +1,108 @@
 #pragma once
 #include "ftdi.h"
+#include <furi_hal.h>
+
+#define FTDI_GPIO_COUNT 8
+
+typedef enum {
+    FtdiGpioPinoutFtdi, /**< FT232H order, TCK/SCK on pin 2 (PA7) */
+    FtdiGpioPinoutSpi, /**< SCK/MOSI/MISO on the SPI1 pins, needed for hardware SPI */
+    FtdiGpioPinoutCount,
+} FtdiGpioPinout;
+
+//Pins of ADBUS0..ADBUS7 in the active pinout
+extern GpioPin ftdi_gpio_pins[FTDI_GPIO_COUNT];
 
 void ftdi_gpio_set_direction(uint8_t gpio_mask);
 void ftdi_gpio_init(uint8_t gpio_mask);
 void ftdi_gpio_deinit();
+void ftdi_gpio_set_pinout(FtdiGpioPinout pinout);
+FtdiGpioPinout ftdi_gpio_get_pinout(void);
+void ftdi_gpio_update_pinout(void);
+FtdiGpioPinout ftdi_gpio_get_active_pinout(void);
+
+#ifdef FTDI_GPIO_HOST
+//Host builds of the MPSSE engine model the pins in software, see tests/
+void ftdi_gpio_write(const GpioPin* gpio, uint8_t state);
+bool ftdi_gpio_read(const GpioPin* gpio);
+#else
+static inline void ftdi_gpio_write(const GpioPin* gpio, uint8_t state) {
+    if(state) {
+        gpio->port->BSRR = gpio->pin;
+    } else {
+        gpio->port->BRR = gpio->pin;
+    }
+}
+
+static inline bool ftdi_gpio_read(const GpioPin* gpio) {
+    return gpio->port->IDR & gpio->pin;
+}
+#endif
 
-static inline uint8_t ftdi_gpio_get_b0(void) { // gpio_ext_pa7
-    return (GPIOA->IDR & LL_GPIO_PIN_7) ? 0b00000001 : 0;
+static inline uint8_t ftdi_gpio_get_b0(void) { // gpio_ext_pa7, pb3 in the SPI pinout
+    return ftdi_gpio_read(&ftdi_gpio_pins[0]) ? 0b00000001 : 0;
 }
 
-static inline uint8_t ftdi_gpio_get_b1(void) { // gpio_ext_pa6
-    return (GPIOA->IDR & LL_GPIO_PIN_6) ? 0b00000010 : 0;
+static inline uint8_t ftdi_gpio_get_b1(void) { // gpio_ext_pa6, pa7 in the SPI pinout
+    return ftdi_gpio_read(&ftdi_gpio_pins[1]) ? 0b00000010 : 0;
 }
 
-static inline uint8_t ftdi_gpio_get_b2(void) { // gpio_ext_pa4
-    return (GPIOA->IDR & LL_GPIO_PIN_4) ? 0b00000100 : 0;
+static inline uint8_t ftdi_gpio_get_b2(void) { // gpio_ext_pa4, pa6 in the SPI pinout
+    return ftdi_gpio_read(&ftdi_gpio_pins[2]) ? 0b00000100 : 0;
 }
 
-static inline uint8_t ftdi_gpio_get_b3(void) { // gpio_ext_pb3
-    return (GPIOB->IDR & LL_GPIO_PIN_3) ? 0b00001000 : 0;
+static inline uint8_t ftdi_gpio_get_b3(void) { // gpio_ext_pb3, pa4 in the SPI pinout
+    return ftdi_gpio_read(&ftdi_gpio_pins[3]) ? 0b00001000 : 0;
 }
 
 static inline uint8_t ftdi_gpio_get_b4(void) { // gpio_ext_pb2
-    return (GPIOB->IDR & LL_GPIO_PIN_2) ? 0b00010000 : 0;
+    return ftdi_gpio_read(&ftdi_gpio_pins[4]) ? 0b00010000 : 0;
 }
 
 static inline uint8_t ftdi_gpio_get_b5(void) { // gpio_ext_pc3
-    return (GPIOC->IDR & LL_GPIO_PIN_3) ? 0b00100000 : 0;
+    return ftdi_gpio_read(&ftdi_gpio_pins[5]) ? 0b00100000 : 0;
 }
 
 static inline uint8_t ftdi_gpio_get_b6(void) { // gpio_ext_pc1
-    return (GPIOC->IDR & LL_GPIO_PIN_1) ? 0b01000000 : 0;
+    return ftdi_gpio_read(&ftdi_gpio_pins[6]) ? 0b01000000 : 0;
 }
 
 static inline uint8_t ftdi_gpio_get_b7(void) { // gpio_ext_pc0
-    return (GPIOC->IDR & LL_GPIO_PIN_0) ? 0b10000000 : 0;
+    return ftdi_gpio_read(&ftdi_gpio_pins[7]) ? 0b10000000 : 0;
 }
 
-static inline void ftdi_gpio_set_noop(uint8_t state) { // gpio_ext_pa7
+static inline void ftdi_gpio_set_noop(uint8_t state) {
     UNUSED(state);
 }
 
-static inline void ftdi_gpio_set_b0(uint8_t state) { // gpio_ext_pa7
-    if(state) {
-        GPIOA->BSRR = LL_GPIO_PIN_7;
-    } else {
-        GPIOA->BRR = LL_GPIO_PIN_7;
-    }
+static inline void ftdi_gpio_set_b0(uint8_t state) { // gpio_ext_pa7, pb3 in the SPI pinout
+    ftdi_gpio_write(&ftdi_gpio_pins[0], state);
 }
 
-static inline void ftdi_gpio_set_b1(uint8_t state) { // gpio_ext_pa6
-    if(state) {
-        GPIOA->BSRR = LL_GPIO_PIN_6;
-    } else {
-        GPIOA->BRR = LL_GPIO_PIN_6;
-    }
+static inline void ftdi_gpio_set_b1(uint8_t state) { // gpio_ext_pa6, pa7 in the SPI pinout
+    ftdi_gpio_write(&ftdi_gpio_pins[1], state);
 }
 
-static inline void ftdi_gpio_set_b2(uint8_t state) { // gpio_ext_pa4
-    if(state) {
-        GPIOA->BSRR = LL_GPIO_PIN_4;
-    } else {
-        GPIOA->BRR = LL_GPIO_PIN_4;
-    }
+static inline void ftdi_gpio_set_b2(uint8_t state) { // gpio_ext_pa4, pa6 in the SPI pinout
+    ftdi_gpio_write(&ftdi_gpio_pins[2], state);
 }
 
-static inline void ftdi_gpio_set_b3(uint8_t state) { // gpio_ext_pb3
-    if(state) {
-        GPIOB->BSRR = LL_GPIO_PIN_3;
-    } else {
-        GPIOB->BRR = LL_GPIO_PIN_3;
-    }
+static inline void ftdi_gpio_set_b3(uint8_t state) { // gpio_ext_pb3, pa4 in the SPI pinout
+    ftdi_gpio_write(&ftdi_gpio_pins[3], state);
 }
 
 static inline void ftdi_gpio_set_b4(uint8_t state) { // gpio_ext_pb2
-    if(state) {
-        GPIOB->BSRR = LL_GPIO_PIN_2;
-    } else {
-        GPIOB->BRR = LL_GPIO_PIN_2;
-    }
+    ftdi_gpio_write(&ftdi_gpio_pins[4], state);
 }
 
 static inline void ftdi_gpio_set_b5(uint8_t state) { // gpio_ext_pc3
-    if(state) {
-        GPIOC->BSRR = LL_GPIO_PIN_3;
-    } else {
-        GPIOC->BRR = LL_GPIO_PIN_3;
-    }
+    ftdi_gpio_write(&ftdi_gpio_pins[5], state);
 }
 
 static inline void ftdi_gpio_set_b6(uint8_t state) { // gpio_ext_pc1
-    if(state) {
-        GPIOC->BSRR = LL_GPIO_PIN_1;
-    } else {
-        GPIOC->BRR = LL_GPIO_PIN_1;
-    }
+    ftdi_gpio_write(&ftdi_gpio_pins[6], state);
 }
 
 static inline void ftdi_gpio_set_b7(uint8_t state) { // gpio_ext_pc0
-    if(state) {
-        GPIOC->BSRR = LL_GPIO_PIN_0;
-    } else {
-        GPIOC->BRR = LL_GPIO_PIN_0;
-    }
+    ftdi_gpio_write(&ftdi_gpio_pins[7], state);
 }
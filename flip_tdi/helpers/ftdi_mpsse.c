@@ -1,42 +1,59 @@
+#pragma GCC optimize("O3")
+#pragma GCC optimize("-funroll-all-loops")
+
 #include "ftdi_mpsse.h"
 #include "furi.h"
 #include <furi_hal.h>
 #include "ftdi_gpio.h"
 #include "ftdi_latency_timer.h"
 #include "ftdi_mpsse_data.h"
+#include "ftdi_spi.h"
 
 #define TAG "FTDI_MPSSE"
 
 typedef void (*FtdiMpsseGpioO)(uint8_t state);
 
-#define FTDI_MPSSE_TIMEOUT 5000
-#define FTDI_MPSSE_TX_RX_SIZE (4096UL)
+#define FTDI_MPSSE_RESPONSE_SIZE_MAX  (2UL)
+#define FTDI_MPSSE_COMMAND_SIZE_SHIFT (3UL)
+#define FTDI_MPSSE_COMMAND_SIZE_MAX   (4UL)
+#define FTDI_MPSSE_CLOCK_BASE         (60000000UL)
+#define FTDI_MPSSE_CLOCK_BASE_DIV5    (12000000UL)
+#define FTDI_MPSSE_CLOCK_WAIT_SLICE   (1000UL) // 1ms of TCK per pass of clock until GPIOL1
 
 typedef enum {
-    FtdiMpsseErrorNone = 0,
-    FtdiMpsseErrorTimeout,
-    FtdiMpsseErrorTxOverflow,
-} FtdiMpsseError;
+    FtdiMpsseStatusDone = 0, /**< All complete commands are executed */
+    FtdiMpsseStatusTxFull, /**< Output is stalled until the host reads the TX buffer */
+    FtdiMpsseStatusWait, /**< Waiting for GPIOL1, the command is retried on the next pass */
+} FtdiMpsseStatus;
 
 struct FtdiMpsse {
     Ftdi* ftdi;
     uint8_t gpio_state;
     uint8_t gpio_mask;
-    uint16_t data_size;
     bool is_loopback;
     bool is_div5;
     bool is_clk3phase;
     bool is_adaptive;
-    FtdiMpsseError error;
+    uint16_t clock_divisor;
+    uint32_t clock; // TCK frequency in Hz
+    uint32_t half_period; // CPU cycles per TCK half period
+
+    FtdiSpi* ftdi_spi;
 
     FtdiMpsseGpioO gpio_o[8];
     uint8_t gpio_mask_old;
 
     FtdiMpsseCallbackImmediate callback_immediate;
     void* context_immediate;
+    bool is_immediate;
+
+    //Command gathered from the USB OUT packets, it may span two of them
+    uint8_t command[FTDI_MPSSE_COMMAND_SIZE_MAX];
+    size_t command_len;
 
-    uint8_t* data_buf;
-    uint16_t data_buf_count_byte;
+    //Shifting command whose data phase is in progress
+    uint8_t data_command;
+    uint32_t data_remaining;
 };
 
 void ftdi_mpsse_gpio_set_callback(
@@ -127,95 +144,287 @@ static inline uint8_t ftdi_mpsse_gpio_get(void) {
     return gpio_data;
 }
 
+/** TCK = base / ((1 + divisor) * 2), base is 60MHz or 12MHz with divide by 5 */
+static void ftdi_mpsse_update_clock(FtdiMpsse* ftdi_mpsse) {
+    uint32_t base = ftdi_mpsse->is_div5 ? FTDI_MPSSE_CLOCK_BASE_DIV5 : FTDI_MPSSE_CLOCK_BASE;
+    ftdi_mpsse->clock = base / ((ftdi_mpsse->clock_divisor + 1UL) * 2);
+    ftdi_mpsse->half_period = furi_hal_cortex_instructions_per_microsecond() * 1000000UL /
+                              (ftdi_mpsse->clock * 2);
+}
+
+static inline FtdiMpsseDataShift ftdi_mpsse_data_config(FtdiMpsse* ftdi_mpsse, uint8_t command) {
+    FtdiMpsseDataShift shift = ftdi_mpsse_data_shift_config(command, ftdi_mpsse->gpio_state);
+    shift.loopback = ftdi_mpsse->is_loopback;
+    shift.adaptive = ftdi_mpsse->is_adaptive;
+    shift.half_period = ftdi_mpsse->half_period;
+    return shift;
+}
+
 FtdiMpsse* ftdi_mpsse_alloc(Ftdi* ftdi) {
     FtdiMpsse* ftdi_mpsse = malloc(sizeof(FtdiMpsse));
     ftdi_mpsse->ftdi = ftdi;
     ftdi_mpsse->gpio_state = 0;
     ftdi_mpsse->gpio_mask = 0;
-    ftdi_mpsse->data_size = 0;
     ftdi_mpsse->is_loopback = false;
-    ftdi_mpsse->is_div5 = false;
+    //FT232H starts with the 12MHz clock of the older chips
+    ftdi_mpsse->is_div5 = true;
     ftdi_mpsse->is_clk3phase = false;
     ftdi_mpsse->is_adaptive = false;
+    ftdi_mpsse->clock_divisor = 0;
+    ftdi_mpsse_update_clock(ftdi_mpsse);
+    ftdi_mpsse->callback_immediate = NULL;
+    ftdi_mpsse->context_immediate = NULL;
 
-    ftdi_mpsse->error = FtdiMpsseErrorNone;
-    ftdi_mpsse->data_buf = malloc(FTDI_MPSSE_TX_RX_SIZE * sizeof(uint8_t));
-    ftdi_mpsse->data_buf_count_byte = 0;
+    ftdi_mpsse_reset(ftdi_mpsse);
 
     ftdi_mpsse_gpio_init(ftdi_mpsse);
+    ftdi_mpsse->ftdi_spi = ftdi_spi_alloc();
 
     return ftdi_mpsse;
 }
 
 void ftdi_mpsse_free(FtdiMpsse* ftdi_mpsse) {
     if(!ftdi_mpsse) return;
-    free(ftdi_mpsse->data_buf);
+    ftdi_spi_free(ftdi_mpsse->ftdi_spi);
     ftdi_gpio_deinit();
     free(ftdi_mpsse);
     ftdi_mpsse = NULL;
 }
 
-uint8_t ftdi_mpsse_get_data_stream(FtdiMpsse* ftdi_mpsse) {
-    uint8_t data = 0;
-    if(ftdi_get_rx_buf(ftdi_mpsse->ftdi, &data, 1, FTDI_MPSSE_TIMEOUT) != 1) {
-        FURI_LOG_E(TAG, "Timeout");
-        ftdi_mpsse->error = FtdiMpsseErrorTimeout;
+void ftdi_mpsse_reset(FtdiMpsse* ftdi_mpsse) {
+    ftdi_mpsse->command_len = 0;
+    ftdi_mpsse->data_command = 0;
+    ftdi_mpsse->data_remaining = 0;
+    ftdi_mpsse->is_immediate = false;
+}
+
+static inline void ftdi_mpsse_immediate(FtdiMpsse* ftdi_mpsse) {
+    if(ftdi_mpsse->callback_immediate) {
+        ftdi_mpsse->callback_immediate(ftdi_mpsse->context_immediate);
     }
-#ifdef FTDI_DEBUG
-    FURI_LOG_RAW_I("0x%02X ", data);
-#endif
-    return data;
 }
 
-void ftdi_mpssse_set_data_stream(FtdiMpsse* ftdi_mpsse, uint8_t* data, uint16_t size) {
-    ftdi_set_tx_buf(ftdi_mpsse->ftdi, data, size);
+/**
+ * Size of the command with its parameters, 0 for an unknown opcode.
+ * The data phase of byte shifts is streamed separately and not included.
+ */
+static size_t ftdi_mpsse_get_command_size(uint8_t command) {
+    if(!(command & 0x80)) {
+        if(command & FtdiMpsseShiftWriteTms) {
+            //TMS shifts are bit mode only and share the data byte with TDI
+            if(!(command & FtdiMpsseShiftBitmode) || (command & FtdiMpsseShiftDoWrite)) {
+                return 0;
+            }
+            return 3;
+        }
+        if(!(command & (FtdiMpsseShiftDoWrite | FtdiMpsseShiftDoRead))) {
+            return 0;
+        }
+        if((command & FtdiMpsseShiftBitmode) && !(command & FtdiMpsseShiftDoWrite)) {
+            return 2;
+        }
+        return FTDI_MPSSE_COMMAND_SIZE_SHIFT;
+    }
+
+    switch(command) {
+    case FtdiMpsseCommandsGetBitsLow:
+    case FtdiMpsseCommandsGetBitsHigh:
+    case FtdiMpsseCommandsLoopbackStart:
+    case FtdiMpsseCommandsLoopbackEnd:
+    case FtdiMpsseCommandsSendImmediate:
+    case FtdiMpsseCommandsWaitOnHigh:
+    case FtdiMpsseCommandsWaitOnLow:
+    case FtdiMpsseCommandsDisDiv5:
+    case FtdiMpsseCommandsEnDiv5:
+    case FtdiMpsseCommandsEnableClk3Phase:
+    case FtdiMpsseCommandsDisableClk3Phase:
+    case FtdiMpsseCommandsClkWaitOnHigh:
+    case FtdiMpsseCommandsClkWaitOnLow:
+    case FtdiMpsseCommandsEnableClkAdaptive:
+    case FtdiMpsseCommandsDisableClkAdaptive:
+        return 1;
+    case FtdiMpsseCommandsClkBitsNoData:
+    case FtdiMpsseCommandsReadShort:
+        return 2;
+    case FtdiMpsseCommandsSetBitsLow:
+    case FtdiMpsseCommandsSetBitsHigh:
+    case FtdiMpsseCommandsSetTckDivisor:
+    case FtdiMpsseCommandsClkBytesNoData:
+    case FtdiMpsseCommandsClkCountWaitOnHigh:
+    case FtdiMpsseCommandsClkCountWaitOnLow:
+    case FtdiMpsseCommandsDriveZero:
+    case FtdiMpsseCommandsReadExtended:
+    case FtdiMpsseCommandsWriteShort:
+        return 3;
+    case FtdiMpsseCommandsWriteExtended:
+        return 4;
+    default:
+        return 0;
+    }
 }
 
-static inline void ftdi_mpsse_skeep_data(FtdiMpsse* ftdi_mpsse) {
-    ftdi_mpsse->data_size++;
-    while(ftdi_mpsse->data_size--) {
-        if(ftdi_mpsse->error != FtdiMpsseErrorNone) return;
-        ftdi_mpsse_get_data_stream(ftdi_mpsse);
+/** Bit and TMS shifts carry their data in the command and are executed at once */
+static void ftdi_mpsse_shift_bits(FtdiMpsse* ftdi_mpsse, const uint8_t* command) {
+    FtdiMpsseDataShift shift = ftdi_mpsse_data_config(ftdi_mpsse, command[0]);
+    uint8_t bits = (command[1] & 0x07) + 1;
+    uint8_t result = 0;
+
+    if(command[0] & FtdiMpsseShiftWriteTms) {
+        result = ftdi_mpsse_data_shift_tms(&shift, command[2], bits);
+    } else if(command[0] & FtdiMpsseShiftDoWrite) {
+        result = ftdi_mpsse_data_shift_bits(&shift, command[2], bits);
+    } else {
+        //Read-only shifts hold MOSI
+        uint8_t hold = ftdi_gpio_read(&shift.mosi) ? 0xFF : 0x00;
+        result = ftdi_mpsse_data_shift_bits(&shift, hold, bits);
+    }
+
+    if(command[0] & FtdiMpsseShiftDoRead) {
+        ftdi_set_tx_buf(ftdi_mpsse->ftdi, &result, 1);
     }
 }
 
-void ftdi_mpsse_get_data(FtdiMpsse* ftdi_mpsse) {
-    //todo add support for tx buffer, data_size_max = 0xFF00
-    ftdi_mpsse->data_size++;
-    if(ftdi_mpsse->data_size > FTDI_MPSSE_TX_RX_SIZE) {
-        ftdi_mpsse->error = FtdiMpsseErrorTxOverflow;
-        FURI_LOG_E(TAG, "Tx buffer overflow");
-        ftdi_mpsse_skeep_data(ftdi_mpsse);
-        ftdi_mpsse->data_size = 0;
+static void ftdi_mpsse_shift(FtdiMpsse* ftdi_mpsse, const uint8_t* command) {
+    if(command[0] & (FtdiMpsseShiftBitmode | FtdiMpsseShiftWriteTms)) {
+        ftdi_mpsse_shift_bits(ftdi_mpsse, command);
+        return;
     }
+    ftdi_mpsse->data_command = command[0];
+    ftdi_mpsse->data_remaining = (command[1] | (uint32_t)command[2] << 8) + 1;
+}
 
-    if(ftdi_get_rx_buf(
-           ftdi_mpsse->ftdi, ftdi_mpsse->data_buf, ftdi_mpsse->data_size, FTDI_MPSSE_TIMEOUT) !=
-       ftdi_mpsse->data_size) {
-        FURI_LOG_E(TAG, "Timeout");
-        ftdi_mpsse->error = FtdiMpsseErrorTimeout;
+/**
+ * Configures SPI1 for the data phase if its edges and clock fit the peripheral:
+ * data must change on one edge and be sampled on the other one.
+ */
+static bool ftdi_mpsse_shift_spi_config(FtdiMpsse* ftdi_mpsse, const FtdiMpsseDataShift* shift) {
+    if(ftdi_gpio_get_active_pinout() != FtdiGpioPinoutSpi) return false;
+    if(ftdi_mpsse->is_loopback || ftdi_mpsse->is_adaptive) return false;
+
+    uint8_t command = ftdi_mpsse->data_command;
+    bool is_write = command & FtdiMpsseShiftDoWrite;
+    bool is_read = command & FtdiMpsseShiftDoRead;
+    if(is_write && is_read && (shift->write_edge1 == shift->read_edge1)) return false;
+
+    //CPHA 1: output on the first edge, sample on the second one
+    bool cpha = is_read ? !shift->read_edge1 : shift->write_edge1;
+    return ftdi_spi_set_config(
+        ftdi_mpsse->ftdi_spi, ftdi_mpsse->clock, shift->clk_idle, cpha, shift->lsb);
+}
+
+static void ftdi_mpsse_shift_spi(
+    FtdiMpsse* ftdi_mpsse,
+    const FtdiMpsseDataShift* shift,
+    const uint8_t* data_out,
+    uint8_t* data_in,
+    uint32_t size) {
+    uint8_t* tx_data = (uint8_t*)data_out;
+    if(!tx_data) {
+        //Read-only shifts hold MOSI
+        memset(data_in, ftdi_gpio_read(&shift->mosi) ? 0xFF : 0x00, size);
+        tx_data = data_in;
     }
-    ftdi_mpsse->data_buf_count_byte = ftdi_mpsse->data_size;
+
+    //MOSI keeps the last bit when it goes back to GPIO
+    uint8_t last = tx_data[size - 1];
+    ftdi_gpio_write(&shift->mosi, shift->lsb ? (last & 0x80) : (last & 0x01));
+
+    if(!ftdi_spi_trx(ftdi_mpsse->ftdi_spi, tx_data, data_in, size) && data_in) {
+        memset(data_in, 0xFF, size);
+    }
+    ftdi_gpio_set_direction(ftdi_mpsse->gpio_mask);
 }
 
-static uint16_t ftdi_mpsse_get_data_size(FtdiMpsse* ftdi_mpsse) {
-    return ftdi_mpsse_get_data_stream(ftdi_mpsse) |
-           (uint16_t)ftdi_mpsse_get_data_stream(ftdi_mpsse) << 8;
+/**
+ * Shifts as much of the data phase as the RX data and the TX space allow.
+ * Data goes out of the USB OUT packet and comes in to the USB IN packet directly,
+ * one chunk never crosses a packet boundary.
+ */
+static FtdiMpsseStatus ftdi_mpsse_shift_data(FtdiMpsse* ftdi_mpsse) {
+    FtdiMpsseDataShift shift = ftdi_mpsse_data_config(ftdi_mpsse, ftdi_mpsse->data_command);
+    bool is_spi = ftdi_mpsse_shift_spi_config(ftdi_mpsse, &shift);
+
+    while(ftdi_mpsse->data_remaining) {
+        uint32_t size = ftdi_mpsse->data_remaining;
+        uint32_t available = 0;
+        const uint8_t* data_out = NULL;
+        uint8_t* data_in = NULL;
+
+        if(ftdi_mpsse->data_command & FtdiMpsseShiftDoWrite) {
+            data_out = ftdi_rx_packet_peek(ftdi_mpsse->ftdi, &available);
+            if(!data_out) return FtdiMpsseStatusDone;
+            size = MIN(size, available);
+        }
+        if(ftdi_mpsse->data_command & FtdiMpsseShiftDoRead) {
+            data_in = ftdi_tx_packet_claim(ftdi_mpsse->ftdi, &available);
+            if(!data_in) return FtdiMpsseStatusTxFull;
+            size = MIN(size, available);
+        }
+
+        if(is_spi) {
+            ftdi_mpsse_shift_spi(ftdi_mpsse, &shift, data_out, data_in, size);
+        } else {
+            ftdi_mpsse_data_shift_bytes(&shift, data_out, data_in, size);
+        }
+
+        if(data_out) ftdi_rx_packet_consume(ftdi_mpsse->ftdi, size);
+        if(data_in) ftdi_tx_packet_commit(ftdi_mpsse->ftdi, size);
+        ftdi_mpsse->data_remaining -= size;
+    }
+
+    return FtdiMpsseStatusDone;
 }
 
-static inline void ftdi_mpsse_immediate(FtdiMpsse* ftdi_mpsse) {
-    if(ftdi_mpsse->callback_immediate) {
-        ftdi_mpsse->callback_immediate(ftdi_mpsse->context_immediate);
+/** Clock-only and GPIOL1 wait opcodes, Wait leaves the command to be retried */
+static FtdiMpsseStatus ftdi_mpsse_clock(FtdiMpsse* ftdi_mpsse, const uint8_t* command) {
+    FtdiMpsseDataShift shift = ftdi_mpsse_data_config(ftdi_mpsse, 0);
+    uint32_t cycles = ((command[1] | (uint32_t)command[2] << 8) + 1) * 8;
+    bool is_done = true;
+
+    switch(command[0]) {
+    case FtdiMpsseCommandsClkBitsNoData:
+        ftdi_mpsse_data_clock_cycles(&shift, (command[1] & 0x07) + 1, false, false);
+        break;
+    case FtdiMpsseCommandsClkBytesNoData:
+        ftdi_mpsse_data_clock_cycles(&shift, cycles, false, false);
+        break;
+    case FtdiMpsseCommandsClkCountWaitOnHigh:
+    case FtdiMpsseCommandsClkCountWaitOnLow:
+        ftdi_mpsse_data_clock_cycles(
+            &shift, cycles, true, command[0] == FtdiMpsseCommandsClkCountWaitOnHigh);
+        break;
+    case FtdiMpsseCommandsClkWaitOnHigh:
+    case FtdiMpsseCommandsClkWaitOnLow:
+        //Clocks in slices, so USB and purge requests are served while GPIOL1 is not there
+        is_done = ftdi_mpsse_data_clock_cycles(
+            &shift,
+            MAX(ftdi_mpsse->clock / FTDI_MPSSE_CLOCK_WAIT_SLICE, 1UL),
+            true,
+            command[0] == FtdiMpsseCommandsClkWaitOnHigh);
+        break;
+    case FtdiMpsseCommandsWaitOnHigh:
+    case FtdiMpsseCommandsWaitOnLow:
+        is_done = ftdi_gpio_read(&shift.gpiol1) == (command[0] == FtdiMpsseCommandsWaitOnHigh);
+        break;
+    default:
+        break;
     }
+
+    return is_done ? FtdiMpsseStatusDone : FtdiMpsseStatusWait;
 }
-void ftdi_mpsse_state_machine(FtdiMpsse* ftdi_mpsse) {
-    ftdi_mpsse->error = FtdiMpsseErrorNone;
-    uint8_t data = ftdi_mpsse_get_data_stream(ftdi_mpsse);
+
+static FtdiMpsseStatus ftdi_mpsse_command(FtdiMpsse* ftdi_mpsse, const uint8_t* command) {
     uint8_t gpio_state_io = 0xFF;
-    switch(data) {
+
+    if(!(command[0] & 0x80)) {
+        ftdi_mpsse_shift(ftdi_mpsse, command);
+        return FtdiMpsseStatusDone;
+    }
+
+    switch(command[0]) {
     case FtdiMpsseCommandsSetBitsLow: // 0x80  Change LSB GPIO output */
-        ftdi_mpsse->gpio_state = ftdi_mpsse_get_data_stream(ftdi_mpsse);
-        ftdi_mpsse->gpio_mask = ftdi_mpsse_get_data_stream(ftdi_mpsse);
+        ftdi_mpsse->gpio_state = command[1];
+        ftdi_mpsse->gpio_mask = command[2];
         if(ftdi_mpsse->gpio_mask_old != ftdi_mpsse->gpio_mask) {
             ftdi_mpsse_gpio_set_direction(ftdi_mpsse);
             ftdi_mpsse->gpio_mask_old = ftdi_mpsse->gpio_mask;
@@ -225,299 +434,64 @@ void ftdi_mpsse_state_machine(FtdiMpsse* ftdi_mpsse) {
         break;
     case FtdiMpsseCommandsSetBitsHigh: // 0x82  Change MSB GPIO output */
         //Todo not supported
-        ftdi_mpsse_get_data_stream(ftdi_mpsse);
-        ftdi_mpsse_get_data_stream(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsGetBitsLow: // 0x81  Get LSB GPIO output */
         //Read GPIO
         gpio_state_io = ftdi_mpsse_gpio_get();
-        ftdi_mpssse_set_data_stream(ftdi_mpsse, &gpio_state_io, 1);
+        ftdi_set_tx_buf(ftdi_mpsse->ftdi, &gpio_state_io, 1);
         break;
     case FtdiMpsseCommandsGetBitsHigh: // 0x83  Get MSB GPIO output */
         //Todo not supported
         gpio_state_io = 0xFF;
-        ftdi_mpssse_set_data_stream(ftdi_mpsse, &gpio_state_io, 1);
+        ftdi_set_tx_buf(ftdi_mpsse->ftdi, &gpio_state_io, 1);
         break;
     case FtdiMpsseCommandsSendImmediate: // 0x87  Send immediate */
         //tx data to host callback
-        ftdi_mpsse_immediate(ftdi_mpsse);
-        break;
-    case FtdiMpsseCommandsWriteBytesPveMsb: // 0x10  Write bytes with positive edge clock, MSB first */
-        //spi mode 1,3
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_get_data(ftdi_mpsse);
-        ftdi_mpsse_data_write_bytes_pve_msb(ftdi_mpsse->data_buf, ftdi_mpsse->data_buf_count_byte);
-        break;
-    case FtdiMpsseCommandsWriteBytesNveMsb: // 0x11  Write bytes with negative edge clock, MSB first */
-        //spi mode 0,2
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_get_data(ftdi_mpsse);
-        ftdi_mpsse_data_write_bytes_nve_msb(ftdi_mpsse->data_buf, ftdi_mpsse->data_buf_count_byte);
-        break;
-    case FtdiMpsseCommandsWriteBitsPveMsb: // 0x12  Write bits with positive edge clock, MSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_skeep_data(ftdi_mpsse);
-        break;
-    case FtdiMpsseCommandsWriteBitsNveMsb: // 0x13  Write bits with negative edge clock, MSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_skeep_data(ftdi_mpsse);
-        break;
-    case FtdiMpsseCommandsWriteBytesPveLsb: // 0x18  Write bytes with positive edge clock, LSB first */
-        //spi mode 1,3
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_get_data(ftdi_mpsse);
-        ftdi_mpsse_data_write_bytes_pve_lsb(ftdi_mpsse->data_buf, ftdi_mpsse->data_buf_count_byte);
-        break;
-    case FtdiMpsseCommandsWriteBytesNveLsb: // 0x19  Write bytes with negative edge clock, LSB first */
-        //spi mode 0,2
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_get_data(ftdi_mpsse);
-        ftdi_mpsse_data_write_bytes_nve_lsb(ftdi_mpsse->data_buf, ftdi_mpsse->data_buf_count_byte);
-        break;
-    case FtdiMpsseCommandsWriteBitsPveLsb: // 0x1a  Write bits with positive edge clock, LSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_skeep_data(ftdi_mpsse);
-        break;
-    case FtdiMpsseCommandsWriteBitsNveLsb: // 0x1b  Write bits with negative edge clock, LSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        ftdi_mpsse_skeep_data(ftdi_mpsse);
-        break;
-    case FtdiMpsseCommandsReadBytesPveMsb: // 0x20  Read bytes with positive edge clock, MSB first */
-        //spi mode 1,3
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        if(ftdi_mpsse->data_size >= FTDI_MPSSE_TX_RX_SIZE) {
-            ftdi_mpsse->error = FtdiMpsseErrorTxOverflow;
-            FURI_LOG_E(TAG, "Tx buffer overflow");
-        } else {
-            ftdi_mpsse->data_size++;
-            ftdi_mpsse_data_read_bytes_pve_msb(ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpssse_set_data_stream(ftdi_mpsse, ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpsse_immediate(ftdi_mpsse);
-        }
-        break;
-    case FtdiMpsseCommandsReadBytesNveMsb: // 0x24  Read bytes with negative edge clock, MSB first */
-        //spi mode 0,2
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        if(ftdi_mpsse->data_size >= FTDI_MPSSE_TX_RX_SIZE) {
-            ftdi_mpsse->error = FtdiMpsseErrorTxOverflow;
-            FURI_LOG_E(TAG, "Tx buffer overflow");
-        } else {
-            ftdi_mpsse->data_size++;
-            ftdi_mpsse_data_read_bytes_nve_msb(ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpssse_set_data_stream(ftdi_mpsse, ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpsse_immediate(ftdi_mpsse);
-        }
-
-        //write data
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsReadBitsPveMsb: // 0x22  Read bits with positive edge clock, MSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //write data
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsReadBitsNveMsb: // 0x26  Read bits with negative edge clock, MSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //write data
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsReadBytesPveLsb: // 0x28  Read bytes with positive edge clock, LSB first */
-        //spi mode 1,3
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        if(ftdi_mpsse->data_size >= FTDI_MPSSE_TX_RX_SIZE) {
-            ftdi_mpsse->error = FtdiMpsseErrorTxOverflow;
-            FURI_LOG_E(TAG, "Tx buffer overflow");
-        } else {
-            ftdi_mpsse->data_size++;
-            ftdi_mpsse_data_read_bytes_pve_lsb(ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpssse_set_data_stream(ftdi_mpsse, ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpsse_immediate(ftdi_mpsse);
-        }
-        break;
-    case FtdiMpsseCommandsReadBytesNveLsb: // 0x2c  Read bytes with negative edge clock, LSB first */
-        //spi mode 0,2
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        if(ftdi_mpsse->data_size >= FTDI_MPSSE_TX_RX_SIZE) {
-            ftdi_mpsse->error = FtdiMpsseErrorTxOverflow;
-            FURI_LOG_E(TAG, "Tx buffer overflow");
-        } else {
-            ftdi_mpsse->data_size++;
-            ftdi_mpsse_data_read_bytes_nve_lsb(ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpssse_set_data_stream(ftdi_mpsse, ftdi_mpsse->data_buf, ftdi_mpsse->data_size);
-            ftdi_mpsse_immediate(ftdi_mpsse);
-        }
-        break;
-    case FtdiMpsseCommandsReadBitsPveLsb: // 0x2a  Read bits with positive edge clock, LSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //write data
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsReadBitsNveLsb: // 0x2e  Read bits with negative edge clock, LSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //write data
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBytesPveNveMsb: // 0x31  Read/Write bytes with positive edge clock, MSB first */
-        //spi mode 1,3
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_get_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBytesNvePveMsb: // 0x34  Read/Write bytes with negative edge clock, MSB first */
-        //spi mode 0,2
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_get_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBitsPveNveMsb: // 0x33  Read/Write bits with positive edge clock, MSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_skeep_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBitsNvePveMsb: // 0x36  Read/Write bits with negative edge clock, MSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_skeep_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBytesPveNveLsb: // 0x39  Read/Write bytes with positive edge clock, LSB first */
-        //spi mode 1,3
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_get_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBytesNvePveLsb: // 0x3c  Read/Write bytes with negative edge clock, LSB first */
-        //spi mode 0,2
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_get_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBitsPveNveLsb: // 0x3b  Read/Write bits with positive edge clock, LSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_skeep_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsRwBitsNvePveLsb: // 0x3e  Read/Write bits with negative edge clock, LSB first */
-        //not supported
-        ftdi_mpsse->data_size = ftdi_mpsse_get_data_size(ftdi_mpsse);
-        //read data
-        //ftdi_mpsse_skeep_data(ftdi_mpsse);
-        //ftdi_mpssse_set_data_stream(ftdi_mpsse, 0xFF, ftdi_mpsse->data_size);
-        break;
-    case FtdiMpsseCommandsWriteBitsTmsPve: // 0x4a  Write bits with TMS, positive edge clock */
-        //not supported
-        break;
-    case FtdiMpsseCommandsWriteBitsTmsNve: // 0x4b  Write bits with TMS, negative edge clock */
-        //not supported
-        break;
-    case FtdiMpsseCommandsRwBitsTmsPvePve: // 0x6a  Read/Write bits with TMS, positive edge clock, MSB first */
-        //not supported
-        break;
-    case FtdiMpsseCommandsRwBitsTmsPveNve: // 0x6b  Read/Write bits with TMS, positive edge clock, MSB first */
-        //not supported
-        break;
-    case FtdiMpsseCommandsRwBitsTmsNvePve: // 0x6e  Read/Write bits with TMS, negative edge clock, MSB first */
-        //not supported
-        break;
-    case FtdiMpsseCommandsRwBitsTmsNveNve: // 0x6f  Read/Write bits with TMS, negative edge clock, MSB first */
-        //not supported
+        ftdi_mpsse->is_immediate = true;
         break;
     case FtdiMpsseCommandsLoopbackStart: // 0x84  Enable loopback */
         ftdi_mpsse->is_loopback = true;
-        ftdi_mpsse_immediate(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsLoopbackEnd: // 0x85  Disable loopback */
         ftdi_mpsse->is_loopback = false;
-        ftdi_mpsse_immediate(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsSetTckDivisor: // 0x86  Set clock */
-        ftdi_mpsse_immediate(ftdi_mpsse);
+        ftdi_mpsse->clock_divisor = command[1] | (uint16_t)command[2] << 8;
+        ftdi_mpsse_update_clock(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsDisDiv5: // 0x8a  Disable divide by 5 */
         ftdi_mpsse->is_div5 = false;
-        ftdi_mpsse_immediate(ftdi_mpsse);
+        ftdi_mpsse_update_clock(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsEnDiv5: // 0x8b  Enable divide by 5 */
         ftdi_mpsse->is_div5 = true;
-        ftdi_mpsse_immediate(ftdi_mpsse);
+        ftdi_mpsse_update_clock(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsEnableClk3Phase: // 0x8c  Enable 3-phase data clocking (I2C) */
         ftdi_mpsse->is_clk3phase = true;
-        ftdi_mpsse_immediate(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsDisableClk3Phase: // 0x8d  Disable 3-phase data clocking */
         ftdi_mpsse->is_clk3phase = false;
-        ftdi_mpsse_immediate(ftdi_mpsse);
-        break;
-    case FtdiMpsseCommandsClkBitsNoData: // 0x8e  Allows JTAG clock to be output w/o data */
-        //not supported
-        break;
-    case FtdiMpsseCommandsClkBytesNoData: // 0x8f  Allows JTAG clock to be output w/o data */
-        //not supported
-        break;
-    case FtdiMpsseCommandsClkWaitOnHigh: // 0x94  Clock until GPIOL1 is high */
-        //not supported
-        break;
-    case FtdiMpsseCommandsClkWaitOnLow: // 0x95  Clock until GPIOL1 is low */
-        //not supported
         break;
     case FtdiMpsseCommandsEnableClkAdaptive: // 0x96  Enable JTAG adaptive clock for ARM */
         ftdi_mpsse->is_adaptive = true;
-        ftdi_mpsse_immediate(ftdi_mpsse);
         break;
     case FtdiMpsseCommandsDisableClkAdaptive: // 0x97  Disable JTAG adaptive clock */
         ftdi_mpsse->is_adaptive = false;
-        ftdi_mpsse_immediate(ftdi_mpsse);
         break;
+    case FtdiMpsseCommandsClkBitsNoData: // 0x8e  Allows JTAG clock to be output w/o data */
+    case FtdiMpsseCommandsClkBytesNoData: // 0x8f  Allows JTAG clock to be output w/o data */
+    case FtdiMpsseCommandsClkWaitOnHigh: // 0x94  Clock until GPIOL1 is high */
+    case FtdiMpsseCommandsClkWaitOnLow: // 0x95  Clock until GPIOL1 is low */
     case FtdiMpsseCommandsClkCountWaitOnHigh: // 0x9c  Clock byte cycles until GPIOL1 is high */
-        //not supported
-        break;
     case FtdiMpsseCommandsClkCountWaitOnLow: // 0x9d  Clock byte cycles until GPIOL1 is low */
-        //not supported
-        break;
-    case FtdiMpsseCommandsDriveZero: // 0x9e  Drive-zero mode */
-        //not supported
-        break;
     case FtdiMpsseCommandsWaitOnHigh: // 0x88  Wait until GPIOL1 is high */
-        //not supported
-        break;
     case FtdiMpsseCommandsWaitOnLow: // 0x89  Wait until GPIOL1 is low */
-        //not supported
-        break;
+        return ftdi_mpsse_clock(ftdi_mpsse, command);
+    case FtdiMpsseCommandsDriveZero: // 0x9e  Drive-zero mode */
     case FtdiMpsseCommandsReadShort: // 0x90  Read short */
-        //not supported
-        break;
     case FtdiMpsseCommandsReadExtended: // 0x91  Read extended */
-        //not supported
-        break;
     case FtdiMpsseCommandsWriteShort: // 0x92  Write short */
-        //not supported
-        break;
     case FtdiMpsseCommandsWriteExtended: // 0x93  Write extended */
         //not supported
         break;
@@ -525,4 +499,71 @@ void ftdi_mpsse_state_machine(FtdiMpsse* ftdi_mpsse) {
     default:
         break;
     }
+    return FtdiMpsseStatusDone;
+}
+
+/** Gathers the pending command from the USB OUT packets, false if it is not complete yet */
+static bool ftdi_mpsse_command_fill(FtdiMpsse* ftdi_mpsse) {
+    while(true) {
+        size_t size = 1;
+        if(ftdi_mpsse->command_len) {
+            size = MAX(ftdi_mpsse_get_command_size(ftdi_mpsse->command[0]), 1U);
+        }
+        if(ftdi_mpsse->command_len >= size) return true;
+
+        uint32_t available = 0;
+        const uint8_t* data = ftdi_rx_packet_peek(ftdi_mpsse->ftdi, &available);
+        if(!data) return false;
+
+        available = MIN(available, size - ftdi_mpsse->command_len);
+        memcpy(&ftdi_mpsse->command[ftdi_mpsse->command_len], data, available);
+        ftdi_mpsse->command_len += available;
+        ftdi_rx_packet_consume(ftdi_mpsse->ftdi, available);
+    }
+}
+
+/** Executes every complete command received, stops at a partial one */
+static FtdiMpsseStatus ftdi_mpsse_execute(FtdiMpsse* ftdi_mpsse) {
+    while(true) {
+        if(ftdi_mpsse->data_remaining) {
+            FtdiMpsseStatus status = ftdi_mpsse_shift_data(ftdi_mpsse);
+            if(ftdi_mpsse->data_remaining) return status;
+        }
+
+        if(!ftdi_mpsse_command_fill(ftdi_mpsse)) return FtdiMpsseStatusDone;
+        const uint8_t* command = ftdi_mpsse->command;
+
+        //Responses are never split, keep room for the largest one
+        if(ftdi_available_tx_space(ftdi_mpsse->ftdi) < FTDI_MPSSE_RESPONSE_SIZE_MAX) {
+            return FtdiMpsseStatusTxFull;
+        }
+
+#ifdef FTDI_DEBUG
+        FURI_LOG_RAW_I("0x%02X ", command[0]);
+#endif
+        if(ftdi_mpsse_get_command_size(command[0])) {
+            //A waiting command stays gathered and is retried on the next pass
+            FtdiMpsseStatus status = ftdi_mpsse_command(ftdi_mpsse, command);
+            if(status == FtdiMpsseStatusWait) return status;
+        } else {
+            //Bad command response lets the host resynchronize
+            uint8_t response[FTDI_MPSSE_RESPONSE_SIZE_MAX] = {FTDI_MPSSE_BAD_COMMAND, command[0]};
+            ftdi_set_tx_buf(ftdi_mpsse->ftdi, response, sizeof(response));
+            ftdi_mpsse->is_immediate = true;
+        }
+        ftdi_mpsse->command_len = 0;
+    }
+}
+
+bool ftdi_mpsse_process(FtdiMpsse* ftdi_mpsse) {
+    FtdiMpsseStatus status = ftdi_mpsse_execute(ftdi_mpsse);
+
+    //Responses are coalesced into full USB packets, the partial one goes out
+    //on SEND_IMMEDIATE, on a full TX pool or when the latency timer expires
+    if(ftdi_mpsse->is_immediate || (status == FtdiMpsseStatusTxFull)) {
+        ftdi_mpsse->is_immediate = false;
+        ftdi_mpsse_immediate(ftdi_mpsse);
+    }
+
+    return status == FtdiMpsseStatusDone;
 }
@@ -8,4 +8,9 @@ void ftdi_mpsse_gpio_set_callback(FtdiMpsse* ftdi_mpsse, FtdiMpsseCallbackImmedi
 
 FtdiMpsse* ftdi_mpsse_alloc(Ftdi* ftdi);
 void ftdi_mpsse_free(FtdiMpsse* ftdi_mpsse);
-void ftdi_mpsse_state_machine(FtdiMpsse* ftdi_mpsse);
+void ftdi_mpsse_reset(FtdiMpsse* ftdi_mpsse);
+/**
+ * Executes all complete commands received so far,
+ * false if stalled on a full TX buffer or waiting for GPIOL1
+ */
+bool ftdi_mpsse_process(FtdiMpsse* ftdi_mpsse);
@@ -6,118 +6,144 @@
 //ftdi_gpio_set_b0 - CLK
 //ftdi_gpio_set_b1 - MOSI
 //ftdi_gpio_set_b2 - MISO
-//ftdi_gpio_set_b3 - CS
+//ftdi_gpio_set_b3 - CS, TMS in JTAG shifts
+//ftdi_gpio_get_b5 - GPIOL1 for the wait and clock-until opcodes
+//ftdi_gpio_get_b7 - RTCK in adaptive clocking mode
 
-static inline void ftdi_mpsse_data_write_bytes_nve_msb(uint8_t* data, uint32_t size) {
-    uint8_t mask = 0x80;
-    for(uint32_t i = 0; i < size; i++) {
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b1(data[i] & mask);
-            ftdi_gpio_set_b0(1);
-            data[i] <<= 1;
-            ftdi_gpio_set_b0(0);
-        }
-    }
-    ftdi_gpio_set_b0(0);
-    ftdi_gpio_set_b1(0);
+//RTCK wait per TCK edge, about 100us at 64MHz
+#define FTDI_MPSSE_DATA_ADAPTIVE_SPINS (1000UL)
+
+// Clock edges of one bit: the first one leaves the idle level, the second one returns to it.
+typedef struct {
+    uint8_t clk_idle; // Idle level of CLK, set by the host with SetBitsLow
+    bool lsb;
+    bool write_edge1; // MOSI changes on the first edge, not before it
+    bool read_edge1; // MISO is sampled on the first edge, not on the second one
+    bool loopback;
+    bool adaptive;
+    uint32_t half_period; // CPU cycles between clock edges, 0 runs at GPIO speed
+    uint32_t edge; // DWT cycle count of the last clock edge
+    GpioPin clk;
+    GpioPin mosi;
+    GpioPin miso;
+    GpioPin tms;
+    GpioPin gpiol1;
+} FtdiMpsseDataShift;
+
+static inline FtdiMpsseDataShift
+    ftdi_mpsse_data_shift_config(uint8_t command, uint8_t gpio_state) {
+    FtdiMpsseDataShift shift;
+    shift.clk_idle = gpio_state & 0b00000001;
+    // Idle low: the first edge is positive, idle high: the first edge is negative
+    shift.write_edge1 = !(command & FtdiMpsseShiftWriteNeg) == !shift.clk_idle;
+    shift.read_edge1 = !(command & FtdiMpsseShiftReadNeg) == !shift.clk_idle;
+    shift.lsb = command & FtdiMpsseShiftLsb;
+    shift.loopback = false;
+    shift.adaptive = false;
+    shift.half_period = 0;
+    shift.edge = DWT->CYCCNT;
+    shift.clk = ftdi_gpio_pins[0];
+    shift.mosi = ftdi_gpio_pins[1];
+    shift.miso = ftdi_gpio_pins[2];
+    shift.tms = ftdi_gpio_pins[3];
+    shift.gpiol1 = ftdi_gpio_pins[5];
+    return shift;
 }
 
-static inline void ftdi_mpsse_data_read_bytes_nve_msb(uint8_t* data, uint32_t size) {
-    memset(data, 0, size);
-    for(uint32_t i = 0; i < size; i++) {
-        uint8_t mask = 0x80;
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b0(1);
-            data[i] |= ftdi_gpio_get_b2() ? mask : 0;
-            ftdi_gpio_set_b0(0);
-            mask >>= 1;
+static inline void ftdi_mpsse_data_clock(FtdiMpsseDataShift* shift, uint8_t level) {
+    if(shift->half_period) {
+        while(DWT->CYCCNT - shift->edge < shift->half_period) {
         }
+        shift->edge = DWT->CYCCNT;
     }
-}
-
-static inline void ftdi_mpsse_data_write_bytes_nve_lsb(uint8_t* data, uint32_t size) {
-    uint8_t mask = 0x01;
-    for(uint32_t i = 0; i < size; i++) {
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b1(data[i] & mask);
-            ftdi_gpio_set_b0(1);
-            data[i] >>= 1;
-            ftdi_gpio_set_b0(0);
+    ftdi_gpio_write(&shift->clk, level);
+    if(shift->adaptive) {
+        // Bounded, in case nothing drives RTCK
+        for(uint32_t i = FTDI_MPSSE_DATA_ADAPTIVE_SPINS; i; i--) {
+            if(!ftdi_gpio_get_b7() == !level) break;
         }
     }
-    ftdi_gpio_set_b0(0);
-    ftdi_gpio_set_b1(0);
 }
 
-static inline void ftdi_mpsse_data_read_bytes_nve_lsb(uint8_t* data, uint32_t size) {
-    memset(data, 0, size);
-    for(uint32_t i = 0; i < size; i++) {
-        uint8_t mask = 0x01;
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b0(1);
-            data[i] |= ftdi_gpio_get_b2() ? mask : 0;
-            ftdi_gpio_set_b0(0);
-            mask <<= 1;
-        }
-    }
+// One clock cycle: out changes on the write edge, the returned MISO level is the read edge sample
+static inline bool
+    ftdi_mpsse_data_shift_bit(FtdiMpsseDataShift* shift, const GpioPin* out, uint8_t level) {
+    bool in = false;
+    if(!shift->write_edge1) ftdi_gpio_write(out, level);
+    ftdi_mpsse_data_clock(shift, !shift->clk_idle);
+    if(shift->write_edge1) ftdi_gpio_write(out, level);
+    if(shift->read_edge1) in = ftdi_gpio_read(&shift->miso);
+    ftdi_mpsse_data_clock(shift, shift->clk_idle);
+    if(!shift->read_edge1) in = ftdi_gpio_read(&shift->miso);
+    return in;
 }
 
-static inline void ftdi_mpsse_data_write_bytes_pve_msb(uint8_t* data, uint32_t size) {
-    uint8_t mask = 0x80;
-    ftdi_gpio_set_b0(1);
-    for(uint32_t i = 0; i < size; i++) {
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b1(data[i] & mask);
-            ftdi_gpio_set_b0(0);
-            data[i] <<= 1;
-            ftdi_gpio_set_b0(1);
+// Shifts 1..8 bits on MOSI. As on FTDI chips, MSB first reads fill the low bits of the result
+// and LSB first reads fill the high bits.
+static inline uint8_t
+    ftdi_mpsse_data_shift_bits(FtdiMpsseDataShift* shift, uint8_t data, uint8_t bits) {
+    uint8_t result = 0;
+    for(uint8_t j = 0; j < bits; j++) {
+        uint8_t bit = shift->lsb ? (data & 0x01) : (data & 0x80);
+        bool in = ftdi_mpsse_data_shift_bit(shift, &shift->mosi, bit);
+        if(shift->loopback) in = bit;
+
+        if(shift->lsb) {
+            data >>= 1;
+            result = (result >> 1) | (in ? 0x80 : 0);
+        } else {
+            data <<= 1;
+            result = (result << 1) | (in ? 0x01 : 0);
         }
     }
-    ftdi_gpio_set_b0(1);
-    ftdi_gpio_set_b1(0);
+    return result;
 }
 
-static inline void ftdi_mpsse_data_read_bytes_pve_msb(uint8_t* data, uint32_t size) {
-    memset(data, 0, size);
-    ftdi_gpio_set_b0(0);
-    for(uint32_t i = 0; i < size; i++) {
-        uint16_t mask = 0x80;
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b0(1);
-            data[i] |= ftdi_gpio_get_b2() ? mask : 0;
-            ftdi_gpio_set_b0(0);
-            mask >>= 1;
-        }
+static inline uint8_t ftdi_mpsse_data_shift_byte(FtdiMpsseDataShift* shift, uint8_t data) {
+    return ftdi_mpsse_data_shift_bits(shift, data, 8);
+}
+
+// TMS shift of 1..7 bits: bit 7 is held on TDI, bits 0..6 go out on TMS LSB first and TDO is
+// sampled in the same pass, so a JTAG state change with its last TDI bit is one command.
+static inline uint8_t
+    ftdi_mpsse_data_shift_tms(FtdiMpsseDataShift* shift, uint8_t data, uint8_t bits) {
+    uint8_t tdi = data & 0x80;
+    uint8_t result = 0;
+    ftdi_gpio_write(&shift->mosi, tdi);
+    for(uint8_t j = 0; j < bits; j++) {
+        bool in = ftdi_mpsse_data_shift_bit(shift, &shift->tms, data & 0x01);
+        if(shift->loopback) in = tdi;
+        data >>= 1;
+        result = (result >> 1) | (in ? 0x80 : 0);
     }
-    ftdi_gpio_set_b0(1);
+    return result;
 }
 
-static inline void ftdi_mpsse_data_write_bytes_pve_lsb(uint8_t* data, uint32_t size) {
-    uint8_t mask = 0x01;
-    ftdi_gpio_set_b0(1);
-    for(uint32_t i = 0; i < size; i++) {
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b1(data[i] & mask);
-            ftdi_gpio_set_b0(0);
-            data[i] >>= 1;
-            ftdi_gpio_set_b0(1);
-        }
+// Clocks without data. With wait set it stops before the next cycle once GPIOL1 reads
+// wait_level, returns true in that case.
+static inline bool ftdi_mpsse_data_clock_cycles(
+    FtdiMpsseDataShift* shift,
+    uint32_t cycles,
+    bool wait,
+    bool wait_level) {
+    for(; cycles; cycles--) {
+        if(wait && (ftdi_gpio_read(&shift->gpiol1) == wait_level)) return true;
+        ftdi_mpsse_data_clock(shift, !shift->clk_idle);
+        ftdi_mpsse_data_clock(shift, shift->clk_idle);
     }
-    ftdi_gpio_set_b0(1);
-    ftdi_gpio_set_b1(0);
+    return wait && (ftdi_gpio_read(&shift->gpiol1) == wait_level);
 }
 
-static inline void ftdi_mpsse_data_read_bytes_pve_lsb(uint8_t* data, uint32_t size) {
-    memset(data, 0, size);
-    ftdi_gpio_set_b0(0);
+// data_out == NULL keeps MOSI at its last level, data_in == NULL drops the sampled bits
+static inline void ftdi_mpsse_data_shift_bytes(
+    FtdiMpsseDataShift* shift,
+    const uint8_t* data_out,
+    uint8_t* data_in,
+    uint32_t size) {
+    // Read-only shifts hold MOSI, repeat its level in every bit
+    uint8_t hold = ftdi_gpio_read(&shift->mosi) ? 0xFF : 0x00;
     for(uint32_t i = 0; i < size; i++) {
-        uint16_t mask = 0x01;
-        for(uint8_t j = 0; j < 8; j++) {
-            ftdi_gpio_set_b0(1);
-            data[i] |= ftdi_gpio_get_b2() ? mask : 0;
-            ftdi_gpio_set_b0(0);
-            mask <<= 1;
-        }
+        uint8_t in = ftdi_mpsse_data_shift_byte(shift, data_out ? data_out[i] : hold);
+        if(data_in) data_in[i] = in;
     }
-    ftdi_gpio_set_b0(1);
-}
\ No newline at end of file
+}
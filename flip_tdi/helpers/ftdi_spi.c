@@ -0,0 +1,126 @@
+#include "ftdi_spi.h"
+#include "furi.h"
+#include <furi_hal.h>
+#include <furi_hal_spi.h>
+#include <furi_hal_resources.h>
+
+#define TAG "FTDI_SPI"
+
+#define FTDI_SPI_TIMEOUT       100
+#define FTDI_SPI_KERNEL_CLOCK  (64000000UL)
+#define FTDI_SPI_PRESCALER_MAX 8
+
+/*
+ * SPI1 on the external header: SCK PB3, MOSI PA7, MISO PA6.
+ * The pins stay in GPIO mode between transfers, so SetBitsLow keeps working,
+ * and are switched to the SPI alternate function only while a transfer runs.
+ */
+struct FtdiSpi {
+    FuriHalSpiBusHandle handle; // Must be first, the handle callback casts it back
+    LL_SPI_InitTypeDef config;
+};
+
+static const uint32_t ftdi_spi_prescaler[FTDI_SPI_PRESCALER_MAX] = {
+    LL_SPI_BAUDRATEPRESCALER_DIV2,
+    LL_SPI_BAUDRATEPRESCALER_DIV4,
+    LL_SPI_BAUDRATEPRESCALER_DIV8,
+    LL_SPI_BAUDRATEPRESCALER_DIV16,
+    LL_SPI_BAUDRATEPRESCALER_DIV32,
+    LL_SPI_BAUDRATEPRESCALER_DIV64,
+    LL_SPI_BAUDRATEPRESCALER_DIV128,
+    LL_SPI_BAUDRATEPRESCALER_DIV256,
+};
+
+static void ftdi_spi_set_pin_mode(FtdiSpi* ftdi_spi, uint32_t mode, uint32_t miso_mode) {
+    LL_GPIO_SetPinMode(ftdi_spi->handle.sck->port, ftdi_spi->handle.sck->pin, mode);
+    LL_GPIO_SetPinMode(ftdi_spi->handle.mosi->port, ftdi_spi->handle.mosi->pin, mode);
+    LL_GPIO_SetPinMode(ftdi_spi->handle.miso->port, ftdi_spi->handle.miso->pin, miso_mode);
+}
+
+static void ftdi_spi_handle_event_callback(
+    FuriHalSpiBusHandle* handle,
+    FuriHalSpiBusHandleEvent event) {
+    FtdiSpi* ftdi_spi = (FtdiSpi*)handle;
+    SPI_TypeDef* spi = handle->bus->spi;
+
+    if(event == FuriHalSpiBusHandleEventActivate) {
+        //SCK is driven to CPOL once SPI is enabled, before the pins are switched to it
+        LL_SPI_Init(spi, &ftdi_spi->config);
+        LL_SPI_SetRxFIFOThreshold(spi, LL_SPI_RX_FIFO_TH_QUARTER);
+        LL_SPI_Enable(spi);
+    } else if(event == FuriHalSpiBusHandleEventDeactivate) {
+        LL_SPI_Disable(spi);
+    }
+}
+
+FtdiSpi* ftdi_spi_alloc(void) {
+    FtdiSpi* ftdi_spi = malloc(sizeof(FtdiSpi));
+    ftdi_spi->handle.bus = &furi_hal_spi_bus_r;
+    ftdi_spi->handle.callback = ftdi_spi_handle_event_callback;
+    ftdi_spi->handle.miso = &gpio_ext_pa6;
+    ftdi_spi->handle.mosi = &gpio_ext_pa7;
+    ftdi_spi->handle.sck = &gpio_ext_pb3;
+    //CS is an ordinary MPSSE GPIO, the handle never touches it
+    ftdi_spi->handle.cs = &gpio_ext_pa4;
+
+    ftdi_spi->config.Mode = LL_SPI_MODE_MASTER;
+    ftdi_spi->config.TransferDirection = LL_SPI_FULL_DUPLEX;
+    ftdi_spi->config.DataWidth = LL_SPI_DATAWIDTH_8BIT;
+    ftdi_spi->config.ClockPolarity = LL_SPI_POLARITY_LOW;
+    ftdi_spi->config.ClockPhase = LL_SPI_PHASE_1EDGE;
+    ftdi_spi->config.NSS = LL_SPI_NSS_SOFT;
+    ftdi_spi->config.BaudRate = LL_SPI_BAUDRATEPRESCALER_DIV32;
+    ftdi_spi->config.BitOrder = LL_SPI_MSB_FIRST;
+    ftdi_spi->config.CRCCalculation = LL_SPI_CRCCALCULATION_DISABLE;
+    ftdi_spi->config.CRCPoly = 7;
+
+    //Alternate function number only, the mode is switched per transfer
+    LL_GPIO_SetAFPin_0_7(GPIOB, LL_GPIO_PIN_3, LL_GPIO_AF_5);
+    LL_GPIO_SetAFPin_0_7(GPIOA, LL_GPIO_PIN_7, LL_GPIO_AF_5);
+    LL_GPIO_SetAFPin_0_7(GPIOA, LL_GPIO_PIN_6, LL_GPIO_AF_5);
+
+    furi_hal_spi_bus_handle_init(&ftdi_spi->handle);
+    return ftdi_spi;
+}
+
+void ftdi_spi_free(FtdiSpi* ftdi_spi) {
+    if(!ftdi_spi) return;
+    furi_hal_spi_bus_handle_deinit(&ftdi_spi->handle);
+    free(ftdi_spi);
+    ftdi_spi = NULL;
+}
+
+/**
+ * Selects the fastest prescaler not above the requested clock.
+ * Returns false if the clock is below what the peripheral can do.
+ */
+bool ftdi_spi_set_config(FtdiSpi* ftdi_spi, uint32_t clock, bool cpol, bool cpha, bool lsb) {
+    size_t index = 0;
+    while((FTDI_SPI_KERNEL_CLOCK >> (index + 1)) > clock) {
+        if(++index == FTDI_SPI_PRESCALER_MAX) return false;
+    }
+
+    ftdi_spi->config.BaudRate = ftdi_spi_prescaler[index];
+    ftdi_spi->config.ClockPolarity = cpol ? LL_SPI_POLARITY_HIGH : LL_SPI_POLARITY_LOW;
+    ftdi_spi->config.ClockPhase = cpha ? LL_SPI_PHASE_2EDGE : LL_SPI_PHASE_1EDGE;
+    ftdi_spi->config.BitOrder = lsb ? LL_SPI_LSB_FIRST : LL_SPI_MSB_FIRST;
+    return true;
+}
+
+/** rx_data may be NULL for write-only shifts */
+bool ftdi_spi_trx(FtdiSpi* ftdi_spi, uint8_t* tx_data, uint8_t* rx_data, size_t size) {
+    furi_hal_spi_acquire(&ftdi_spi->handle);
+    ftdi_spi_set_pin_mode(ftdi_spi, LL_GPIO_MODE_ALTERNATE, LL_GPIO_MODE_ALTERNATE);
+
+    bool result =
+        furi_hal_spi_bus_trx_dma(&ftdi_spi->handle, tx_data, rx_data, size, FTDI_SPI_TIMEOUT);
+
+    //Back to GPIO, the caller restores the directions set by the host
+    ftdi_spi_set_pin_mode(ftdi_spi, LL_GPIO_MODE_OUTPUT, LL_GPIO_MODE_INPUT);
+    furi_hal_spi_release(&ftdi_spi->handle);
+
+    if(!result) {
+        FURI_LOG_E(TAG, "Transfer timeout");
+    }
+    return result;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "ftdi.h"
+
+typedef struct FtdiSpi FtdiSpi;
+
+FtdiSpi* ftdi_spi_alloc(void);
+void ftdi_spi_free(FtdiSpi* ftdi_spi);
+bool ftdi_spi_set_config(FtdiSpi* ftdi_spi, uint32_t clock, bool cpol, bool cpha, bool lsb);
+bool ftdi_spi_trx(FtdiSpi* ftdi_spi, uint8_t* tx_data, uint8_t* rx_data, size_t size);
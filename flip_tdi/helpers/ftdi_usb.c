@@ -15,12 +15,9 @@
 
 #define FTDI_USB_RX_MAX_SIZE       (FTDI_USB_EP_OUT_SIZE)
 #define FTDI_USB_MODEM_STATUS_SIZE (sizeof(uint16_t))
-#define FTDI_USB_TX_MAX_SIZE       (FTDI_USB_EP_IN_SIZE - FTDI_USB_MODEM_STATUS_SIZE)
 
-typedef struct {
-    uint16_t status;
-    uint8_t data[FTDI_USB_TX_MAX_SIZE];
-} FtdiTxData;
+static_assert(FTDI_USB_RX_MAX_SIZE == FTDI_PACKET_SIZE, "Wrong FTDI_PACKET_SIZE");
+static_assert(FTDI_USB_MODEM_STATUS_SIZE == FTDI_PACKET_STATUS_SIZE, "Wrong status size");
 
 static usbd_respond ftdi_usb_ep_config(usbd_device* dev, uint8_t cfg);
 static usbd_respond
@@ -53,6 +50,7 @@ struct FtdiUsb {
 
     bool tx_complete;
     bool tx_immediate;
+    bool tx_packet; // An IN packet of the pool is being sent
 };
 
 static int32_t ftdi_thread_worker(void* context) {
@@ -61,27 +59,25 @@ static int32_t ftdi_thread_worker(void* context) {
     UNUSED(dev);
 
     uint32_t len_data = 0;
-    FtdiTxData tx_data = {0};
     uint16_t* status = ftdi_get_modem_status_uint16_t(ftdi_usb->ftdi);
+    uint16_t tx_status = status[0];
 
-    tx_data.status = status[0];
-    ftdi_usb_send(dev, (uint8_t*)&tx_data, FTDI_USB_MODEM_STATUS_SIZE);
+    ftdi_usb_send(dev, (uint8_t*)&tx_status, FTDI_USB_MODEM_STATUS_SIZE);
 
     while(true) {
         uint32_t flags = furi_thread_flags_wait(EventAll, FuriFlagWaitAny, FuriWaitForever);
 
         if(flags & EventRx) { //fast flag
-            uint8_t buf[FTDI_USB_RX_MAX_SIZE];
-            len_data = ftdi_usb_receive(dev, buf, FTDI_USB_RX_MAX_SIZE);
-            // if(len_data > 0) {
-            //     for(uint32_t i = 0; i < len_data; i++) {
-            //         FURI_LOG_RAW_I("%c", (char)buf[i]);
-            //     }
-            //     FURI_LOG_RAW_I("\r\n");
-            // }
-            if(len_data > 0) {
-                ftdi_set_rx_buf(ftdi_usb->ftdi, buf, len_data);
-                ftdi_start_uart_tx(ftdi_usb->ftdi);
+            //Without a free packet the endpoint is not read and NAKs the host,
+            //the pool raises EventRx again once the engines release one
+            uint8_t* buf = ftdi_rx_packet_alloc(ftdi_usb->ftdi);
+            if(buf) {
+                len_data = ftdi_usb_receive(dev, buf, FTDI_USB_RX_MAX_SIZE);
+                if(len_data > 0) {
+                    ftdi_rx_packet_push(ftdi_usb->ftdi, len_data);
+                    ftdi_start_uart_tx(ftdi_usb->ftdi);
+                    ftdi_start_bitbang_rx(ftdi_usb->ftdi);
+                }
             }
             flags &= ~EventRx; // clear flag
         }
@@ -89,38 +85,39 @@ static int32_t ftdi_thread_worker(void* context) {
         if(flags) {
             if(flags & EventResetSio) {
                 ftdi_reset_sio(ftdi_usb->ftdi);
-                ftdi_usb_send(dev, (uint8_t*)&tx_data, FTDI_USB_MODEM_STATUS_SIZE);
+                tx_status = status[0];
+                ftdi_usb_send(dev, (uint8_t*)&tx_status, FTDI_USB_MODEM_STATUS_SIZE);
             }
             if(flags & EventTxComplete) {
                 ftdi_usb->tx_complete = true;
-                if((ftdi_usb->tx_immediate) || (ftdi_available_tx_buf(ftdi_usb->ftdi) != 0)) {
-                    ftdi_reset_latency_timer(ftdi_usb->ftdi);
-                    flags |= EventTx;
+                if(ftdi_usb->tx_packet) {
+                    ftdi_usb->tx_packet = false;
+                    ftdi_tx_packet_release(ftdi_usb->ftdi);
                 }
+                flags |= EventTx;
             }
 
             if(flags & EventTxImmediate) {
+                //SEND_IMMEDIATE or latency timer: the partial IN packet goes out too
+                ftdi_tx_flush(ftdi_usb->ftdi);
                 ftdi_usb->tx_immediate = true;
-                if(ftdi_usb->tx_complete) {
-                    flags |= EventTx;
-                }
+                flags |= EventTx;
             }
 
-            if(flags & EventTx) {
-                ftdi_usb->tx_complete = false;
-                ftdi_usb->tx_immediate = false;
-
-                tx_data.status = status[0];
-                len_data = ftdi_available_tx_buf(ftdi_usb->ftdi);
-
-                if(len_data > 0) {
-                    if(len_data > FTDI_USB_TX_MAX_SIZE) {
-                        len_data = FTDI_USB_TX_MAX_SIZE;
-                    }
-                    len_data = ftdi_get_tx_buf(ftdi_usb->ftdi, tx_data.data, len_data);
-                    ftdi_usb_send(dev, (uint8_t*)&tx_data, len_data + FTDI_USB_MODEM_STATUS_SIZE);
-                } else {
-                    ftdi_usb_send(dev, (uint8_t*)&tx_data, FTDI_USB_MODEM_STATUS_SIZE);
+            if((flags & EventTx) && ftdi_usb->tx_complete) {
+                //Full packets are sent back to back, the status alone only when flushing
+                uint8_t* packet = ftdi_tx_packet_get(ftdi_usb->ftdi, &len_data);
+                if(packet) {
+                    ftdi_usb->tx_complete = false;
+                    ftdi_usb->tx_immediate = false;
+                    ftdi_usb->tx_packet = true;
+                    ftdi_reset_latency_timer(ftdi_usb->ftdi);
+                    ftdi_usb_send(dev, packet, len_data);
+                } else if(ftdi_usb->tx_immediate) {
+                    ftdi_usb->tx_complete = false;
+                    ftdi_usb->tx_immediate = false;
+                    tx_status = status[0];
+                    ftdi_usb_send(dev, (uint8_t*)&tx_status, FTDI_USB_MODEM_STATUS_SIZE);
                 }
             }
 
@@ -141,6 +138,16 @@ static void ftdi_usb_callback_tx_immediate(void* context) {
     furi_thread_flags_set(furi_thread_get_id(ftdi_usb->thread), EventTxImmediate);
 }
 
+static void ftdi_usb_callback_rx_free(void* context) {
+    FtdiUsb* ftdi_usb = context;
+    furi_thread_flags_set(furi_thread_get_id(ftdi_usb->thread), EventRx);
+}
+
+static void ftdi_usb_callback_tx_ready(void* context) {
+    FtdiUsb* ftdi_usb = context;
+    furi_thread_flags_set(furi_thread_get_id(ftdi_usb->thread), EventTx);
+}
+
 static void ftdi_usb_init(usbd_device* dev, FuriHalUsbInterface* intf, void* ctx) {
     UNUSED(intf);
     FtdiUsb* ftdi_usb = ctx;
@@ -159,6 +166,8 @@ static void ftdi_usb_init(usbd_device* dev, FuriHalUsbInterface* intf, void* ctx
 
     ftdi_usb->ftdi = ftdi_alloc();
     ftdi_set_callback_tx_immediate(ftdi_usb->ftdi, ftdi_usb_callback_tx_immediate, ftdi_usb);
+    ftdi_set_callback_rx_free(ftdi_usb->ftdi, ftdi_usb_callback_rx_free, ftdi_usb);
+    ftdi_set_callback_tx_ready(ftdi_usb->ftdi, ftdi_usb_callback_tx_ready, ftdi_usb);
 
     furi_thread_start(ftdi_usb->thread);
 }
@@ -177,6 +177,19 @@ typedef enum {
 
 } FtdiMpsseCommands;
 
+/* Bits of the MPSSE shifting commands (opcodes below 0x80) */
+typedef enum {
+    FtdiMpsseShiftWriteNeg = 0x01, /**< Write TDI/DO on negative TCK/SK edge */
+    FtdiMpsseShiftBitmode = 0x02, /**< Write bits, not bytes */
+    FtdiMpsseShiftReadNeg = 0x04, /**< Sample TDO/DI on negative TCK/SK edge */
+    FtdiMpsseShiftLsb = 0x08, /**< LSB first */
+    FtdiMpsseShiftDoWrite = 0x10, /**< Write TDI/DO */
+    FtdiMpsseShiftDoRead = 0x20, /**< Read TDO/DI */
+    FtdiMpsseShiftWriteTms = 0x40, /**< Write TMS/CS */
+} FtdiMpsseShift;
+
+#define FTDI_MPSSE_BAD_COMMAND (0xFAUL) /**< Response to an unknown opcode, followed by it */
+
 /* USB control requests */
 typedef enum {
     FtdiControlRequestsOut = (FtdiControlTypeVendor | FtdiControlRecipientDevice | FtdiControlOut),
@@ -26,12 +26,12 @@ void flip_tdi_scene_about_on_enter(void* context) {
 
     furi_string_cat_printf(temp_str, "\e#%s\n", "What it can do:");
     furi_string_cat_printf(temp_str, "- Emulate FT232H VCP mode\n");
-    furi_string_cat_printf(temp_str, "- Emulate FT232H Async bitbang mode, max freq 50kHz \n");
-    furi_string_cat_printf(temp_str, "- Emulate FT232H Sync bitbang mode, max freq 70kHz \n");
-    furi_string_cat_printf(temp_str, "- Emulate FT232H MPSSE mode, max freq 70kHz \n");
+    furi_string_cat_printf(temp_str, "- Emulate FT232H Async bitbang mode, max freq 1MHz \n");
+    furi_string_cat_printf(temp_str, "- Emulate FT232H Sync bitbang mode, max freq 1MHz \n");
+    furi_string_cat_printf(temp_str, "- Emulate FT232H MPSSE mode, clock set by the host\n");
+    furi_string_cat_printf(temp_str, "- Emulate FT232H JTAG mode (OpenOCD ftdi driver)\n");
     furi_string_cat_printf(
-        temp_str,
-        "- Emulate FT232H SPI mode (half duplex), fix freq 2MHz, max block size 4096 byte\n");
+        temp_str, "- Emulate FT232H SPI mode, up to 32MHz with hardware SPI (HW SPI pinout)\n");
 
     widget_add_text_box_element(
         app->widget,
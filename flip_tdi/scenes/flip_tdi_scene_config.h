@@ -3,4 +3,5 @@ ADD_SCENE(flip_tdi, menu, Menu)
 ADD_SCENE(flip_tdi, wiring_uart, WiringUart)
 ADD_SCENE(flip_tdi, wiring_spi, WiringSpi)
 ADD_SCENE(flip_tdi, wiring_gpio, WiringGpio)
+ADD_SCENE(flip_tdi, pinout, Pinout)
 ADD_SCENE(flip_tdi, about, About)
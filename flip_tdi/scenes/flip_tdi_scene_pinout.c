@@ -0,0 +1,41 @@
+#include "../flip_tdi_app_i.h"
+
+static const char* const flip_tdi_scene_pinout_text[FtdiGpioPinoutCount] = {
+    "FT232H",
+    "HW SPI",
+};
+
+static void flip_tdi_scene_pinout_set_pinout(VariableItem* item) {
+    uint8_t index = variable_item_get_current_value_index(item);
+
+    variable_item_set_current_value_text(item, flip_tdi_scene_pinout_text[index]);
+    ftdi_gpio_set_pinout(index);
+}
+
+void flip_tdi_scene_pinout_on_enter(void* context) {
+    furi_assert(context);
+
+    FlipTDIApp* app = context;
+    VariableItemList* variable_item_list = app->variable_item_list;
+    FtdiGpioPinout pinout = ftdi_gpio_get_pinout();
+
+    VariableItem* item = variable_item_list_add(
+        variable_item_list, "Pinout", FtdiGpioPinoutCount, flip_tdi_scene_pinout_set_pinout, app);
+    variable_item_set_current_value_index(item, pinout);
+    variable_item_set_current_value_text(item, flip_tdi_scene_pinout_text[pinout]);
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, FlipTDIViewVariableItemList);
+}
+
+bool flip_tdi_scene_pinout_on_event(void* context, SceneManagerEvent event) {
+    UNUSED(context);
+    UNUSED(event);
+    return false;
+}
+
+void flip_tdi_scene_pinout_on_exit(void* context) {
+    furi_assert(context);
+
+    FlipTDIApp* app = context;
+    variable_item_list_reset(app->variable_item_list);
+}
@@ -4,7 +4,18 @@ void flip_tdi_scene_wiring_spi_on_enter(void* context) {
     furi_assert(context);
 
     FlipTDIApp* app = context;
-    widget_add_icon_element(app->widget, 0, 0, &I_flip_tdi_wiring_spi);
+    if(ftdi_gpio_get_pinout() == FtdiGpioPinoutSpi) {
+        widget_add_string_multiline_element(
+            app->widget,
+            64,
+            32,
+            AlignCenter,
+            AlignCenter,
+            FontSecondary,
+            "HW SPI pinout\n2(A7): MOSI  3(A6): MISO\n4(A4): CS  5(B3): SCK\n8,18: GND");
+    } else {
+        widget_add_icon_element(app->widget, 0, 0, &I_flip_tdi_wiring_spi);
+    }
     view_dispatcher_switch_to_view(app->view_dispatcher, FlipTDIViewWidget);
 }
 
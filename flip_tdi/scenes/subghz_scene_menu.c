@@ -18,6 +18,8 @@ void flip_tdi_scene_menu_on_enter(void* context) {
         submenu, "WiringSpi", SubmenuIndexWiringSpi, flip_tdi_scene_menu_submenu_callback, app);
     submenu_add_item(
         submenu, "WiringGpio", SubmenuIndexWiringGpio, flip_tdi_scene_menu_submenu_callback, app);
+    submenu_add_item(
+        submenu, "Pinout", SubmenuIndexPinout, flip_tdi_scene_menu_submenu_callback, app);
     submenu_add_item(
         submenu, "About", SubmenuIndexAbout, flip_tdi_scene_menu_submenu_callback, app);
 
@@ -45,6 +47,9 @@ bool flip_tdi_scene_menu_on_event(void* context, SceneManagerEvent event) {
         } else if(event.event == SubmenuIndexWiringGpio) {
             scene_manager_next_scene(app->scene_manager, FlipTDISceneWiringGpio);
             consumed = true;
+        } else if(event.event == SubmenuIndexPinout) {
+            scene_manager_next_scene(app->scene_manager, FlipTDIScenePinout);
+            consumed = true;
         }
         scene_manager_set_scene_state(app->scene_manager, FlipTDIViewSubmenu, event.event);
     }
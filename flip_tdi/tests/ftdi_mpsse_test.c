@@ -0,0 +1,500 @@
+/*
+ * Host test of the MPSSE command decoder in helpers/ftdi_mpsse.c.
+ * The USB packet pool, SPI1 and the pins are replaced by the models below,
+ * the pins drive a small JTAG/SPI target that samples MOSI and TMS on rising TCK
+ * and shifts its MISO pattern on falling TCK.
+ */
+#include <furi.h>
+#include <furi_hal.h>
+
+#include "../helpers/ftdi_mpsse.h"
+#include "../helpers/ftdi_gpio.h"
+#include "../helpers/ftdi_spi.h"
+
+#define TEST_TX_SIZE    (1024UL)
+#define TEST_TRACE_SIZE (64UL)
+#define TEST_PASSES_MAX (1000UL)
+#define TEST_BAD        (0xAAU) // Unknown opcode sent after every command
+
+static int test_failures = 0;
+
+#define CHECK(expr)                                                         \
+    do {                                                                    \
+        if(!(expr)) {                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            test_failures++;                                                \
+        }                                                                   \
+    } while(0)
+
+//Pins and the target
+
+typedef struct {
+    uint8_t mosi;
+    uint8_t tms;
+    uint32_t cycle;
+} TestEdge;
+
+static struct {
+    uint8_t level[FTDI_GPIO_COUNT];
+    uint8_t gpiol1;
+    uint8_t miso[TEST_TRACE_SIZE];
+    size_t miso_len;
+    size_t miso_pos;
+    TestEdge rise[TEST_TRACE_SIZE];
+    size_t rise_count;
+} test_pins;
+
+static HostDwt test_dwt;
+static GPIO_TypeDef test_port;
+static FtdiGpioPinout test_pinout = FtdiGpioPinoutFtdi;
+
+GpioPin ftdi_gpio_pins[FTDI_GPIO_COUNT] = {
+    {&test_port, 1 << 0},
+    {&test_port, 1 << 1},
+    {&test_port, 1 << 2},
+    {&test_port, 1 << 3},
+    {&test_port, 1 << 4},
+    {&test_port, 1 << 5},
+    {&test_port, 1 << 6},
+    {&test_port, 1 << 7},
+};
+
+HostDwt* host_dwt(void) {
+    test_dwt.CYCCNT++;
+    return &test_dwt;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 64;
+}
+
+static size_t test_pin_index(const GpioPin* gpio) {
+    return __builtin_ctz(gpio->pin);
+}
+
+void ftdi_gpio_write(const GpioPin* gpio, uint8_t state) {
+    size_t index = test_pin_index(gpio);
+    uint8_t level = state ? 1 : 0;
+    uint8_t old = test_pins.level[index];
+    test_pins.level[index] = level;
+    if(index != 0 || old == level) return;
+
+    if(level) {
+        if(test_pins.rise_count < TEST_TRACE_SIZE) {
+            TestEdge* edge = &test_pins.rise[test_pins.rise_count];
+            edge->mosi = test_pins.level[1];
+            edge->tms = test_pins.level[3];
+            edge->cycle = test_dwt.CYCCNT;
+        }
+        test_pins.rise_count++;
+    } else if(test_pins.miso_pos < test_pins.miso_len) {
+        test_pins.miso_pos++;
+    }
+}
+
+bool ftdi_gpio_read(const GpioPin* gpio) {
+    size_t index = test_pin_index(gpio);
+    if(index == 2) {
+        //The target pulls MISO high once its pattern is out
+        if(test_pins.miso_pos >= test_pins.miso_len) return true;
+        return test_pins.miso[test_pins.miso_pos];
+    }
+    if(index == 5) return test_pins.gpiol1;
+    return test_pins.level[index];
+}
+
+void ftdi_gpio_set_direction(uint8_t gpio_mask) {
+    UNUSED(gpio_mask);
+}
+
+void ftdi_gpio_init(uint8_t gpio_mask) {
+    UNUSED(gpio_mask);
+}
+
+void ftdi_gpio_deinit(void) {
+}
+
+FtdiGpioPinout ftdi_gpio_get_active_pinout(void) {
+    return test_pinout;
+}
+
+static void test_pins_reset(const char* miso) {
+    memset(&test_pins, 0, sizeof(test_pins));
+    for(; miso && *miso; miso++) {
+        test_pins.miso[test_pins.miso_len++] = (*miso == '1');
+    }
+}
+
+//SPI1, every configuration is refused so the data goes out on the pins
+
+struct FtdiSpi {
+    uint32_t clock;
+    size_t configs;
+};
+
+static struct FtdiSpi test_spi;
+
+FtdiSpi* ftdi_spi_alloc(void) {
+    memset(&test_spi, 0, sizeof(test_spi));
+    return &test_spi;
+}
+
+void ftdi_spi_free(FtdiSpi* ftdi_spi) {
+    UNUSED(ftdi_spi);
+}
+
+bool ftdi_spi_set_config(FtdiSpi* ftdi_spi, uint32_t clock, bool cpol, bool cpha, bool lsb) {
+    UNUSED(cpol);
+    UNUSED(cpha);
+    UNUSED(lsb);
+    ftdi_spi->clock = clock;
+    ftdi_spi->configs++;
+    return false;
+}
+
+bool ftdi_spi_trx(FtdiSpi* ftdi_spi, uint8_t* tx_data, uint8_t* rx_data, size_t size) {
+    UNUSED(ftdi_spi);
+    UNUSED(tx_data);
+    UNUSED(rx_data);
+    UNUSED(size);
+    return false;
+}
+
+//USB packet pool, OUT data is cut into packets of a chosen size to split the commands
+
+struct Ftdi {
+    const uint8_t* rx;
+    uint32_t rx_size;
+    uint32_t rx_pos;
+    uint32_t rx_packet;
+    uint8_t tx[TEST_TX_SIZE];
+    uint32_t tx_size;
+    size_t immediate;
+};
+
+const uint8_t* ftdi_rx_packet_peek(Ftdi* ftdi, uint32_t* size) {
+    if(ftdi->rx_pos >= ftdi->rx_size) return NULL;
+    uint32_t packet_end = (ftdi->rx_pos / ftdi->rx_packet + 1) * ftdi->rx_packet;
+    *size = MIN(packet_end, ftdi->rx_size) - ftdi->rx_pos;
+    return &ftdi->rx[ftdi->rx_pos];
+}
+
+void ftdi_rx_packet_consume(Ftdi* ftdi, uint32_t size) {
+    furi_check(ftdi->rx_pos + size <= ftdi->rx_size);
+    ftdi->rx_pos += size;
+}
+
+uint8_t* ftdi_tx_packet_claim(Ftdi* ftdi, uint32_t* size) {
+    *size = FTDI_PACKET_PAYLOAD_SIZE - ftdi->tx_size % FTDI_PACKET_PAYLOAD_SIZE;
+    *size = MIN(*size, TEST_TX_SIZE - ftdi->tx_size);
+    return *size ? &ftdi->tx[ftdi->tx_size] : NULL;
+}
+
+void ftdi_tx_packet_commit(Ftdi* ftdi, uint32_t size) {
+    ftdi->tx_size += size;
+}
+
+uint32_t ftdi_set_tx_buf(Ftdi* ftdi, const uint8_t* data, uint32_t size) {
+    furi_check(ftdi->tx_size + size <= TEST_TX_SIZE);
+    memcpy(&ftdi->tx[ftdi->tx_size], data, size);
+    ftdi->tx_size += size;
+    return size;
+}
+
+uint32_t ftdi_available_tx_space(Ftdi* ftdi) {
+    return TEST_TX_SIZE - ftdi->tx_size;
+}
+
+static void test_immediate_callback(void* context) {
+    Ftdi* ftdi = context;
+    ftdi->immediate++;
+}
+
+//Runner
+
+typedef struct {
+    Ftdi ftdi;
+    FtdiMpsse* mpsse;
+} TestContext;
+
+static void test_start(TestContext* test) {
+    memset(&test->ftdi, 0, sizeof(test->ftdi));
+    test->mpsse = ftdi_mpsse_alloc(&test->ftdi);
+    ftdi_mpsse_gpio_set_callback(test->mpsse, test_immediate_callback, &test->ftdi);
+}
+
+static void test_stop(TestContext* test) {
+    ftdi_mpsse_free(test->mpsse);
+}
+
+/** Feeds the commands in packets of packet_size bytes, runs the engine until they are used up */
+static void test_run(TestContext* test, const uint8_t* data, size_t size, uint32_t packet_size) {
+    test->ftdi.rx = data;
+    test->ftdi.rx_size = size;
+    test->ftdi.rx_pos = 0;
+    test->ftdi.rx_packet = packet_size;
+    test->ftdi.tx_size = 0;
+
+    for(size_t pass = 0; pass < TEST_PASSES_MAX; pass++) {
+        bool is_done = ftdi_mpsse_process(test->mpsse);
+        if(is_done && test->ftdi.rx_pos == test->ftdi.rx_size) return;
+    }
+    printf(
+        "engine stalled at byte %lu of %lu\n",
+        (unsigned long)test->ftdi.rx_pos,
+        (unsigned long)size);
+    test_failures++;
+}
+
+//Tests
+
+typedef struct {
+    uint8_t data[8];
+    uint8_t size; // Command, parameters and the data of byte shifts
+    uint8_t response; // Bytes the command sends back
+    uint8_t gpiol1; // Level that completes the wait opcodes
+} TestCommand;
+
+static const TestCommand test_commands[] = {
+    //GPIO and modes
+    {{0x80, 0x00, 0x00}, 3, 0, 0},
+    {{0x81}, 1, 1, 0},
+    {{0x82, 0x00, 0x00}, 3, 0, 0},
+    {{0x83}, 1, 1, 0},
+    {{0x84}, 1, 0, 0},
+    {{0x85}, 1, 0, 0},
+    {{0x86, 0x00, 0x00}, 3, 0, 0},
+    {{0x87}, 1, 0, 0},
+    {{0x8A}, 1, 0, 0},
+    {{0x8B}, 1, 0, 0},
+    {{0x8C}, 1, 0, 0},
+    {{0x8D}, 1, 0, 0},
+    {{0x96}, 1, 0, 0},
+    {{0x97}, 1, 0, 0},
+    //Clocks and waits
+    {{0x88}, 1, 0, 1},
+    {{0x89}, 1, 0, 0},
+    {{0x8E, 0x07}, 2, 0, 0},
+    {{0x8F, 0x01, 0x00}, 3, 0, 0},
+    {{0x94}, 1, 0, 1},
+    {{0x95}, 1, 0, 0},
+    {{0x9C, 0x00, 0x00}, 3, 0, 1},
+    {{0x9D, 0x00, 0x00}, 3, 0, 0},
+    //Parsed but not supported
+    {{0x90, 0x00}, 2, 0, 0},
+    {{0x91, 0x00, 0x00}, 3, 0, 0},
+    {{0x92, 0x00, 0x00}, 3, 0, 0},
+    {{0x93, 0x00, 0x00, 0x00}, 4, 0, 0},
+    {{0x9E, 0x00, 0x00}, 3, 0, 0},
+    //Shifts
+    {{0x10, 0x00, 0x00, 0x55}, 4, 0, 0},
+    {{0x19, 0x01, 0x00, 0x12, 0x34}, 5, 0, 0},
+    {{0x12, 0x07, 0x55}, 3, 0, 0},
+    {{0x20, 0x02, 0x00}, 3, 3, 0},
+    {{0x22, 0x07}, 2, 1, 0},
+    {{0x2E, 0x03}, 2, 1, 0},
+    {{0x31, 0x00, 0x00, 0x55}, 4, 1, 0},
+    {{0x3B, 0x03, 0x55}, 3, 1, 0},
+    {{0x4B, 0x06, 0x7F}, 3, 0, 0},
+    {{0x6B, 0x02, 0x03}, 3, 1, 0},
+};
+
+//Opcodes that must be answered with 0xFA and the opcode
+static const uint8_t test_bad_commands[] = {
+    0x00, // Shift that neither writes nor reads
+    0x48, // TMS shift in byte mode
+    0x5A, // TMS shift that also writes TDI
+    0x98,
+    0xAB,
+    0xFF,
+};
+
+static void test_command_sizes(void) {
+    static const uint32_t packet_sizes[] = {FTDI_PACKET_SIZE, 1};
+    for(size_t p = 0; p < COUNT_OF(packet_sizes); p++) {
+        for(size_t i = 0; i < COUNT_OF(test_commands); i++) {
+            const TestCommand* command = &test_commands[i];
+            uint8_t data[sizeof(command->data) + 1];
+            memcpy(data, command->data, command->size);
+            data[command->size] = TEST_BAD;
+
+            TestContext test;
+            test_start(&test);
+            test_pins_reset(NULL);
+            test_pins.gpiol1 = command->gpiol1;
+            test_run(&test, data, command->size + 1, packet_sizes[p]);
+
+            //A wrong size runs the next command from the parameters or eats the bad opcode
+            uint32_t tx_size = test.ftdi.tx_size;
+            bool is_ok = (tx_size == command->response + 2U) &&
+                         (test.ftdi.tx[tx_size - 2] == FTDI_MPSSE_BAD_COMMAND) &&
+                         (test.ftdi.tx[tx_size - 1] == TEST_BAD);
+            if(!is_ok) {
+                printf(
+                    "opcode 0x%02X, packet size %lu: %lu bytes back\n",
+                    command->data[0],
+                    (unsigned long)packet_sizes[p],
+                    (unsigned long)tx_size);
+            }
+            CHECK(is_ok);
+            test_stop(&test);
+        }
+    }
+}
+
+static void test_bad_command(void) {
+    for(size_t i = 0; i < COUNT_OF(test_bad_commands); i++) {
+        //The decoder resynchronizes, the GPIO read after the bad opcode still runs
+        uint8_t data[] = {test_bad_commands[i], 0x81};
+        TestContext test;
+        test_start(&test);
+        test_pins_reset(NULL);
+        test_run(&test, data, sizeof(data), FTDI_PACKET_SIZE);
+
+        CHECK(test.ftdi.tx_size == 3);
+        CHECK(test.ftdi.tx[0] == FTDI_MPSSE_BAD_COMMAND);
+        CHECK(test.ftdi.tx[1] == test_bad_commands[i]);
+        //The reply goes out at once, without SEND_IMMEDIATE
+        CHECK(test.ftdi.immediate == 1);
+        test_stop(&test);
+    }
+}
+
+static void test_check_rise(size_t index, uint8_t mosi, uint8_t tms) {
+    CHECK(test_pins.rise[index].mosi == mosi);
+    CHECK(test_pins.rise[index].tms == tms);
+}
+
+static void test_bit_shift(void) {
+    //CLK and MOSI low, TMS high, then 4 bits of 0xA0 out on -ve TCK, in on +ve TCK, MSB first
+    static const uint8_t msb[] = {0x80, 0x08, 0x0B, 0x33, 0x03, 0xA0};
+    TestContext test;
+    test_start(&test);
+    test_pins_reset("1100");
+    test_run(&test, msb, sizeof(msb), FTDI_PACKET_SIZE);
+    CHECK(test_pins.rise_count == 4);
+    test_check_rise(0, 1, 1);
+    test_check_rise(1, 0, 1);
+    test_check_rise(2, 1, 1);
+    test_check_rise(3, 0, 1);
+    CHECK(test_pins.level[0] == 0);
+    //MSB first reads fill the low bits
+    CHECK(test.ftdi.tx_size == 1);
+    CHECK(test.ftdi.tx[0] == 0x0C);
+    test_stop(&test);
+
+    //Same bits LSB first, the reads fill the high bits
+    static const uint8_t lsb[] = {0x80, 0x08, 0x0B, 0x3B, 0x03, 0x05};
+    test_start(&test);
+    test_pins_reset("1100");
+    test_run(&test, lsb, sizeof(lsb), FTDI_PACKET_SIZE);
+    CHECK(test_pins.rise_count == 4);
+    test_check_rise(0, 1, 1);
+    test_check_rise(1, 0, 1);
+    test_check_rise(2, 1, 1);
+    test_check_rise(3, 0, 1);
+    CHECK(test.ftdi.tx_size == 1);
+    CHECK(test.ftdi.tx[0] == 0x30);
+    test_stop(&test);
+
+    //Clock-only opcodes: 3 bits, then 2 bytes
+    static const uint8_t clock[] = {0x80, 0x00, 0x0B, 0x8E, 0x02, 0x8F, 0x01, 0x00};
+    test_start(&test);
+    test_pins_reset(NULL);
+    test_run(&test, clock, sizeof(clock), FTDI_PACKET_SIZE);
+    CHECK(test_pins.rise_count == 3 + 16);
+    CHECK(test.ftdi.tx_size == 0);
+    test_stop(&test);
+}
+
+static void test_tms_shift(void) {
+    //TMS 1, 0, 1 LSB first with TDI held high by bit 7, TDO in on +ve TCK
+    static const uint8_t rw[] = {0x80, 0x00, 0x0B, 0x6B, 0x02, 0x85};
+    TestContext test;
+    test_start(&test);
+    test_pins_reset("110");
+    test_run(&test, rw, sizeof(rw), FTDI_PACKET_SIZE);
+    CHECK(test_pins.rise_count == 3);
+    test_check_rise(0, 1, 1);
+    test_check_rise(1, 1, 0);
+    test_check_rise(2, 1, 1);
+    CHECK(test.ftdi.tx_size == 1);
+    CHECK(test.ftdi.tx[0] == 0x60);
+    test_stop(&test);
+
+    //Test-Logic-Reset: 7 bits of TMS high with TDI low, nothing comes back
+    static const uint8_t reset[] = {0x80, 0x00, 0x0B, 0x4B, 0x06, 0x7F};
+    test_start(&test);
+    test_pins_reset(NULL);
+    test_run(&test, reset, sizeof(reset), FTDI_PACKET_SIZE);
+    CHECK(test_pins.rise_count == 7);
+    for(size_t i = 0; i < 7; i++) {
+        test_check_rise(i, 0, 1);
+    }
+    CHECK(test.ftdi.tx_size == 0);
+    test_stop(&test);
+}
+
+/** TCK of one byte write: the clock handed to SPI1 and the spacing of the rising edges */
+static void test_tck(TestContext* test, const uint8_t* config, size_t size, uint32_t clock) {
+    uint8_t data[8];
+    static const uint8_t write[] = {0x11, 0x00, 0x00, 0x55};
+    memcpy(data, config, size);
+    memcpy(&data[size], write, sizeof(write));
+
+    test_pins_reset(NULL);
+    test_run(test, data, size + sizeof(write), FTDI_PACKET_SIZE);
+    CHECK(test_spi.clock == clock);
+    CHECK(test_pins.rise_count == 8);
+
+    uint32_t period = 64000000UL / clock;
+    uint32_t spacing = test_pins.rise[7].cycle - test_pins.rise[6].cycle;
+    if(spacing < period || spacing > period + 4) {
+        printf(
+            "%lu Hz: %lu cycles per TCK, expected %lu\n",
+            (unsigned long)clock,
+            (unsigned long)spacing,
+            (unsigned long)period);
+    }
+    CHECK(spacing >= period && spacing <= period + 4);
+}
+
+static void test_tck_divisor(void) {
+    //SPI pinout, so every byte shift offers its clock to SPI1
+    test_pinout = FtdiGpioPinoutSpi;
+    TestContext test;
+    test_start(&test);
+
+    static const uint8_t start[] = {0x80, 0x00, 0x0B};
+    test_tck(&test, start, sizeof(start), 6000000UL);
+
+    static const uint8_t div5_off[] = {0x8A, 0x86, 0x05, 0x00};
+    test_tck(&test, div5_off, sizeof(div5_off), 5000000UL);
+
+    static const uint8_t div5_on[] = {0x8B};
+    test_tck(&test, div5_on, sizeof(div5_on), 1000000UL);
+
+    static const uint8_t slowest[] = {0x86, 0xFF, 0xFF};
+    test_tck(&test, slowest, sizeof(slowest), 91UL);
+
+    static const uint8_t fastest[] = {0x8A, 0x86, 0x00, 0x00};
+    test_tck(&test, fastest, sizeof(fastest), 30000000UL);
+
+    test_stop(&test);
+    test_pinout = FtdiGpioPinoutFtdi;
+}
+
+int main(void) {
+    test_command_sizes();
+    test_bad_command();
+    test_bit_shift();
+    test_tms_shift();
+    test_tck_divisor();
+
+    if(test_failures) {
+        printf("%d checks failed\n", test_failures);
+        return 1;
+    }
+    printf("MPSSE tests passed\n");
+    return 0;
+}
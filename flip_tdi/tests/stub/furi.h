@@ -0,0 +1,25 @@
+#pragma once
+//Just enough of the Furi API for a host build of the MPSSE engine
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Flipper malloc returns zeroed memory, the engine relies on it
+#define malloc(size) calloc(1, (size))
+
+#define UNUSED(x) (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+#define furi_assert(x) ((x) ? (void)0 : abort())
+#define furi_check(x) furi_assert(x)
+
+#define FURI_LOG_E(tag, ...) UNUSED(tag)
+#define FURI_LOG_W(tag, ...) UNUSED(tag)
+#define FURI_LOG_I(tag, ...) UNUSED(tag)
+#define FURI_LOG_D(tag, ...) UNUSED(tag)
+#define FURI_LOG_RAW_I(...) printf(__VA_ARGS__)
@@ -0,0 +1,23 @@
+#pragma once
+//Pins and the DWT cycle counter of the host build, the pin levels live in mpsse_test.c
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t IDR;
+} GPIO_TypeDef;
+
+typedef struct {
+    GPIO_TypeDef* port;
+    uint16_t pin;
+} GpioPin;
+
+typedef struct {
+    uint32_t CYCCNT;
+} HostDwt;
+
+//Every read of the counter advances it by one cycle
+HostDwt* host_dwt(void);
+#define DWT (host_dwt())
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <furi.h>
+
+#define SPI_MEM_HASH_MAGIC 0x48534D53 // "SMSH"
+#define SPI_MEM_HASH_VERSION 2
+#define SPI_MEM_HASH_SHA256_SIZE 32
+
+typedef struct SPIMemHash SPIMemHash;
+
+// Sidecar header, followed by one little-endian CRC32 per sector
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t image_size;
+    uint32_t sector_size;
+    // The dump file as it was when the sidecar was written, a rewritten or edited dump won't match
+    uint32_t dump_size;
+    uint32_t dump_timestamp;
+    uint8_t sha256[SPI_MEM_HASH_SHA256_SIZE];
+} SPIMemHashHeader;
+
+SPIMemHash* spi_mem_hash_alloc(void);
+void spi_mem_hash_free(SPIMemHash* hash);
+void spi_mem_hash_start(SPIMemHash* hash);
+uint32_t spi_mem_hash_update(SPIMemHash* hash, const uint8_t* data, size_t size);
+void spi_mem_hash_finish(SPIMemHash* hash, uint8_t* sha256);
+size_t spi_mem_hash_get_sector_count(const SPIMemHashHeader* header);
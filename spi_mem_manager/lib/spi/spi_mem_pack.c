@@ -0,0 +1,308 @@
+#include "spi_mem_pack.h"
+
+#define SPI_MEM_PACK_INDEX_BATCH 64
+#define SPI_MEM_PACK_HASH_LOG 10
+#define SPI_MEM_PACK_LZ4_MIN_MATCH 4
+#define SPI_MEM_PACK_LZ4_LAST_LITERALS 5
+#define SPI_MEM_PACK_LZ4_MF_LIMIT 12
+
+struct SPIMemPack {
+    size_t block_size;
+    SPIMemPackHeader header;
+    uint32_t block_index;
+    uint32_t data_offset;
+    SPIMemPackIndexEntry index[SPI_MEM_PACK_INDEX_BATCH];
+    uint16_t hash_table[1 << SPI_MEM_PACK_HASH_LOG];
+    uint8_t* buffer;
+};
+
+SPIMemPack* spi_mem_pack_alloc(size_t block_size) {
+    furi_check(block_size <= UINT16_MAX);
+    SPIMemPack* pack = malloc(sizeof(SPIMemPack));
+    pack->block_size = block_size;
+    pack->buffer = malloc(block_size);
+    return pack;
+}
+
+void spi_mem_pack_free(SPIMemPack* pack) {
+    free(pack->buffer);
+    free(pack);
+}
+
+// LZ4 block format, see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+static uint32_t spi_mem_pack_read_u32(const uint8_t* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t spi_mem_pack_hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - SPI_MEM_PACK_HASH_LOG);
+}
+
+static bool spi_mem_pack_lz4_put_length(uint8_t** dst, const uint8_t* dst_end, size_t length) {
+    while(length >= 255) {
+        if(*dst >= dst_end) return false;
+        *(*dst)++ = 255;
+        length -= 255;
+    }
+    if(*dst >= dst_end) return false;
+    *(*dst)++ = length;
+    return true;
+}
+
+static bool spi_mem_pack_lz4_put_sequence(
+    uint8_t** dst,
+    const uint8_t* dst_end,
+    const uint8_t* literals,
+    size_t literals_size,
+    size_t offset,
+    size_t match_size) {
+    if(*dst >= dst_end) return false;
+    uint8_t* token = (*dst)++;
+    *token = MIN(literals_size, 15U) << 4;
+    if(literals_size >= 15) {
+        if(!spi_mem_pack_lz4_put_length(dst, dst_end, literals_size - 15)) return false;
+    }
+    if((size_t)(dst_end - *dst) < literals_size) return false;
+    memcpy(*dst, literals, literals_size);
+    *dst += literals_size;
+    if(match_size == 0) return true; // last sequence carries literals only
+    if((dst_end - *dst) < 2) return false;
+    *(*dst)++ = offset & 0xFF;
+    *(*dst)++ = offset >> 8;
+    size_t match_code = match_size - SPI_MEM_PACK_LZ4_MIN_MATCH;
+    *token |= MIN(match_code, 15U);
+    if(match_code >= 15) {
+        if(!spi_mem_pack_lz4_put_length(dst, dst_end, match_code - 15)) return false;
+    }
+    return true;
+}
+
+size_t spi_mem_pack_lz4_encode(
+    SPIMemPack* pack,
+    const uint8_t* src,
+    size_t src_size,
+    uint8_t* dst,
+    size_t dst_capacity) {
+    uint8_t* out = dst;
+    const uint8_t* out_end = dst + dst_capacity;
+    size_t anchor = 0;
+    size_t pos = 0;
+    memset(pack->hash_table, 0, sizeof(pack->hash_table));
+    if(src_size > SPI_MEM_PACK_LZ4_MF_LIMIT) {
+        size_t match_start_limit = src_size - SPI_MEM_PACK_LZ4_MF_LIMIT;
+        size_t match_end_limit = src_size - SPI_MEM_PACK_LZ4_LAST_LITERALS;
+        while(pos < match_start_limit) {
+            uint32_t sequence = spi_mem_pack_read_u32(&src[pos]);
+            uint32_t hash = spi_mem_pack_hash(sequence);
+            size_t ref = pack->hash_table[hash];
+            pack->hash_table[hash] = pos;
+            if(ref >= pos || spi_mem_pack_read_u32(&src[ref]) != sequence) {
+                pos++;
+                continue;
+            }
+            size_t match_size = SPI_MEM_PACK_LZ4_MIN_MATCH;
+            while((pos + match_size < match_end_limit) &&
+                  (src[ref + match_size] == src[pos + match_size])) {
+                match_size++;
+            }
+            if(!spi_mem_pack_lz4_put_sequence(
+                   &out, out_end, &src[anchor], pos - anchor, pos - ref, match_size))
+                return 0;
+            pos += match_size;
+            anchor = pos;
+        }
+    }
+    if(!spi_mem_pack_lz4_put_sequence(&out, out_end, &src[anchor], src_size - anchor, 0, 0))
+        return 0;
+    return out - dst;
+}
+
+static bool spi_mem_pack_lz4_get_length(
+    const uint8_t** src,
+    const uint8_t* src_end,
+    size_t* length) {
+    uint8_t byte;
+    do {
+        if(*src >= src_end) return false;
+        byte = *(*src)++;
+        *length += byte;
+    } while(byte == 255);
+    return true;
+}
+
+bool spi_mem_pack_lz4_decode(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size) {
+    const uint8_t* src_end = src + src_size;
+    size_t pos = 0;
+    while(src < src_end) {
+        uint8_t token = *src++;
+        size_t literals_size = token >> 4;
+        if(literals_size == 15) {
+            if(!spi_mem_pack_lz4_get_length(&src, src_end, &literals_size)) return false;
+        }
+        if((size_t)(src_end - src) < literals_size) return false;
+        if(dst_size - pos < literals_size) return false;
+        memcpy(&dst[pos], src, literals_size);
+        src += literals_size;
+        pos += literals_size;
+        if(src == src_end) break;
+        if((src_end - src) < 2) return false;
+        size_t offset = src[0] | (src[1] << 8);
+        src += 2;
+        if(offset == 0 || offset > pos) return false;
+        size_t match_size = token & 0x0F;
+        if(match_size == 15) {
+            if(!spi_mem_pack_lz4_get_length(&src, src_end, &match_size)) return false;
+        }
+        match_size += SPI_MEM_PACK_LZ4_MIN_MATCH;
+        if(dst_size - pos < match_size) return false;
+        // byte by byte, matches may overlap the bytes they produce
+        for(size_t i = 0; i < match_size; i++, pos++) {
+            dst[pos] = dst[pos - offset];
+        }
+    }
+    return pos == dst_size;
+}
+
+static bool spi_mem_pack_is_erased(const uint8_t* data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        if(data[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+static uint32_t spi_mem_pack_get_index_offset(uint32_t block_index) {
+    return sizeof(SPIMemPackHeader) + block_index * sizeof(SPIMemPackIndexEntry);
+}
+
+static size_t spi_mem_pack_get_expected_size(SPIMemPack* pack) {
+    size_t offset = pack->block_index * pack->header.block_size;
+    if(offset >= pack->header.image_size) return 0;
+    return MIN(pack->header.block_size, pack->header.image_size - offset);
+}
+
+static bool spi_mem_pack_flush_index(SPIMemPack* pack, File* file) {
+    uint32_t batch_size = pack->block_index % SPI_MEM_PACK_INDEX_BATCH;
+    if(batch_size == 0) batch_size = SPI_MEM_PACK_INDEX_BATCH;
+    uint32_t batch_start = pack->block_index - batch_size;
+    size_t index_size = batch_size * sizeof(SPIMemPackIndexEntry);
+    if(!storage_file_seek(file, spi_mem_pack_get_index_offset(batch_start), true)) return false;
+    if(storage_file_write(file, pack->index, index_size) != index_size) return false;
+    return storage_file_seek(file, pack->data_offset, true);
+}
+
+bool spi_mem_pack_write_start(SPIMemPack* pack, File* file, size_t image_size) {
+    pack->header.magic = SPI_MEM_PACK_MAGIC;
+    pack->header.version = SPI_MEM_PACK_VERSION;
+    pack->header.reserved = 0;
+    pack->header.image_size = image_size;
+    pack->header.block_size = pack->block_size;
+    pack->header.block_count = (image_size + pack->block_size - 1) / pack->block_size;
+    pack->block_index = 0;
+    pack->data_offset = spi_mem_pack_get_index_offset(pack->header.block_count);
+    if(storage_file_write(file, &pack->header, sizeof(SPIMemPackHeader)) !=
+       sizeof(SPIMemPackHeader))
+        return false;
+    // index slots are skipped here and filled in batches as blocks arrive
+    return storage_file_seek(file, pack->data_offset, true);
+}
+
+bool spi_mem_pack_write_block(SPIMemPack* pack, File* file, const uint8_t* data, size_t size) {
+    if(size != spi_mem_pack_get_expected_size(pack)) return false;
+    SPIMemPackIndexEntry* entry = &pack->index[pack->block_index % SPI_MEM_PACK_INDEX_BATCH];
+    const uint8_t* payload = data;
+    entry->reserved = 0;
+    entry->size = size;
+    if(spi_mem_pack_is_erased(data, size)) {
+        entry->type = SPIMemPackBlockTypeErased;
+        entry->size = 0;
+    } else {
+        entry->type = SPIMemPackBlockTypeRaw;
+        size_t packed_size = spi_mem_pack_lz4_encode(pack, data, size, pack->buffer, size - 1);
+        if(packed_size) {
+            entry->type = SPIMemPackBlockTypeLZ4;
+            entry->size = packed_size;
+            payload = pack->buffer;
+        }
+    }
+    if(entry->size) {
+        if(storage_file_write(file, payload, entry->size) != entry->size) return false;
+        pack->data_offset += entry->size;
+    }
+    pack->block_index++;
+    if((pack->block_index % SPI_MEM_PACK_INDEX_BATCH) == 0) {
+        return spi_mem_pack_flush_index(pack, file);
+    }
+    return true;
+}
+
+bool spi_mem_pack_write_end(SPIMemPack* pack, File* file) {
+    if((pack->block_index % SPI_MEM_PACK_INDEX_BATCH) != 0) {
+        if(!spi_mem_pack_flush_index(pack, file)) return false;
+    }
+    // image may be shorter than announced if reading was interrupted
+    pack->header.image_size =
+        MIN(pack->header.image_size, pack->block_index * pack->header.block_size);
+    if(!storage_file_seek(file, 0, true)) return false;
+    return storage_file_write(file, &pack->header, sizeof(SPIMemPackHeader)) ==
+           sizeof(SPIMemPackHeader);
+}
+
+bool spi_mem_pack_read_header(File* file, SPIMemPackHeader* header) {
+    bool success = false;
+    do {
+        if(!storage_file_seek(file, 0, true)) break;
+        if(storage_file_read(file, header, sizeof(SPIMemPackHeader)) != sizeof(SPIMemPackHeader))
+            break;
+        if(header->magic != SPI_MEM_PACK_MAGIC) break;
+        if(header->version != SPI_MEM_PACK_VERSION) break;
+        if(header->block_size == 0 || header->block_size > UINT16_MAX) break;
+        if(header->image_size > (uint64_t)header->block_count * header->block_size) break;
+        success = true;
+    } while(0);
+    return success;
+}
+
+bool spi_mem_pack_read_start(SPIMemPack* pack, File* file) {
+    if(!spi_mem_pack_read_header(file, &pack->header) ||
+       pack->header.block_size != pack->block_size) {
+        storage_file_seek(file, 0, true);
+        return false;
+    }
+    pack->block_index = 0;
+    pack->data_offset = spi_mem_pack_get_index_offset(pack->header.block_count);
+    return true;
+}
+
+static bool spi_mem_pack_load_index(SPIMemPack* pack, File* file) {
+    uint32_t batch_size =
+        MIN((uint32_t)SPI_MEM_PACK_INDEX_BATCH, pack->header.block_count - pack->block_index);
+    size_t index_size = batch_size * sizeof(SPIMemPackIndexEntry);
+    if(!storage_file_seek(file, spi_mem_pack_get_index_offset(pack->block_index), true))
+        return false;
+    if(storage_file_read(file, pack->index, index_size) != index_size) return false;
+    return storage_file_seek(file, pack->data_offset, true);
+}
+
+bool spi_mem_pack_read_block(SPIMemPack* pack, File* file, uint8_t* data, size_t size) {
+    if(size == 0 || size != spi_mem_pack_get_expected_size(pack)) return false;
+    if((pack->block_index % SPI_MEM_PACK_INDEX_BATCH) == 0) {
+        if(!spi_mem_pack_load_index(pack, file)) return false;
+    }
+    SPIMemPackIndexEntry* entry = &pack->index[pack->block_index % SPI_MEM_PACK_INDEX_BATCH];
+    bool success = false;
+    if(entry->type == SPIMemPackBlockTypeErased) {
+        memset(data, 0xFF, size);
+        success = true;
+    } else if(entry->type == SPIMemPackBlockTypeRaw) {
+        success = (entry->size == size) && (storage_file_read(file, data, size) == size);
+    } else if(entry->type == SPIMemPackBlockTypeLZ4) {
+        success = (entry->size <= pack->block_size) &&
+                  (storage_file_read(file, pack->buffer, entry->size) == entry->size) &&
+                  spi_mem_pack_lz4_decode(pack->buffer, entry->size, data, size);
+    }
+    pack->data_offset += entry->size;
+    pack->block_index++;
+    return success;
+}
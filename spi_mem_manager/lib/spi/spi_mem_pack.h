@@ -0,0 +1,56 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+
+#define SPI_MEM_PACK_MAGIC 0x5A4D5053 // "SPMZ"
+#define SPI_MEM_PACK_VERSION 1
+
+/*
+ * Packed dump layout:
+ *   SPIMemPackHeader
+ *   SPIMemPackIndexEntry[block_count]
+ *   block payloads, in block order
+ * Erased (all 0xFF) blocks carry no payload, other blocks are stored
+ * as LZ4 block-format data or raw when compression does not pay off.
+ * tools/spi_mem_pack.py converts between this format and raw .bin
+ */
+
+typedef enum {
+    SPIMemPackBlockTypeErased = 0,
+    SPIMemPackBlockTypeRaw = 1,
+    SPIMemPackBlockTypeLZ4 = 2,
+} SPIMemPackBlockType;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t image_size;
+    uint32_t block_size;
+    uint32_t block_count;
+} SPIMemPackHeader;
+
+typedef struct {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t size;
+} SPIMemPackIndexEntry;
+
+typedef struct SPIMemPack SPIMemPack;
+
+SPIMemPack* spi_mem_pack_alloc(size_t block_size);
+void spi_mem_pack_free(SPIMemPack* pack);
+bool spi_mem_pack_write_start(SPIMemPack* pack, File* file, size_t image_size);
+bool spi_mem_pack_write_block(SPIMemPack* pack, File* file, const uint8_t* data, size_t size);
+bool spi_mem_pack_write_end(SPIMemPack* pack, File* file);
+bool spi_mem_pack_read_start(SPIMemPack* pack, File* file);
+bool spi_mem_pack_read_block(SPIMemPack* pack, File* file, uint8_t* data, size_t size);
+bool spi_mem_pack_read_header(File* file, SPIMemPackHeader* header);
+size_t spi_mem_pack_lz4_encode(
+    SPIMemPack* pack,
+    const uint8_t* src,
+    size_t src_size,
+    uint8_t* dst,
+    size_t dst_capacity);
+bool spi_mem_pack_lz4_decode(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
@@ -1,7 +1,6 @@
-#include <furi_hal.h>
-#include <furi_hal_spi_config.h>
 #include "spi_mem_chip_i.h"
 #include "spi_mem_tools.h"
+#include "spi_mem_transport.h"
 
 static uint8_t spi_mem_tools_addr_to_byte_arr(uint32_t addr, uint8_t* cmd) {
     uint8_t len = 3; // TODO(add support of 4 bytes address mode)
@@ -17,46 +16,15 @@ static bool spi_mem_tools_trx(
     size_t tx_size,
     uint8_t* rx_buf,
     size_t rx_size) {
-    bool success = false;
-    furi_hal_spi_acquire(&furi_hal_spi_bus_handle_external);
-    do {
-        if(!furi_hal_spi_bus_tx(
-               &furi_hal_spi_bus_handle_external, (uint8_t*)&cmd, 1, SPI_MEM_SPI_TIMEOUT))
-            break;
-        if(tx_buf) {
-            if(!furi_hal_spi_bus_tx(
-                   &furi_hal_spi_bus_handle_external, tx_buf, tx_size, SPI_MEM_SPI_TIMEOUT))
-                break;
-        }
-        if(rx_buf) {
-            if(!furi_hal_spi_bus_rx(
-                   &furi_hal_spi_bus_handle_external, rx_buf, rx_size, SPI_MEM_SPI_TIMEOUT))
-                break;
-        }
-        success = true;
-    } while(0);
-    furi_hal_spi_release(&furi_hal_spi_bus_handle_external);
-    return success;
+    uint8_t header = (uint8_t)cmd;
+    return spi_mem_transport_transfer(&header, 1, tx_buf, tx_size, rx_buf, rx_size);
 }
 
 static bool spi_mem_tools_write_buffer(uint8_t* data, size_t size, size_t offset) {
-    furi_hal_spi_acquire(&furi_hal_spi_bus_handle_external);
-    uint8_t cmd = (uint8_t)SPIMemChipCMDWriteData;
-    uint8_t address[4];
-    uint8_t address_size = spi_mem_tools_addr_to_byte_arr(offset, address);
-    bool success = false;
-    do {
-        if(!furi_hal_spi_bus_tx(&furi_hal_spi_bus_handle_external, &cmd, 1, SPI_MEM_SPI_TIMEOUT))
-            break;
-        if(!furi_hal_spi_bus_tx(
-               &furi_hal_spi_bus_handle_external, address, address_size, SPI_MEM_SPI_TIMEOUT))
-            break;
-        if(!furi_hal_spi_bus_tx(&furi_hal_spi_bus_handle_external, data, size, SPI_MEM_SPI_TIMEOUT))
-            break;
-        success = true;
-    } while(0);
-    furi_hal_spi_release(&furi_hal_spi_bus_handle_external);
-    return success;
+    uint8_t header[5];
+    header[0] = (uint8_t)SPIMemChipCMDWriteData;
+    uint8_t header_size = 1 + spi_mem_tools_addr_to_byte_arr(offset, &header[1]);
+    return spi_mem_transport_transfer(header, header_size, data, size, NULL, 0);
 }
 
 bool spi_mem_tools_read_chip_info(SPIMemChip* chip) {
@@ -88,16 +56,17 @@ bool spi_mem_tools_read_block(SPIMemChip* chip, size_t offset, uint8_t* data, si
     if(!spi_mem_tools_check_chip_info(chip)) return false;
     for(size_t i = 0; i < block_size; i += SPI_MEM_MAX_BLOCK_SIZE) {
         uint8_t cmd[4];
-        if((offset + SPI_MEM_MAX_BLOCK_SIZE) > chip->size) return false;
+        size_t read_size = MIN((size_t)SPI_MEM_MAX_BLOCK_SIZE, block_size - i);
+        if((offset + read_size) > chip->size) return false;
         if(!spi_mem_tools_trx(
                SPIMemChipCMDReadData,
                cmd,
                spi_mem_tools_addr_to_byte_arr(offset, cmd),
                data,
-               SPI_MEM_MAX_BLOCK_SIZE))
+               read_size))
             return false;
-        offset += SPI_MEM_MAX_BLOCK_SIZE;
-        data += SPI_MEM_MAX_BLOCK_SIZE;
+        offset += read_size;
+        data += read_size;
     }
     return true;
 }
@@ -140,6 +109,25 @@ bool spi_mem_tools_erase_chip(SPIMemChip* chip) {
     return true;
 }
 
+bool spi_mem_tools_erase_sector(SPIMemChip* chip, size_t offset) {
+    uint8_t cmd[4];
+    do {
+        if(!spi_mem_tools_check_chip_info(chip)) break;
+        if((offset % SPI_MEM_SECTOR_SIZE) != 0) break;
+        if(offset >= chip->size) break;
+        if(!spi_mem_tools_set_write_enabled(chip, true)) break;
+        if(!spi_mem_tools_trx(
+               SPIMemChipCMDSectorErase,
+               cmd,
+               spi_mem_tools_addr_to_byte_arr(offset, cmd),
+               NULL,
+               0))
+            break;
+        return true;
+    } while(0);
+    return false;
+}
+
 bool spi_mem_tools_write_bytes(SPIMemChip* chip, size_t offset, uint8_t* data, size_t block_size) {
     do {
         if(!spi_mem_tools_check_chip_info(chip)) break;
@@ -0,0 +1,34 @@
+#include <furi_hal.h>
+#include <furi_hal_spi_config.h>
+#include "spi_mem_transport.h"
+#include "spi_mem_tools.h"
+
+// External SPI bus on the GPIO header
+bool spi_mem_transport_transfer(
+    const uint8_t* header,
+    size_t header_size,
+    const uint8_t* tx_data,
+    size_t tx_size,
+    uint8_t* rx_data,
+    size_t rx_size) {
+    bool success = false;
+    furi_hal_spi_acquire(&furi_hal_spi_bus_handle_external);
+    do {
+        if(!furi_hal_spi_bus_tx(
+               &furi_hal_spi_bus_handle_external, header, header_size, SPI_MEM_SPI_TIMEOUT))
+            break;
+        if(tx_data && tx_size) {
+            if(!furi_hal_spi_bus_tx(
+                   &furi_hal_spi_bus_handle_external, tx_data, tx_size, SPI_MEM_SPI_TIMEOUT))
+                break;
+        }
+        if(rx_data && rx_size) {
+            if(!furi_hal_spi_bus_rx(
+                   &furi_hal_spi_bus_handle_external, rx_data, rx_size, SPI_MEM_SPI_TIMEOUT))
+                break;
+        }
+        success = true;
+    } while(0);
+    furi_hal_spi_release(&furi_hal_spi_bus_handle_external);
+    return success;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <furi.h>
+
+/*
+ * One chip select cycle on the SPI bus: header (command and address) and
+ * tx_data are sent, then rx_size bytes are clocked into rx_data.
+ * Any of tx_data and rx_data may be NULL.
+ */
+bool spi_mem_transport_transfer(
+    const uint8_t* header,
+    size_t header_size,
+    const uint8_t* tx_data,
+    size_t tx_size,
+    uint8_t* rx_data,
+    size_t rx_size);
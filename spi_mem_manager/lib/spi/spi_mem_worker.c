@@ -19,6 +19,9 @@ SPIMemWorker* spi_mem_worker_alloc() {
     worker->callback = NULL;
     worker->thread = furi_thread_alloc();
     worker->mode_index = SPIMemWorkerModeIdle;
+    worker->hash = spi_mem_hash_alloc();
+    worker->range_offset = 0;
+    worker->range_size = 0;
     furi_thread_set_name(worker->thread, "SPIMemWorker");
     furi_thread_set_callback(worker->thread, spi_mem_worker_thread);
     furi_thread_set_context(worker->thread, worker);
@@ -28,6 +31,7 @@ SPIMemWorker* spi_mem_worker_alloc() {
 
 void spi_mem_worker_free(SPIMemWorker* worker) {
     furi_thread_free(worker->thread);
+    spi_mem_hash_free(worker->hash);
     free(worker);
 }
 
@@ -37,6 +41,13 @@ bool spi_mem_worker_check_for_stop(SPIMemWorker* worker) {
     return (flags & SPIMemEventStopThread);
 }
 
+// Limits the following operations to [offset, offset + size), size 0 selects the whole chip
+void spi_mem_worker_set_range(SPIMemWorker* worker, size_t offset, size_t size) {
+    furi_check(worker->mode_index == SPIMemWorkerModeIdle);
+    worker->range_offset = offset;
+    worker->range_size = size;
+}
+
 static int32_t spi_mem_worker_thread(void* thread_context) {
     SPIMemWorker* worker = thread_context;
     while(true) {
@@ -26,6 +26,7 @@ void spi_mem_worker_free(SPIMemWorker* worker);
 void spi_mem_worker_start_thread(SPIMemWorker* worker);
 void spi_mem_worker_stop_thread(SPIMemWorker* worker);
 bool spi_mem_worker_check_for_stop(SPIMemWorker* worker);
+void spi_mem_worker_set_range(SPIMemWorker* worker, size_t offset, size_t size);
 void spi_mem_worker_chip_detect_start(
     SPIMemChip* chip_info,
     found_chips_t* found_chips,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "spi_mem_worker.h"
+#include "spi_mem_hash.h"
 
 typedef enum {
     SPIMemWorkerModeIdle,
@@ -19,6 +20,9 @@ struct SPIMemWorker {
     void* cb_ctx;
     FuriThread* thread;
     FuriString* file_name;
+    SPIMemHash* hash;
+    size_t range_offset;
+    size_t range_size;
 };
 
 extern const SPIMemWorkerModeType spi_mem_worker_modes[];
@@ -34,14 +34,38 @@ static bool spi_mem_worker_await_chip_busy(SPIMemWorker* worker) {
     }
 }
 
-static size_t spi_mem_worker_modes_get_total_size(SPIMemWorker* worker) {
+static size_t spi_mem_worker_modes_get_range_size(SPIMemWorker* worker) {
     size_t chip_size = spi_mem_chip_get_size(worker->chip_info);
+    if(worker->range_offset >= chip_size) return 0;
+    size_t range_size = chip_size - worker->range_offset;
+    if(worker->range_size && (worker->range_size < range_size)) range_size = worker->range_size;
+    return range_size;
+}
+
+static size_t spi_mem_worker_modes_get_total_size(SPIMemWorker* worker) {
+    size_t range_size = spi_mem_worker_modes_get_range_size(worker);
     size_t file_size = spi_mem_file_get_size(worker->cb_ctx);
-    size_t total_size = chip_size;
-    if(chip_size > file_size) total_size = file_size;
+    size_t total_size = range_size;
+    if(range_size > file_size) total_size = file_size;
     return total_size;
 }
 
+// A region takes a dump of its own size, or a raw full-chip dump read from the region offset.
+// Without a region the dump is used from the start, as before.
+static bool spi_mem_worker_modes_get_file_offset(SPIMemWorker* worker, size_t* file_offset) {
+    size_t chip_size = spi_mem_chip_get_size(worker->chip_info);
+    size_t range_size = spi_mem_worker_modes_get_range_size(worker);
+    size_t file_size = spi_mem_file_get_size(worker->cb_ctx);
+    *file_offset = 0;
+    if(range_size == chip_size) return true;
+    if(file_size == range_size) return true;
+    if((file_size == chip_size) && !spi_mem_file_is_packed(worker->cb_ctx)) {
+        *file_offset = worker->range_offset;
+        return true;
+    }
+    return false;
+}
+
 // ChipDetect
 static void spi_mem_worker_chip_detect_process(SPIMemWorker* worker) {
     SPIMemCustomEventWorker event;
@@ -58,18 +82,25 @@ static void spi_mem_worker_chip_detect_process(SPIMemWorker* worker) {
 }
 
 // Read
-static bool spi_mem_worker_read(SPIMemWorker* worker, SPIMemCustomEventWorker* event) {
+static bool spi_mem_worker_read(
+    SPIMemWorker* worker,
+    SPIMemHashHeader* header,
+    bool* hash_valid,
+    SPIMemCustomEventWorker* event) {
     uint8_t data_buffer[SPI_MEM_FILE_BUFFER_SIZE];
-    size_t chip_size = spi_mem_chip_get_size(worker->chip_info);
+    size_t chip_size = spi_mem_worker_modes_get_range_size(worker);
     size_t offset = 0;
     bool success = true;
+    *hash_valid = spi_mem_file_hash_create_open(worker->cb_ctx); // sidecar is optional
+    spi_mem_hash_start(worker->hash);
     while(true) {
         furi_delay_tick(10); // to give some time to OS
         size_t block_size = SPI_MEM_FILE_BUFFER_SIZE;
         if(spi_mem_worker_check_for_stop(worker)) break;
         if(offset >= chip_size) break;
         if((offset + block_size) > chip_size) block_size = chip_size - offset;
-        if(!spi_mem_tools_read_block(worker->chip_info, offset, data_buffer, block_size)) {
+        if(!spi_mem_tools_read_block(
+               worker->chip_info, worker->range_offset + offset, data_buffer, block_size)) {
             *event = SPIMemCustomEventWorkerChipFail;
             success = false;
             break;
@@ -78,21 +109,40 @@ static bool spi_mem_worker_read(SPIMemWorker* worker, SPIMemCustomEventWorker* e
             success = false;
             break;
         }
+        uint32_t crc = spi_mem_hash_update(worker->hash, data_buffer, block_size);
+        if(*hash_valid) *hash_valid = spi_mem_file_hash_write_crc(worker->cb_ctx, crc);
         offset += block_size;
         spi_mem_worker_run_callback(worker, SPIMemCustomEventWorkerBlockReaded);
     }
-    if(success) *event = SPIMemCustomEventWorkerDone;
+    if(success) {
+        *header = (SPIMemHashHeader){
+            .magic = SPI_MEM_HASH_MAGIC,
+            .version = SPI_MEM_HASH_VERSION,
+            .image_size = offset,
+            .sector_size = SPI_MEM_FILE_BUFFER_SIZE,
+        };
+        spi_mem_hash_finish(worker->hash, header->sha256);
+        *event = SPIMemCustomEventWorkerDone;
+    } else {
+        *hash_valid = false;
+    }
     return success;
 }
 
 static void spi_mem_worker_read_process(SPIMemWorker* worker) {
     SPIMemCustomEventWorker event = SPIMemCustomEventWorkerFileFail;
+    SPIMemHashHeader header;
+    bool hash_valid = false;
     do {
         if(!spi_mem_worker_await_chip_busy(worker)) break;
         if(!spi_mem_file_create_open(worker->cb_ctx)) break;
-        if(!spi_mem_worker_read(worker, &event)) break;
+        if(!spi_mem_worker_read(worker, &header, &hash_valid, &event)) break;
     } while(0);
     spi_mem_file_close(worker->cb_ctx);
+    // header takes the size and timestamp of the closed dump
+    if(hash_valid) hash_valid = spi_mem_file_hash_write_header(worker->cb_ctx, &header);
+    spi_mem_file_hash_close(worker->cb_ctx);
+    if(!hash_valid) spi_mem_file_hash_delete(worker->cb_ctx);
     spi_mem_worker_run_callback(worker, event);
 }
 
@@ -109,7 +159,8 @@ static bool
         if(spi_mem_worker_check_for_stop(worker)) break;
         if(offset >= total_size) break;
         if((offset + block_size) > total_size) block_size = total_size - offset;
-        if(!spi_mem_tools_read_block(worker->chip_info, offset, data_buffer_chip, block_size)) {
+        if(!spi_mem_tools_read_block(
+               worker->chip_info, worker->range_offset + offset, data_buffer_chip, block_size)) {
             *event = SPIMemCustomEventWorkerChipFail;
             success = false;
             break;
@@ -130,31 +181,125 @@ static bool
     return success;
 }
 
+// Compares chip contents against the dump sidecar, the dump itself is not read
+static bool spi_mem_worker_verify_by_hash(
+    SPIMemWorker* worker,
+    const SPIMemHashHeader* header,
+    SPIMemCustomEventWorker* event) {
+    uint8_t data_buffer_chip[SPI_MEM_FILE_BUFFER_SIZE];
+    uint8_t sha256[SPI_MEM_HASH_SHA256_SIZE];
+    size_t offset = 0;
+    bool success = true;
+    spi_mem_hash_start(worker->hash);
+    while(true) {
+        furi_delay_tick(10); // to give some time to OS
+        size_t block_size = SPI_MEM_FILE_BUFFER_SIZE;
+        uint32_t crc_file;
+        if(spi_mem_worker_check_for_stop(worker)) {
+            success = false;
+            break;
+        }
+        if(offset >= header->image_size) break;
+        if((offset + block_size) > header->image_size) block_size = header->image_size - offset;
+        if(!spi_mem_tools_read_block(
+               worker->chip_info, worker->range_offset + offset, data_buffer_chip, block_size)) {
+            *event = SPIMemCustomEventWorkerChipFail;
+            success = false;
+            break;
+        }
+        if(!spi_mem_file_hash_read_crc(worker->cb_ctx, &crc_file)) {
+            success = false;
+            break;
+        }
+        if(spi_mem_hash_update(worker->hash, data_buffer_chip, block_size) != crc_file) {
+            *event = SPIMemCustomEventWorkerVerifyFail;
+            success = false;
+            break;
+        }
+        offset += block_size;
+        spi_mem_worker_run_callback(worker, SPIMemCustomEventWorkerBlockReaded);
+    }
+    if(success) {
+        spi_mem_hash_finish(worker->hash, sha256);
+        if(memcmp(sha256, header->sha256, SPI_MEM_HASH_SHA256_SIZE) != 0) {
+            *event = SPIMemCustomEventWorkerVerifyFail;
+            success = false;
+        }
+    }
+    if(success) *event = SPIMemCustomEventWorkerDone;
+    return success;
+}
+
+static bool spi_mem_worker_verify_hash_usable(SPIMemWorker* worker, SPIMemHashHeader* header) {
+    size_t total_size = spi_mem_worker_modes_get_total_size(worker);
+    if(!spi_mem_file_hash_open(worker->cb_ctx, header)) return false;
+    if(header->image_size == total_size && header->sector_size == SPI_MEM_FILE_BUFFER_SIZE) {
+        return true;
+    }
+    spi_mem_file_hash_close(worker->cb_ctx);
+    return false;
+}
+
 static void spi_mem_worker_verify_process(SPIMemWorker* worker) {
     SPIMemCustomEventWorker event = SPIMemCustomEventWorkerFileFail;
+    SPIMemHashHeader header;
     size_t total_size = spi_mem_worker_modes_get_total_size(worker);
+    size_t file_offset = 0;
     do {
+        if(!spi_mem_worker_modes_get_file_offset(worker, &file_offset)) break;
         if(!spi_mem_worker_await_chip_busy(worker)) break;
+        // the sidecar hashes the whole dump, it can't check a slice of it
+        if((file_offset == 0) && spi_mem_worker_verify_hash_usable(worker, &header)) {
+            spi_mem_worker_verify_by_hash(worker, &header, &event);
+            break;
+        }
         if(!spi_mem_file_open(worker->cb_ctx)) break;
+        if(!spi_mem_file_seek(worker->cb_ctx, file_offset)) break;
         if(!spi_mem_worker_verify(worker, total_size, &event)) break;
     } while(0);
+    spi_mem_file_hash_close(worker->cb_ctx);
     spi_mem_file_close(worker->cb_ctx);
     spi_mem_worker_run_callback(worker, event);
 }
 
 // Erase
+static bool spi_mem_worker_erase_range(SPIMemWorker* worker) {
+    size_t range_size = spi_mem_worker_modes_get_range_size(worker);
+    // sector erase would touch data outside of an unaligned range
+    if((worker->range_offset % SPI_MEM_SECTOR_SIZE) != 0) return false;
+    if((range_size % SPI_MEM_SECTOR_SIZE) != 0) return false;
+    for(size_t offset = 0; offset < range_size; offset += SPI_MEM_SECTOR_SIZE) {
+        if(spi_mem_worker_check_for_stop(worker)) return false;
+        if(!spi_mem_tools_erase_sector(worker->chip_info, worker->range_offset + offset))
+            return false;
+        if(!spi_mem_worker_await_chip_busy(worker)) return false;
+    }
+    return true;
+}
+
 static void spi_mem_worker_erase_process(SPIMemWorker* worker) {
     SPIMemCustomEventWorker event = SPIMemCustomEventWorkerChipFail;
     do {
         if(!spi_mem_worker_await_chip_busy(worker)) break;
-        if(!spi_mem_tools_erase_chip(worker->chip_info)) break;
-        if(!spi_mem_worker_await_chip_busy(worker)) break;
+        if(worker->range_size) {
+            if(!spi_mem_worker_erase_range(worker)) break;
+        } else {
+            if(!spi_mem_tools_erase_chip(worker->chip_info)) break;
+            if(!spi_mem_worker_await_chip_busy(worker)) break;
+        }
         event = SPIMemCustomEventWorkerDone;
     } while(0);
     spi_mem_worker_run_callback(worker, event);
 }
 
 // Write
+static bool spi_mem_worker_is_erased(const uint8_t* data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        if(data[i] != 0xFF) return false;
+    }
+    return true;
+}
+
 static bool spi_mem_worker_write_block_by_page(
     SPIMemWorker* worker,
     size_t offset,
@@ -162,10 +307,15 @@ static bool spi_mem_worker_write_block_by_page(
     size_t block_size,
     size_t page_size) {
     for(size_t i = 0; i < block_size; i += page_size) {
-        if(!spi_mem_worker_await_chip_busy(worker)) return false;
-        if(!spi_mem_tools_write_bytes(worker->chip_info, offset, data, page_size)) return false;
-        offset += page_size;
-        data += page_size;
+        size_t write_size = MIN(page_size, block_size - i);
+        // chip is erased before writing, programming 0xFF pages is a no-op
+        if(!spi_mem_worker_is_erased(data, write_size)) {
+            if(!spi_mem_worker_await_chip_busy(worker)) return false;
+            if(!spi_mem_tools_write_bytes(worker->chip_info, offset, data, write_size))
+                return false;
+        }
+        offset += write_size;
+        data += write_size;
     }
     return true;
 }
@@ -188,7 +338,7 @@ static bool
             break;
         }
         if(!spi_mem_worker_write_block_by_page(
-               worker, offset, data_buffer, block_size, page_size)) {
+               worker, worker->range_offset + offset, data_buffer, block_size, page_size)) {
             success = false;
             break;
         }
@@ -202,8 +352,14 @@ static void spi_mem_worker_write_process(SPIMemWorker* worker) {
     SPIMemCustomEventWorker event = SPIMemCustomEventWorkerChipFail;
     size_t total_size =
         spi_mem_worker_modes_get_total_size(worker); // need to be executed before opening file
+    size_t file_offset = 0;
     do {
+        if(!spi_mem_worker_modes_get_file_offset(worker, &file_offset)) {
+            event = SPIMemCustomEventWorkerFileFail;
+            break;
+        }
         if(!spi_mem_file_open(worker->cb_ctx)) break;
+        if(!spi_mem_file_seek(worker->cb_ctx, file_offset)) break;
         if(!spi_mem_worker_await_chip_busy(worker)) break;
         if(!spi_mem_worker_write(worker, total_size, &event)) break;
         if(!spi_mem_worker_await_chip_busy(worker)) break;
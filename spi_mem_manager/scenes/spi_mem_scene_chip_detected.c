@@ -52,6 +52,11 @@ static void spi_mem_scene_chip_detected_set_previous_scene(SPIMemApp* app) {
 
 static void spi_mem_scene_chip_detected_set_next_scene(SPIMemApp* app) {
     uint32_t scene = SPIMemSceneStart;
+    memset(&app->range, 0, sizeof(SPIMemPartition));
+    if(partitions_size(app->partitions)) {
+        scene_manager_next_scene(app->scene_manager, SPIMemSceneSelectPartition);
+        return;
+    }
     if(app->mode == SPIMemModeRead) scene = SPIMemSceneReadFilename;
     if(app->mode == SPIMemModeWrite) scene = SPIMemSceneErase;
     if(app->mode == SPIMemModeErase) scene = SPIMemSceneErase;
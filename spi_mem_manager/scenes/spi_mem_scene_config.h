@@ -19,3 +19,4 @@ ADD_SCENE(spi_mem, storage_error, StorageError)
 ADD_SCENE(spi_mem, select_vendor, SelectVendor)
 ADD_SCENE(spi_mem, select_model, SelectModel)
 ADD_SCENE(spi_mem, wiring, Wiring)
+ADD_SCENE(spi_mem, select_partition, SelectPartition)
@@ -24,6 +24,7 @@ void spi_mem_scene_erase_on_enter(void* context) {
     notification_message(app->notifications, &sequence_blink_start_magenta);
     view_dispatcher_switch_to_view(app->view_dispatcher, SPIMemViewWidget);
     spi_mem_worker_start_thread(app->worker);
+    spi_mem_worker_set_range(app->worker, app->range.offset, app->range.size);
     spi_mem_worker_erase_start(app->chip_info, app->worker, spi_mem_scene_erase_callback, app);
 }
 
@@ -9,6 +9,17 @@ void spi_mem_scene_file_info_on_enter(void* context) {
         app->widget, 64, 9, AlignCenter, AlignBottom, FontPrimary, "File info");
     widget_add_string_element(
         app->widget, 64, 20, AlignCenter, AlignBottom, FontSecondary, furi_string_get_cstr(str));
+    if(spi_mem_file_is_packed(app)) {
+        furi_string_printf(str, "Packed: %zu KB on SD", spi_mem_file_get_disk_size(app) / 1024);
+        widget_add_string_element(
+            app->widget,
+            64,
+            31,
+            AlignCenter,
+            AlignBottom,
+            FontSecondary,
+            furi_string_get_cstr(str));
+    }
     furi_string_free(str);
     view_dispatcher_switch_to_view(app->view_dispatcher, SPIMemViewWidget);
 }
@@ -6,12 +6,27 @@ void spi_mem_scene_read_filename_view_result_callback(void* context) {
     view_dispatcher_send_custom_event(app->view_dispatcher, SPIMemCustomEventTextEditResult);
 }
 
+// Append the partition name, replacing characters that can't be used in a file name
+static void spi_mem_scene_read_append_range_name(SPIMemApp* app) {
+    size_t name_size = strlen(app->text_buffer);
+    if(name_size + 1 >= SPI_MEM_TEXT_BUFFER_SIZE) return;
+    app->text_buffer[name_size++] = '_';
+    for(const char* c = app->range.name; *c && name_size + 1 < SPI_MEM_TEXT_BUFFER_SIZE; c++) {
+        bool is_valid = (*c > ' ') && (*c < 0x7F) && !strchr("\\/:*?\"<>|", *c);
+        app->text_buffer[name_size++] = is_valid ? *c : '_';
+    }
+    app->text_buffer[name_size] = '\0';
+}
+
 void spi_mem_scene_read_set_random_filename(SPIMemApp* app) {
     if(furi_string_end_with(app->file_path, SPI_MEM_FILE_EXTENSION)) {
         size_t filename_start = furi_string_search_rchar(app->file_path, '/');
         furi_string_left(app->file_path, filename_start);
     }
     name_generator_make_auto(app->text_buffer, SPI_MEM_TEXT_BUFFER_SIZE, SPI_MEM_FILE_PREFIX);
+    if(app->range.size) {
+        spi_mem_scene_read_append_range_name(app);
+    }
 }
 
 void spi_mem_scene_read_filename_on_enter(void* context) {
@@ -0,0 +1,70 @@
+#include "../spi_mem_app_i.h"
+
+#define SPI_MEM_SCENE_SELECT_PARTITION_WHOLE_CHIP UINT32_MAX
+
+static void spi_mem_scene_select_partition_submenu_callback(void* context, uint32_t index) {
+    SPIMemApp* app = context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, index);
+}
+
+static bool spi_mem_scene_select_partition_is_usable(SPIMemApp* app, SPIMemPartition* partition) {
+    if(partition->offset >= spi_mem_chip_get_size(app->chip_info)) return false;
+    if(app->mode == SPIMemModeWrite || app->mode == SPIMemModeErase) {
+        return spi_mem_partitions_is_erasable(partition);
+    }
+    return true;
+}
+
+void spi_mem_scene_select_partition_on_enter(void* context) {
+    SPIMemApp* app = context;
+    submenu_add_item(
+        app->submenu,
+        "Whole chip",
+        SPI_MEM_SCENE_SELECT_PARTITION_WHOLE_CHIP,
+        spi_mem_scene_select_partition_submenu_callback,
+        app);
+    for(size_t index = 0; index < partitions_size(app->partitions); index++) {
+        SPIMemPartition* partition = partitions_get(app->partitions, index);
+        if(!spi_mem_scene_select_partition_is_usable(app, partition)) continue;
+        submenu_add_item(
+            app->submenu,
+            partition->name,
+            index,
+            spi_mem_scene_select_partition_submenu_callback,
+            app);
+    }
+    submenu_set_header(app->submenu, "Choose region");
+    submenu_set_selected_item(
+        app->submenu,
+        scene_manager_get_scene_state(app->scene_manager, SPIMemSceneSelectPartition));
+    view_dispatcher_switch_to_view(app->view_dispatcher, SPIMemViewSubmenu);
+}
+
+static void spi_mem_scene_select_partition_set_next_scene(SPIMemApp* app) {
+    uint32_t scene = SPIMemSceneStart;
+    if(app->mode == SPIMemModeRead) scene = SPIMemSceneReadFilename;
+    if(app->mode == SPIMemModeWrite) scene = SPIMemSceneErase;
+    if(app->mode == SPIMemModeErase) scene = SPIMemSceneErase;
+    if(app->mode == SPIMemModeCompare) scene = SPIMemSceneVerify;
+    scene_manager_next_scene(app->scene_manager, scene);
+}
+
+bool spi_mem_scene_select_partition_on_event(void* context, SceneManagerEvent event) {
+    SPIMemApp* app = context;
+    bool success = false;
+    if(event.type == SceneManagerEventTypeCustom) {
+        scene_manager_set_scene_state(app->scene_manager, SPIMemSceneSelectPartition, event.event);
+        memset(&app->range, 0, sizeof(SPIMemPartition));
+        if(event.event != SPI_MEM_SCENE_SELECT_PARTITION_WHOLE_CHIP) {
+            app->range = *partitions_get(app->partitions, event.event);
+        }
+        spi_mem_scene_select_partition_set_next_scene(app);
+        success = true;
+    }
+    return success;
+}
+
+void spi_mem_scene_select_partition_on_exit(void* context) {
+    SPIMemApp* app = context;
+    submenu_reset(app->submenu);
+}
@@ -2,6 +2,7 @@
 
 typedef enum {
     SPIMemSceneStartSubmenuIndexRead,
+    SPIMemSceneStartSubmenuIndexReadPacked,
     SPIMemSceneStartSubmenuIndexSaved,
     SPIMemSceneStartSubmenuIndexErase,
     SPIMemSceneStartSubmenuIndexWiring,
@@ -21,6 +22,12 @@ void spi_mem_scene_start_on_enter(void* context) {
         SPIMemSceneStartSubmenuIndexRead,
         spi_mem_scene_start_submenu_callback,
         app);
+    submenu_add_item(
+        app->submenu,
+        "Read Packed",
+        SPIMemSceneStartSubmenuIndexReadPacked,
+        spi_mem_scene_start_submenu_callback,
+        app);
     submenu_add_item(
         app->submenu,
         "Saved",
@@ -57,6 +64,12 @@ bool spi_mem_scene_start_on_event(void* context, SceneManagerEvent event) {
         scene_manager_set_scene_state(app->scene_manager, SPIMemSceneStart, event.event);
         if(event.event == SPIMemSceneStartSubmenuIndexRead) {
             app->mode = SPIMemModeRead;
+            app->pack_dump = false;
+            scene_manager_next_scene(app->scene_manager, SPIMemSceneChipDetect);
+            success = true;
+        } else if(event.event == SPIMemSceneStartSubmenuIndexReadPacked) {
+            app->mode = SPIMemModeRead;
+            app->pack_dump = true;
             scene_manager_next_scene(app->scene_manager, SPIMemSceneChipDetect);
             success = true;
         } else if(event.event == SPIMemSceneStartSubmenuIndexSaved) {
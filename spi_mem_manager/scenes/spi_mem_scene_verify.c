@@ -18,12 +18,14 @@ void spi_mem_scene_verify_on_enter(void* context) {
     spi_mem_view_progress_set_verify_callback(
         app->view_progress, spi_mem_scene_verify_view_result_callback, app);
     notification_message(app->notifications, &sequence_blink_start_cyan);
-    spi_mem_view_progress_set_chip_size(app->view_progress, spi_mem_chip_get_size(app->chip_info));
+    spi_mem_view_progress_set_chip_size(
+        app->view_progress, spi_mem_partitions_get_range_size(app));
     spi_mem_view_progress_set_file_size(app->view_progress, spi_mem_file_get_size(app));
     spi_mem_view_progress_set_block_size(
         app->view_progress, spi_mem_tools_get_file_max_block_size(app->chip_info));
     view_dispatcher_switch_to_view(app->view_dispatcher, SPIMemViewProgress);
     spi_mem_worker_start_thread(app->worker);
+    spi_mem_worker_set_range(app->worker, app->range.offset, app->range.size);
     spi_mem_worker_verify_start(app->chip_info, app->worker, spi_mem_scene_verify_callback, app);
 }
 
@@ -2,6 +2,7 @@
 #include "spi_mem_app_i.h"
 #include "spi_mem_files.h"
 #include "lib/spi/spi_mem_chip_i.h"
+#include "lib/spi/spi_mem_tools.h"
 
 static bool spi_mem_custom_event_callback(void* context, uint32_t event) {
     furi_assert(context);
@@ -36,9 +37,17 @@ SPIMemApp* spi_mem_alloc(void) {
     instance->view_detect = spi_mem_view_detect_alloc();
     instance->text_input = text_input_alloc();
     instance->mode = SPIMemModeUnknown;
+    instance->file = NULL;
+    instance->hash_file = NULL;
+    instance->pack = spi_mem_pack_alloc(SPI_MEM_FILE_BUFFER_SIZE);
+    instance->file_pack_mode = SPIMemFilePackModeNone;
+    instance->pack_dump = false;
+    partitions_init(instance->partitions);
+    memset(&instance->range, 0, sizeof(SPIMemPartition));
 
     // Migrate data from old sd-card folder
     storage_common_migrate(instance->storage, EXT_PATH("spimem"), STORAGE_APP_DATA_PATH_PREFIX);
+    spi_mem_partitions_load(instance);
 
     view_dispatcher_set_event_callback_context(instance->view_dispatcher, instance);
     view_dispatcher_set_custom_event_callback(
@@ -90,8 +99,10 @@ void spi_mem_free(SPIMemApp* instance) {
     view_dispatcher_free(instance->view_dispatcher);
     scene_manager_free(instance->scene_manager);
     spi_mem_worker_free(instance->worker);
+    spi_mem_pack_free(instance->pack);
     free(instance->chip_info);
     found_chips_clear(instance->found_chips);
+    partitions_clear(instance->partitions);
     furi_record_close(RECORD_STORAGE);
     furi_record_close(RECORD_DIALOGS);
     furi_record_close(RECORD_NOTIFICATION);
@@ -18,12 +18,16 @@
 #include <toolbox/name_generator.h>
 #include "scenes/spi_mem_scene.h"
 #include "lib/spi/spi_mem_worker.h"
+#include "lib/spi/spi_mem_pack.h"
+#include "spi_mem_partitions.h"
 #include "spi_mem_manager_icons.h"
 #include "views/spi_mem_view_progress.h"
 #include "views/spi_mem_view_detect.h"
 
 #define TAG "SPIMem"
 #define SPI_MEM_FILE_EXTENSION ".bin"
+#define SPI_MEM_HASH_FILE_EXTENSION ".hash"
+#define SPI_MEM_PARTITION_MAP_PATH STORAGE_APP_DATA_PATH_PREFIX "/partitions.txt"
 #define SPI_MEM_FILE_PREFIX "SPIMem"
 #define SPI_MEM_FILE_NAME_SIZE 100
 #define SPI_MEM_TEXT_BUFFER_SIZE 128
@@ -37,6 +41,12 @@ typedef enum {
     SPIMemModeUnknown
 } SPIMemMode;
 
+typedef enum {
+    SPIMemFilePackModeNone,
+    SPIMemFilePackModeRead,
+    SPIMemFilePackModeWrite
+} SPIMemFilePackMode;
+
 struct SPIMemApp {
     Gui* gui;
     ViewDispatcher* view_dispatcher;
@@ -49,6 +59,12 @@ struct SPIMemApp {
     DialogsApp* dialogs;
     Storage* storage;
     File* file;
+    File* hash_file;
+    SPIMemPack* pack;
+    SPIMemFilePackMode file_pack_mode;
+    bool pack_dump;
+    partitions_t partitions;
+    SPIMemPartition range;
     Widget* widget;
     SPIMemWorker* worker;
     SPIMemChip* chip_info;
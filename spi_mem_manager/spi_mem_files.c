@@ -1,6 +1,16 @@
 #include "spi_mem_app_i.h"
+#include "spi_mem_files.h"
+
+static void spi_mem_file_get_hash_path(SPIMemApp* app, FuriString* hash_path) {
+    furi_string_set(hash_path, app->file_path);
+    if(furi_string_end_with(hash_path, SPI_MEM_FILE_EXTENSION)) {
+        furi_string_left(hash_path, furi_string_size(hash_path) - strlen(SPI_MEM_FILE_EXTENSION));
+    }
+    furi_string_cat(hash_path, SPI_MEM_HASH_FILE_EXTENSION);
+}
 
 bool spi_mem_file_delete(SPIMemApp* app) {
+    spi_mem_file_hash_delete(app);
     return (storage_simply_remove(app->storage, furi_string_get_cstr(app->file_path)));
 }
 
@@ -26,6 +36,12 @@ bool spi_mem_file_create_open(SPIMemApp* app) {
         if(!storage_file_open(
                app->file, furi_string_get_cstr(app->file_path), FSAM_WRITE, FSOM_CREATE_NEW))
             break;
+        if(app->pack_dump) {
+            if(!spi_mem_pack_write_start(
+                   app->pack, app->file, spi_mem_partitions_get_range_size(app)))
+                break;
+            app->file_pack_mode = SPIMemFilePackModeWrite;
+        }
         success = true;
     } while(0);
     if(!success) { //-V547
@@ -41,28 +57,170 @@ bool spi_mem_file_open(SPIMemApp* app) {
         dialog_message_show_storage_error(app->dialogs, "Cannot save\nfile");
         return false;
     }
+    if(spi_mem_pack_read_start(app->pack, app->file)) {
+        app->file_pack_mode = SPIMemFilePackModeRead;
+    }
     return true;
 }
 
+// Raw dumps only, packed blocks can only be read in order
+bool spi_mem_file_seek(SPIMemApp* app, size_t offset) {
+    if(offset == 0) return true;
+    if(app->file_pack_mode == SPIMemFilePackModeRead) return false;
+    return storage_file_seek(app->file, offset, true);
+}
+
 bool spi_mem_file_write_block(SPIMemApp* app, uint8_t* data, size_t size) {
+    if(app->file_pack_mode == SPIMemFilePackModeWrite) {
+        return spi_mem_pack_write_block(app->pack, app->file, data, size);
+    }
     if(storage_file_write(app->file, data, size) != size) return false;
     return true;
 }
 
 bool spi_mem_file_read_block(SPIMemApp* app, uint8_t* data, size_t size) {
+    if(app->file_pack_mode == SPIMemFilePackModeRead) {
+        return spi_mem_pack_read_block(app->pack, app->file, data, size);
+    }
     if(storage_file_read(app->file, data, size) != size) return false;
     return true;
 }
 
 void spi_mem_file_close(SPIMemApp* app) {
+    if(!app->file) return;
+    if(app->file_pack_mode == SPIMemFilePackModeWrite) {
+        if(!spi_mem_pack_write_end(app->pack, app->file)) {
+            FURI_LOG_E(TAG, "Failed to finalize packed dump");
+        }
+    }
+    app->file_pack_mode = SPIMemFilePackModeNone;
     storage_file_close(app->file);
     storage_file_free(app->file);
+    app->file = NULL;
+}
+
+static bool spi_mem_file_get_pack_header(SPIMemApp* app, SPIMemPackHeader* header) {
+    File* file = storage_file_alloc(app->storage);
+    bool success = false;
+    if(storage_file_open(
+           file, furi_string_get_cstr(app->file_path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        success = spi_mem_pack_read_header(file, header);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    return success;
+}
+
+bool spi_mem_file_is_packed(SPIMemApp* app) {
+    SPIMemPackHeader header;
+    return spi_mem_file_get_pack_header(app, &header);
 }
 
+size_t spi_mem_file_get_disk_size(SPIMemApp* app) {
+    FileInfo file_info;
+    if(storage_common_stat(app->storage, furi_string_get_cstr(app->file_path), &file_info) !=
+       FSE_OK)
+        return 0;
+    return file_info.size;
+}
+
+// Size of the image stored in the dump, regardless of packing
 size_t spi_mem_file_get_size(SPIMemApp* app) {
+    SPIMemPackHeader header;
+    if(spi_mem_file_get_pack_header(app, &header)) return header.image_size;
     FileInfo file_info;
     if(storage_common_stat(app->storage, furi_string_get_cstr(app->file_path), &file_info) !=
        FSE_OK)
         return 0;
     return file_info.size;
 }
+
+static bool spi_mem_file_get_dump_stamp(SPIMemApp* app, uint32_t* size, uint32_t* timestamp) {
+    const char* path = furi_string_get_cstr(app->file_path);
+    FileInfo file_info;
+    if(storage_common_stat(app->storage, path, &file_info) != FSE_OK) return false;
+    if(storage_common_timestamp(app->storage, path, timestamp) != FSE_OK) return false;
+    *size = file_info.size;
+    return true;
+}
+
+bool spi_mem_file_hash_create_open(SPIMemApp* app) {
+    bool success = false;
+    SPIMemHashHeader header = {0};
+    FuriString* hash_path = furi_string_alloc();
+    spi_mem_file_get_hash_path(app, hash_path);
+    app->hash_file = storage_file_alloc(app->storage);
+    do {
+        if(!storage_file_open(
+               app->hash_file, furi_string_get_cstr(hash_path), FSAM_WRITE, FSOM_CREATE_ALWAYS))
+            break;
+        // placeholder, rewritten by spi_mem_file_hash_write_header once the image is complete
+        if(storage_file_write(app->hash_file, &header, sizeof(header)) != sizeof(header)) break;
+        success = true;
+    } while(0);
+    furi_string_free(hash_path);
+    if(!success) spi_mem_file_hash_close(app);
+    return success;
+}
+
+bool spi_mem_file_hash_open(SPIMemApp* app, SPIMemHashHeader* header) {
+    bool success = false;
+    FuriString* hash_path = furi_string_alloc();
+    spi_mem_file_get_hash_path(app, hash_path);
+    app->hash_file = storage_file_alloc(app->storage);
+    do {
+        if(!storage_file_open(
+               app->hash_file, furi_string_get_cstr(hash_path), FSAM_READ, FSOM_OPEN_EXISTING))
+            break;
+        if(storage_file_read(app->hash_file, header, sizeof(SPIMemHashHeader)) !=
+           sizeof(SPIMemHashHeader))
+            break;
+        if(header->magic != SPI_MEM_HASH_MAGIC) break;
+        if(header->version != SPI_MEM_HASH_VERSION) break;
+        if(header->image_size != spi_mem_file_get_size(app)) break;
+        uint32_t dump_size, dump_timestamp;
+        if(!spi_mem_file_get_dump_stamp(app, &dump_size, &dump_timestamp)) break;
+        if(header->dump_size != dump_size || header->dump_timestamp != dump_timestamp) break;
+        size_t crc_table_size = spi_mem_hash_get_sector_count(header) * sizeof(uint32_t);
+        if(storage_file_size(app->hash_file) != sizeof(SPIMemHashHeader) + crc_table_size)
+            break;
+        success = true;
+    } while(0);
+    furi_string_free(hash_path);
+    if(!success) spi_mem_file_hash_close(app);
+    return success;
+}
+
+// Call once the dump file is closed, the header records its final size and timestamp
+bool spi_mem_file_hash_write_header(SPIMemApp* app, SPIMemHashHeader* header) {
+    if(!app->hash_file) return false;
+    if(!spi_mem_file_get_dump_stamp(app, &header->dump_size, &header->dump_timestamp))
+        return false;
+    if(!storage_file_seek(app->hash_file, 0, true)) return false;
+    return storage_file_write(app->hash_file, header, sizeof(SPIMemHashHeader)) ==
+           sizeof(SPIMemHashHeader);
+}
+
+bool spi_mem_file_hash_write_crc(SPIMemApp* app, uint32_t crc) {
+    if(!app->hash_file) return false;
+    return storage_file_write(app->hash_file, &crc, sizeof(crc)) == sizeof(crc);
+}
+
+bool spi_mem_file_hash_read_crc(SPIMemApp* app, uint32_t* crc) {
+    if(!app->hash_file) return false;
+    return storage_file_read(app->hash_file, crc, sizeof(uint32_t)) == sizeof(uint32_t);
+}
+
+void spi_mem_file_hash_close(SPIMemApp* app) {
+    if(!app->hash_file) return;
+    storage_file_close(app->hash_file);
+    storage_file_free(app->hash_file);
+    app->hash_file = NULL;
+}
+
+void spi_mem_file_hash_delete(SPIMemApp* app) {
+    FuriString* hash_path = furi_string_alloc();
+    spi_mem_file_get_hash_path(app, hash_path);
+    storage_simply_remove(app->storage, furi_string_get_cstr(hash_path));
+    furi_string_free(hash_path);
+}
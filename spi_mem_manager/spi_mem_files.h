@@ -1,5 +1,6 @@
 #pragma once
 #include "spi_mem_app.h"
+#include "lib/spi/spi_mem_hash.h"
 
 bool spi_mem_file_select(SPIMemApp* app);
 bool spi_mem_file_create(SPIMemApp* app, const char* file_name);
@@ -8,6 +9,16 @@ bool spi_mem_file_create_open(SPIMemApp* app);
 bool spi_mem_file_open(SPIMemApp* app);
 bool spi_mem_file_write_block(SPIMemApp* app, uint8_t* data, size_t size);
 bool spi_mem_file_read_block(SPIMemApp* app, uint8_t* data, size_t size);
+bool spi_mem_file_seek(SPIMemApp* app, size_t offset);
 void spi_mem_file_close(SPIMemApp* app);
 void spi_mem_file_show_storage_error(SPIMemApp* app, const char* error_text);
 size_t spi_mem_file_get_size(SPIMemApp* app);
+size_t spi_mem_file_get_disk_size(SPIMemApp* app);
+bool spi_mem_file_is_packed(SPIMemApp* app);
+bool spi_mem_file_hash_create_open(SPIMemApp* app);
+bool spi_mem_file_hash_open(SPIMemApp* app, SPIMemHashHeader* header);
+bool spi_mem_file_hash_write_header(SPIMemApp* app, SPIMemHashHeader* header);
+bool spi_mem_file_hash_write_crc(SPIMemApp* app, uint32_t crc);
+bool spi_mem_file_hash_read_crc(SPIMemApp* app, uint32_t* crc);
+void spi_mem_file_hash_close(SPIMemApp* app);
+void spi_mem_file_hash_delete(SPIMemApp* app);
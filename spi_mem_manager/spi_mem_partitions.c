@@ -0,0 +1,58 @@
+#include "spi_mem_app_i.h"
+#include "spi_mem_partitions.h"
+#include "lib/spi/spi_mem_tools.h"
+#include <flipper_format/flipper_format.h>
+
+#define SPI_MEM_PARTITION_MAP_FILETYPE "Flipper SPI Mem Partition Map"
+#define SPI_MEM_PARTITION_MAP_VERSION 1
+
+/*
+ * Optional partition map, one Name/Offset/Size triplet per region:
+ *
+ * Filetype: Flipper SPI Mem Partition Map
+ * Version: 1
+ * Name: bootloader
+ * Offset: 0
+ * Size: 65536
+ */
+bool spi_mem_partitions_load(SPIMemApp* app) {
+    FlipperFormat* flipper_format = flipper_format_file_alloc(app->storage);
+    FuriString* temp_str = furi_string_alloc();
+    uint32_t version = 0;
+    bool success = false;
+    partitions_reset(app->partitions);
+    do {
+        if(!flipper_format_file_open_existing(flipper_format, SPI_MEM_PARTITION_MAP_PATH)) break;
+        if(!flipper_format_read_header(flipper_format, temp_str, &version)) break;
+        if(furi_string_cmp_str(temp_str, SPI_MEM_PARTITION_MAP_FILETYPE) != 0) break;
+        if(version != SPI_MEM_PARTITION_MAP_VERSION) break;
+        while(flipper_format_read_string(flipper_format, "Name", temp_str)) {
+            SPIMemPartition partition;
+            snprintf(
+                partition.name, sizeof(partition.name), "%s", furi_string_get_cstr(temp_str));
+            if(!flipper_format_read_uint32(flipper_format, "Offset", &partition.offset, 1)) break;
+            if(!flipper_format_read_uint32(flipper_format, "Size", &partition.size, 1)) break;
+            if(partition.size == 0) continue;
+            partitions_push_back(app->partitions, partition);
+        }
+        success = true;
+    } while(0);
+    if(!success) FURI_LOG_D(TAG, "No partition map loaded");
+    furi_string_free(temp_str);
+    flipper_format_free(flipper_format);
+    return success;
+}
+
+// Size of the selected region clamped to the chip, whole chip if nothing is selected
+size_t spi_mem_partitions_get_range_size(SPIMemApp* app) {
+    size_t chip_size = spi_mem_chip_get_size(app->chip_info);
+    if(app->range.offset >= chip_size) return 0;
+    size_t range_size = chip_size - app->range.offset;
+    if(app->range.size && (app->range.size < range_size)) range_size = app->range.size;
+    return range_size;
+}
+
+bool spi_mem_partitions_is_erasable(const SPIMemPartition* partition) {
+    return ((partition->offset % SPI_MEM_SECTOR_SIZE) == 0) &&
+           ((partition->size % SPI_MEM_SECTOR_SIZE) == 0);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <furi.h>
+#include <m-array.h>
+#include "spi_mem_app.h"
+
+#define SPI_MEM_PARTITION_NAME_SIZE 24
+
+typedef struct {
+    char name[SPI_MEM_PARTITION_NAME_SIZE];
+    uint32_t offset;
+    uint32_t size;
+} SPIMemPartition;
+
+ARRAY_DEF(partitions, SPIMemPartition, M_POD_OPLIST)
+
+bool spi_mem_partitions_load(SPIMemApp* app);
+size_t spi_mem_partitions_get_range_size(SPIMemApp* app);
+bool spi_mem_partitions_is_erasable(const SPIMemPartition* partition);
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x5A4D5053  # "SPMZ"
+VERSION = 1
+BLOCK_SIZE = 4096
+
+HEADER = struct.Struct("<IHHIII")
+INDEX_ENTRY = struct.Struct("<BBH")
+
+BLOCK_TYPE_ERASED = 0
+BLOCK_TYPE_RAW = 1
+BLOCK_TYPE_LZ4 = 2
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5
+LZ4_MF_LIMIT = 12
+LZ4_HASH_LOG = 10
+
+
+def lz4_put_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def lz4_put_sequence(out, literals, offset, match_size):
+    token = min(len(literals), 15) << 4
+    token_pos = len(out)
+    out.append(0)
+    if len(literals) >= 15:
+        lz4_put_length(out, len(literals) - 15)
+    out += literals
+    if match_size:
+        out += struct.pack("<H", offset)
+        match_code = match_size - LZ4_MIN_MATCH
+        token |= min(match_code, 15)
+        if match_code >= 15:
+            lz4_put_length(out, match_code - 15)
+    out[token_pos] = token
+
+
+# Same greedy matcher as spi_mem_pack_lz4_encode, so packed files are identical
+def lz4_encode(src):
+    out = bytearray()
+    table = [0] * (1 << LZ4_HASH_LOG)
+    anchor = pos = 0
+    if len(src) > LZ4_MF_LIMIT:
+        match_start_limit = len(src) - LZ4_MF_LIMIT
+        match_end_limit = len(src) - LZ4_LAST_LITERALS
+        while pos < match_start_limit:
+            sequence = src[pos : pos + 4]
+            value = struct.unpack("<I", sequence)[0]
+            hash = ((value * 2654435761) & 0xFFFFFFFF) >> (32 - LZ4_HASH_LOG)
+            ref = table[hash]
+            table[hash] = pos
+            if ref >= pos or src[ref : ref + 4] != sequence:
+                pos += 1
+                continue
+            match_size = LZ4_MIN_MATCH
+            while (
+                pos + match_size < match_end_limit
+                and src[ref + match_size] == src[pos + match_size]
+            ):
+                match_size += 1
+            lz4_put_sequence(out, src[anchor:pos], pos - ref, match_size)
+            pos += match_size
+            anchor = pos
+    lz4_put_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+
+def lz4_get_length(src, pos):
+    length = 0
+    while True:
+        byte = src[pos]
+        pos += 1
+        length += byte
+        if byte != 255:
+            return length, pos
+
+
+def lz4_decode(src, size):
+    out = bytearray()
+    pos = 0
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+        literals_size = token >> 4
+        if literals_size == 15:
+            extra, pos = lz4_get_length(src, pos)
+            literals_size += extra
+        out += src[pos : pos + literals_size]
+        pos += literals_size
+        if pos >= len(src):
+            break
+        offset = src[pos] | (src[pos + 1] << 8)
+        pos += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("corrupted LZ4 block")
+        match_size = token & 0x0F
+        if match_size == 15:
+            extra, pos = lz4_get_length(src, pos)
+            match_size += extra
+        for _ in range(match_size + LZ4_MIN_MATCH):
+            out.append(out[-offset])
+    if len(out) != size:
+        raise ValueError("LZ4 block size mismatch")
+    return bytes(out)
+
+
+def pack(raw):
+    block_count = (len(raw) + BLOCK_SIZE - 1) // BLOCK_SIZE
+    index = bytearray()
+    data = bytearray()
+    for offset in range(0, len(raw), BLOCK_SIZE):
+        block = raw[offset : offset + BLOCK_SIZE]
+        if block == b"\xff" * len(block):
+            index += INDEX_ENTRY.pack(BLOCK_TYPE_ERASED, 0, 0)
+            continue
+        packed = lz4_encode(block)
+        if len(packed) < len(block):
+            index += INDEX_ENTRY.pack(BLOCK_TYPE_LZ4, 0, len(packed))
+            data += packed
+        else:
+            index += INDEX_ENTRY.pack(BLOCK_TYPE_RAW, 0, len(block))
+            data += block
+    header = HEADER.pack(MAGIC, VERSION, 0, len(raw), BLOCK_SIZE, block_count)
+    return header + index + data
+
+
+def unpack(packed):
+    magic, version, _, image_size, block_size, block_count = HEADER.unpack_from(packed)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a packed SPI Mem dump")
+    index_offset = HEADER.size
+    data_offset = index_offset + block_count * INDEX_ENTRY.size
+    raw = bytearray()
+    for block in range((image_size + block_size - 1) // block_size):
+        size = min(block_size, image_size - len(raw))
+        block_type, _, payload_size = INDEX_ENTRY.unpack_from(
+            packed, index_offset + block * INDEX_ENTRY.size
+        )
+        payload = packed[data_offset : data_offset + payload_size]
+        data_offset += payload_size
+        if block_type == BLOCK_TYPE_ERASED:
+            raw += b"\xff" * size
+        elif block_type == BLOCK_TYPE_RAW:
+            raw += payload
+        elif block_type == BLOCK_TYPE_LZ4:
+            raw += lz4_decode(payload, size)
+        else:
+            raise ValueError(f"unknown block type {block_type} at block {block}")
+    return bytes(raw)
+
+
+def is_packed(data):
+    return len(data) >= HEADER.size and HEADER.unpack_from(data)[0] == MAGIC
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert SPI Mem Manager dumps")
+    parser.add_argument("command", choices=["pack", "unpack", "info"])
+    parser.add_argument("input")
+    parser.add_argument("output", nargs="?")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as file:
+        data = file.read()
+
+    if args.command == "info":
+        if not is_packed(data):
+            print(f"raw dump, {len(data)} bytes")
+            return 0
+        image_size = HEADER.unpack_from(data)[3]
+        print(f"packed dump, {image_size} bytes image, {len(data)} bytes on disk")
+        return 0
+
+    if not args.output:
+        parser.error("output file is required")
+    if args.command == "pack":
+        if is_packed(data):
+            parser.error("input is already packed")
+        result = pack(data)
+    else:
+        result = unpack(data) if is_packed(data) else data
+
+    with open(args.output, "wb") as file:
+        file.write(result)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,23 @@
+/**
+ * @file crc32.h
+ * @brief CRC-32 (IEEE 802.3) calculation.
+ *
+ * Produces the same values as the RP2040 DMA sniffer
+ * configured for CRC-32 with bit-reversed data and output.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Update a CRC-32 value with a buffer.
+ *
+ * Start with a zero value to calculate a fresh CRC.
+ *
+ * @param[in] crc previous CRC-32 value.
+ * @param[in] data pointer to the buffer containing the data.
+ * @param[in] data_size size of the data, in bytes.
+ * @returns updated CRC-32 value.
+ */
+uint32_t crc32_calc(uint32_t crc, const void* data, size_t data_size);
@@ -5,6 +5,7 @@
 
 #include "uf2.h"
 #include "swd.h"
+#include "crc32.h"
 #include "board.h"
 #include "target.h"
 #include "rp2040.h"
@@ -14,18 +15,62 @@
 #define W25Q128_CAPACITY (0x1000000UL)
 #define W25Q128_PAGE_SIZE (0x100UL)
 #define W25Q128_SECTOR_SIZE (0x1000UL)
+#define W25Q128_BLOCK_SIZE (0x10000UL)
+#define W25Q128_SECTORS_PER_BLOCK (W25Q128_BLOCK_SIZE / W25Q128_SECTOR_SIZE)
+#define W25Q128_PAGES_PER_SECTOR (W25Q128_SECTOR_SIZE / W25Q128_PAGE_SIZE)
 
-#define PROGRESS_VERIFY_WEIGHT (4U)
-#define PROGRESS_ERASE_WEIGHT (6U)
-#define PROGRESS_PROGRAM_WEIGHT (90U)
+#define PROGRESS_PROGRAM_WEIGHT (95U)
+#define PROGRESS_VERIFY_WEIGHT (5U)
 
 #define FLASHER_ATTEMPT_COUNT (10UL)
 
+// Erase the whole block instead of single sectors if more sectors than this have changed
+#define FLASHER_BLOCK_ERASE_THRESHOLD (W25Q128_SECTORS_PER_BLOCK / 2U)
+
+// Sectors built while scanning that are kept until programmed, each takes W25Q128_SECTOR_SIZE
+#define FLASHER_SECTOR_CACHE_COUNT (4U)
+
+// Sectors the image may touch, bounds the sector list to 12 KiB (a 4 MiB image)
+#define FLASHER_SECTOR_COUNT_MAX (1024U)
+
+typedef enum {
+    FlasherSectorFlagRegular = 1U << 0, // Image CRC known from the file scan
+    FlasherSectorFlagChanged = 1U << 1, // Flash contents differ from the image
+    FlasherSectorFlagCached = 1U << 2, // Image data is held in the sector cache
+    FlasherSectorFlagProgrammed = 1U << 3, // Sector has been erased and programmed
+} FlasherSectorFlag;
+
+typedef struct {
+    uint32_t address;
+    uint32_t crc;
+    uint16_t coverage;
+    uint8_t flags;
+    uint8_t cache_index;
+} FlasherSector;
+
+ARRAY_DEF(FlasherSectorArray, FlasherSector, M_POD_OPLIST);
+
 typedef struct {
     FlasherCallback callback;
     void* context;
+    bool use_loader;
+    bool xip_mode;
 } Flasher;
 
+typedef struct {
+    File* file;
+    Uf2ExtentArray_t extents;
+    Uf2SectorArray_t crcs;
+    FlasherSectorArray_t sectors;
+    size_t data_size;
+    size_t progress_size;
+    uint8_t progress;
+    uint8_t* file_buf;
+    uint8_t* buf;
+    uint8_t* cache[FLASHER_SECTOR_CACHE_COUNT];
+    uint32_t cache_count;
+} FlasherImage;
+
 static Flasher flasher;
 
 bool flasher_init(void) {
@@ -58,15 +103,65 @@ void flasher_set_callback(FlasherCallback callback, void* context) {
 }
 
 static inline bool flasher_init_chip(void) {
-    return rp2040_init();
+    flasher.xip_mode = false;
+    // Prefer the bootrom-based loader, fall back to driving the SSI directly
+    flasher.use_loader = rp2040_loader_init();
+    if(!flasher.use_loader) {
+        FURI_LOG_W(TAG, "Flash loader unavailable, using direct SSI access");
+        return rp2040_init();
+    }
+    return true;
+}
+
+// With the loader, the flash can either be read via XIP or erased and programmed, not both
+static bool flasher_set_xip_mode(bool enable) {
+    if(!flasher.use_loader || flasher.xip_mode == enable) return true;
+    if(!(enable ? rp2040_loader_finish() : rp2040_loader_begin())) return false;
+    flasher.xip_mode = enable;
+    return true;
+}
+
+static bool flasher_erase(uint32_t address, size_t size) {
+    if(flasher.use_loader) {
+        return flasher_set_xip_mode(false) && rp2040_loader_erase(address, size);
+    }
+
+    for(size_t offset = 0; offset < size; offset += W25Q128_SECTOR_SIZE) {
+        if(!rp2040_flash_erase_sector(address + offset)) return false;
+    }
+
+    return true;
 }
 
-static inline bool flasher_erase_sector(uint32_t address) {
-    return rp2040_flash_erase_sector(address);
+static bool flasher_program(uint32_t address, const void* data, size_t data_size) {
+    if(flasher.use_loader) {
+        return flasher_set_xip_mode(false) && rp2040_loader_program(address, data, data_size);
+    }
+
+    const uint8_t* tx_data = data;
+
+    for(size_t offset = 0; offset < data_size; offset += W25Q128_PAGE_SIZE) {
+        if(!rp2040_flash_program_page(address + offset, &tx_data[offset], W25Q128_PAGE_SIZE))
+            return false;
+    }
+
+    return true;
+}
+
+static inline bool flasher_program_finish(void) {
+    return flasher_set_xip_mode(true);
+}
+
+static bool flasher_read_flash(uint32_t address, void* data, size_t data_size) {
+    if(flasher.use_loader) {
+        return flasher_set_xip_mode(true) && rp2040_flash_read_xip(address, data, data_size);
+    }
+    return rp2040_flash_read_data(address, data, data_size);
 }
 
-static inline bool flasher_program_page(uint32_t address, const void* data, size_t data_size) {
-    return rp2040_flash_program_page(address, data, data_size);
+static inline bool flasher_get_flash_crc(uint32_t address, size_t size, uint32_t* crc) {
+    furi_assert(flasher.use_loader);
+    return flasher_set_xip_mode(true) && rp2040_flash_crc32(address, size, crc);
 }
 
 static void flasher_emit_progress(uint8_t start, uint8_t weight, uint8_t progress) {
@@ -139,133 +234,498 @@ static bool flasher_prepare_file(File* file, const char* file_path) {
     return success;
 }
 
-static bool flasher_verify_file(File* file, size_t* data_size) {
-    bool success = false;
+// Count the sectors touched by the image, extents sharing a sector count it once
+static size_t flasher_get_sector_count(FlasherImage* image) {
+    size_t sector_count = 0;
+    uint32_t next_address = 0;
 
-    do {
-        uint32_t block_count;
-        if(!uf2_get_block_count(file, &block_count)) {
-            FURI_LOG_E(TAG, "Failed to get block count");
-            flasher_emit_error(FlasherErrorBadFile);
-            break;
+    for(size_t i = 0; i < Uf2ExtentArray_size(image->extents); ++i) {
+        const Uf2Extent* extent = Uf2ExtentArray_cget(image->extents, i);
+        const uint32_t start = extent->address & ~(W25Q128_SECTOR_SIZE - 1);
+        const uint32_t end = extent->address + extent->size;
+        const uint32_t address = MAX(start, next_address);
+
+        if(address < end) {
+            sector_count += (end - address + W25Q128_SECTOR_SIZE - 1) / W25Q128_SECTOR_SIZE;
+            next_address = (end + W25Q128_SECTOR_SIZE - 1) & ~(W25Q128_SECTOR_SIZE - 1);
         }
+    }
+
+    return sector_count;
+}
+
+// List the sectors touched by the image along with their image CRCs, where known in advance
+static bool flasher_prepare_sectors(FlasherImage* image) {
+    FlasherSectorArray_reset(image->sectors);
+
+    const size_t sector_count = flasher_get_sector_count(image);
+    if(sector_count > FLASHER_SECTOR_COUNT_MAX) {
+        FURI_LOG_E(
+            TAG,
+            "Image covers %zu sectors, at most %u are supported",
+            sector_count,
+            FLASHER_SECTOR_COUNT_MAX);
+        return false;
+    }
 
-        uint32_t blocks_verified;
-        uint8_t prev_progress = UINT8_MAX;
+    FlasherSectorArray_reserve(image->sectors, sector_count);
 
-        for(blocks_verified = 0; blocks_verified < block_count; ++blocks_verified) {
-            if(!uf2_verify_block(file, RP2040_FAMILY_ID, W25Q128_PAGE_SIZE)) break;
+    for(size_t i = 0; i < Uf2ExtentArray_size(image->extents); ++i) {
+        const Uf2Extent* extent = Uf2ExtentArray_cget(image->extents, i);
+        const uint32_t end_address = extent->address + extent->size;
 
-            const uint8_t verify_progress = (blocks_verified * 100UL) / block_count;
-            if(verify_progress != prev_progress) {
-                prev_progress = verify_progress;
-                flasher_emit_progress(0, PROGRESS_VERIFY_WEIGHT, verify_progress);
-                FURI_LOG_D(TAG, "Verifying file: %u%%", verify_progress);
+        uint32_t address = extent->address & ~(W25Q128_SECTOR_SIZE - 1);
+        for(; address < end_address; address += W25Q128_SECTOR_SIZE) {
+            const uint32_t start = MAX(extent->address, address);
+            const uint32_t end = MIN(end_address, address + W25Q128_SECTOR_SIZE);
+
+            // Extents are sorted, so a shared sector can only be the last one listed
+            const size_t sector_count = FlasherSectorArray_size(image->sectors);
+            FlasherSector* last =
+                sector_count > 0 ? FlasherSectorArray_get(image->sectors, sector_count - 1) : NULL;
+            if(last && last->address == address) {
+                last->coverage += end - start;
+                continue;
             }
+
+            const FlasherSector sector = {
+                .address = address,
+                .coverage = end - start,
+            };
+
+            FlasherSectorArray_push_back(image->sectors, sector);
         }
+    }
+
+    // Both arrays are sorted by address
+    size_t j = 0;
+    for(size_t i = 0; i < Uf2SectorArray_size(image->crcs); ++i) {
+        const Uf2Sector* crc = Uf2SectorArray_cget(image->crcs, i);
+
+        while(FlasherSectorArray_get(image->sectors, j)->address < crc->address) {
+            ++j;
+        }
+
+        FlasherSector* sector = FlasherSectorArray_get(image->sectors, j);
+        sector->crc = crc->crc;
+        sector->flags |= FlasherSectorFlagRegular;
+    }
+
+    return true;
+}
+
+static bool flasher_prepare_image(FlasherImage* image) {
+    bool success = false;
 
-        if(blocks_verified < block_count) {
-            FURI_LOG_E(TAG, "Failed to verify all blocks");
+    do {
+        if(!uf2_get_extents(
+               image->file,
+               RP2040_FAMILY_ID,
+               W25Q128_PAGE_SIZE,
+               W25Q128_SECTOR_SIZE,
+               image->extents,
+               image->crcs)) {
+            FURI_LOG_E(TAG, "Failed to read UF2 blocks");
             flasher_emit_error(FlasherErrorBadFile);
             break;
         }
 
-        const size_t size_total = block_count * W25Q128_PAGE_SIZE;
+        image->data_size = 0;
+
+        size_t i;
+        for(i = 0; i < Uf2ExtentArray_size(image->extents); ++i) {
+            Uf2Extent* extent = Uf2ExtentArray_get(image->extents, i);
+            if(extent->address < RP2040_FLASH_BASE_ADDR) break;
+            // Convert to flash address space
+            extent->address -= RP2040_FLASH_BASE_ADDR;
+            if(extent->address + extent->size > W25Q128_CAPACITY) break;
+            image->data_size += extent->size;
+        }
 
-        if(size_total > W25Q128_CAPACITY) {
-            FURI_LOG_E(TAG, "File is too large to fit on the flash");
+        if(i < Uf2ExtentArray_size(image->extents)) {
+            FURI_LOG_E(TAG, "File does not fit on the flash");
             flasher_emit_error(FlasherErrorBadFile);
             break;
         }
 
-        if(!storage_file_seek(file, 0, true)) {
-            FURI_LOG_E(TAG, "Failed to rewind the file");
+        for(i = 0; i < Uf2SectorArray_size(image->crcs); ++i) {
+            Uf2SectorArray_get(image->crcs, i)->address -= RP2040_FLASH_BASE_ADDR;
+        }
+
+        if(!flasher_prepare_sectors(image)) {
             flasher_emit_error(FlasherErrorBadFile);
             break;
         }
 
-        *data_size = size_total;
         success = true;
     } while(false);
 
     return success;
 }
 
-static bool flasher_erase_flash(size_t erase_size) {
-    uint8_t prev_progress = UINT8_MAX;
+// Get the new sector contents: image data where available, current flash contents elsewhere
+static bool flasher_build_sector(FlasherImage* image, const FlasherSector* sector, uint8_t* buf) {
+    const uint32_t address = sector->address;
 
-    size_t size_erased;
-    for(size_erased = 0; size_erased < erase_size;) {
-        if(!flasher_erase_sector(size_erased)) {
-            FURI_LOG_E(TAG, "Failed to erase flash sector at address 0x%zX", size_erased);
+    if(sector->coverage < W25Q128_SECTOR_SIZE) {
+        if(!flasher_read_flash(address, buf, W25Q128_SECTOR_SIZE)) {
+            FURI_LOG_E(TAG, "Failed to read flash at address 0x%lX", address);
             flasher_emit_error(FlasherErrorDisconnect);
-            break;
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < Uf2ExtentArray_size(image->extents); ++i) {
+        const Uf2Extent* extent = Uf2ExtentArray_cget(image->extents, i);
+        const uint32_t start = MAX(extent->address, address);
+        const uint32_t end = MIN(extent->address + extent->size, address + W25Q128_SECTOR_SIZE);
+        if(start >= end) continue;
+
+        const size_t block_count = (end - start) / W25Q128_PAGE_SIZE;
+        const uint32_t first_block_index =
+            uf2_extent_get_block_index(extent, start, W25Q128_PAGE_SIZE);
+        const uint32_t last_block_index =
+            uf2_extent_get_block_index(extent, end - W25Q128_PAGE_SIZE, W25Q128_PAGE_SIZE);
+        const uint32_t block_index = MIN(first_block_index, last_block_index);
+
+        if(!uf2_seek_block(image->file, block_index) ||
+           !uf2_read_blocks(image->file, image->file_buf, block_count)) {
+            FURI_LOG_E(TAG, "Failed to read UF2 blocks");
+            flasher_emit_error(FlasherErrorBadFile);
+            return false;
         }
 
-        size_erased += MIN(erase_size - size_erased, W25Q128_SECTOR_SIZE);
+        uint8_t* data = &buf[start - address];
+
+        size_t j;
+        for(j = 0; j < block_count; ++j) {
+            // Blocks stored in descending address order fill the data from the end
+            const size_t page_index = extent->block_step < 0 ? block_count - 1 - j : j;
+            if(!uf2_parse_block(
+                   &image->file_buf[j * UF2_BLOCK_SIZE],
+                   RP2040_FAMILY_ID,
+                   NULL,
+                   &data[page_index * W25Q128_PAGE_SIZE],
+                   W25Q128_PAGE_SIZE))
+                break;
+        }
 
-        const uint8_t erase_progress = (size_erased * 100UL) / erase_size;
-        if(erase_progress != prev_progress) {
-            prev_progress = erase_progress;
-            flasher_emit_progress(PROGRESS_VERIFY_WEIGHT, PROGRESS_ERASE_WEIGHT, erase_progress);
-            FURI_LOG_D(TAG, "Erasing flash: %u%%", erase_progress);
+        if(j < block_count) {
+            FURI_LOG_E(TAG, "Failed to verify UF2 block #%lu", block_index + j);
+            flasher_emit_error(FlasherErrorBadFile);
+            return false;
         }
     }
 
-    return size_erased == erase_size;
+    return true;
 }
 
-static bool flasher_program_flash(File* file, size_t data_size) {
-    uint8_t prev_progress = UINT8_MAX;
+// Get the sector contents for programming, building them unless cached during the scan
+static const uint8_t* flasher_get_sector_data(FlasherImage* image, const FlasherSector* sector) {
+    if(sector->flags & FlasherSectorFlagCached) {
+        return image->cache[sector->cache_index];
+    }
 
-    size_t size_programmed;
-    for(size_programmed = 0; size_programmed < data_size;) {
-        uint8_t buf[W25Q128_PAGE_SIZE];
+    // Flash contents are not readable while programming, so only fully covered sectors get here
+    furi_assert(sector->coverage == W25Q128_SECTOR_SIZE);
+    return flasher_build_sector(image, sector, image->buf) ? image->buf : NULL;
+}
 
-        if(!uf2_read_block(file, buf, W25Q128_PAGE_SIZE)) {
-            FURI_LOG_E(TAG, "Failed to read UF2 block");
-            flasher_emit_error(FlasherErrorBadFile);
-            break;
+static bool flasher_is_page_erased(const uint8_t* data) {
+    for(size_t i = 0; i < W25Q128_PAGE_SIZE; ++i) {
+        if(data[i] != 0xFFU) return false;
+    }
+    return true;
+}
+
+// Program one freshly erased sector, skipping the pages that are to remain erased
+static bool flasher_program_sector(uint32_t address, const uint8_t* data) {
+    for(size_t offset = 0; offset < W25Q128_SECTOR_SIZE;) {
+        if(flasher_is_page_erased(&data[offset])) {
+            offset += W25Q128_PAGE_SIZE;
+            continue;
+        }
+
+        size_t run_size = W25Q128_PAGE_SIZE;
+        while(offset + run_size < W25Q128_SECTOR_SIZE &&
+              !flasher_is_page_erased(&data[offset + run_size])) {
+            run_size += W25Q128_PAGE_SIZE;
+        }
+
+        if(!flasher_program(address + offset, &data[offset], run_size)) {
+            FURI_LOG_E(TAG, "Failed to program flash at address 0x%lX", address + offset);
+            flasher_emit_error(FlasherErrorDisconnect);
+            return false;
+        }
+
+        offset += run_size;
+    }
+
+    return true;
+}
+
+static bool flasher_erase_sector(uint32_t address) {
+    if(!flasher_erase(address, W25Q128_SECTOR_SIZE)) {
+        FURI_LOG_E(TAG, "Failed to erase flash sector at address 0x%lX", address);
+        flasher_emit_error(FlasherErrorDisconnect);
+        return false;
+    }
+    return true;
+}
+
+// Scanning and programming each count for half of the programming progress
+static void flasher_advance_progress(FlasherImage* image, const FlasherSector* sector) {
+    image->progress_size += sector->coverage;
+
+    const uint8_t progress = (image->progress_size * 50UL) / image->data_size;
+    if(progress != image->progress) {
+        image->progress = progress;
+        flasher_emit_progress(0, PROGRESS_PROGRAM_WEIGHT, progress);
+        FURI_LOG_D(TAG, "Programming flash: %u%%", progress);
+    }
+}
+
+// Building the sector needs XIP for the flash contents or the CRC, so keep the result
+static inline bool flasher_is_built_on_scan(const FlasherSector* sector) {
+    return sector->coverage < W25Q128_SECTOR_SIZE ||
+           (flasher.use_loader && !(sector->flags & FlasherSectorFlagRegular));
+}
+
+// Find out whether the sector differs from the image, using CRCs calculated on the target
+static bool flasher_scan_sector(FlasherImage* image, FlasherSector* sector) {
+    uint8_t* data = NULL;
+
+    if(flasher_is_built_on_scan(sector)) {
+        furi_assert(image->cache_count < FLASHER_SECTOR_CACHE_COUNT);
+
+        if(!image->cache[image->cache_count]) {
+            image->cache[image->cache_count] = malloc(W25Q128_SECTOR_SIZE);
         }
 
-        if(!flasher_program_page(size_programmed, buf, W25Q128_PAGE_SIZE)) {
-            FURI_LOG_E(TAG, "Failed to program flash page at address 0x%zX", size_programmed);
+        data = image->cache[image->cache_count];
+        if(!flasher_build_sector(image, sector, data)) return false;
+
+        sector->crc = crc32_calc(0, data, W25Q128_SECTOR_SIZE);
+    }
+
+    bool changed = true;
+
+    if(flasher.use_loader) {
+        uint32_t flash_crc;
+        if(!flasher_get_flash_crc(sector->address, W25Q128_SECTOR_SIZE, &flash_crc)) {
+            FURI_LOG_E(TAG, "Failed to calculate flash CRC at address 0x%lX", sector->address);
             flasher_emit_error(FlasherErrorDisconnect);
+            return false;
+        }
+        changed = flash_crc != sector->crc;
+    }
+
+    if(changed) {
+        sector->flags |= FlasherSectorFlagChanged;
+        if(data) {
+            sector->flags |= FlasherSectorFlagCached;
+            sector->cache_index = image->cache_count++;
+        }
+    }
+
+    return true;
+}
+
+// Scan the sectors from first on until either all are done or the cache is full
+static bool flasher_scan_sectors(FlasherImage* image, size_t first, size_t* last) {
+    const size_t sector_count = FlasherSectorArray_size(image->sectors);
+
+    image->cache_count = 0;
+
+    size_t i;
+    for(i = first; i < sector_count; ++i) {
+        FlasherSector* sector = FlasherSectorArray_get(image->sectors, i);
+        if(flasher_is_built_on_scan(sector) && image->cache_count == FLASHER_SECTOR_CACHE_COUNT)
             break;
+        if(!flasher_scan_sector(image, sector)) return false;
+        flasher_advance_progress(image, sector);
+    }
+
+    *last = i;
+    return true;
+}
+
+// Erasing the whole block is faster, but the unchanged sectors must be programmed again
+static bool flasher_is_block_erase_worth(const FlasherImage* image, size_t first, size_t last) {
+    if(last - first != W25Q128_SECTORS_PER_BLOCK) return false;
+
+    uint32_t changed_count = 0;
+
+    for(size_t i = first; i < last; ++i) {
+        const FlasherSector* sector = FlasherSectorArray_cget(image->sectors, i);
+        if(sector->coverage < W25Q128_SECTOR_SIZE) return false;
+        if(sector->flags & FlasherSectorFlagChanged) {
+            ++changed_count;
+        } else if(!(sector->flags & FlasherSectorFlagRegular)) {
+            // Could only be programmed again by building it a second time
+            return false;
+        }
+    }
+
+    return changed_count > FLASHER_BLOCK_ERASE_THRESHOLD;
+}
+
+// Program the changed sectors of one block, all of them within [first, last)
+static bool flasher_program_block(FlasherImage* image, size_t first, size_t last) {
+    const bool erase_block = flasher_is_block_erase_worth(image, first, last);
+
+    if(erase_block) {
+        const uint32_t address = FlasherSectorArray_cget(image->sectors, first)->address;
+        if(!flasher_erase(address, W25Q128_BLOCK_SIZE)) {
+            FURI_LOG_E(TAG, "Failed to erase flash block at address 0x%lX", address);
+            flasher_emit_error(FlasherErrorDisconnect);
+            return false;
+        }
+    }
+
+    for(size_t i = first; i < last; ++i) {
+        FlasherSector* sector = FlasherSectorArray_get(image->sectors, i);
+
+        if(erase_block || (sector->flags & FlasherSectorFlagChanged)) {
+            const uint8_t* data = flasher_get_sector_data(image, sector);
+            if(!data) return false;
+            if(!erase_block && !flasher_erase_sector(sector->address)) return false;
+            if(!flasher_program_sector(sector->address, data)) return false;
+            sector->flags |= FlasherSectorFlagProgrammed;
+        }
+
+        flasher_advance_progress(image, sector);
+    }
+
+    return true;
+}
+
+// Program the changed sectors in [first, last), one block at a time
+static bool flasher_program_sectors(FlasherImage* image, size_t first, size_t last) {
+    while(first < last) {
+        const uint32_t block_address = FlasherSectorArray_cget(image->sectors, first)->address &
+                                       ~(W25Q128_BLOCK_SIZE - 1);
+
+        size_t block_last = first + 1;
+        while(block_last < last &&
+              (FlasherSectorArray_cget(image->sectors, block_last)->address &
+               ~(W25Q128_BLOCK_SIZE - 1)) == block_address) {
+            ++block_last;
         }
 
-        size_programmed += W25Q128_PAGE_SIZE;
+        if(!flasher_program_block(image, first, block_last)) return false;
+        first = block_last;
+    }
+
+    return true;
+}
+
+// Scan with XIP enabled, then program with it disabled, usually switching just once per run
+static bool flasher_program_flash(FlasherImage* image) {
+    const size_t sector_count = FlasherSectorArray_size(image->sectors);
+
+    image->progress_size = 0;
+    image->progress = UINT8_MAX;
+
+    for(size_t first = 0; first < sector_count;) {
+        size_t last;
+        if(!flasher_scan_sectors(image, first, &last)) return false;
+        if(!flasher_program_sectors(image, first, last)) return false;
+        first = last;
+    }
+
+    if(!flasher_program_finish()) {
+        FURI_LOG_E(TAG, "Failed to finish programming");
+        flasher_emit_error(FlasherErrorDisconnect);
+        return false;
+    }
+
+    return true;
+}
+
+static bool flasher_verify_flash(const FlasherImage* image) {
+    // The CRC is calculated on the target and requires the flash loader
+    if(!flasher.use_loader) {
+        FURI_LOG_W(TAG, "Flash loader unavailable, skipping verification");
+        return true;
+    }
+
+    // The rest of the sectors have just been found to match the image
+    for(size_t i = 0; i < FlasherSectorArray_size(image->sectors); ++i) {
+        const FlasherSector* sector = FlasherSectorArray_cget(image->sectors, i);
+        if(!(sector->flags & FlasherSectorFlagProgrammed)) continue;
+
+        uint32_t flash_crc;
+        if(!flasher_get_flash_crc(sector->address, W25Q128_SECTOR_SIZE, &flash_crc)) {
+            FURI_LOG_E(TAG, "Failed to calculate flash CRC");
+            flasher_emit_error(FlasherErrorDisconnect);
+            return false;
+        }
 
-        const uint8_t program_progress = (size_programmed * 100UL) / data_size;
-        if(program_progress != prev_progress) {
-            prev_progress = program_progress;
-            flasher_emit_progress(
-                PROGRESS_VERIFY_WEIGHT + PROGRESS_ERASE_WEIGHT,
-                PROGRESS_PROGRAM_WEIGHT,
-                program_progress);
-            FURI_LOG_D(TAG, "Programming flash: %u%%", program_progress);
+        if(flash_crc != sector->crc) {
+            FURI_LOG_E(
+                TAG,
+                "CRC mismatch at address 0x%lX, expected: 0x%08lX, got: 0x%08lX",
+                sector->address,
+                sector->crc,
+                flash_crc);
+            flasher_emit_error(FlasherErrorVerify);
+            return false;
         }
     }
 
-    return size_programmed == data_size;
+    flasher_emit_progress(PROGRESS_PROGRAM_WEIGHT, PROGRESS_VERIFY_WEIGHT, 100);
+    return true;
 }
 
 void flasher_start(const char* file_path) {
     FURI_LOG_D(TAG, "Flashing firmware from file: %s", file_path);
 
     Storage* storage = furi_record_open(RECORD_STORAGE);
-    File* file = storage_file_alloc(storage);
-    size_t data_size;
+
+    FlasherImage image = {
+        .file = storage_file_alloc(storage),
+        .file_buf = malloc(W25Q128_PAGES_PER_SECTOR * UF2_BLOCK_SIZE),
+        .buf = malloc(W25Q128_SECTOR_SIZE),
+    };
+
+    Uf2ExtentArray_init(image.extents);
+    Uf2SectorArray_init(image.crcs);
+    FlasherSectorArray_init(image.sectors);
+
+    swd_reset_stats();
+    const uint32_t start_tick = furi_get_tick();
 
     do {
         if(!flasher_prepare_target()) break;
-        if(!flasher_prepare_file(file, file_path)) break;
-        if(!flasher_verify_file(file, &data_size)) break;
-        if(!flasher_erase_flash(data_size)) break;
-        if(!flasher_program_flash(file, data_size)) break;
+        if(!flasher_prepare_file(image.file, file_path)) break;
+        if(!flasher_prepare_image(&image)) break;
+        if(!flasher_program_flash(&image)) break;
+        if(!flasher_verify_flash(&image)) break;
         flasher_emit_success();
     } while(false);
 
-    storage_file_free(file);
+    SwdStats stats;
+    swd_get_stats(&stats);
+
+    FURI_LOG_I(
+        TAG,
+        "Done in %lu ms, SWD reads: %lu, writes: %lu, waits: %lu, errors: %lu",
+        furi_get_tick() - start_tick,
+        stats.read_count,
+        stats.write_count,
+        stats.wait_count,
+        stats.error_count);
+
+    for(uint32_t i = 0; i < FLASHER_SECTOR_CACHE_COUNT; ++i) {
+        free(image.cache[i]);
+    }
+
+    FlasherSectorArray_clear(image.sectors);
+    Uf2SectorArray_clear(image.crcs);
+    Uf2ExtentArray_clear(image.extents);
+    free(image.buf);
+    free(image.file_buf);
+    storage_file_free(image.file);
     furi_record_close(RECORD_STORAGE);
 }
@@ -22,6 +22,7 @@ typedef enum {
 typedef enum {
     FlasherErrorBadFile, /**< File error: wrong format, I/O problem, etc.*/
     FlasherErrorDisconnect, /**< Connection error: Module disconnected, frozen, etc. */
+    FlasherErrorVerify, /**< Verification error: flash contents do not match the file. */
     FlasherErrorUnknown, /**< An error that does not fit to any of the above categories. */
 } FlasherError;
 
@@ -89,9 +89,35 @@
 #define RP_RESETS_BASE_ADDR 0x4000c000U
 #define RP_RESETS_RESET (RP_RESETS_BASE_ADDR + 0x00U)
 #define RP_RESETS_RESET_DONE (RP_RESETS_BASE_ADDR + 0x08U)
+#define RP_RESETS_RESET_DMA_BITS 0x00000004U
 #define RP_RESETS_RESET_IO_QSPI_BITS 0x00000040U
 #define RP_RESETS_RESET_PADS_QSPI_BITS 0x00000200U
 
+#define RP_DMA_BASE_ADDR 0x50000000U
+#define RP_DMA_CH_READ_ADDR(x) (RP_DMA_BASE_ADDR + (x) * 0x40U + 0x00U)
+#define RP_DMA_CH_WRITE_ADDR(x) (RP_DMA_BASE_ADDR + (x) * 0x40U + 0x04U)
+#define RP_DMA_CH_TRANS_COUNT(x) (RP_DMA_BASE_ADDR + (x) * 0x40U + 0x08U)
+#define RP_DMA_CH_CTRL_TRIG(x) (RP_DMA_BASE_ADDR + (x) * 0x40U + 0x0cU)
+#define RP_DMA_SNIFF_CTRL (RP_DMA_BASE_ADDR + 0x434U)
+#define RP_DMA_SNIFF_DATA (RP_DMA_BASE_ADDR + 0x438U)
+#define RP_DMA_CTRL_EN (1U << 0U)
+#define RP_DMA_CTRL_DATA_SIZE_WORD (2U << 2U)
+#define RP_DMA_CTRL_INCR_READ (1U << 4U)
+#define RP_DMA_CTRL_CHAIN_TO(x) ((x) << 11U)
+#define RP_DMA_CTRL_TREQ_PERMANENT (0x3fU << 15U)
+#define RP_DMA_CTRL_SNIFF_EN (1U << 23U)
+#define RP_DMA_CTRL_BUSY (1U << 24U)
+#define RP_DMA_CTRL_AHB_ERROR (1U << 31U)
+#define RP_DMA_SNIFF_CTRL_EN (1U << 0U)
+#define RP_DMA_SNIFF_CTRL_DMACH(x) ((x) << 1U)
+#define RP_DMA_SNIFF_CTRL_CALC_CRC32R (1U << 5U)
+#define RP_DMA_SNIFF_CTRL_OUT_REV (1U << 10U)
+#define RP_DMA_SNIFF_CTRL_OUT_INV (1U << 11U)
+#define RP_DMA_CRC_CHANNEL 0U
+#define RP_DMA_CRC_TIMEOUT_MS(x) (1000U + (x) / 512U)
+
+#define RP_XIP_NOCACHE_NOALLOC_BASE_ADDR 0x13000000U
+
 // SPI Flash defines
 #define SPI_FLASH_OPCODE_MASK 0x00ffU
 #define SPI_FLASH_OPCODE(x) ((x) & SPI_FLASH_OPCODE_MASK)
@@ -136,8 +162,56 @@
 #define W25X_CMD_RESET_ENABLE (0x66U)
 #define W25X_CMD_RESET (0x99U)
 
+// Bootrom function lookup
+#define RP_ROM_FUNC_TABLE_ADDR 0x00000014U
+#define RP_ROM_FUNC_TABLE_MAX_ENTRIES 64U
+#define RP_ROM_CODE(c1, c2) ((uint16_t)(c1) | ((uint16_t)(c2) << 8U))
+
+#define RP_SRAM_BASE_ADDR 0x20000000U
+#define RP_SRAM_END_ADDR 0x20042000U
+
+#define RP_XPSR_THUMB (1U << 24U)
+
+// Flash loader memory layout: two data buffers at the start of SRAM, stack at its very end
+#define RP_LOADER_BUFFER_COUNT 2U
+#define RP_LOADER_BUFFER_ADDR(x) (RP_SRAM_BASE_ADDR + (x) * RP2040_LOADER_BUFFER_SIZE)
+#define RP_LOADER_STACK_ADDR RP_SRAM_END_ADDR
+#define RP_LOADER_PAGE_SIZE 0x100U
+#define RP_LOADER_SECTOR_SIZE 0x1000U
+#define RP_LOADER_BLOCK_ERASE_CMD 0xd8U
+#define RP_LOADER_CALL_TIMEOUT_MS 5000U
+
 #define TAG "VgmRp2040"
 
+typedef enum {
+    Rp2040RomFuncConnectInternalFlash,
+    Rp2040RomFuncFlashExitXip,
+    Rp2040RomFuncFlashRangeErase,
+    Rp2040RomFuncFlashRangeProgram,
+    Rp2040RomFuncFlashFlushCache,
+    Rp2040RomFuncFlashEnterCmdXip,
+    Rp2040RomFuncDebugTrampoline,
+    Rp2040RomFuncCount,
+} Rp2040RomFunc;
+
+static const uint16_t rp2040_rom_func_codes[Rp2040RomFuncCount] = {
+    [Rp2040RomFuncConnectInternalFlash] = RP_ROM_CODE('I', 'F'),
+    [Rp2040RomFuncFlashExitXip] = RP_ROM_CODE('E', 'X'),
+    [Rp2040RomFuncFlashRangeErase] = RP_ROM_CODE('R', 'E'),
+    [Rp2040RomFuncFlashRangeProgram] = RP_ROM_CODE('R', 'P'),
+    [Rp2040RomFuncFlashFlushCache] = RP_ROM_CODE('F', 'C'),
+    [Rp2040RomFuncFlashEnterCmdXip] = RP_ROM_CODE('C', 'X'),
+    [Rp2040RomFuncDebugTrampoline] = RP_ROM_CODE('D', 'T'),
+};
+
+typedef struct {
+    uint32_t rom_funcs[Rp2040RomFuncCount];
+    uint32_t buffer_index;
+    bool busy;
+} Rp2040Loader;
+
+static Rp2040Loader loader;
+
 static bool rp2040_spi_gpio_init(void) {
     bool success = false;
 
@@ -431,3 +505,314 @@ bool rp2040_flash_program_page(uint32_t address, const void* data, size_t data_s
 
     return success;
 }
+
+// Read a 16-bit value from anywhere in the bootrom using aligned word accesses
+static bool rp2040_rom_read_16(uint32_t address, uint16_t* data) {
+    uint32_t value;
+    if(!target_read_memory_32(address & ~3U, &value)) return false;
+    *data = (address & 2U) ? (value >> 16U) : (value & 0xFFFFU);
+    return true;
+}
+
+static bool rp2040_rom_lookup_funcs(void) {
+    bool success = false;
+
+    do {
+        memset(loader.rom_funcs, 0, sizeof(loader.rom_funcs));
+
+        uint16_t table_address;
+        if(!rp2040_rom_read_16(RP_ROM_FUNC_TABLE_ADDR, &table_address)) break;
+
+        // The table is a list of (code, function address) pairs terminated by a zero code
+        bool table_read = false;
+        for(uint32_t i = 0; i < RP_ROM_FUNC_TABLE_MAX_ENTRIES; ++i) {
+            const uint32_t entry_address = table_address + i * 2U * sizeof(uint16_t);
+            uint16_t code;
+            if(!rp2040_rom_read_16(entry_address, &code)) break;
+            if(code == 0) {
+                table_read = true;
+                break;
+            }
+
+            uint16_t func_address;
+            if(!rp2040_rom_read_16(entry_address + sizeof(uint16_t), &func_address)) break;
+
+            for(uint32_t j = 0; j < Rp2040RomFuncCount; ++j) {
+                if(rp2040_rom_func_codes[j] == code) {
+                    loader.rom_funcs[j] = func_address;
+                }
+            }
+        }
+
+        if(!table_read) break;
+
+        uint32_t j;
+        for(j = 0; j < Rp2040RomFuncCount; ++j) {
+            if(loader.rom_funcs[j] == 0) {
+                FURI_LOG_E(TAG, "Bootrom function not found: 0x%04X", rp2040_rom_func_codes[j]);
+                break;
+            }
+        }
+
+        if(j < Rp2040RomFuncCount) break;
+
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+// Run a bootrom function via the debug trampoline, which executes a breakpoint when done
+static bool rp2040_rom_call_start(Rp2040RomFunc func, const uint32_t* args, size_t arg_count) {
+    furi_assert(!loader.busy);
+    furi_assert(arg_count <= 4U);
+
+    bool success = false;
+
+    do {
+        size_t i;
+        for(i = 0; i < arg_count; ++i) {
+            if(!target_write_core_register(TARGET_CORE_REG_R0 + i, args[i])) break;
+        }
+        if(i < arg_count) break;
+
+        if(!target_write_core_register(TARGET_CORE_REG_R7, loader.rom_funcs[func])) break;
+        if(!target_write_core_register(TARGET_CORE_REG_SP, RP_LOADER_STACK_ADDR)) break;
+        if(!target_write_core_register(
+               TARGET_CORE_REG_PC, loader.rom_funcs[Rp2040RomFuncDebugTrampoline] & ~1U))
+            break;
+        if(!target_write_core_register(TARGET_CORE_REG_XPSR, RP_XPSR_THUMB)) break;
+        if(!target_resume()) break;
+
+        loader.busy = true;
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+static bool rp2040_rom_call_wait(void) {
+    if(!loader.busy) return true;
+
+    const uint32_t start_tick = furi_get_tick();
+
+    bool halted = false;
+    do {
+        if(!target_is_halted(&halted)) break;
+        if(halted) break;
+        furi_delay_tick(1);
+    } while(furi_get_tick() - start_tick < furi_ms_to_ticks(RP_LOADER_CALL_TIMEOUT_MS));
+
+    if(!halted) {
+        FURI_LOG_E(TAG, "Bootrom function call timed out");
+        return false;
+    }
+
+    loader.busy = false;
+    return true;
+}
+
+static bool rp2040_rom_call(Rp2040RomFunc func, const uint32_t* args, size_t arg_count) {
+    return rp2040_rom_call_start(func, args, arg_count) && rp2040_rom_call_wait();
+}
+
+bool rp2040_loader_init(void) {
+    bool success = false;
+
+    do {
+        loader.buffer_index = 0;
+        loader.busy = false;
+
+        if(!rp2040_rom_lookup_funcs()) {
+            FURI_LOG_E(TAG, "Failed to look up bootrom functions");
+            break;
+        }
+        if(!rp2040_loader_begin()) break;
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool rp2040_loader_begin(void) {
+    bool success = false;
+
+    do {
+        if(!rp2040_rom_call_wait()) break;
+        if(!rp2040_rom_call(Rp2040RomFuncConnectInternalFlash, NULL, 0)) {
+            FURI_LOG_E(TAG, "Failed to connect SPI flash");
+            break;
+        }
+        if(!rp2040_rom_call(Rp2040RomFuncFlashExitXip, NULL, 0)) {
+            FURI_LOG_E(TAG, "Failed to exit XIP mode");
+            break;
+        }
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool rp2040_loader_erase(uint32_t address, size_t size) {
+    furi_assert((address % RP_LOADER_SECTOR_SIZE) == 0);
+
+    bool success = false;
+
+    do {
+        if(!rp2040_rom_call_wait()) break;
+
+        const uint32_t args[] = {
+            address,
+            ((size + RP_LOADER_SECTOR_SIZE - 1) / RP_LOADER_SECTOR_SIZE) * RP_LOADER_SECTOR_SIZE,
+            RP2040_LOADER_ERASE_SIZE,
+            RP_LOADER_BLOCK_ERASE_CMD,
+        };
+
+        if(!rp2040_rom_call(Rp2040RomFuncFlashRangeErase, args, COUNT_OF(args))) {
+            FURI_LOG_E(TAG, "Failed to erase flash at address 0x%lX", address);
+            break;
+        }
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool rp2040_loader_program(uint32_t address, const void* data, size_t data_size) {
+    furi_assert((address % RP_LOADER_PAGE_SIZE) == 0);
+    furi_assert((data_size % RP_LOADER_PAGE_SIZE) == 0);
+    furi_assert(data_size <= RP2040_LOADER_BUFFER_SIZE);
+
+    bool success = false;
+
+    do {
+        const uint32_t buffer_address = RP_LOADER_BUFFER_ADDR(loader.buffer_index);
+
+        // The other buffer may still be in use by the target at this point
+        if(!target_write_memory_block(buffer_address, data, data_size)) {
+            FURI_LOG_E(TAG, "Failed to upload data to SRAM");
+            break;
+        }
+        if(!rp2040_rom_call_wait()) break;
+
+        const uint32_t args[] = {address, buffer_address, data_size};
+
+        if(!rp2040_rom_call_start(Rp2040RomFuncFlashRangeProgram, args, COUNT_OF(args))) {
+            FURI_LOG_E(TAG, "Failed to program flash at address 0x%lX", address);
+            break;
+        }
+
+        loader.buffer_index = (loader.buffer_index + 1) % RP_LOADER_BUFFER_COUNT;
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool rp2040_loader_finish(void) {
+    bool success = false;
+
+    do {
+        if(!rp2040_rom_call_wait()) break;
+        if(!rp2040_rom_call(Rp2040RomFuncFlashFlushCache, NULL, 0)) break;
+        if(!rp2040_rom_call(Rp2040RomFuncFlashEnterCmdXip, NULL, 0)) break;
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool rp2040_flash_read_xip(uint32_t address, void* data, size_t data_size) {
+    return target_read_memory_block(RP_XIP_NOCACHE_NOALLOC_BASE_ADDR + address, data, data_size);
+}
+
+static bool rp2040_dma_reset(void) {
+    bool success = false;
+
+    do {
+        if(!target_write_memory_32(
+               RP_RESETS_RESET | RP_REG_ACCESS_WRITE_ATOMIC_BITSET, RP_RESETS_RESET_DMA_BITS))
+            break;
+        if(!target_write_memory_32(
+               RP_RESETS_RESET | RP_REG_ACCESS_WRITE_ATOMIC_BITCLR, RP_RESETS_RESET_DMA_BITS))
+            break;
+
+        uint32_t reset_done = 0;
+        for(uint32_t i = 0; i < 100U && !(reset_done & RP_RESETS_RESET_DMA_BITS); ++i) {
+            if(!target_read_memory_32(RP_RESETS_RESET_DONE, &reset_done)) break;
+        }
+
+        if(!(reset_done & RP_RESETS_RESET_DMA_BITS)) break;
+
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool rp2040_flash_crc32(uint32_t address, size_t size, uint32_t* crc) {
+    furi_assert((address & 3U) == 0);
+    furi_assert((size & 3U) == 0);
+
+    bool success = false;
+
+    do {
+        // Stop any transfers left running by the firmware
+        if(!rp2040_dma_reset()) {
+            FURI_LOG_E(TAG, "Failed to reset DMA");
+            break;
+        }
+
+        // Standard CRC-32: initial value 0xFFFFFFFF, reflected data and output, inverted output
+        if(!target_write_memory_32(RP_DMA_SNIFF_DATA, UINT32_MAX)) break;
+        if(!target_write_memory_32(
+               RP_DMA_SNIFF_CTRL,
+               RP_DMA_SNIFF_CTRL_EN | RP_DMA_SNIFF_CTRL_DMACH(RP_DMA_CRC_CHANNEL) |
+                   RP_DMA_SNIFF_CTRL_CALC_CRC32R | RP_DMA_SNIFF_CTRL_OUT_REV |
+                   RP_DMA_SNIFF_CTRL_OUT_INV))
+            break;
+
+        // Read the flash through the uncached XIP window, discard the data into SRAM
+        if(!target_write_memory_32(
+               RP_DMA_CH_READ_ADDR(RP_DMA_CRC_CHANNEL),
+               RP_XIP_NOCACHE_NOALLOC_BASE_ADDR + address))
+            break;
+        if(!target_write_memory_32(RP_DMA_CH_WRITE_ADDR(RP_DMA_CRC_CHANNEL), RP_SRAM_BASE_ADDR))
+            break;
+        if(!target_write_memory_32(
+               RP_DMA_CH_TRANS_COUNT(RP_DMA_CRC_CHANNEL), size / sizeof(uint32_t)))
+            break;
+        if(!target_write_memory_32(
+               RP_DMA_CH_CTRL_TRIG(RP_DMA_CRC_CHANNEL),
+               RP_DMA_CTRL_EN | RP_DMA_CTRL_DATA_SIZE_WORD | RP_DMA_CTRL_INCR_READ |
+                   RP_DMA_CTRL_CHAIN_TO(RP_DMA_CRC_CHANNEL) | RP_DMA_CTRL_TREQ_PERMANENT |
+                   RP_DMA_CTRL_SNIFF_EN))
+            break;
+
+        const uint32_t start_tick = furi_get_tick();
+
+        uint32_t ctrl = 0;
+        bool is_read;
+        do {
+            is_read = target_read_memory_32(RP_DMA_CH_CTRL_TRIG(RP_DMA_CRC_CHANNEL), &ctrl);
+            if(!is_read || !(ctrl & RP_DMA_CTRL_BUSY)) break;
+            furi_delay_tick(1);
+        } while(furi_get_tick() - start_tick < furi_ms_to_ticks(RP_DMA_CRC_TIMEOUT_MS(size)));
+
+        if(!is_read) {
+            FURI_LOG_E(TAG, "Failed to read DMA channel state");
+            break;
+        }
+
+        if(ctrl & (RP_DMA_CTRL_BUSY | RP_DMA_CTRL_AHB_ERROR)) {
+            FURI_LOG_E(TAG, "DMA transfer failed, CTRL: 0x%08lX", ctrl);
+            break;
+        }
+
+        if(!target_read_memory_32(RP_DMA_SNIFF_DATA, crc)) break;
+
+        success = true;
+    } while(false);
+
+    return success;
+}
@@ -17,6 +17,11 @@
 
 #define RP2040_FAMILY_ID (0xE48BFF56UL)
 
+#define RP2040_FLASH_BASE_ADDR (0x10000000UL)
+
+#define RP2040_LOADER_BUFFER_SIZE (0x1000UL)
+#define RP2040_LOADER_ERASE_SIZE (0x10000UL)
+
 /**
  * @brief Initialise RP2040-specific hardware.
  *
@@ -51,3 +56,83 @@ bool rp2040_flash_erase_sector(uint32_t address);
  * @returns true on success, false otherwise.
  */
 bool rp2040_flash_program_page(uint32_t address, const void* data, size_t data_size);
+
+/**
+ * @brief Prepare the on-target flash loader.
+ *
+ * Looks up the bootrom flash functions and calls rp2040_loader_begin().
+ * Once successful, the rp2040_loader_*() functions can be used
+ * instead of accessing the flash directly via SSI.
+ *
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_loader_init(void);
+
+/**
+ * @brief Prepare the SPI flash chip for erasing and programming.
+ *
+ * Connects the SPI flash and takes it out of XIP mode. Use to resume
+ * erasing and programming after rp2040_loader_finish().
+ *
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_loader_begin(void);
+
+/**
+ * @brief Erase a region of the SPI flash chip using the bootrom.
+ *
+ * Uses 64K block erase commands where possible, waits
+ * for any pending programming operation to complete.
+ *
+ * @param[in] address target address within the flash address space (must be sector-aligned).
+ * @param[in] size size of the region to be erased (will be rounded up to the sector size).
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_loader_erase(uint32_t address, size_t size);
+
+/**
+ * @brief Program a region of the SPI flash chip using the bootrom.
+ *
+ * The data is uploaded into one of two target SRAM buffers while the previous
+ * buffer is still being programmed. The function returns as soon as the
+ * programming has started, call rp2040_loader_finish() after the last chunk.
+ *
+ * @param[in] address target address within the flash address space (must be page-aligned).
+ * @param[in] data pointer to the word-aligned buffer containing the data to be written.
+ * @param[in] data_size size of the data (multiple of 256B, max RP2040_LOADER_BUFFER_SIZE).
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_loader_program(uint32_t address, const void* data, size_t data_size);
+
+/**
+ * @brief Wait for the pending operations and restore the flash XIP mode.
+ *
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_loader_finish(void);
+
+/**
+ * @brief Read data from the SPI flash chip through the XIP window.
+ *
+ * Much faster than rp2040_flash_read_data(), but the flash MUST be
+ * in XIP mode, e.g. after calling rp2040_loader_finish().
+ *
+ * @param[in] address target address within the flash address space (must be word-aligned).
+ * @param[out] data pointer to the word-aligned buffer to contain the data to be read.
+ * @param[in] data_size size of the data to be read (must be a multiple of 4).
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_flash_read_xip(uint32_t address, void* data, size_t data_size);
+
+/**
+ * @brief Calculate the CRC-32 of a region of the SPI flash chip on the target.
+ *
+ * Uses the DMA sniffer, so that the data does not have to be read over SWD.
+ * The flash MUST be in XIP mode, e.g. after calling rp2040_loader_finish().
+ *
+ * @param[in] address target address within the flash address space (must be word-aligned).
+ * @param[in] size size of the region (must be a multiple of 4).
+ * @param[out] crc pointer to the value to contain the CRC-32 (see crc32_calc()).
+ * @returns true on success, false otherwise.
+ */
+bool rp2040_flash_crc32(uint32_t address, size_t size, uint32_t* crc);
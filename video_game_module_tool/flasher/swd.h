@@ -7,6 +7,9 @@
  * - Debug hardware initialisation
  * - Target selection in a multidrop bus
  * - Debug and Access port access
+ * - WAIT response handling and transfer statistics
+ *
+ * The wire-level signalling is delegated to a transport, see swd_transport.h.
  *
  * For more information, see ARM IHI0031G
  * https://documentation-service.arm.com/static/622222b2e6f58973271ebc21
@@ -17,6 +20,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "swd_transport.h"
+
 // Only bits [3:2] are used to access DP registers
 #define SWD_DP_REG_ADDR_SHIFT (2U)
 
@@ -48,12 +53,24 @@
 
 // CSW bits (PROT bits are for AHB3)
 #define SWD_AP_REG_CSW_SIZE_WORD (2UL << 0U)
+#define SWD_AP_REG_CSW_ADDRINC_OFF (0UL << 4U)
+#define SWD_AP_REG_CSW_ADDRINC_SINGLE (1UL << 4U)
 #define SWD_AP_REG_CSW_HPROT_DATA (1UL << 24U)
 #define SWD_AP_REG_CSW_HPROT_PRIVILIGED (1UL << 25U)
 #define SWD_AP_REG_CSW_HPROT_BUFFERABLE (1UL << 26U)
 #define SWD_AP_REG_CSW_HPROT_CACHEABLE (1UL << 27U)
 #define SWD_AP_REG_CSW_HNONSEC (1UL << 30U)
 
+/**
+ * @brief SWD transfer statistics.
+ */
+typedef struct {
+    uint32_t read_count; /**< Read requests sent, including repeated ones. */
+    uint32_t write_count; /**< Write requests sent, including repeated ones. */
+    uint32_t wait_count; /**< Requests repeated after a WAIT acknowledge. */
+    uint32_t error_count; /**< Requests that have failed. */
+} SwdStats;
+
 /**
  * @brief Initialise SWD bus.
  *
@@ -120,3 +137,40 @@ bool swd_ap_read(uint8_t address, uint32_t* data);
  * @returns true on success, false otherwise.
  */
 bool swd_ap_write(uint8_t address, uint32_t data);
+
+/**
+ * @brief Perform a series of Access Port (AP) reads.
+ *
+ * Reads 32-bit words from the same AP register, using posted
+ * reads so that N words cost N + 1 AP/DP transactions.
+ *
+ * @param[in] address AP register address.
+ * @param[out] data pointer to the buffer to contain the read data.
+ * @param[in] count number of words to be read (must be non-zero).
+ * @returns true on success, false otherwise.
+ */
+bool swd_ap_read_block(uint8_t address, uint32_t* data, size_t count);
+
+/**
+ * @brief Perform a series of Access Port (AP) writes.
+ *
+ * Writes 32-bit words to the same AP register.
+ *
+ * @param[in] address AP register address.
+ * @param[in] data pointer to the buffer containing the data to be written.
+ * @param[in] count number of words to be written.
+ * @returns true on success, false otherwise.
+ */
+bool swd_ap_write_block(uint8_t address, const uint32_t* data, size_t count);
+
+/**
+ * @brief Get the transfer statistics accumulated since the last reset.
+ *
+ * @param[out] stats pointer to the structure to contain the statistics.
+ */
+void swd_get_stats(SwdStats* stats);
+
+/**
+ * @brief Reset the transfer statistics.
+ */
+void swd_reset_stats(void);
@@ -0,0 +1,206 @@
+#include "swd_transport.h"
+#include "swd.h"
+
+#include <furi.h>
+#include <furi_hal_resources.h>
+
+#define SWD_REQUEST_LEN (8U)
+#define SWD_RESPONSE_LEN (3U)
+#define SWD_DATA_LEN (32U)
+
+#define SWD_ALERT_SEQUENCE_0 (0x6209F392UL)
+#define SWD_ALERT_SEQUENCE_1 (0x86852D95UL)
+#define SWD_ALERT_SEQUENCE_2 (0xE3DDAFE9UL)
+#define SWD_ALERT_SEQUENCE_3 (0x19BC0EA2UL)
+
+#define SWD_ACTIVATION_CODE (0x1AU)
+
+#define SWD_SLEEP_SEQUENCE (0xE3BCU)
+
+#define SWD_TARGETSEL_REQUEST (0x81U | (SWD_DP_REG_WO_TASRGETSEL << 3))
+
+typedef enum {
+    SwdioDirectionIn,
+    SwdioDirectionOut,
+} SwdioDirection;
+
+#ifdef SWD_ENABLE_CYCLE_DELAY
+// Slows SWCLK down, useful for debugging via logic analyzer
+__attribute__((always_inline)) static inline void swd_delay_half_cycle(void) {
+    asm volatile("nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n"
+                 "nop \n");
+}
+#else
+#define swd_delay_half_cycle()
+#endif
+
+static void __attribute__((optimize("-O3"))) swd_turnaround(SwdioDirection mode) {
+    static SwdioDirection prev_dir = SwdioDirectionIn;
+
+    if(prev_dir == mode) {
+        return;
+    } else {
+        prev_dir = mode;
+    }
+
+    if(mode == SwdioDirectionIn) {
+        // Using LL functions for performance reasons
+        LL_GPIO_SetPinMode(gpio_swdio.port, gpio_swdio.pin, LL_GPIO_MODE_INPUT);
+    } else {
+        furi_hal_gpio_write(&gpio_swclk, false);
+    }
+    swd_delay_half_cycle();
+
+    furi_hal_gpio_write(&gpio_swclk, true);
+    swd_delay_half_cycle();
+
+    if(mode == SwdioDirectionOut) {
+        furi_hal_gpio_write(&gpio_swclk, false);
+        // Using LL functions for performance reasons
+        LL_GPIO_SetPinMode(gpio_swdio.port, gpio_swdio.pin, LL_GPIO_MODE_OUTPUT);
+    }
+}
+
+static void __attribute__((optimize("-O3"))) swd_tx(uint32_t data, uint32_t n_cycles) {
+    swd_turnaround(SwdioDirectionOut);
+
+    for(uint32_t i = 0; i < n_cycles; ++i) {
+        furi_hal_gpio_write(&gpio_swclk, false);
+        furi_hal_gpio_write(&gpio_swdio, data & (1UL << i));
+        swd_delay_half_cycle();
+
+        furi_hal_gpio_write(&gpio_swclk, true);
+        swd_delay_half_cycle();
+    }
+
+    furi_hal_gpio_write(&gpio_swclk, false);
+}
+
+static void __attribute__((optimize("-O3"))) swd_tx_parity(uint32_t data, uint32_t n_cycles) {
+    const int parity = __builtin_parity(data);
+    swd_tx(data, n_cycles);
+    furi_hal_gpio_write(&gpio_swdio, parity);
+    swd_delay_half_cycle();
+    furi_hal_gpio_write(&gpio_swclk, true);
+    swd_delay_half_cycle();
+    furi_hal_gpio_write(&gpio_swclk, false);
+}
+
+static uint32_t __attribute__((optimize("-O3"))) swd_rx(uint32_t n_cycles) {
+    uint32_t ret = 0;
+    swd_turnaround(SwdioDirectionIn);
+
+    for(uint32_t i = 0; i < n_cycles; ++i) {
+        furi_hal_gpio_write(&gpio_swclk, false);
+        ret |= furi_hal_gpio_read(&gpio_swdio) ? (1UL << i) : 0;
+        swd_delay_half_cycle();
+
+        furi_hal_gpio_write(&gpio_swclk, true);
+        swd_delay_half_cycle();
+    }
+
+    furi_hal_gpio_write(&gpio_swclk, false);
+    return ret;
+}
+
+static bool __attribute__((optimize("-O3"))) swd_rx_parity(uint32_t* data, uint32_t n_cycles) {
+    const uint32_t rx_value = swd_rx(n_cycles);
+    swd_delay_half_cycle();
+
+    const bool parity_calc = __builtin_parity(rx_value);
+    const bool parity_rx = furi_hal_gpio_read(&gpio_swdio);
+
+    furi_hal_gpio_write(&gpio_swclk, true);
+    swd_delay_half_cycle();
+    furi_hal_gpio_write(&gpio_swclk, false);
+
+    if(data) {
+        *data = rx_value;
+    }
+
+    return parity_calc == parity_rx;
+}
+
+static void swd_line_reset(bool idle_cycles) {
+    swd_tx(0xFFFFFFFFUL, 32U);
+    swd_tx(0x0FFFFFFFUL, idle_cycles ? 32U : 24U);
+}
+
+static void swd_leave_dormant_state(void) {
+    swd_line_reset(false);
+    swd_tx(SWD_ALERT_SEQUENCE_0, 32U);
+    swd_tx(SWD_ALERT_SEQUENCE_1, 32U);
+    swd_tx(SWD_ALERT_SEQUENCE_2, 32U);
+    swd_tx(SWD_ALERT_SEQUENCE_3, 32U);
+    swd_tx(SWD_ACTIVATION_CODE << 4U, 12U);
+}
+
+static void swd_enter_dormant_state(void) {
+    swd_line_reset(false);
+    swd_tx(SWD_SLEEP_SEQUENCE, 16U);
+}
+
+void swd_transport_init(void) {
+    furi_hal_gpio_init_ex(
+        &gpio_swclk, GpioModeOutputPushPull, GpioPullNo, GpioSpeedVeryHigh, GpioAltFnUnused);
+    furi_hal_gpio_init_ex(
+        &gpio_swdio, GpioModeOutputPushPull, GpioPullNo, GpioSpeedVeryHigh, GpioAltFnUnused);
+
+    swd_leave_dormant_state();
+    swd_line_reset(true);
+}
+
+void swd_transport_deinit(void) {
+    swd_enter_dormant_state();
+    furi_hal_gpio_init_simple(&gpio_swclk, GpioModeAnalog);
+    furi_hal_gpio_init_simple(&gpio_swdio, GpioModeAnalog);
+}
+
+void swd_transport_select_target(uint32_t target_id) {
+    swd_tx(SWD_TARGETSEL_REQUEST, SWD_REQUEST_LEN);
+    swd_rx(SWD_RESPONSE_LEN);
+    swd_tx_parity(target_id, SWD_DATA_LEN);
+    swd_tx(0UL, 8);
+}
+
+SwdAck swd_transport_read(uint8_t request, uint32_t* data) {
+    swd_tx(request, SWD_REQUEST_LEN);
+
+    const SwdAck ack = swd_rx(SWD_RESPONSE_LEN);
+    if(ack != SwdAckOk) return ack;
+
+    return swd_rx_parity(data, SWD_DATA_LEN) ? SwdAckOk : SwdAckParityError;
+}
+
+SwdAck swd_transport_write(uint8_t request, uint32_t data) {
+    swd_tx(request, SWD_REQUEST_LEN);
+
+    const SwdAck ack = swd_rx(SWD_RESPONSE_LEN);
+    if(ack != SwdAckOk) return ack;
+
+    swd_tx_parity(data, SWD_DATA_LEN);
+    swd_tx(0UL, 8);
+    return SwdAckOk;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file swd_transport.h
+ * @brief Serial Wire Debug (SWD) wire-level transport, GPIO bit-bang on SWCLK and SWDIO.
+ *
+ * The transport moves single SWD packets (request, acknowledge and data
+ * phases) over the wire. The protocol layer in swd.h builds requests,
+ * handles retries and keeps track of DP state on top of it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Acknowledge received from the target.
+ */
+typedef enum {
+    SwdAckOk = 1U, /**< Transfer accepted. */
+    SwdAckWait = 2U, /**< Target is busy, the request must be repeated. */
+    SwdAckFault = 4U, /**< Sticky error flag is set in the DP. */
+    SwdAckNone = 7U, /**< No response (target not connected or not selected). */
+    SwdAckParityError = 8U, /**< Read data was received with a wrong parity bit. */
+} SwdAck;
+
+/**
+ * @brief Configure the pins, wake up the target and reset the SWD bus.
+ */
+void swd_transport_init(void);
+
+/**
+ * @brief Put the target to dormant state and release the pins.
+ */
+void swd_transport_deinit(void);
+
+/**
+ * @brief Send a TARGETSEL sequence on a multidrop (SWD v2) bus.
+ *
+ * @param[in] target_id value to be sent.
+ */
+void swd_transport_select_target(uint32_t target_id);
+
+/**
+ * @brief Send a read request and receive the data phase.
+ *
+ * @param[in] request request byte.
+ * @param[out] data pointer to the value to be read (may be NULL).
+ * @returns acknowledge received from the target.
+ */
+SwdAck swd_transport_read(uint8_t request, uint32_t* data);
+
+/**
+ * @brief Send a write request and the data phase.
+ *
+ * @param[in] request request byte.
+ * @param[in] data value to be written.
+ * @returns acknowledge received from the target.
+ */
+SwdAck swd_transport_write(uint8_t request, uint32_t data);
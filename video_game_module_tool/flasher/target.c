@@ -60,27 +60,46 @@
 
 #define CORTEXM_DHCSR_DEBUG_HALT (CORTEXM_DHCSR_C_DEBUGEN | CORTEXM_DHCSR_C_HALT)
 
+/* Debug Core Register Selector Register (DCRSR) */
+#define CORTEXM_DCRSR_REGWNR (1U << 16U)
+#define CORTEXM_DCRSR_REGSEL_MASK 0x0000001fU
+
+#define TARGET_REGRDY_ATTEMPT_COUNT (100U)
+
+// TAR auto-increment is only guaranteed within a 1K block
+#define TARGET_TAR_WRAP_SIZE (0x400UL)
+
+#define TARGET_CSW_BASE                                                                     \
+    (SWD_AP_REG_CSW_HPROT_DATA | SWD_AP_REG_CSW_HPROT_PRIVILIGED | SWD_AP_REG_CSW_HNONSEC | \
+     SWD_AP_REG_CSW_SIZE_WORD)
+#define TARGET_CSW_SINGLE (TARGET_CSW_BASE | SWD_AP_REG_CSW_ADDRINC_OFF)
+#define TARGET_CSW_BLOCK (TARGET_CSW_BASE | SWD_AP_REG_CSW_ADDRINC_SINGLE)
+
 #define TAG "VgmTarget"
 
 static uint32_t prev_address;
+static uint32_t prev_csw;
 
-static bool target_memory_access_setup(uint32_t address) {
+static bool target_memory_access_setup(uint32_t address, uint32_t csw) {
     bool success = false;
     do {
-        // If the address was previously set up, do not waste time on it
+        // If the access mode and address were previously set up, do not waste time on them
+        if(csw != prev_csw) {
+            if(!swd_ap_write(SWD_AP_REG_RW_CSW, csw)) break;
+            prev_csw = csw;
+        }
         if(address != prev_address) {
-            // Word access, no auto increment
-            if(!swd_ap_write(
-                   SWD_AP_REG_RW_CSW,
-                   SWD_AP_REG_CSW_HPROT_DATA | SWD_AP_REG_CSW_HPROT_PRIVILIGED |
-                       SWD_AP_REG_CSW_HNONSEC | SWD_AP_REG_CSW_SIZE_WORD))
-                break;
             if(!swd_ap_write(SWD_AP_REG_RW_TAR, address)) break;
             prev_address = address;
         }
         success = true;
     } while(false);
 
+    if(!success) {
+        prev_address = UINT32_MAX;
+        prev_csw = UINT32_MAX;
+    }
+
     return success;
 }
 
@@ -155,8 +174,9 @@ bool target_attach(uint32_t id) {
     bool success = false;
 
     do {
-        // Reset previous memory address
+        // Reset previous memory address and access mode
         prev_address = UINT32_MAX;
+        prev_csw = UINT32_MAX;
 
         swd_select_target(id);
 
@@ -208,7 +228,7 @@ bool target_read_memory_32(uint32_t address, uint32_t* data) {
     bool success = false;
 
     do {
-        if(!target_memory_access_setup(address)) break;
+        if(!target_memory_access_setup(address, TARGET_CSW_SINGLE)) break;
         if(!swd_ap_read(SWD_AP_REG_RW_DRW, data)) break;
         success = true;
     } while(false);
@@ -222,10 +242,121 @@ bool target_write_memory_32(uint32_t address, uint32_t data) {
     bool success = false;
 
     do {
-        if(!target_memory_access_setup(address)) break;
+        if(!target_memory_access_setup(address, TARGET_CSW_SINGLE)) break;
         if(!swd_ap_write(SWD_AP_REG_RW_DRW, data)) break;
         success = true;
     } while(false);
 
     return success;
 }
+
+// Size of the next block transfer chunk that does not cross a TAR wrap boundary
+static inline size_t target_get_block_chunk_size(uint32_t address, size_t data_size) {
+    return MIN(data_size, TARGET_TAR_WRAP_SIZE - (address & (TARGET_TAR_WRAP_SIZE - 1U)));
+}
+
+bool target_read_memory_block(uint32_t address, void* data, size_t data_size) {
+    furi_assert((address & 3U) == 0);
+    furi_assert(((uintptr_t)data & 3U) == 0);
+    furi_assert((data_size & 3U) == 0);
+
+    uint32_t* rx_data = data;
+
+    size_t size_read;
+    for(size_read = 0; size_read < data_size;) {
+        const uint32_t chunk_address = address + size_read;
+        const size_t chunk_size =
+            target_get_block_chunk_size(chunk_address, data_size - size_read);
+
+        if(!target_memory_access_setup(chunk_address, TARGET_CSW_BLOCK)) break;
+        // TAR is advanced by the target, so it must be set up again for the next access
+        prev_address = UINT32_MAX;
+        if(!swd_ap_read_block(
+               SWD_AP_REG_RW_DRW,
+               &rx_data[size_read / sizeof(uint32_t)],
+               chunk_size / sizeof(uint32_t)))
+            break;
+
+        size_read += chunk_size;
+    }
+
+    return size_read == data_size;
+}
+
+bool target_write_memory_block(uint32_t address, const void* data, size_t data_size) {
+    furi_assert((address & 3U) == 0);
+    furi_assert(((uintptr_t)data & 3U) == 0);
+    furi_assert((data_size & 3U) == 0);
+
+    const uint32_t* tx_data = data;
+
+    size_t size_written;
+    for(size_written = 0; size_written < data_size;) {
+        const uint32_t chunk_address = address + size_written;
+        const size_t chunk_size =
+            target_get_block_chunk_size(chunk_address, data_size - size_written);
+
+        if(!target_memory_access_setup(chunk_address, TARGET_CSW_BLOCK)) break;
+        // TAR is advanced by the target, so it must be set up again for the next access
+        prev_address = UINT32_MAX;
+        if(!swd_ap_write_block(
+               SWD_AP_REG_RW_DRW,
+               &tx_data[size_written / sizeof(uint32_t)],
+               chunk_size / sizeof(uint32_t)))
+            break;
+
+        size_written += chunk_size;
+    }
+
+    return size_written == data_size;
+}
+
+bool target_write_core_register(uint32_t reg, uint32_t value) {
+    furi_assert((reg & ~CORTEXM_DCRSR_REGSEL_MASK) == 0);
+
+    bool success = false;
+
+    do {
+        if(!target_write_memory_32(CORTEXM_DCRDR, value)) break;
+        if(!target_write_memory_32(CORTEXM_DCRSR, CORTEXM_DCRSR_REGWNR | reg)) break;
+
+        uint32_t i;
+        for(i = 0; i < TARGET_REGRDY_ATTEMPT_COUNT; ++i) {
+            uint32_t dhcsr;
+            if(!target_read_memory_32(CORTEXM_DHCSR, &dhcsr)) break;
+            if(dhcsr & CORTEXM_DHCSR_S_REGRDY) break;
+        }
+
+        if(i >= TARGET_REGRDY_ATTEMPT_COUNT) break;
+
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool target_resume(void) {
+    bool success = false;
+
+    do {
+        // C_MASKINTS may only be changed while the core is halted
+        if(!target_write_memory_32(
+               CORTEXM_DHCSR,
+               CORTEXM_DHCSR_DBGKEY | CORTEXM_DHCSR_DEBUG_HALT | CORTEXM_DHCSR_C_MASKINTS))
+            break;
+        if(!target_write_memory_32(
+               CORTEXM_DHCSR,
+               CORTEXM_DHCSR_DBGKEY | CORTEXM_DHCSR_C_DEBUGEN | CORTEXM_DHCSR_C_MASKINTS))
+            break;
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool target_is_halted(bool* halted) {
+    uint32_t dhcsr;
+    if(!target_read_memory_32(CORTEXM_DHCSR, &dhcsr)) return false;
+    *halted = (dhcsr & CORTEXM_DHCSR_S_HALT) != 0;
+    return true;
+}
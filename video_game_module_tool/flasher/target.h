@@ -11,6 +11,13 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define TARGET_CORE_REG_R0 (0U)
+#define TARGET_CORE_REG_R7 (7U)
+#define TARGET_CORE_REG_SP (13U)
+#define TARGET_CORE_REG_LR (14U)
+#define TARGET_CORE_REG_PC (15U)
+#define TARGET_CORE_REG_XPSR (16U)
+
 /**
  * @brief Attach and halt the debug target.
  *
@@ -43,3 +50,56 @@ bool target_read_memory_32(uint32_t address, uint32_t* data);
  * @returns true on success, false otherwise.
  */
 bool target_write_memory_32(uint32_t address, uint32_t data);
+
+/**
+ * @brief Read a block of 32-bit words within target address space.
+ *
+ * Uses address auto-increment and pipelined reads, which is
+ * much faster than calling target_read_memory_32() repeatedly.
+ *
+ * @param[in] address target memory address (must be word-aligned).
+ * @param[out] data pointer to the word-aligned buffer to contain the read data.
+ * @param[in] data_size size of the data to be read (must be a multiple of 4).
+ * @returns true on success, false otherwise.
+ */
+bool target_read_memory_block(uint32_t address, void* data, size_t data_size);
+
+/**
+ * @brief Write a block of 32-bit words within target address space.
+ *
+ * Uses address auto-increment, which is much faster than
+ * calling target_write_memory_32() repeatedly.
+ *
+ * @param[in] address target memory address (must be word-aligned).
+ * @param[in] data pointer to the word-aligned buffer containing the data to be written.
+ * @param[in] data_size size of the data to be written (must be a multiple of 4).
+ * @returns true on success, false otherwise.
+ */
+bool target_write_memory_block(uint32_t address, const void* data, size_t data_size);
+
+/**
+ * @brief Write a core register of the halted debug target.
+ *
+ * @param[in] reg register number (as used by the DCRSR register, see TARGET_CORE_REG_*).
+ * @param[in] value value to be written to the register.
+ * @returns true on success, false otherwise.
+ */
+bool target_write_core_register(uint32_t reg, uint32_t value);
+
+/**
+ * @brief Resume the halted debug target with interrupts masked.
+ *
+ * The target stays under debug control and will halt again
+ * upon hitting a breakpoint instruction.
+ *
+ * @returns true on success, false otherwise.
+ */
+bool target_resume(void);
+
+/**
+ * @brief Check whether the debug target is halted.
+ *
+ * @param[out] halted pointer to the value to hold the halt state.
+ * @returns true on success, false otherwise.
+ */
+bool target_is_halted(bool* halted);
@@ -2,10 +2,13 @@
 
 #include <furi.h>
 
-#define UF2_BLOCK_SIZE (512UL)
+#include "crc32.h"
+
 #define UF2_DATA_SIZE (476UL)
 #define UF2_CHECKSUM_SIZE (16UL)
 
+#define UF2_READ_BLOCK_COUNT (16UL)
+
 #define UF2_MAGIC_START_0 (0x0A324655UL)
 #define UF2_MAGIC_START_1 (0x9E5D5157UL)
 #define UF2_MAGIC_END (0x0AB16F30UL)
@@ -47,11 +50,6 @@ typedef struct {
     uint32_t magic_end;
 } Uf2BlockTrailer;
 
-static bool uf2_block_header_read(Uf2BlockHeader* header, File* file) {
-    const size_t size_read = storage_file_read(file, header, sizeof(Uf2BlockHeader));
-    return size_read == sizeof(Uf2BlockHeader);
-}
-
 static bool
     uf2_block_header_verify(const Uf2BlockHeader* header, uint32_t family_id, size_t payload_size) {
     bool success = false;
@@ -96,72 +94,265 @@ static bool
     return success;
 }
 
-static bool uf2_block_header_skip(File* file) {
-    return storage_file_seek(file, sizeof(Uf2BlockHeader), false);
+static bool uf2_block_trailer_verify(const Uf2BlockTrailer* trailer) {
+    return trailer->magic_end == UF2_MAGIC_END;
 }
 
-static bool uf2_block_payload_skip(File* file) {
-    return storage_file_seek(file, sizeof(Uf2BlockData), false);
+bool uf2_get_block_count(File* file, uint32_t* block_count) {
+    const size_t file_size = storage_file_size(file);
+
+    if(file_size == 0) {
+        FURI_LOG_E(TAG, "File size is zero");
+        return false;
+    } else if(file_size % UF2_BLOCK_SIZE != 0) {
+        FURI_LOG_E(TAG, "File size is not a multiple of %lu bytes", UF2_BLOCK_SIZE);
+        return false;
+    }
+
+    *block_count = file_size / UF2_BLOCK_SIZE;
+    return true;
 }
 
-static bool uf2_block_trailer_skip(File* file) {
-    return storage_file_seek(file, sizeof(Uf2BlockTrailer), false);
+bool uf2_read_blocks(File* file, void* data, size_t block_count) {
+    const size_t data_size = block_count * UF2_BLOCK_SIZE;
+    return storage_file_read(file, data, data_size) == data_size;
 }
 
-static bool uf2_block_payload_read(File* file, void* payload_data, size_t payload_size) {
-    bool success = false;
+bool uf2_seek_block(File* file, uint32_t block_index) {
+    return storage_file_seek(file, block_index * UF2_BLOCK_SIZE, true);
+}
 
-    do {
-        const size_t size_read = storage_file_read(file, payload_data, payload_size);
-        if(size_read != payload_size) break;
-        if(!storage_file_seek(file, UF2_DATA_SIZE - payload_size, false)) break;
-        success = true;
-    } while(false);
+bool uf2_parse_block(
+    const void* block_data,
+    uint32_t family_id,
+    uint32_t* target_addr,
+    void* payload_data,
+    size_t payload_size) {
+    const uint8_t* block = block_data;
+    const Uf2BlockHeader* header = (const Uf2BlockHeader*)block;
+    const Uf2BlockData* data = (const Uf2BlockData*)&block[sizeof(Uf2BlockHeader)];
+    const Uf2BlockTrailer* trailer =
+        (const Uf2BlockTrailer*)&block[sizeof(Uf2BlockHeader) + sizeof(Uf2BlockData)];
 
-    return success;
+    if(!uf2_block_header_verify(header, family_id, payload_size)) return false;
+    if(!uf2_block_trailer_verify(trailer)) return false;
+
+    if(target_addr) {
+        *target_addr = header->target_addr;
+    }
+    if(payload_data) {
+        memcpy(payload_data, data->payload, payload_size);
+    }
+    return true;
 }
 
-static bool uf2_block_trailer_read(Uf2BlockTrailer* trailer, File* file) {
-    const size_t size_read = storage_file_read(file, trailer, sizeof(Uf2BlockTrailer));
-    return size_read == sizeof(Uf2BlockTrailer);
+uint32_t
+    uf2_extent_get_block_index(const Uf2Extent* extent, uint32_t address, size_t payload_size) {
+    const int32_t offset = (address - extent->address) / payload_size;
+    return extent->block_index + offset * extent->block_step;
 }
 
-static bool uf2_block_trailer_verify(const Uf2BlockTrailer* trailer) {
-    return trailer->magic_end == UF2_MAGIC_END;
+// Get the block step needed to go from one block to another within the extent, 0 if impossible
+static int32_t uf2_extent_get_step(const Uf2Extent* extent, uint32_t from, uint32_t to) {
+    const int32_t step = (int32_t)(to - from);
+    if(step != 1 && step != -1) return 0;
+    if(extent->block_step != 0 && extent->block_step != step) return 0;
+    return step;
 }
 
-bool uf2_get_block_count(File* file, uint32_t* block_count) {
-    const size_t file_size = storage_file_size(file);
+// Add one block to the extent map, keeping it sorted by address
+static bool uf2_extent_add(
+    Uf2ExtentArray_t extents,
+    uint32_t address,
+    uint32_t block_index,
+    size_t payload_size) {
+    size_t index = Uf2ExtentArray_size(extents);
 
-    if(file_size == 0) {
-        FURI_LOG_E(TAG, "File size is zero");
+    // Blocks are usually in order, so search from the end
+    while(index > 0 && Uf2ExtentArray_get(extents, index - 1)->address > address) {
+        --index;
+    }
+
+    Uf2Extent* prev = index > 0 ? Uf2ExtentArray_get(extents, index - 1) : NULL;
+    Uf2Extent* next =
+        index < Uf2ExtentArray_size(extents) ? Uf2ExtentArray_get(extents, index) : NULL;
+
+    if((prev && prev->address + prev->size > address) ||
+       (next && address + payload_size > next->address)) {
+        FURI_LOG_E(TAG, "Overlapping blocks at address %lX (block #%lu)", address, block_index);
         return false;
-    } else if(file_size % UF2_BLOCK_SIZE != 0) {
-        FURI_LOG_E(TAG, "File size is not a multiple of %lu bytes", UF2_BLOCK_SIZE);
+    }
+
+    // Append to the previous extent if both the addresses and the blocks are adjacent
+    if(prev && prev->address + prev->size == address) {
+        const uint32_t last_block_index =
+            uf2_extent_get_block_index(prev, address - payload_size, payload_size);
+        const int32_t step = uf2_extent_get_step(prev, last_block_index, block_index);
+
+        if(step != 0) {
+            prev->size += payload_size;
+            prev->block_step = step;
+
+            // The block might have closed the gap to the next extent
+            if(next && address + payload_size == next->address &&
+               uf2_extent_get_step(next, block_index, next->block_index) == step) {
+                prev->size += next->size;
+                Uf2ExtentArray_remove_v(extents, index, index + 1);
+            }
+
+            return true;
+        }
+    }
+
+    // Prepend to the next extent, likewise
+    if(next && address + payload_size == next->address) {
+        const int32_t step = uf2_extent_get_step(next, block_index, next->block_index);
+
+        if(step != 0) {
+            next->address = address;
+            next->size += payload_size;
+            next->block_index = block_index;
+            next->block_step = step;
+            return true;
+        }
+    }
+
+    if(Uf2ExtentArray_size(extents) >= UF2_EXTENT_COUNT_MAX) {
+        FURI_LOG_E(
+            TAG, "Too many discontinuous blocks, at most %u are supported", UF2_EXTENT_COUNT_MAX);
         return false;
     }
 
-    *block_count = file_size / UF2_BLOCK_SIZE;
+    const Uf2Extent extent = {
+        .address = address,
+        .size = payload_size,
+        .block_index = block_index,
+        .block_step = 0,
+    };
+
+    Uf2ExtentArray_push_at(extents, index, extent);
     return true;
 }
 
-bool uf2_verify_block(File* file, uint32_t family_id, size_t payload_size) {
-    Uf2BlockHeader header;
-    Uf2BlockTrailer trailer;
+// Calculate the CRC of each aligned sector whose payloads are read in address order
+static bool uf2_sector_add(
+    Uf2SectorArray_t sectors,
+    Uf2Sector* current,
+    size_t* current_size,
+    uint32_t address,
+    const void* payload_data,
+    size_t payload_size,
+    size_t sector_size) {
+    if(address % sector_size == 0) {
+        current->address = address;
+        current->crc = 0;
+    } else if(*current_size == 0 || current->address + *current_size != address) {
+        *current_size = 0;
+        return true;
+    }
+
+    current->crc = crc32_calc(current->crc, payload_data, payload_size);
+    *current_size = address + payload_size - current->address;
+
+    if(*current_size < sector_size) return true;
+
+    if(Uf2SectorArray_size(sectors) >= UF2_SECTOR_COUNT_MAX) {
+        FURI_LOG_E(TAG, "Too many sectors, at most %u are supported", UF2_SECTOR_COUNT_MAX);
+        return false;
+    }
+
+    size_t index = Uf2SectorArray_size(sectors);
 
-    if(!uf2_block_header_read(&header, file)) return false;
-    if(!uf2_block_header_verify(&header, family_id, payload_size)) return false;
-    if(!uf2_block_payload_skip(file)) return false;
-    if(!uf2_block_trailer_read(&trailer, file)) return false;
-    if(!uf2_block_trailer_verify(&trailer)) return false;
+    while(index > 0 && Uf2SectorArray_get(sectors, index - 1)->address > current->address) {
+        --index;
+    }
 
+    Uf2SectorArray_push_at(sectors, index, *current);
+    *current_size = 0;
     return true;
 }
 
-bool uf2_read_block(File* file, void* payload_data, size_t payload_size) {
-    if(!uf2_block_header_skip(file)) return false;
-    if(!uf2_block_payload_read(file, payload_data, payload_size)) return false;
-    if(!uf2_block_trailer_skip(file)) return false;
+// Check whether the target addresses descend through the file, judging by the first and last block
+static bool uf2_is_descending(
+    File* file,
+    uint8_t* file_buf,
+    uint32_t block_count,
+    uint32_t family_id,
+    size_t payload_size,
+    bool* descending) {
+    uint32_t first_address, last_address;
 
+    if(!uf2_seek_block(file, 0) || !uf2_read_blocks(file, file_buf, 1)) return false;
+    if(!uf2_parse_block(file_buf, family_id, &first_address, NULL, payload_size)) return false;
+    if(!uf2_seek_block(file, block_count - 1) || !uf2_read_blocks(file, file_buf, 1)) return false;
+    if(!uf2_parse_block(file_buf, family_id, &last_address, NULL, payload_size)) return false;
+
+    *descending = last_address < first_address;
     return true;
 }
+
+bool uf2_get_extents(
+    File* file,
+    uint32_t family_id,
+    size_t payload_size,
+    size_t sector_size,
+    Uf2ExtentArray_t extents,
+    Uf2SectorArray_t sectors) {
+    Uf2ExtentArray_reset(extents);
+    Uf2SectorArray_reset(sectors);
+
+    uint32_t block_count;
+    if(!uf2_get_block_count(file, &block_count)) return false;
+
+    uint8_t* file_buf = malloc(UF2_READ_BLOCK_COUNT * UF2_BLOCK_SIZE);
+    uint8_t* payload = malloc(payload_size);
+
+    Uf2Sector current_sector = {0};
+    size_t current_sector_size = 0;
+
+    bool descending;
+    uint32_t read_count = 0;
+
+    if(uf2_is_descending(file, file_buf, block_count, family_id, payload_size, &descending)) {
+        while(read_count < block_count) {
+            const uint32_t current_count = MIN(block_count - read_count, UF2_READ_BLOCK_COUNT);
+            const uint32_t first_index =
+                descending ? block_count - read_count - current_count : read_count;
+
+            if(!uf2_seek_block(file, first_index)) break;
+            if(!uf2_read_blocks(file, file_buf, current_count)) break;
+
+            uint32_t i;
+            for(i = 0; i < current_count; ++i, ++read_count) {
+                const uint32_t buf_index = descending ? current_count - 1 - i : i;
+                const uint32_t block_index = first_index + buf_index;
+
+                uint32_t address;
+                if(!uf2_parse_block(
+                       &file_buf[buf_index * UF2_BLOCK_SIZE],
+                       family_id,
+                       &address,
+                       payload,
+                       payload_size))
+                    break;
+                if(!uf2_extent_add(extents, address, block_index, payload_size)) break;
+                if(!uf2_sector_add(
+                       sectors,
+                       &current_sector,
+                       &current_sector_size,
+                       address,
+                       payload,
+                       payload_size,
+                       sector_size))
+                    break;
+            }
+
+            if(i < current_count) break;
+        }
+    }
+
+    free(payload);
+    free(file_buf);
+
+    return read_count == block_count;
+}
@@ -12,13 +12,44 @@
  *
  * Suported features:
  * - Family id (respective flag must be set)
+ * - Arbitrary block order and gaps between blocks
  *
  * See https://github.com/Microsoft/uf2 for more information.
  */
 #pragma once
 
+#include <m-array.h>
 #include <storage/storage.h>
 
+#define UF2_BLOCK_SIZE (512UL)
+#define UF2_EXTENT_COUNT_MAX (256U)
+#define UF2_SECTOR_COUNT_MAX (1024U)
+
+/**
+ * @brief Contiguous range of payload data stored in consecutive blocks.
+ *
+ * The blocks may be stored in either order: block_step tells whether the
+ * block index grows (1) or shrinks (-1) with the target address.
+ */
+typedef struct {
+    uint32_t address; /**< Target address of the first byte. */
+    uint32_t size; /**< Size of the payload data, in bytes. */
+    uint32_t block_index; /**< Index of the block containing the first byte. */
+    int32_t block_step; /**< Block index difference between adjacent payloads (0 if only one). */
+} Uf2Extent;
+
+ARRAY_DEF(Uf2ExtentArray, Uf2Extent, M_POD_OPLIST);
+
+/**
+ * @brief CRC-32 of a fully covered, aligned range of payload data.
+ */
+typedef struct {
+    uint32_t address; /**< Target address of the first byte. */
+    uint32_t crc; /**< CRC-32 of the payload data (see crc32_calc()). */
+} Uf2Sector;
+
+ARRAY_DEF(Uf2SectorArray, Uf2Sector, M_POD_OPLIST);
+
 /**
  * @brief Get the block count in a UF2 file.
  *
@@ -34,27 +65,89 @@
 bool uf2_get_block_count(File* file, uint32_t* block_count);
 
 /**
- * @brief Verify a single UF2 block.
+ * @brief Build the extent map of a UF2 file.
  *
- * The file MUST be already open.
+ * Reads and verifies all blocks of the file. Blocks with adjacent target
+ * addresses that are stored next to each other in the file are coalesced into
+ * a single extent, regardless of their order. The resulting extents are sorted
+ * by the target address.
  *
- * Will fail if:
- * - the family id flag is set, but does not match the provided value,
- * - payload size does not match the provided value.
+ * Files with descending target addresses are read from the end. For each
+ * sector_size-aligned range whose payloads are read in address order without
+ * interruption, the CRC-32 is added to the sector array, sorted by the target
+ * address. Other ranges are not included.
+ *
+ * The file MUST be already open. Will fail if any of the blocks fail
+ * verification (see uf2_parse_block()), if any of the blocks overlap,
+ * if there are more than UF2_EXTENT_COUNT_MAX extents or more than
+ * UF2_SECTOR_COUNT_MAX sector CRCs.
  *
  * @param[in] file pointer to the storage file instance.
  * @param[in] family_id family identifier to check against the respective header field.
  * @param[in] payload_size payload size to check agains the respective header field, in bytes.
+ * @param[in] sector_size size of the ranges to calculate the CRC-32 for, in bytes.
+ * @param[out] extents extent array to be filled.
+ * @param[out] sectors sector array to be filled.
+ * @returns true on success, false otherwise.
+ */
+bool uf2_get_extents(
+    File* file,
+    uint32_t family_id,
+    size_t payload_size,
+    size_t sector_size,
+    Uf2ExtentArray_t extents,
+    Uf2SectorArray_t sectors);
+
+/**
+ * @brief Get the index of the block containing the given address.
+ *
+ * @param[in] extent pointer to the extent containing the address.
+ * @param[in] address target address, must be aligned to payload_size.
+ * @param[in] payload_size payload size of the blocks, in bytes.
+ * @returns index of the block within the file.
+ */
+uint32_t
+    uf2_extent_get_block_index(const Uf2Extent* extent, uint32_t address, size_t payload_size);
+
+/**
+ * @brief Seek to the beginning of a UF2 block.
+ *
+ * @param[in] file pointer to the storage file instance.
+ * @param[in] block_index index of the block within the file.
  * @returns true on success, false otherwise.
  */
-bool uf2_verify_block(File* file, uint32_t family_id, size_t payload_size);
+bool uf2_seek_block(File* file, uint32_t block_index);
 
 /**
- * @brief Read the payload from a single UF2 block.
+ * @brief Read several consecutive UF2 blocks at once.
+ *
+ * The file MUST be already open.
  *
  * @param[in] file pointer to the storage file instance.
- * @param[out] payload pointer to the buffer to contain the payload data.
- * @param[in] payload_size size of the payload buffer, in bytes.
+ * @param[out] data pointer to the buffer to contain the raw blocks (block_count * UF2_BLOCK_SIZE).
+ * @param[in] block_count number of blocks to be read.
+ * @returns true on success, false otherwise.
+ */
+bool uf2_read_blocks(File* file, void* data, size_t block_count);
+
+/**
+ * @brief Verify a single raw UF2 block and extract its payload.
+ *
+ * Will fail if:
+ * - the magic numbers do not match,
+ * - the family id flag is set, but does not match the provided value,
+ * - payload size does not match the provided value.
+ *
+ * @param[in] block_data pointer to the raw block data (UF2_BLOCK_SIZE bytes).
+ * @param[in] family_id family identifier to check against the respective header field.
+ * @param[out] target_addr pointer to the value to contain the target address (can be NULL).
+ * @param[out] payload_data pointer to the buffer to contain the payload data (can be NULL).
+ * @param[in] payload_size payload size to check agains the respective header field, in bytes.
  * @returns true on success, false otherwise.
  */
-bool uf2_read_block(File* file, void* payload, size_t payload_size);
+bool uf2_parse_block(
+    const void* block_data,
+    uint32_t family_id,
+    uint32_t* target_addr,
+    void* payload_data,
+    size_t payload_size);
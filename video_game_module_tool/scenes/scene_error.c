@@ -28,6 +28,8 @@ void scene_error_on_enter(void* context) {
         error_msg = "This file is\ncorrupted or\nunsupported";
     } else if(app->flasher_error == FlasherErrorDisconnect) {
         error_msg = "The module was\ndisconnected\nduring the update";
+    } else if(app->flasher_error == FlasherErrorVerify) {
+        error_msg = "Flash contents\ndo not match\nthe file";
     } else if(app->flasher_error == FlasherErrorUnknown) {
         error_msg = "An unknown error\nhas occurred";
     } else {